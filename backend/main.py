@@ -5,10 +5,12 @@ Provides WebSocket streaming and REST API for order management
 
 from fastapi import FastAPI, WebSocket, WebSocketDisconnect, HTTPException
 from fastapi.middleware.cors import CORSMiddleware
+from fastapi.responses import PlainTextResponse
 from contextlib import asynccontextmanager
 import asyncio
 import json
-from typing import List, Set
+import time
+from typing import List, Optional, Set
 import logging
 
 from market_simulator import MarketSimulator
@@ -68,6 +70,9 @@ async def lifespan(app: FastAPI):
     for connection in list(active_connections):
         await connection.close()
     
+    if trading_service:
+        trading_service.flush_history()
+    
     logger.info("✓ Shutdown complete")
 
 
@@ -97,15 +102,22 @@ async def broadcast_market_data():
     
     try:
         while True:
+            # Stage-boundary timestamps carried alongside this tick
+            stamps = [time.perf_counter_ns()]
+            
             # Generate new price
             new_price = market_simulator.generate_price()
+            stamps.append(time.perf_counter_ns())
             
             # Process through C++ engine
             market_data = trading_service.process_price(new_price)
+            stamps.append(time.perf_counter_ns())
             
             # Broadcast to all connected WebSocket clients
-            if active_connections:
-                message = json.dumps(market_data)
+            message = json.dumps(market_data) if active_connections else None
+            stamps.append(time.perf_counter_ns())
+            
+            if message is not None:
                 disconnected = set()
                 
                 for connection in active_connections:
@@ -118,18 +130,19 @@ async def broadcast_market_data():
                 # Remove disconnected clients
                 active_connections.difference_update(disconnected)
             
-            # Broadcast trade events if any
-            if market_data.get("trades"):
-                for trade in market_data["trades"]:
-                    trade_message = json.dumps({
-                        "type": "trade",
-                        **trade
-                    })
-                    for connection in active_connections:
-                        try:
-                            await connection.send_text(trade_message)
-                        except:
-                            pass
+            # Broadcast trade and expiry events if any
+            events = [{"type": "trade", **t} for t in market_data.get("trades", [])]
+            events += [{"type": "expired", **e} for e in market_data.get("expired", [])]
+            for event in events:
+                event_message = json.dumps(event)
+                for connection in active_connections:
+                    try:
+                        await connection.send_text(event_message)
+                    except:
+                        pass
+            
+            stamps.append(time.perf_counter_ns())
+            trading_service.record_tick_pipeline(stamps)
             
             # Wait for next update
             await asyncio.sleep(market_simulator.update_interval)
@@ -174,7 +187,8 @@ async def create_order(order: OrderCreate):
     Create a new buy or sell order
     
     Args:
-        order: Order details (side, price, quantity)
+        order: Order details (side, price, quantity, optional stop_price
+            and expiry)
         
     Returns:
         OrderResponse: Order confirmation with ID and status
@@ -188,7 +202,11 @@ async def create_order(order: OrderCreate):
     result = trading_service.add_order(
         side=order.side.value,
         price=order.price,
-        quantity=order.quantity
+        quantity=order.quantity,
+        stop_price=order.stop_price,
+        expire_after_ms=order.expire_after_ms,
+        expire_after_ticks=order.expire_after_ticks,
+        display_quantity=order.display_quantity
     )
     
     # Broadcast order event to WebSocket clients
@@ -198,6 +216,7 @@ async def create_order(order: OrderCreate):
         "side": order.side.value,
         "price": order.price,
         "quantity": order.quantity,
+        "stop_price": order.stop_price,
         "status": result["status"]
     })
     
@@ -218,6 +237,7 @@ async def websocket_endpoint(websocket: WebSocket):
     Clients receive:
     - Market data updates (price, SMA, order book)
     - Trade execution events
+    - Order expiry events
     - Order placement events
     """
     await websocket.accept()
@@ -257,16 +277,283 @@ async def websocket_endpoint(websocket: WebSocket):
         logger.info(f"Client {client_id} removed. Total connections: {len(active_connections)}")
 
 
+@app.get("/api/history")
+async def get_history(start: Optional[int] = None, end: Optional[int] = None,
+                      points: int = 500, method: str = "minmax"):
+    """
+    Stored price history for a time range, downsampled in C++
+    
+    Args:
+        start: Range start (epoch ms, inclusive; default: all history)
+        end: Range end (epoch ms, exclusive; default: latest tick)
+        points: Maximum points to return, 2-10000 (e.g. chart width in pixels)
+        method: "minmax" (bucket lows and highs) or "lttb"
+    
+    Returns:
+        dict: timestamps (ms) and prices in time order
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    if not 2 <= points <= 10000:
+        raise HTTPException(status_code=400, detail="points must be between 2 and 10000")
+    if method not in ("minmax", "lttb"):
+        raise HTTPException(status_code=400, detail="method must be 'minmax' or 'lttb'")
+    return trading_service.get_price_history(start, end, points, method)
+
+
+@app.get("/api/auction")
+async def get_auction():
+    """
+    Matching mode and the indicative call-auction uncross
+    
+    Returns:
+        dict: mode, indicative price and volume, buy surplus and crossing levels
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    return trading_service.get_auction_state()
+
+
+@app.post("/api/auction/start")
+async def start_auction():
+    """
+    Start a call auction: orders rest without matching until the uncross
+    
+    Returns:
+        dict: The auction state
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    return trading_service.start_auction()
+
+
+@app.post("/api/auction/uncross")
+async def uncross_auction():
+    """
+    Uncross the auction at the volume-maximising price and reopen continuous matching
+    
+    Returns:
+        dict: Uncross price, volume, buy surplus and the executed trades
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    return trading_service.uncross_auction()
+
+
+@app.post("/api/batch/start")
+async def start_batch(interval_ms: float = 100.0, allocation: str = "pro_rata"):
+    """
+    Switch to frequent batch auctions cleared every interval_ms
+    
+    Args:
+        interval_ms: Time between clears (> 0); a due batch clears on the next price tick
+        allocation: "pro_rata" or "time", for the marginal price level
+    
+    Returns:
+        dict: mode, interval and the orders waiting for the first clear
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    if interval_ms <= 0:
+        raise HTTPException(status_code=400, detail="interval_ms must be positive")
+    if allocation not in ("pro_rata", "time"):
+        raise HTTPException(status_code=400, detail="allocation must be 'pro_rata' or 'time'")
+    return trading_service.start_batch(interval_ms, allocation)
+
+
+@app.post("/api/batch/stop")
+async def stop_batch():
+    """
+    Clear the last batch and reopen continuous matching
+    
+    Returns:
+        dict: Clearing price, volume, buy surplus and the executed trades
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    return trading_service.stop_batch()
+
+
+@app.post("/api/simulate")
+async def simulate(duration_s: float = 86400.0, order_rate: float = 10.0, seed: int = 0):
+    """
+    Run a simulated session faster than real time (the live book is untouched)
+    
+    Args:
+        duration_s: Simulated seconds, up to a week
+        order_rate: Synthetic orders per simulated second
+        seed: Random seed; the same seed gives the same session
+    
+    Returns:
+        dict: Event counts, volume, final price and SMA, wall time and speedup
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    if not 0 < duration_s <= 7 * 86400:
+        raise HTTPException(status_code=400, detail="duration_s must be in (0, 604800]")
+    if not 0 <= order_rate <= 10000:
+        raise HTTPException(status_code=400, detail="order_rate must be in [0, 10000]")
+    # Off the event loop: the broadcast keeps running meanwhile
+    return await asyncio.to_thread(trading_service.run_simulation, duration_s, order_rate, seed)
+
+
+@app.post("/api/backtest")
+async def backtest(fast_window: int = 20, slow_window: int = 100, quantity: float = 0.1,
+                   duration_s: float = 86400.0, order_rate: float = 20.0, seed: int = 0,
+                   latency_us: int = 0):
+    """
+    Backtest the reference SMA-crossover strategy on a simulated session
+    
+    Args:
+        fast_window: Fast SMA window (ticks), below slow_window
+        slow_window: Slow SMA window (ticks)
+        quantity: Position held long or short
+        duration_s: Simulated seconds, up to a week
+        order_rate: Synthetic orders per simulated second
+        seed: Random seed; the same seed gives the same session
+        latency_us: Order-entry and market-data latency, each way
+    
+    Returns:
+        dict: Strategy orders, fills, position, cash, PnL and drawdown, wall time and speedup
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    if not 0 < fast_window < slow_window <= 100000:
+        raise HTTPException(status_code=400, detail="Need 0 < fast_window < slow_window <= 100000")
+    if quantity <= 0:
+        raise HTTPException(status_code=400, detail="quantity must be positive")
+    if not 0 < duration_s <= 7 * 86400:
+        raise HTTPException(status_code=400, detail="duration_s must be in (0, 604800]")
+    if not 0 <= order_rate <= 10000:
+        raise HTTPException(status_code=400, detail="order_rate must be in [0, 10000]")
+    if not 0 <= latency_us <= 10**6:
+        raise HTTPException(status_code=400, detail="latency_us must be in [0, 1000000]")
+    return await asyncio.to_thread(trading_service.run_backtest, fast_window, slow_window, quantity,
+                                   duration_s, order_rate, seed, latency_us)
+
+
+@app.post("/api/backtest/sweep")
+async def backtest_sweep(fast_windows: str = "5,10,20", slow_windows: str = "50,100,200",
+                         quantity: float = 0.1, start: Optional[int] = None, end: Optional[int] = None,
+                         order_rate: float = 20.0, seed: int = 0, latency_us: int = 0):
+    """
+    Backtest a grid of SMA-crossover windows on the recorded price history
+    
+    Args:
+        fast_windows: Comma-separated fast SMA windows (ticks)
+        slow_windows: Comma-separated slow SMA windows (ticks)
+        quantity: Position held long or short
+        start: Range start in epoch milliseconds (default: all history)
+        end: Range end in epoch milliseconds, exclusive (default: now)
+        order_rate: Synthetic orders per simulated second
+        seed: Random seed of the synthetic liquidity
+        latency_us: Order-entry and market-data latency, each way
+    
+    Returns:
+        dict: Tick count, threads, wall time and the runs, best PnL first
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    try:
+        fast = [int(w) for w in fast_windows.split(",")]
+        slow = [int(w) for w in slow_windows.split(",")]
+    except ValueError:
+        raise HTTPException(status_code=400, detail="Windows must be comma-separated integers")
+    if not all(0 < w <= 100000 for w in fast + slow):
+        raise HTTPException(status_code=400, detail="Windows must be in [1, 100000]")
+    if not any(f < s for f in fast for s in slow):
+        raise HTTPException(status_code=400, detail="Need at least one fast window below a slow window")
+    if len(fast) * len(slow) > 256:
+        raise HTTPException(status_code=400, detail="At most 256 window pairs")
+    if quantity <= 0:
+        raise HTTPException(status_code=400, detail="quantity must be positive")
+    if not 0 <= order_rate <= 10000:
+        raise HTTPException(status_code=400, detail="order_rate must be in [0, 10000]")
+    if not 0 <= latency_us <= 10**6:
+        raise HTTPException(status_code=400, detail="latency_us must be in [0, 1000000]")
+    # Copy the ticks here, where prices are recorded; replay off the event loop
+    timestamps, prices = trading_service.read_price_ticks(start, end)
+    return await asyncio.to_thread(trading_service.sweep_backtest, timestamps, prices, fast, slow,
+                                   quantity, order_rate, seed, latency_us)
+
+
 @app.get("/health")
 async def health_check():
     """Health check endpoint for monitoring"""
     return {
         "status": "healthy",
         "active_connections": len(active_connections),
-        "trading_service": "initialized" if trading_service else "not initialized"
+        "trading_service": "initialized" if trading_service else "not initialized",
+        "simd_path": trading_service.simd_path if trading_service else None,
+        "matching": {"policy": trading_service.matching, "trade_price": trading_service.trade_price}
+                    if trading_service else None
     }
 
 
+@app.get("/metrics", response_class=PlainTextResponse)
+async def prometheus_metrics():
+    """
+    Engine counters and gauges for Prometheus scraping
+    
+    Returns:
+        str: Text exposition format (orders, rejects, fills, cancels, ticks,
+             SMA updates, price levels, resting orders, WebSocket clients)
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    
+    body = trading_service.get_prometheus_metrics()
+    body += (
+        "# HELP trade_engine_websocket_clients Connected WebSocket clients\n"
+        "# TYPE trade_engine_websocket_clients gauge\n"
+        f"trade_engine_websocket_clients {len(active_connections)}\n"
+    )
+    return PlainTextResponse(body, media_type="text/plain; version=0.0.4")
+
+
+@app.get("/metrics/latency")
+async def latency_metrics():
+    """
+    Order book latency percentiles recorded inside the C++ engine
+    
+    Returns:
+        dict: Per-operation count and p50/p90/p99/p99.9 latency (ns)
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    
+    return trading_service.get_latency_stats()
+
+
+@app.get("/metrics/pipeline")
+async def pipeline_metrics():
+    """
+    End-to-end tick pipeline latency attribution
+    
+    Returns:
+        dict: Per-stage (generate, process, serialize, fanout) percentiles,
+              each stage's share of the total and the dominant stage
+    """
+    if not trading_service or not market_simulator:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    
+    return trading_service.get_pipeline_report(budget_s=market_simulator.update_interval)
+
+
+@app.get("/metrics/memory")
+async def memory_metrics():
+    """
+    Memory used by the C++ order book and indicators
+    
+    Returns:
+        dict: Bytes per component, bytes per resting order and high-water marks
+    """
+    if not trading_service:
+        raise HTTPException(status_code=503, detail="Trading service not initialized")
+    
+    return trading_service.get_memory_stats()
+
+
 if __name__ == "__main__":
     import uvicorn
     
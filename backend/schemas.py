@@ -4,7 +4,7 @@ Ensures type safety between Python backend and TypeScript frontend
 """
 
 from pydantic import BaseModel, Field, field_validator
-from typing import Literal
+from typing import Literal, Optional
 from enum import Enum
 
 
@@ -19,6 +19,19 @@ class OrderCreate(BaseModel):
     side: OrderSideEnum = Field(..., description="Order side (buy or sell)")
     price: float = Field(..., gt=0, description="Order price (must be positive)")
     quantity: float = Field(..., gt=0, description="Order quantity (must be positive)")
+    stop_price: Optional[float] = Field(
+        None, gt=0,
+        description="Trigger price for a stop-limit order (rests at price once the market reaches it)"
+    )
+    expire_after_ms: Optional[int] = Field(
+        None, gt=0, description="Good-till-time: the order expires this many milliseconds after placement"
+    )
+    expire_after_ticks: Optional[int] = Field(
+        None, gt=0, description="Good-for-N-ticks: the order expires after this many price ticks"
+    )
+    display_quantity: Optional[float] = Field(
+        None, gt=0, description="Iceberg order: show this much of the quantity at a time, refilled as it fills"
+    )
     
     @field_validator('price', 'quantity')
     @classmethod
@@ -74,6 +87,28 @@ class MarketDataMessage(BaseModel):
         }
 
 
+class ExpiredOrderMessage(BaseModel):
+    """WebSocket message for an order that expired unfilled"""
+    type: Literal["expired"] = "expired"
+    timestamp: float
+    order_id: str
+    side: OrderSideEnum
+    price: float
+    quantity: float = Field(..., description="Quantity still open when the order expired")
+    
+    class Config:
+        json_schema_extra = {
+            "example": {
+                "type": "expired",
+                "timestamp": 1234567890.123,
+                "order_id": "ORD125",
+                "side": "buy",
+                "price": 45000.00,
+                "quantity": 0.5
+            }
+        }
+
+
 class TradeMessage(BaseModel):
     """WebSocket message for trade execution events"""
     type: Literal["trade"] = "trade"
@@ -3,12 +3,29 @@ Python fallback for trade_engine module
 Used when C++ module is not available
 """
 
+import sys
+
+import numpy as np
+
 class OrderSide:
     """Order side enum"""
     BUY = "BUY"
     SELL = "SELL"
 
 
+class TradingMode:
+    """Matching mode enum"""
+    CONTINUOUS = "CONTINUOUS"
+    AUCTION = "AUCTION"
+    BATCH = "BATCH"
+
+
+class BatchAllocation:
+    """How clear_batch shares the marginal price level"""
+    TIME = "TIME"
+    PRO_RATA = "PRO_RATA"
+
+
 class Order:
     """Order class"""
     def __init__(self, order_id, side, price, quantity):
@@ -16,6 +33,8 @@ class Order:
         self.side = side
         self.price = price
         self.quantity = quantity
+        self.display = quantity
+        self.hidden = 0.0
         import time
         self.timestamp = int(time.time() * 1000)
 
@@ -31,13 +50,75 @@ class Trade:
         self.timestamp = int(time.time() * 1000)
 
 
+class ExpiredOrder:
+    """Python fallback expired order"""
+    def __init__(self, order):
+        self.order_id = order.id
+        self.side = order.side
+        self.price = order.price
+        self.quantity = order.quantity + order.hidden
+        import time
+        self.timestamp = int(time.time() * 1000)
+
+
+class PriceHistory:
+    """Python fallback (timestamp, price) ring on two numpy arrays"""
+    def __init__(self, capacity):
+        if capacity <= 0:
+            raise ValueError("History capacity must be greater than 0")
+        self._timestamps = np.zeros(capacity)
+        self._prices = np.zeros(capacity)
+        self._size = 0
+        self._next = 0
+    
+    def push(self, timestamp, price):
+        self._timestamps[self._next] = timestamp
+        self._prices[self._next] = price
+        self._next = (self._next + 1) % len(self._prices)
+        self._size = min(self._size + 1, len(self._prices))
+    
+    def arrays(self):
+        if self._size == len(self._prices) and self._next != 0:
+            self._timestamps = np.roll(self._timestamps, -self._next)
+            self._prices = np.roll(self._prices, -self._next)
+            self._next = 0
+        timestamps = self._timestamps[:self._size].view()
+        prices = self._prices[:self._size].view()
+        timestamps.flags.writeable = prices.flags.writeable = False
+        return timestamps, prices
+    
+    def timestamps(self):
+        return self.arrays()[0]
+    
+    def prices(self):
+        return self.arrays()[1]
+    
+    def last(self):
+        return float(self._prices[self._next - 1]) if self._size else 0.0
+    
+    def capacity(self):
+        return len(self._prices)
+    
+    def memory_bytes(self):
+        return self._timestamps.nbytes + self._prices.nbytes
+    
+    def clear(self):
+        self._size = 0
+        self._next = 0
+    
+    def __len__(self):
+        return self._size
+
+
 class SMACalculator:
     """Python fallback SMA calculator"""
     def __init__(self, window_size):
         self.window_size = window_size
         self.prices = []
     
-    def add_price(self, price):
+    def add_price(self, price, timestamp=None, history=None):
+        if history is not None:
+            history.push(timestamp, price)
         self.prices.append(price)
         if len(self.prices) > self.window_size:
             self.prices.pop(0)
@@ -50,6 +131,9 @@ class SMACalculator:
     def size(self):
         return len(self.prices)
     
+    def memory_bytes(self):
+        return sys.getsizeof(self.prices)
+    
     def reset(self):
         self.prices = []
 
@@ -60,12 +144,23 @@ class OrderBook:
         self.bids = {}  # price -> [orders]
         self.asks = {}  # price -> [orders]
         self.next_id = 1
+        self._mode = TradingMode.CONTINUOUS
+        self._pending = []
+        self._stops = []  # [stop_price, order]; order.price is the limit (0: market)
+        self._last_price = 0.0
+        self._clock_ms = 0
+        self._ticks = 0
+        self._expiries = []  # [clock ("time" or "ticks"), deadline, order_id]
+        self._expired = []
     
     def add_order(self, side, price, quantity):
         order_id = f"ORD{self.next_id}"
         self.next_id += 1
         
         order = Order(order_id, side, price, quantity)
+        if self._mode == TradingMode.BATCH:
+            self._pending.append(order)
+            return order_id
         
         if side == OrderSide.BUY:
             if price not in self.bids:
@@ -78,11 +173,324 @@ class OrderBook:
         
         return order_id
     
+    def add_iceberg_order(self, side, price, display_quantity, total_quantity):
+        if display_quantity <= 0 or total_quantity < display_quantity:
+            raise ValueError("Display quantity must be positive and at most the total")
+        order_id = self.add_order(side, price, display_quantity)
+        order = self._find_order(order_id)
+        order.hidden = total_quantity - display_quantity
+        return order_id
+    
+    @staticmethod
+    def _replenish(order):
+        # Refill a filled iceberg's next tranche; False once the reserve is spent
+        if order.hidden <= 0:
+            return False
+        order.quantity = min(order.display, order.hidden)
+        order.hidden -= order.quantity
+        return True
+    
+    def iceberg_orders(self):
+        return sum(1 for levels in (self.bids, self.asks) for orders in levels.values()
+                   for o in orders if o.hidden > 0) + sum(1 for o in self._pending if o.hidden > 0)
+    
+    def add_order_good_till(self, side, price, quantity, expire_ms):
+        if expire_ms <= self._clock_ms:
+            raise ValueError("Expiry must be after the engine clock")
+        order_id = self.add_order(side, price, quantity)
+        self._expiries.append(["time", expire_ms, order_id])
+        return order_id
+    
+    def add_order_good_for_ticks(self, side, price, quantity, ticks):
+        if ticks <= 0:
+            raise ValueError("Tick count must be greater than 0")
+        order_id = self.add_order(side, price, quantity)
+        self._expiries.append(["ticks", self._ticks + ticks, order_id])
+        return order_id
+    
+    def advance_time(self, now_ms):
+        before = len(self._expired)
+        if now_ms > self._clock_ms:
+            self._clock_ms = now_ms
+            self._expire("time", now_ms)
+        return len(self._expired) - before
+    
+    def _expire(self, clock, now):
+        due = [e for e in self._expiries if e[0] == clock and e[1] <= now]
+        self._expiries = [e for e in self._expiries if e not in due]
+        for _, _, order_id in due:
+            order = self._find_order(order_id)
+            if order is not None and self.cancel_order(order_id):
+                self._expired.append(ExpiredOrder(order))
+    
+    def _find_order(self, order_id):
+        for order in self._pending:
+            if order.id == order_id:
+                return order
+        for levels in (self.bids, self.asks):
+            for orders in levels.values():
+                for order in orders:
+                    if order.id == order_id:
+                        return order
+        return None
+    
+    def clock_millis(self):
+        return self._clock_ms
+    
+    def ticks(self):
+        return self._ticks
+    
+    def take_expired(self):
+        expired, self._expired = self._expired, []
+        return expired
+    
     def match_orders(self):
         trades = []
         # Simplified matching - just return empty for now
         return trades
     
+    def add_stop_order(self, side, stop_price, quantity, limit_price=0.0):
+        if stop_price <= 0 or quantity <= 0 or limit_price < 0:
+            raise ValueError("Stop price and quantity must be positive, limit non-negative")
+        order_id = f"ORD{self.next_id}"
+        self.next_id += 1
+        self._stops.append([stop_price, Order(order_id, side, limit_price, quantity)])
+        return order_id
+    
+    def process_tick(self, price):
+        if price <= 0:
+            raise ValueError("Price must be positive")
+        self._last_price = price
+        trades = []
+        self._fire_stops(trades, price)
+        self._ticks += 1
+        self._expire("ticks", self._ticks)
+        return trades
+    
+    def _fire_stops(self, trades, price):
+        # Stops reached by price, then by their own trades; continuous trading only
+        high = low = price
+        start = len(trades)
+        while self._mode == TradingMode.CONTINUOUS:
+            fired = [s for s in self._stops
+                     if (s[1].side == OrderSide.BUY and s[0] <= high)
+                     or (s[1].side == OrderSide.SELL and s[0] >= low)]
+            if not fired:
+                break
+            self._stops = [s for s in self._stops if s not in fired]
+            round_start = len(trades)
+            for _, order in fired:
+                self._sweep(order, trades)
+            if len(trades) == round_start:
+                break
+            high = max(t.price for t in trades[round_start:])
+            low = min(t.price for t in trades[round_start:])
+        if len(trades) > start:
+            self._last_price = trades[-1].price
+    
+    def _sweep(self, order, trades):
+        # Fired stops take liquidity at the resting price; stop-limits rest the rest
+        buy = order.side == OrderSide.BUY
+        levels = self.asks if buy else self.bids
+        for p in sorted(levels, reverse=not buy):
+            if order.quantity <= 0 or (order.price > 0 and (p > order.price if buy else p < order.price)):
+                break
+            while levels[p] and order.quantity > 0:
+                resting = levels[p][0]
+                trade = Trade()
+                trade.buy_order_id, trade.sell_order_id = (order.id, resting.id) if buy else (resting.id, order.id)
+                trade.price, trade.quantity = p, min(order.quantity, resting.quantity)
+                trades.append(trade)
+                order.quantity -= trade.quantity
+                resting.quantity -= trade.quantity
+                if resting.quantity <= 0:
+                    levels[p].pop(0)
+                    if self._replenish(resting):
+                        levels[p].append(resting)
+            if not levels[p]:
+                del levels[p]
+        if order.quantity > 0 and order.price > 0:
+            (self.bids if buy else self.asks).setdefault(order.price, []).append(order)
+    
+    def last_price(self):
+        return self._last_price
+    
+    def stop_orders(self):
+        return len(self._stops)
+    
+    def set_mode(self, mode):
+        if self._mode == TradingMode.BATCH and mode != TradingMode.BATCH:
+            self._release_pending()
+        self._mode = mode
+    
+    def _release_pending(self):
+        # Waiting orders join the book behind what already rests there
+        for order in self._pending:
+            levels = self.bids if order.side == OrderSide.BUY else self.asks
+            levels.setdefault(order.price, []).append(order)
+        self._pending = []
+    
+    def pending_orders(self):
+        return len(self._pending)
+    
+    def clear_batch(self, allocation=BatchAllocation.PRO_RATA, reference_price=0.0):
+        result = self._clear_batch(allocation, reference_price)
+        if result["trades"]:
+            self._fire_stops(result["trades"], result["price"])
+        return result
+    
+    def clear_batch_fills(self, allocation=BatchAllocation.PRO_RATA, reference_price=0.0):
+        # Stops wait for the next tick: their trades would not be batch fills
+        result = self._clear_batch(allocation, reference_price)
+        trades = result.pop("trades")
+        result["buy_seq"] = np.array([int(t.buy_order_id[3:]) for t in trades], dtype=np.uint64)
+        result["sell_seq"] = np.array([int(t.sell_order_id[3:]) for t in trades], dtype=np.uint64)
+        result["prices"] = np.array([t.price for t in trades], dtype=np.float64)
+        result["quantities"] = np.array([t.quantity for t in trades], dtype=np.float64)
+        return result
+    
+    def _clear_batch(self, allocation, reference_price):
+        self._release_pending()
+        if allocation == BatchAllocation.TIME:
+            return self._uncross(reference_price)
+        
+        result = self.indicative_auction(reference_price)
+        price = result["price"]
+        # Whole levels fill until the volume runs out; the marginal one pro rata
+        fills = []
+        for levels, prices in ((self.bids, sorted((p for p in self.bids if p >= price), reverse=True)),
+                               (self.asks, sorted(p for p in self.asks if p <= price))):
+            remaining, side = result["volume"], []
+            for p in prices:
+                if remaining <= 0:
+                    break
+                total = sum(o.quantity for o in levels[p])
+                share = min(1.0, remaining / total)
+                side.extend([o, o.quantity * share] for o in levels[p])
+                remaining -= min(total, remaining)
+            fills.append(side)
+        
+        trades = []
+        bids, asks = fills
+        i = j = 0
+        while i < len(bids) and j < len(asks):
+            quantity = min(bids[i][1], asks[j][1])
+            if quantity > 1e-12:
+                trade = Trade()
+                trade.buy_order_id, trade.sell_order_id = bids[i][0].id, asks[j][0].id
+                trade.price, trade.quantity = price, quantity
+                trades.append(trade)
+            for fill in (bids[i], asks[j]):
+                fill[0].quantity -= quantity
+                fill[1] -= quantity
+            if bids[i][1] <= 1e-12:
+                i += 1
+            if asks[j][1] <= 1e-12:
+                j += 1
+        for levels in (self.bids, self.asks):
+            for p in list(levels):
+                levels[p] = ([o for o in levels[p] if o.quantity > 1e-9]
+                             + [o for o in levels[p] if o.quantity <= 1e-9 and self._replenish(o)])
+                if not levels[p]:
+                    del levels[p]
+        if trades:
+            self._last_price = price
+        result["trades"] = trades
+        return result
+    
+    def mode(self):
+        return self._mode
+    
+    def indicative_auction(self, reference_price=0.0):
+        best_bid, best_ask = self.get_best_bid(), self.get_best_ask()
+        crossing = best_bid > 0 and best_ask > 0 and best_bid >= best_ask
+        bids = [(p, q) for p, q in self.get_bids() if crossing and p >= best_ask]
+        asks = [(p, q) for p, q in self.get_asks() if crossing and p <= best_bid]
+        result = {"price": 0.0, "volume": 0.0, "buy_surplus": 0.0,
+                  "price_levels": len(bids) + len(asks)}
+        if not crossing:
+            return result
+        
+        def depth(p):
+            demand = sum(q for bp, q in bids if bp >= p)
+            supply = sum(q for ap, q in asks if ap <= p)
+            return demand, supply
+        
+        # Max volume, then min surplus, then pressure, then reference price
+        scored = []
+        for p in sorted({p for p, _ in bids} | {p for p, _ in asks}):
+            demand, supply = depth(p)
+            scored.append((min(demand, supply), -abs(demand - supply), p, demand - supply))
+        best = max(s[:2] for s in scored)
+        tied = [s for s in scored if s[:2] == best]
+        low, high = tied[0][2], tied[-1][2]
+        if all(s[3] > 0 for s in tied):
+            price = high
+        elif all(s[3] < 0 for s in tied):
+            price = low
+        elif reference_price > 0:
+            price = min(max(reference_price, low), high)
+        else:
+            price = low + (high - low) / 2
+        demand, supply = depth(price)
+        result.update(price=price, volume=min(demand, supply), buy_surplus=demand - supply)
+        return result
+    
+    def uncross(self, reference_price=0.0):
+        result = self._uncross(reference_price)
+        if result["trades"]:
+            self._fire_stops(result["trades"], result["price"])
+        return result
+    
+    def _uncross(self, reference_price):
+        result = self.indicative_auction(reference_price)
+        trades = []
+        price = result["price"]
+        refilled = []  # Icebergs show their next tranche after the auction
+        bid_prices = [p for p in sorted(self.bids, reverse=True) if result["volume"] > 0 and p >= price]
+        ask_prices = [p for p in sorted(self.asks) if result["volume"] > 0 and p <= price]
+        while bid_prices and ask_prices:
+            bid = self.bids[bid_prices[0]][0]
+            ask = self.asks[ask_prices[0]][0]
+            trade = Trade()
+            trade.buy_order_id, trade.sell_order_id = bid.id, ask.id
+            trade.price, trade.quantity = price, min(bid.quantity, ask.quantity)
+            trades.append(trade)
+            bid.quantity -= trade.quantity
+            ask.quantity -= trade.quantity
+            for levels, prices, order in ((self.bids, bid_prices, bid), (self.asks, ask_prices, ask)):
+                if order.quantity == 0:
+                    levels[prices[0]].pop(0)
+                    if self._replenish(order):
+                        refilled.append((levels, order))
+                    if not levels[prices[0]]:
+                        del levels[prices.pop(0)]
+        for levels, order in refilled:
+            levels.setdefault(order.price, []).append(order)
+        if trades:
+            self._last_price = price
+        result["trades"] = trades
+        return result
+    
+    def cancel_order(self, order_id):
+        for stop in self._stops:
+            if stop[1].id == order_id:
+                self._stops.remove(stop)
+                return True
+        for order in self._pending:
+            if order.id == order_id:
+                self._pending.remove(order)
+                return True
+        for levels in (self.bids, self.asks):
+            for price, orders in list(levels.items()):
+                for order in orders:
+                    if order.id == order_id:
+                        orders.remove(order)
+                        if not orders:
+                            del levels[price]
+                        return True
+        return False
+    
     def get_bids(self):
         result = []
         for price in sorted(self.bids.keys(), reverse=True):
@@ -111,6 +519,833 @@ class OrderBook:
         self.bids = {}
         self.asks = {}
         self.next_id = 1
+        self._mode = TradingMode.CONTINUOUS
+        self._pending = []
+        self._stops = []
+        self._last_price = 0.0
+        self._clock_ms = 0
+        self._ticks = 0
+        self._expiries = []
+        self._expired = []
+    
+    def get_latency_stats(self):
+        return {}
+    
+    def reset_latency_stats(self):
+        pass
+    
+    def memory_stats(self):
+        return {}
+
+
+MATCHING_POLICIES = ("fifo", "pro_rata", "top_order_pro_rata")
+TRADE_PRICE_RULES = ("ask", "passive", "midpoint")
+
+
+def make_order_book(matching="fifo", trade_price="ask"):
+    """Python fallback: the same simplified book for every matching rule"""
+    if matching not in MATCHING_POLICIES or trade_price not in TRADE_PRICE_RULES:
+        raise ValueError("Unknown matching policy or trade price rule")
+    return OrderBook()
+
+
+class PipelineStats:
+    """Python fallback pipeline stats (mean per stage only)"""
+    STAGES = ("generate", "process", "serialize", "fanout", "total")
+    
+    def __init__(self):
+        self.reset()
+    
+    def record_tick(self, start, generated, processed, serialized, sent):
+        stamps = [start, generated, processed, serialized, sent]
+        for i, stage in enumerate(self.STAGES[:-1]):
+            self.sums[stage] += max(0, stamps[i + 1] - stamps[i])
+        self.sums["total"] += max(0, sent - start)
+        self.ticks += 1
+    
+    def get_report(self):
+        total = self.sums["total"]
+        return {
+            "ticks": self.ticks,
+            "stages": {
+                stage: {
+                    "count": self.ticks,
+                    "mean_ns": self.sums[stage] / self.ticks if self.ticks else 0.0,
+                    "share": self.sums[stage] / total if total else 0.0
+                }
+                for stage in self.STAGES
+            }
+        }
+    
+    def reset(self):
+        self.sums = {stage: 0 for stage in self.STAGES}
+        self.ticks = 0
+
+
+class TickStore:
+    """Python fallback tick history (uncompressed, in memory; path is ignored)"""
+    def __init__(self, path=""):
+        self.path = path
+        self.ticks = []
+    
+    def append(self, timestamp, price, quantity=0.0):
+        if self.ticks and timestamp < self.ticks[-1][0]:
+            raise ValueError("Tick timestamps must be non-decreasing")
+        self.ticks.append((int(timestamp), float(price), float(quantity)))
+    
+    def flush(self):
+        pass
+    
+    def read(self, t_from, t_to):
+        rows = [t for t in self.ticks if t_from <= t[0] < t_to]
+        return (np.array([t[0] for t in rows], dtype=np.int64),
+                np.array([t[1] for t in rows], dtype=np.float64),
+                np.array([t[2] for t in rows], dtype=np.float64))
+    
+    def downsample(self, t_from, t_to, points, method="minmax"):
+        if points < 2:
+            raise ValueError("Downsampling needs at least 2 points")
+        if method not in ("minmax", "lttb"):
+            raise ValueError(f"Unknown downsampling method: {method}")
+        timestamps, prices, _ = self.read(t_from, t_to)
+        if len(prices) <= points:
+            return timestamps, prices
+        buckets = points // 2 if method == "minmax" else 2 * points
+        keep = set()
+        for chunk in np.array_split(np.arange(len(prices)), buckets):
+            if len(chunk):
+                keep.update((chunk[np.argmin(prices[chunk])], chunk[np.argmax(prices[chunk])]))
+        if method == "lttb":
+            keep.update((0, len(prices) - 1))
+        idx = np.array(sorted(keep))
+        if method == "lttb" and len(idx) > points:
+            idx = idx[np.linspace(0, len(idx) - 1, points).round().astype(int)]
+        return timestamps[idx], prices[idx]
+    
+    def block_index(self):
+        return []
+    
+    def stats(self):
+        return {"ticks": len(self.ticks), "blocks": 0, "bytes": 24 * len(self.ticks),
+                "bytes_per_tick": 24.0 if self.ticks else 0.0, "path": self.path}
+    
+    def __len__(self):
+        return len(self.ticks)
+
+
+class SimulationConfig:
+    """Price model and synthetic order flow of a Simulation (times in microseconds)"""
+    def __init__(self):
+        self.initial_price = 45000.0
+        self.drift = 0.0
+        self.volatility = 0.0005
+        self.price_interval_us = 500000
+        self.seed = 0
+        self.sma_window = 20
+        self.order_rate = 0.0
+        self.order_spread = 0.002
+        self.max_quantity = 1.0
+        self.tick_size = 0.01
+        self.order_lifetime_us = 5000000
+
+
+class LatencyDistribution:
+    """Shape of one latency leg"""
+    FIXED = "FIXED"
+    UNIFORM = "UNIFORM"
+    EXPONENTIAL = "EXPONENTIAL"
+
+
+class LatencyModel:
+    """One latency leg of a participant, in simulated microseconds"""
+    def __init__(self, distribution=LatencyDistribution.FIXED, base_us=0, spread_us=0.0):
+        self.distribution = distribution
+        self.base_us = base_us
+        self.spread_us = spread_us
+
+
+class ParticipantFill:
+    """Python fallback fill of a participant order, as delivered"""
+    def __init__(self, client_id, order_id, side, price, quantity, remaining, exchange_time_us):
+        self.client_id = client_id
+        self.order_id = order_id
+        self.side = side
+        self.price = price
+        self.quantity = quantity
+        self.remaining = remaining
+        self.exchange_time_us = exchange_time_us
+
+
+class Simulation:
+    """Python fallback discrete-event simulation (heapq of timestamped events)"""
+    def __init__(self, config=None):
+        import random
+        self.config = config or SimulationConfig()
+        c = self.config
+        if (c.initial_price <= 0 or c.volatility < 0 or c.price_interval_us < 0 or c.order_rate < 0
+                or c.order_spread < 0 or c.max_quantity <= 0 or c.tick_size <= 0
+                or c.order_lifetime_us < 0):
+            raise ValueError("Invalid simulation config")
+        self._book = OrderBook()
+        self._sma = SMACalculator(c.sma_window)
+        self._price = c.initial_price
+        self._queue = []
+        self._seq = 0
+        self._now = 0
+        self._normals = []
+        self._normal_offset = 0
+        self._rng = random.Random(c.seed)
+        self._latency_rng = random.Random(c.seed ^ 0xD1B54A32D192ED03)
+        self._handler = None
+        self._participants = []
+        self._next_client = 1
+        self._clients = {}    # client ID -> [participant, order ID, remaining], while resting
+        self._by_order = {}   # order ID -> client ID, while resting
+        self._published = (0.0, 0.0)
+        self._stats = dict.fromkeys(("events", "price_steps", "orders", "rejected", "cancels",
+                                     "trades", "expired", "wakeups"), 0)
+        self._stats["volume"] = 0.0
+        if c.price_interval_us > 0:
+            dt = c.price_interval_us * 1e-6
+            self._mean = (c.drift - 0.5 * c.volatility ** 2) * dt
+            self._scale = c.volatility * np.sqrt(dt)
+            self._push(c.price_interval_us, "price_step")
+        if c.order_rate > 0:
+            self._push(self._next_arrival(), "order_flow")
+    
+    def _push(self, time_us, kind, *args):
+        import heapq
+        heapq.heappush(self._queue, (time_us, self._seq, kind, args))
+        self._seq += 1
+    
+    def _check(self, time_us):
+        if time_us < self._now:
+            raise ValueError("Cannot schedule an event in the simulated past")
+    
+    def schedule_order(self, time_us, side, price, quantity, lifetime_us=0):
+        self._check(time_us)
+        if lifetime_us < 0:
+            raise ValueError("Lifetime must not be negative")
+        self._push(time_us, "order", side, price, quantity, lifetime_us)
+    
+    def schedule_cancel(self, time_us, order_id):
+        self._check(time_us)
+        if not (order_id.startswith("ORD") and order_id[3:].isdigit()):
+            raise ValueError(f"Not an order ID: {order_id}")
+        self._push(time_us, "cancel", order_id)
+    
+    def schedule_price(self, time_us, price):
+        self._check(time_us)
+        if price <= 0:
+            raise ValueError("Price must be positive")
+        self._push(time_us, "price", price)
+    
+    def schedule_wakeup(self, time_us, token):
+        self._check(time_us)
+        self._push(time_us, "wakeup", token)
+    
+    def set_wakeup_handler(self, handler):
+        self._handler = handler
+    
+    def add_participant(self, order_entry=None, market_data=None):
+        order_entry = order_entry or LatencyModel()
+        market_data = market_data or LatencyModel()
+        if min(order_entry.base_us, order_entry.spread_us, market_data.base_us, market_data.spread_us) < 0:
+            raise ValueError("Latency must not be negative")
+        self._participants.append({
+            "order_entry": order_entry, "market_data": market_data, "last_entry": 0, "last_notice": 0,
+            "on_fill": None, "on_price": None, "on_trade": None, "on_book": None,
+            "stats": {"orders": 0, "rejected": 0, "cancels": 0, "fills": 0, "filled_quantity": 0.0},
+        })
+        return len(self._participants) - 1
+    
+    def _participant(self, index):
+        if not 0 <= index < len(self._participants):
+            raise ValueError("Unknown participant")
+        return self._participants[index]
+    
+    def set_fill_handler(self, participant, handler):
+        self._participant(participant)["on_fill"] = handler
+    
+    def set_price_handler(self, participant, handler):
+        self._participant(participant)["on_price"] = handler
+    
+    def set_trade_handler(self, participant, handler):
+        self._participant(participant)["on_trade"] = handler
+    
+    def set_book_handler(self, participant, handler):
+        self._participant(participant)["on_book"] = handler
+    
+    def participant_stats(self, participant):
+        return dict(self._participant(participant)["stats"])
+    
+    def _latency(self, model):
+        if model.distribution == LatencyDistribution.FIXED or model.spread_us <= 0:
+            return model.base_us
+        if model.distribution == LatencyDistribution.UNIFORM:
+            return model.base_us + int(self._latency_rng.random() * model.spread_us)
+        return model.base_us + int(self._latency_rng.expovariate(1.0 / model.spread_us))
+    
+    def _send(self, p, leg, kind, *args):
+        # A message never overtakes the one sent before it on the same leg
+        last = "last_entry" if leg == "order_entry" else "last_notice"
+        p[last] = max(self._now + self._latency(p[leg]), p[last])
+        self._push(p[last], kind, *args)
+    
+    def submit_order(self, participant, side, price, quantity):
+        client_id = self._next_client
+        self._next_client += 1
+        self._send(self._participant(participant), "order_entry", "client_order",
+                   participant, client_id, side, price, quantity)
+        return client_id
+    
+    def submit_cancel(self, participant, client_id):
+        self._send(self._participant(participant), "order_entry", "client_cancel", participant, client_id)
+    
+    def queue_ahead(self, client_id):
+        # Scans the level; the native engine keeps this up to date per event
+        client = self._clients.get(client_id)
+        if client is None:
+            return -1.0
+        order_id = client[1]
+        for levels in (self._book.bids, self._book.asks):
+            for orders in levels.values():
+                ids = [o.id for o in orders]
+                if order_id in ids:
+                    return float(sum(o.quantity for o in orders[:ids.index(order_id)]))
+        return -1.0
+    
+    def run_until(self, end_us):
+        applied = 0
+        while self._queue and self._queue[0][0] <= end_us:
+            self.step()
+            applied += 1
+        if end_us > self._now:
+            self._now = end_us
+            self._book.advance_time(end_us // 1000)
+            self._stats["expired"] += len(self._book.take_expired())
+        return applied
+    
+    def step(self):
+        import heapq
+        if not self._queue:
+            return False
+        self._now, _, kind, args = heapq.heappop(self._queue)
+        self._stats["events"] += 1
+        self._book.advance_time(self._now // 1000)
+        c = self.config
+        if kind == "price_step":
+            self._apply_price(self._price * np.exp(self._mean + self._scale * self._next_normal()))
+            self._push(self._now + c.price_interval_us, "price_step")
+        elif kind == "price":
+            self._apply_price(args[0])
+        elif kind == "order_flow":
+            side = OrderSide.SELL if self._rng.random() < 0.5 else OrderSide.BUY
+            offset = (1.25 * self._rng.random() - 0.25) * c.order_spread
+            raw = self._price * (1.0 - offset if side == OrderSide.BUY else 1.0 + offset)
+            price = max(c.tick_size, round(raw / c.tick_size) * c.tick_size)
+            quantity = c.max_quantity * (1.0 - self._rng.random())
+            self._apply_order(side, price, quantity, c.order_lifetime_us)
+            self._push(self._next_arrival(), "order_flow")
+        elif kind == "order":
+            self._apply_order(*args)
+        elif kind == "cancel":
+            if self._book.cancel_order(args[0]):
+                self._stats["cancels"] += 1
+        elif kind == "wakeup":
+            self._stats["wakeups"] += 1
+            if self._handler is not None:
+                self._handler(self, args[0])
+        elif kind == "client_order":
+            self._apply_client_order(*args)
+        elif kind == "client_cancel":
+            participant, client_id = args
+            client = self._clients.get(client_id)
+            if client is not None and client[0] == participant and self._book.cancel_order(client[1]):
+                self._stats["cancels"] += 1
+                self._participants[participant]["stats"]["cancels"] += 1
+                del self._by_order[client[1]]
+                del self._clients[client_id]
+        elif kind == "fill_notice":
+            handler = self._participants[args[0]]["on_fill"]
+            if handler is not None:
+                handler(self, args[1])
+        elif kind == "price_notice":
+            handler = self._participants[args[0]]["on_price"]
+            if handler is not None:
+                handler(self, args[1], args[2])
+        elif kind == "trade_notice":
+            handler = self._participants[args[0]]["on_trade"]
+            if handler is not None:
+                handler(self, args[1])
+        elif kind == "book_notice":
+            handler = self._participants[args[0]]["on_book"]
+            if handler is not None:
+                handler(self, args[1], args[2])
+        self._stats["expired"] += len(self._book.take_expired())
+        self._publish_book()
+        return True
+    
+    def _publish_book(self):
+        top = (self._book.get_best_bid(), self._book.get_best_ask())
+        if top == self._published:
+            return
+        self._published = top
+        for i, p in enumerate(self._participants):
+            if p["on_book"] is not None:
+                self._send(p, "market_data", "book_notice", i, *top)
+    
+    def _apply_price(self, price):
+        self._price = price
+        self._sma.add_price(price)
+        self._record(self._book.process_tick(price))
+        self._stats["price_steps"] += 1
+        for i, p in enumerate(self._participants):
+            if p["on_price"] is not None:
+                self._send(p, "market_data", "price_notice", i, price, self._now)
+    
+    def _apply_client_order(self, participant, client_id, side, price, quantity):
+        stats = self._participants[participant]["stats"]
+        if price <= 0 or quantity <= 0:
+            self._stats["rejected"] += 1
+            stats["rejected"] += 1
+            return
+        order_id = self._book.add_order(side, price, quantity)
+        self._stats["orders"] += 1
+        stats["orders"] += 1
+        self._clients[client_id] = [participant, order_id, quantity]
+        self._by_order[order_id] = client_id
+        self._record(self._book.match_orders())
+    
+    def _apply_order(self, side, price, quantity, lifetime_us):
+        if price <= 0 or quantity <= 0:
+            self._stats["rejected"] += 1
+            return
+        if lifetime_us > 0:
+            expire_ms = (self._now + lifetime_us + 999) // 1000
+            self._book.add_order_good_till(side, price, quantity, expire_ms)
+            self._push(expire_ms * 1000, "expiry")
+        else:
+            self._book.add_order(side, price, quantity)
+        self._stats["orders"] += 1
+        self._record(self._book.match_orders())
+    
+    def _record(self, trades):
+        for trade in trades:
+            trade.timestamp = self._now // 1000
+            self._stats["volume"] += trade.quantity
+            for order_id, side in ((trade.buy_order_id, OrderSide.BUY), (trade.sell_order_id, OrderSide.SELL)):
+                if order_id in self._by_order:
+                    self._fill_client(order_id, side, trade)
+        self._stats["trades"] += len(trades)
+        for i, p in enumerate(self._participants):
+            if p["on_trade"] is not None:
+                for trade in trades:
+                    self._send(p, "market_data", "trade_notice", i, trade)
+    
+    def _fill_client(self, order_id, side, trade):
+        client_id = self._by_order[order_id]
+        client = self._clients[client_id]
+        client[2] -= trade.quantity
+        if client[2] <= 0:
+            del self._by_order[order_id]
+            del self._clients[client_id]
+        p = self._participants[client[0]]
+        p["stats"]["fills"] += 1
+        p["stats"]["filled_quantity"] += trade.quantity
+        fill = ParticipantFill(client_id, order_id, side, trade.price, trade.quantity,
+                               max(0.0, client[2]), self._now)
+        self._send(p, "market_data", "fill_notice", client[0], fill)
+    
+    def _next_normal(self):
+        if not self._normals:
+            self._normals = list(gaussian_normals(1024, self.config.seed, self._normal_offset))[::-1]
+            self._normal_offset += 1024
+        return self._normals.pop()
+    
+    def _next_arrival(self):
+        return self._now + int(self._rng.expovariate(self.config.order_rate) * 1e6)
+    
+    def now(self):
+        return self._now
+    
+    def pending_events(self):
+        return len(self._queue)
+    
+    def price(self):
+        return self._price
+    
+    def sma(self):
+        return self._sma.get_sma()
+    
+    def book(self):
+        return self._book
+    
+    def stats(self):
+        return {**self._stats, "now_us": self._now}
+
+
+class StrategyContext:
+    """Python fallback strategy context (orders go through the simulation)"""
+    def __init__(self, simulation, participant):
+        self._sim = simulation
+        self._participant = participant
+        self._position = 0.0
+        self._cash = 0.0
+        self._last_price = 0.0
+        self._best_bid = 0.0
+        self._best_ask = 0.0
+    
+    def submit_order(self, side, price, quantity):
+        return self._sim.submit_order(self._participant, side, price, quantity)
+    
+    def cancel_order(self, client_id):
+        self._sim.submit_cancel(self._participant, client_id)
+    
+    def queue_ahead(self, client_id):
+        return self._sim.queue_ahead(client_id)
+    
+    def now(self):
+        return self._sim.now()
+    
+    def position(self):
+        return self._position
+    
+    def cash(self):
+        return self._cash
+    
+    def last_price(self):
+        return self._last_price
+    
+    def best_bid(self):
+        return self._best_bid
+    
+    def best_ask(self):
+        return self._best_ask
+
+
+class Strategy:
+    """Python fallback strategy base; every callback is optional"""
+    def on_tick(self, context, price):
+        pass
+    
+    def on_trade(self, context, trade):
+        pass
+    
+    def on_book_update(self, context, best_bid, best_ask):
+        pass
+    
+    def on_fill(self, context, fill):
+        pass
+    
+    def on_finish(self, context):
+        pass
+
+
+class SMACrossoverStrategy(Strategy):
+    """Python fallback reference strategy: long above the slow SMA, short below"""
+    def __init__(self, fast_window, slow_window, quantity, slippage=0.001):
+        if not 0 < fast_window < slow_window or quantity <= 0 or slippage < 0:
+            raise ValueError("Need 0 < fast_window < slow_window, quantity > 0 and slippage >= 0")
+        self._fast = SMACalculator(fast_window)
+        self._slow = SMACalculator(slow_window)
+        self._slow_window = slow_window
+        self._quantity = quantity
+        self._slippage = slippage
+        self._signal = 0
+        self._working = 0
+        self._crossovers = 0
+    
+    def on_tick(self, context, price):
+        self._fast.add_price(price)
+        self._slow.add_price(price)
+        if self._slow.size() < self._slow_window:
+            return
+        gap = self._fast.get_sma() - self._slow.get_sma()
+        signal = 1 if gap > 0 else -1 if gap < 0 else self._signal
+        if signal == self._signal:
+            return
+        if self._signal != 0:
+            self._crossovers += 1
+        self._signal = signal
+        if self._working:
+            context.cancel_order(self._working)
+            self._working = 0
+        delta = signal * self._quantity - context.position()
+        if abs(delta) <= self._quantity * 1e-9:
+            return
+        if delta > 0:
+            self._working = context.submit_order(OrderSide.BUY, price * (1.0 + self._slippage), delta)
+        else:
+            self._working = context.submit_order(OrderSide.SELL, price * (1.0 - self._slippage), -delta)
+    
+    def on_fill(self, context, fill):
+        if fill.client_id == self._working and fill.remaining <= 0:
+            self._working = 0
+    
+    def crossovers(self):
+        return self._crossovers
+    
+    def fast_sma(self):
+        return self._fast.get_sma()
+    
+    def slow_sma(self):
+        return self._slow.get_sma()
+
+
+class BatchStrategy(Strategy):
+    """Python fallback strategy handing its events over in batches"""
+    def __init__(self, handler, batch_ticks=1000):
+        if batch_ticks <= 0:
+            raise ValueError("Batch size must be positive")
+        self._handler = handler
+        self._batch_ticks = batch_ticks
+        self._batches = 0
+        self._best = (0.0, 0.0)
+        self._clear()
+    
+    def _clear(self):
+        self._times, self._prices, self._trades, self._fills = [], [], [], []
+    
+    def _flush(self, context):
+        self._batches += 1
+        self._handler(context, {
+            "tick_times": np.array(self._times, dtype=np.int64),
+            "tick_prices": np.array(self._prices, dtype=np.float64),
+            "trades": self._trades, "fills": self._fills,
+            "best_bid": self._best[0], "best_ask": self._best[1],
+        })
+        self._clear()
+    
+    def on_tick(self, context, price):
+        self._times.append(context.now())
+        self._prices.append(price)
+        if len(self._times) >= self._batch_ticks:
+            self._flush(context)
+    
+    def on_trade(self, context, trade):
+        self._trades.append(trade)
+    
+    def on_book_update(self, context, best_bid, best_ask):
+        self._best = (best_bid, best_ask)
+    
+    def on_fill(self, context, fill):
+        self._fills.append(fill)
+    
+    def on_finish(self, context):
+        if self._times or self._trades or self._fills:
+            self._flush(context)
+    
+    def batches(self):
+        return self._batches
+
+
+class BacktestConfig:
+    """Market (price model and synthetic liquidity) and latency of a Backtest"""
+    def __init__(self):
+        self.market = SimulationConfig()
+        self.market.order_rate = 20.0
+        self.order_entry = LatencyModel()
+        self.market_data = LatencyModel()
+
+
+class Backtest:
+    """Python fallback backtest runner over the fallback Simulation"""
+    def __init__(self, strategy, config=None):
+        self._strategy = strategy
+        self.config = config or BacktestConfig()
+    
+    def run(self, end_us):
+        if self.config.market.price_interval_us <= 0:
+            raise ValueError("run() needs the price model; use replay() for recorded prices")
+        self._start(self.config.market)
+        return self._finish(end_us)
+    
+    def replay(self, times_us, prices):
+        import copy
+        times_us = [int(t) for t in times_us]
+        prices = [float(p) for p in prices]
+        if (len(times_us) != len(prices) or any(p <= 0 for p in prices)
+                or any(b < a for a, b in zip([0] + times_us, times_us))):
+            raise ValueError("Ticks need non-decreasing, non-negative times and positive prices")
+        market = copy.copy(self.config.market)
+        market.price_interval_us = 0
+        if prices:
+            market.initial_price = prices[0]
+        self._start(market)
+        for t, p in zip(times_us, prices):
+            self._sim.schedule_price(t, p)
+        return self._finish(times_us[-1] if times_us else 0)
+    
+    def _start(self, market):
+        sim = self._sim = Simulation(market)
+        me = sim.add_participant(self.config.order_entry, self.config.market_data)
+        ctx = self._context = StrategyContext(sim, me)
+        strategy = self._strategy
+        self._result = {"ticks": 0, "max_drawdown": 0.0}
+        self._peak = 0.0
+        
+        def on_price(_, price, sent):
+            ctx._last_price = price
+            self._result["ticks"] += 1
+            equity = ctx._cash + ctx._position * price
+            self._peak = max(self._peak, equity)
+            self._result["max_drawdown"] = max(self._result["max_drawdown"], self._peak - equity)
+            strategy.on_tick(ctx, price)
+        
+        def on_fill(_, fill):
+            signed = fill.quantity if fill.side == OrderSide.BUY else -fill.quantity
+            ctx._position += signed
+            ctx._cash -= signed * fill.price
+            strategy.on_fill(ctx, fill)
+        
+        def on_book(_, best_bid, best_ask):
+            ctx._best_bid, ctx._best_ask = best_bid, best_ask
+            strategy.on_book_update(ctx, best_bid, best_ask)
+        
+        sim.set_price_handler(me, on_price)
+        sim.set_fill_handler(me, on_fill)
+        sim.set_trade_handler(me, lambda _, trade: strategy.on_trade(ctx, trade))
+        sim.set_book_handler(me, on_book)
+    
+    def _finish(self, end_us):
+        sim, ctx = self._sim, self._context
+        sim.run_until(end_us)
+        self._strategy.on_finish(ctx)
+        stats = sim.participant_stats(ctx._participant)
+        market = sim.stats()
+        result = dict(self._result)
+        result.update(orders=stats["orders"], rejected=stats["rejected"], cancels=stats["cancels"],
+                      fills=stats["fills"], traded_quantity=stats["filled_quantity"],
+                      position=ctx._position, cash=ctx._cash,
+                      pnl=ctx._cash + ctx._position * sim.price(), end_us=sim.now(),
+                      market_trades=market["trades"], market_volume=market["volume"])
+        return result
+
+
+class ParallelBacktest:
+    """Python fallback: runs the strategies one after another (threads is ignored)"""
+    def __init__(self, threads=0):
+        import os
+        self._threads = threads or os.cpu_count() or 1
+        self._backtests = []
+    
+    def add(self, strategy, config=None):
+        self._backtests.append(Backtest(strategy, config))
+        return len(self._backtests) - 1
+    
+    def replay(self, times_us, prices, batch_ticks=16384):
+        if batch_ticks <= 0:
+            raise ValueError("Batch size must be positive")
+        times_us = [int(t) for t in times_us]
+        prices = [float(p) for p in prices]
+        return [backtest.replay(times_us, prices) for backtest in self._backtests]
+    
+    def replay_store(self, store, t_from, t_to, time_unit_us=1000, batch_ticks=16384):
+        if time_unit_us <= 0:
+            raise ValueError("Batch size and time unit must be positive")
+        timestamps, prices, _ = store.read(t_from, t_to)
+        origin = int(timestamps[0]) if len(timestamps) else 0
+        times_us = [(int(t) - origin) * time_unit_us for t in timestamps]
+        return self.replay(times_us, prices, batch_ticks)
+    
+    def __len__(self):
+        return len(self._backtests)
+    
+    def threads(self):
+        return self._threads
+
+
+def monotonic_ns():
+    import time
+    return time.perf_counter_ns()
+
+
+def render_prometheus():
+    """No engine metrics without the C++ module"""
+    return ""
+
+
+def reset_metric_counters():
+    pass
+
+
+def allocation_counters():
+    """No allocation tracking without the C++ module"""
+    return {"allocations": 0, "deallocations": 0, "bytes": 0}
+
+
+def sma_batch(prices, window):
+    """Rolling SMA over a whole price series"""
+    return indicator_bank(prices, [window])[0]
+
+
+def indicator_bank(prices, windows):
+    """Several rolling SMAs over the same series, shape (len(windows), len(prices))"""
+    prices = np.asarray(prices, dtype=np.float64)
+    if prices.ndim != 1:
+        raise ValueError("prices must be one-dimensional")
+    prefix = np.concatenate(([0.0], np.cumsum(prices)))
+    count = np.arange(1, len(prices) + 1)
+    out = np.empty((len(windows), len(prices)))
+    for j, window in enumerate(windows):
+        if window <= 0:
+            raise ValueError("Window size must be greater than 0")
+        start = np.maximum(count - window, 0)
+        out[j] = (prefix[count] - prefix[start]) / (count - start)
+    return out
+
+
+def cumulative_depth(prices, quantities):
+    """Cumulative quantity and notional along one side of the book"""
+    prices = np.asarray(prices, dtype=np.float64)
+    quantities = np.asarray(quantities, dtype=np.float64)
+    if prices.shape != quantities.shape:
+        raise ValueError("prices and quantities must have the same length")
+    return np.cumsum(quantities), np.cumsum(prices * quantities)
+
+
+def _mix64(z):
+    z = z ^ (z >> np.uint64(30))
+    z = z * np.uint64(0xBF58476D1CE4E5B9)
+    z = z ^ (z >> np.uint64(27))
+    z = z * np.uint64(0x94D049BB133111EB)
+    return z ^ (z >> np.uint64(31))
+
+
+def gaussian_normals(n, seed=0, offset=0):
+    """Standard normal draws, same counter-based stream as the C++ kernels"""
+    with np.errstate(over="ignore"):
+        key = _mix64(np.uint64(seed) ^ np.uint64(0x5DEECE66D))
+        index = (np.uint64(offset) + np.arange(n, dtype=np.uint64)) * np.uint64(2)
+        golden = np.uint64(0x9E3779B97F4A7C15)
+        h1 = _mix64(key + (index + np.uint64(1)) * golden)
+        h2 = _mix64(key + (index + np.uint64(2)) * golden)
+    u1 = 1.0 - (h1 >> np.uint64(12)).astype(np.float64) / 2.0**52
+    u2 = (h2 >> np.uint64(12)).astype(np.float64) / 2.0**52
+    return np.sqrt(-2.0 * np.log(u1)) * np.cos(2.0 * np.pi * u2)
+
+
+def gbm_path(s0, drift, volatility, dt, n, seed=0):
+    """Geometric Brownian motion path driven by gaussian_normals"""
+    z = gaussian_normals(n, seed)
+    steps = (drift - 0.5 * volatility * volatility) * dt + volatility * np.sqrt(dt) * z
+    return s0 * np.exp(np.cumsum(steps))
+
+
+def simd_path():
+    return SIMD_PATH
+
+
+def set_simd_path(name):
+    if name != SIMD_PATH:
+        raise ValueError(f"SIMD path not supported here: {name}")
+
+
+LATENCY_STATS_ENABLED = False
+ALLOC_TRACKING_ENABLED = False
+SIMD_PATH = "python"
+SIMD_PATHS_SUPPORTED = ["python"]
 
 
 __version__ = "1.0.0 (Python Fallback)"
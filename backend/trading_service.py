@@ -3,9 +3,10 @@ Trading service integrating C++ engine with Python backend
 Manages SMA calculations and order book state
 """
 
+import os
 import time
 import sys
-from typing import Dict, List, Tuple, Optional
+from typing import Dict, List, Optional
 
 # Import the C++ trading engine (or Python fallback)
 try:
@@ -23,20 +24,51 @@ class TradingService:
     Integrates C++ SMACalculator and OrderBook with Python backend
     """
     
-    def __init__(self, sma_window: int = 20):
+    def __init__(self, sma_window: int = 20, tick_store_dir: Optional[str] = None,
+                 history_capacity: int = 100_000, matching: Optional[str] = None,
+                 trade_price: Optional[str] = None):
         """
         Initialize trading service
         
         Args:
             sma_window: Window size for Simple Moving Average calculation
+            tick_store_dir: Directory for the persistent price/trade history
+                            (default: $TICK_STORE_DIR; in memory if unset)
+            history_capacity: Recent (timestamp, price) samples kept in memory
+            matching: "fifo", "pro_rata" or "top_order_pro_rata"
+                      (default: $MATCHING_POLICY, else "fifo")
+            trade_price: "ask", "passive" or "midpoint"
+                         (default: $TRADE_PRICE_RULE, else "ask")
         """
-        # Initialize C++ components
+        # Initialize C++ components; the book is the pre-instantiated
+        # C++ class for the venue's matching rules
+        self.sma_window = sma_window
         self.sma_calculator = trade_engine.SMACalculator(sma_window)
-        self.order_book = trade_engine.OrderBook()
+        self.matching = matching or os.environ.get("MATCHING_POLICY", "fifo")
+        self.trade_price = trade_price or os.environ.get("TRADE_PRICE_RULE", "ask")
+        self.order_book = trade_engine.make_order_book(self.matching, self.trade_price)
         
-        # Track recent prices for UI
-        self.price_history: List[Tuple[float, float]] = []  # (timestamp, price)
-        self.max_history = 100
+        # End-to-end tick pipeline latency (generate -> process -> serialize -> fan-out)
+        self.pipeline_stats = trade_engine.PipelineStats()
+        
+        # Recent prices in a fixed C++ ring, fed by the SMA update
+        self.price_history = trade_engine.PriceHistory(history_capacity)
+        
+        # Compressed full history in C++ (millisecond timestamps)
+        tick_store_dir = tick_store_dir or os.environ.get("TICK_STORE_DIR")
+        prices_path = trades_path = ""
+        if tick_store_dir:
+            os.makedirs(tick_store_dir, exist_ok=True)
+            prices_path = os.path.join(tick_store_dir, "prices.ticks")
+            trades_path = os.path.join(tick_store_dir, "trades.ticks")
+        self.price_store = trade_engine.TickStore(prices_path)
+        self.trade_store = trade_engine.TickStore(trades_path)
+        self._last_tick_ms = 0
+        
+        # Frequent batch auction: clear interval (seconds) and next clear time
+        self._batch_interval = 0.0
+        self._batch_allocation = trade_engine.BatchAllocation.PRO_RATA
+        self._next_batch = 0.0
         
     def process_price(self, price: float) -> Dict:
         """
@@ -48,20 +80,32 @@ class TradingService:
         Returns:
             dict: Market data including price, SMA, and order book
         """
-        # Add price to C++ SMA calculator
-        self.sma_calculator.add_price(price)
+        # Add price to C++ SMA calculator and the history ring in one call
+        timestamp = time.time()
+        self.sma_calculator.add_price(price, timestamp, self.price_history)
         current_sma = self.sma_calculator.get_sma()
         
-        # Store in history
-        timestamp = time.time()
-        self.price_history.append((timestamp, price))
+        # Expire good-till-time orders on the engine clock
+        self.order_book.advance_time(int(timestamp * 1000))
         
-        # Trim history if too long
-        if len(self.price_history) > self.max_history:
-            self.price_history = self.price_history[-self.max_history:]
+        # Match any pending orders (in batch mode: clear the batch once it is due)
+        if self.order_book.mode() == trade_engine.TradingMode.BATCH:
+            trades = []
+            if timestamp >= self._next_batch:
+                trades = self._clear_batch(timestamp)["trades"]
+        else:
+            trades = self._trade_dicts(self.order_book.match_orders())
         
-        # Match any pending orders
-        trades = self.order_book.match_orders()
+        # Then let the new price fire any stops it reaches; the tick also
+        # expires good-for-ticks orders
+        trades += self._trade_dicts(self.order_book.process_tick(price))
+        expired = self.order_book.take_expired()
+        
+        # Record to the tick stores (clamped so a wall-clock step back
+        # cannot break the non-decreasing timestamp order)
+        self._last_tick_ms = max(self._last_tick_ms, int(timestamp * 1000))
+        self.price_store.append(self._last_tick_ms, price)
+        self._record_trades(trades)
         
         # Get current order book state
         bids = self.order_book.get_bids()
@@ -75,26 +119,160 @@ class TradingService:
                 "bids": [[float(p), float(q)] for p, q in bids],
                 "asks": [[float(p), float(q)] for p, q in asks]
             },
-            "trades": [
+            "trades": trades,
+            "expired": [
                 {
-                    "buy_order_id": t.buy_order_id,
-                    "sell_order_id": t.sell_order_id,
-                    "price": t.price,
-                    "quantity": t.quantity,
-                    "timestamp": t.timestamp
+                    "order_id": e.order_id,
+                    "side": "buy" if e.side == trade_engine.OrderSide.BUY else "sell",
+                    "price": e.price,
+                    "quantity": e.quantity,
+                    "timestamp": e.timestamp
                 }
-                for t in trades
+                for e in expired
             ]
         }
     
-    def add_order(self, side: str, price: float, quantity: float) -> Dict:
+    @staticmethod
+    def _trade_dicts(trades) -> List[Dict]:
+        """Convert engine Trades to JSON-ready dicts"""
+        return [
+            {
+                "buy_order_id": t.buy_order_id,
+                "sell_order_id": t.sell_order_id,
+                "price": t.price,
+                "quantity": t.quantity,
+                "timestamp": t.timestamp
+            }
+            for t in trades
+        ]
+    
+    def _record_trades(self, trades: List[Dict]) -> None:
+        """Append executed trades (as dicts) to the trade tick store"""
+        for t in trades:
+            self._last_tick_ms = max(self._last_tick_ms, t["timestamp"])
+            self.trade_store.append(self._last_tick_ms, t["price"], t["quantity"])
+    
+    def start_auction(self) -> Dict:
+        """
+        Stop continuous matching so orders accumulate for a call auction
+        
+        Returns:
+            dict: The auction state (see get_auction_state)
+        """
+        self.order_book.set_mode(trade_engine.TradingMode.AUCTION)
+        return self.get_auction_state()
+    
+    def get_auction_state(self) -> Dict:
+        """
+        Get the matching mode and the indicative uncross price and volume
+        
+        Returns:
+            dict: mode ("auction" or "continuous"), price, volume, buy_surplus
+                  (< 0: sell surplus) and the number of crossing price levels
+        """
+        mode = self.order_book.mode()
+        if mode == trade_engine.TradingMode.BATCH:
+            return {
+                "mode": "batch",
+                "interval_ms": self._batch_interval * 1000,
+                "pending_orders": self.order_book.pending_orders()
+            }
+        return {
+            "mode": "auction" if mode == trade_engine.TradingMode.AUCTION else "continuous",
+            **self.order_book.indicative_auction(self._reference_price())
+        }
+    
+    def uncross_auction(self) -> Dict:
+        """
+        Execute the auction at its equilibrium price and resume continuous matching
+        
+        Returns:
+            dict: Uncross price, volume, buy_surplus and the executed trades
+        """
+        # Continuous first, so stops the auction price reaches fire with it
+        self.order_book.set_mode(trade_engine.TradingMode.CONTINUOUS)
+        result = self.order_book.uncross(self._reference_price())
+        result["trades"] = self._trade_dicts(result["trades"])
+        self._record_trades(result["trades"])
+        return result
+    
+    def start_batch(self, interval_ms: float, allocation: str = "pro_rata") -> Dict:
+        """
+        Switch to frequent batch auctions: orders wait, then clear together
+        
+        Args:
+            interval_ms: Time between clears; a due batch clears on the next price tick
+            allocation: "pro_rata" or "time" for the marginal price level
+            
+        Returns:
+            dict: The batch state (see get_auction_state)
+        """
+        self._batch_interval = interval_ms / 1000.0
+        self._batch_allocation = (trade_engine.BatchAllocation.TIME if allocation == "time"
+                                  else trade_engine.BatchAllocation.PRO_RATA)
+        self._next_batch = time.time() + self._batch_interval
+        self.order_book.set_mode(trade_engine.TradingMode.BATCH)
+        return self.get_auction_state()
+    
+    def stop_batch(self) -> Dict:
+        """
+        Clear the last batch and resume continuous matching
+        
+        Returns:
+            dict: Clearing price, volume, buy_surplus and the executed trades
+        """
+        result = self._clear_batch(time.time())
+        self.order_book.set_mode(trade_engine.TradingMode.CONTINUOUS)
+        self._record_trades(result["trades"])
+        return result
+    
+    def _clear_batch(self, now: float) -> Dict:
+        """
+        Clear the waiting batch and schedule the next one
+        
+        The engine hands back numeric fills rather than Trade objects; the
+        trade dicts are built from them here, order IDs from the sequence numbers
+        """
+        self._next_batch = now + self._batch_interval
+        result = self.order_book.clear_batch_fills(self._batch_allocation, self._reference_price())
+        timestamp = int(now * 1000)
+        columns = (result.pop("buy_seq").tolist(), result.pop("sell_seq").tolist(),
+                   result.pop("prices").tolist(), result.pop("quantities").tolist())
+        result["trades"] = [
+            {
+                "buy_order_id": f"ORD{buy}",
+                "sell_order_id": f"ORD{sell}",
+                "price": price,
+                "quantity": quantity,
+                "timestamp": timestamp
+            }
+            for buy, sell, price, quantity in zip(*columns)
+        ]
+        return result
+    
+    def _reference_price(self) -> float:
+        """Last market price, used to break auction price ties (0 if none yet)"""
+        return self.price_history.last()
+    
+    def add_order(self, side: str, price: float, quantity: float,
+                  stop_price: Optional[float] = None,
+                  expire_after_ms: Optional[int] = None,
+                  expire_after_ticks: Optional[int] = None,
+                  display_quantity: Optional[float] = None) -> Dict:
         """
         Add an order to the C++ order book
         
         Args:
             side: "buy" or "sell"
-            price: Order price
+            price: Order price (the limit of a stop-limit order)
             quantity: Order quantity
+            stop_price: Optional trigger price; the order then waits in the
+                engine's stop index until the market price reaches it
+            expire_after_ms: Optional lifetime; the order expires this long
+                from now on the engine clock
+            expire_after_ticks: Optional lifetime in price ticks
+            display_quantity: Optional iceberg tranche; only this much of
+                quantity shows in the book at a time
             
         Returns:
             dict: Order confirmation with order_id and status
@@ -112,13 +290,44 @@ class TradingService:
                     "message": f"Invalid order side: {side}"
                 }
             
+            if stop_price is not None and (expire_after_ms or expire_after_ticks):
+                return {
+                    "order_id": "",
+                    "status": "rejected",
+                    "message": "Stop orders cannot expire"
+                }
+            
+            if display_quantity is not None and (stop_price is not None
+                                                 or expire_after_ms or expire_after_ticks):
+                return {
+                    "order_id": "",
+                    "status": "rejected",
+                    "message": "Iceberg orders cannot be stops or expire"
+                }
+            
             # Add order to C++ order book
-            order_id = self.order_book.add_order(cpp_side, price, quantity)
+            if display_quantity is not None:
+                order_id = self.order_book.add_iceberg_order(cpp_side, price, display_quantity, quantity)
+                message = f"Iceberg order placed, showing {display_quantity} at a time"
+            elif stop_price is not None:
+                order_id = self.order_book.add_stop_order(cpp_side, stop_price, quantity, price)
+                message = f"Stop order placed, triggers at {stop_price}"
+            elif expire_after_ms is not None:
+                expire_ms = int(time.time() * 1000) + expire_after_ms
+                order_id = self.order_book.add_order_good_till(cpp_side, price, quantity, expire_ms)
+                message = f"Order placed, good for {expire_after_ms} ms"
+            elif expire_after_ticks is not None:
+                order_id = self.order_book.add_order_good_for_ticks(cpp_side, price, quantity,
+                                                                    expire_after_ticks)
+                message = f"Order placed, good for {expire_after_ticks} ticks"
+            else:
+                order_id = self.order_book.add_order(cpp_side, price, quantity)
+                message = "Order placed successfully"
             
             return {
                 "order_id": order_id,
                 "status": "pending",
-                "message": "Order placed successfully"
+                "message": message
             }
             
         except Exception as e:
@@ -128,6 +337,155 @@ class TradingService:
                 "message": str(e)
             }
     
+    def run_simulation(self, duration_s: float, order_rate: float = 10.0, seed: int = 0,
+                       volatility: float = 0.0005) -> Dict:
+        """
+        Run a separate simulated session in the C++ discrete-event kernel
+        
+        Simulated time jumps from event to event, so a day of GBM prices
+        and synthetic order flow takes seconds. The live book is untouched.
+        
+        Args:
+            duration_s: Simulated seconds to run
+            order_rate: Synthetic orders per simulated second
+            seed: Random seed; the same seed gives the same session
+            volatility: GBM volatility per square-root simulated second
+            
+        Returns:
+            dict: Event counts, traded volume, final price and SMA, wall time
+                  and the simulated-to-wall-clock speedup
+        """
+        config = trade_engine.SimulationConfig()
+        config.initial_price = self._reference_price() or config.initial_price
+        config.order_rate = order_rate
+        config.seed = seed
+        config.volatility = volatility
+        config.sma_window = self.sma_window
+        simulation = trade_engine.Simulation(config)
+        
+        start = time.perf_counter()
+        simulation.run_until(int(duration_s * 1e6))
+        wall_time = time.perf_counter() - start
+        
+        return {
+            **simulation.stats(),
+            "duration_s": duration_s,
+            "final_price": simulation.price(),
+            "sma": simulation.sma(),
+            "wall_time_s": wall_time,
+            "speedup": duration_s / wall_time if wall_time > 0 else 0.0
+        }
+    
+    def run_backtest(self, fast_window: int, slow_window: int, quantity: float = 0.1,
+                     duration_s: float = 86400.0, order_rate: float = 20.0, seed: int = 0,
+                     latency_us: int = 0) -> Dict:
+        """
+        Backtest the reference SMA-crossover strategy on a simulated session
+        
+        The strategy runs in C++ next to the simulated book, against GBM
+        prices and synthetic liquidity; the live book is untouched.
+        
+        Args:
+            fast_window: Fast SMA window (ticks)
+            slow_window: Slow SMA window (ticks)
+            quantity: Position held long or short
+            duration_s: Simulated seconds to run
+            order_rate: Synthetic orders per simulated second
+            seed: Random seed; the same seed gives the same session
+            latency_us: Order-entry and market-data latency, each way
+            
+        Returns:
+            dict: Strategy orders, fills, position, cash, PnL and drawdown,
+                  crossovers, wall time and speedup
+        """
+        config = trade_engine.BacktestConfig()
+        config.market.initial_price = self._reference_price() or config.market.initial_price
+        config.market.order_rate = order_rate
+        config.market.seed = seed
+        config.market.sma_window = self.sma_window
+        config.order_entry = trade_engine.LatencyModel(trade_engine.LatencyDistribution.FIXED, latency_us)
+        config.market_data = trade_engine.LatencyModel(trade_engine.LatencyDistribution.FIXED, latency_us)
+        strategy = trade_engine.SMACrossoverStrategy(fast_window, slow_window, quantity)
+        backtest = trade_engine.Backtest(strategy, config)
+        
+        start = time.perf_counter()
+        result = backtest.run(int(duration_s * 1e6))
+        wall_time = time.perf_counter() - start
+        
+        return {
+            **result,
+            "crossovers": strategy.crossovers(),
+            "duration_s": duration_s,
+            "wall_time_s": wall_time,
+            "speedup": duration_s / wall_time if wall_time > 0 else 0.0
+        }
+    
+    def read_price_ticks(self, start_ms: Optional[int] = None, end_ms: Optional[int] = None):
+        """
+        Copy recorded prices out of the tick store
+        
+        Call from the thread that processes prices (the store is not
+        thread-safe); the copy can then be replayed on any thread.
+        
+        Returns:
+            tuple: (timestamps in ms, prices) arrays
+        """
+        start_ms = 0 if start_ms is None else start_ms
+        end_ms = self._last_tick_ms + 1 if end_ms is None else end_ms
+        timestamps, prices, _ = self.price_store.read(start_ms, end_ms)
+        return timestamps, prices
+    
+    def sweep_backtest(self, timestamps, prices, fast_windows: List[int], slow_windows: List[int],
+                       quantity: float = 0.1, order_rate: float = 20.0, seed: int = 0,
+                       latency_us: int = 0) -> Dict:
+        """
+        Backtest every fast/slow SMA-crossover pair on recorded prices
+        
+        All variants replay the same ticks in parallel, each against its own
+        simulated book seeded alike, so only the windows differ.
+        
+        Args:
+            timestamps: Tick times in ms (from read_price_ticks)
+            prices: Tick prices
+            fast_windows: Fast SMA windows (ticks)
+            slow_windows: Slow SMA windows; pairs with fast >= slow are skipped
+            quantity: Position held long or short
+            order_rate: Synthetic orders per simulated second
+            seed: Random seed of the synthetic liquidity
+            latency_us: Order-entry and market-data latency, each way
+            
+        Returns:
+            dict: Tick count, wall time, and one result per pair, best PnL first
+        """
+        pairs = [(f, s) for f in fast_windows for s in slow_windows if 0 < f < s]
+        config = trade_engine.BacktestConfig()
+        config.market.order_rate = order_rate
+        config.market.seed = seed
+        config.market.sma_window = self.sma_window
+        config.order_entry = trade_engine.LatencyModel(trade_engine.LatencyDistribution.FIXED, latency_us)
+        config.market_data = trade_engine.LatencyModel(trade_engine.LatencyDistribution.FIXED, latency_us)
+        
+        parallel = trade_engine.ParallelBacktest()
+        strategies = [trade_engine.SMACrossoverStrategy(f, s, quantity) for f, s in pairs]
+        for strategy in strategies:
+            parallel.add(strategy, config)
+        origin = int(timestamps[0]) if len(timestamps) else 0
+        times_us = [(int(t) - origin) * 1000 for t in timestamps]
+        
+        start = time.perf_counter()
+        results = parallel.replay(times_us, prices)
+        wall_time = time.perf_counter() - start
+        
+        runs = [{"fast_window": f, "slow_window": s, "crossovers": strategy.crossovers(), **result}
+                for (f, s), strategy, result in zip(pairs, strategies, results)]
+        runs.sort(key=lambda run: run["pnl"], reverse=True)
+        return {
+            "ticks": len(times_us),
+            "threads": parallel.threads(),
+            "wall_time_s": wall_time,
+            "runs": runs
+        }
+    
     def get_order_book_snapshot(self) -> Dict:
         """
         Get current order book state
@@ -145,6 +503,136 @@ class TradingService:
             "best_ask": float(self.order_book.get_best_ask())
         }
     
+    def get_latency_stats(self) -> Dict:
+        """
+        Get C++ order book latency percentiles
+        
+        Returns:
+            dict: Per-operation (add, match, cancel, snapshot) count and
+                  p50/p90/p99/p99.9 latency in nanoseconds
+        """
+        return {
+            "enabled": bool(getattr(trade_engine, "LATENCY_STATS_ENABLED", False)),
+            "operations": self.order_book.get_latency_stats()
+        }
+    
+    def record_tick_pipeline(self, stamps: List[int]):
+        """
+        Record one tick's stage-boundary timestamps
+        
+        Args:
+            stamps: time.perf_counter_ns() values taken before generation and
+                    after generation, processing, serialization and fan-out
+        """
+        self.pipeline_stats.record_tick(*stamps)
+    
+    def get_pipeline_report(self, budget_s: Optional[float] = None) -> Dict:
+        """
+        Get per-stage tick pipeline latency and which stage dominates
+        
+        Args:
+            budget_s: Tick interval in seconds, to report budget utilisation
+            
+        Returns:
+            dict: Per-stage percentiles and share of the total, the slowest
+                  stage, and (with a budget) p99 total as a fraction of it
+        """
+        report = self.pipeline_stats.get_report()
+        stages = {k: v for k, v in report["stages"].items() if k != "total"}
+        if report["ticks"]:
+            report["dominant_stage"] = max(stages, key=lambda k: stages[k]["share"])
+        if budget_s and "p99_ns" in report["stages"]["total"]:
+            report["budget_ns"] = int(budget_s * 1e9)
+            report["p99_budget_used"] = report["stages"]["total"]["p99_ns"] / report["budget_ns"]
+        return report
+    
+    def get_memory_stats(self) -> Dict:
+        """
+        Get C++ engine memory usage
+        
+        Returns:
+            dict: Order book byte breakdown and high-water marks, plus the
+                  SMA calculator and price history footprints
+        """
+        return {
+            "order_book": self.order_book.memory_stats(),
+            "sma_calculator_bytes": self.sma_calculator.memory_bytes(),
+            "price_history_bytes": self.price_history.memory_bytes()
+        }
+    
+    @property
+    def simd_path(self) -> str:
+        """SIMD variant the C++ batch kernels are using ("python" on the fallback)"""
+        return trade_engine.simd_path()
+    
+    def get_indicators(self, windows: List[int]) -> Dict:
+        """
+        Recompute several SMAs over the recent price history in one batch
+        
+        Args:
+            windows: SMA window sizes
+            
+        Returns:
+            dict: SIMD path used and, per window, the SMA after each price
+        """
+        # Zero-copy view of the ring, oldest first
+        prices = self.price_history.prices()
+        bank = trade_engine.indicator_bank(prices, windows)
+        return {
+            "simd_path": self.simd_path,
+            "sma": {str(w): [float(v) for v in row] for w, row in zip(windows, bank)}
+        }
+    
+    def get_price_history(self, start_ms: Optional[int] = None, end_ms: Optional[int] = None,
+                          points: int = 500, method: str = "minmax") -> Dict:
+        """
+        Get stored prices for a time range, downsampled for charting
+        
+        Args:
+            start_ms: Range start in epoch milliseconds (default: all history)
+            end_ms: Range end in epoch milliseconds, exclusive (default: now)
+            points: Maximum points to return (e.g. the chart width)
+            method: "minmax" (keeps every bucket's extremes) or "lttb"
+            
+        Returns:
+            dict: timestamps (ms) and prices, plus the method and tick count
+        """
+        start_ms = 0 if start_ms is None else start_ms
+        end_ms = self._last_tick_ms + 1 if end_ms is None else end_ms
+        timestamps, prices = self.price_store.downsample(start_ms, end_ms, points, method)
+        return {
+            "method": method,
+            "total_ticks": len(self.price_store),
+            "timestamps": timestamps.tolist(),
+            "prices": prices.tolist()
+        }
+    
+    def get_tick_store_stats(self) -> Dict:
+        """
+        Get the size of the stored price and trade history
+        
+        Returns:
+            dict: Per store (prices, trades) tick, block and byte counts
+        """
+        return {
+            "prices": self.price_store.stats(),
+            "trades": self.trade_store.stats()
+        }
+    
+    def flush_history(self):
+        """Write buffered history to disk (called on shutdown)"""
+        self.price_store.flush()
+        self.trade_store.flush()
+    
+    def get_prometheus_metrics(self) -> str:
+        """
+        Get engine counters and gauges in Prometheus text format
+        
+        Returns:
+            str: Exposition text from the C++ engine (empty on the fallback)
+        """
+        return trade_engine.render_prometheus()
+    
     def reset(self):
         """Reset all trading state"""
         self.sma_calculator.reset()
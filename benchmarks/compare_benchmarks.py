@@ -0,0 +1,74 @@
+"""
+Compare two Google Benchmark JSON runs of bench_engine
+Flags benchmarks whose time regressed beyond a threshold
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    """Load benchmark results keyed by name (aggregates are skipped)"""
+    with open(path) as f:
+        data = json.load(f)
+
+    results = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("run_type") == "aggregate":
+            continue
+        results[bench["name"]] = bench
+    return results
+
+
+def compare(baseline, candidate, threshold, metric):
+    """Print a comparison table and return the list of regressed benchmarks"""
+    regressions = []
+
+    print(f"{'Benchmark':<40} | {'Baseline':>12} | {'Candidate':>12} | {'Change':>8}")
+    print("-" * 82)
+
+    for name, base in baseline.items():
+        if name not in candidate:
+            continue
+        old = base[metric]
+        new = candidate[name][metric]
+        change = (new - old) / old if old else 0.0
+        unit = base.get("time_unit", "ns")
+
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+
+        print(f"{name:<40} | {old:>10.1f}{unit:>2} | {new:>10.1f}{unit:>2} | {change:>+7.1%}{flag}")
+
+    missing = sorted(set(baseline) - set(candidate))
+    if missing:
+        print(f"\nMissing from candidate: {', '.join(missing)}")
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline", help="Baseline bench_engine JSON output")
+    parser.add_argument("candidate", help="Candidate bench_engine JSON output")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="Relative slowdown that counts as a regression (default: 0.10)")
+    parser.add_argument("--metric", default="cpu_time", choices=["cpu_time", "real_time"],
+                        help="Timing field to compare (default: cpu_time)")
+    args = parser.parse_args()
+
+    regressions = compare(load_results(args.baseline), load_results(args.candidate),
+                          args.threshold, args.metric)
+
+    if regressions:
+        print(f"\n✗ {len(regressions)} benchmark(s) regressed by more than {args.threshold:.0%}")
+        sys.exit(1)
+
+    print("\n✓ No regressions detected")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,641 @@
+/**
+ * Native micro-benchmarks for the C++ trading engine (Google Benchmark)
+ *
+ * Measures OrderBook and SMACalculator directly, without pybind11 overhead.
+ * Emit JSON for run-to-run comparison with:
+ *
+ *   ./bench_engine --benchmark_out=bench_engine.json --benchmark_out_format=json
+ *   python benchmarks/compare_benchmarks.py baseline.json bench_engine.json
+ *
+ * Hardware counters (cycles, instructions, cache/TLB/branch misses) are
+ * reported per iteration next to the timings when perf_event_open is
+ * available; see perf_counters.hpp.
+ */
+
+#include "engine.hpp"
+#include "kernels.hpp"
+#include "perf_counters.hpp"
+#include "simulation.hpp"
+#include "strategy.hpp"
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace trading;
+
+namespace {
+
+constexpr double kBasePrice = 45000.0;
+constexpr double kTickSize = 0.5;
+
+/**
+ * @brief Fill a book with `levels` price levels per side, one order each
+ *
+ * Bids sit below kBasePrice and asks above it, so the book never crosses.
+ */
+void populateBook(OrderBook& book, int levels) {
+    for (int i = 0; i < levels; ++i) {
+        book.addOrder(OrderSide::BUY, kBasePrice - kTickSize * (i + 1), 1.0);
+        book.addOrder(OrderSide::SELL, kBasePrice + kTickSize * (i + 1), 1.0);
+    }
+}
+
+/**
+ * @brief Pre-generated random prices so RNG cost stays out of the timed loop
+ */
+std::vector<double> randomPrices(size_t count, int levels, unsigned seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> level(1, levels);
+    std::vector<double> prices(count);
+    for (auto& p : prices) {
+        p = kBasePrice - kTickSize * level(rng);
+    }
+    return prices;
+}
+
+/**
+ * @brief Counts hardware events for the lifetime of a benchmark loop
+ *
+ * Results are attached to the benchmark as per-iteration counters, plus IPC.
+ * Call pause()/resume() alongside state.PauseTiming()/ResumeTiming() so
+ * setup work is excluded from the counts as well as from the timings.
+ */
+class PerfScope {
+public:
+    explicit PerfScope(benchmark::State& state) : state_(state) {
+        counters_.start();
+    }
+
+    ~PerfScope() {
+        auto sample = counters_.stop();
+        if (!counters_.available()) {
+            static bool warned = false;
+            if (!warned) {
+                std::cerr << "Hardware counters unavailable: "
+                          << counters_.unavailableReason() << "\n";
+                warned = true;
+            }
+            return;
+        }
+
+        using E = trading::bench::PerfCounters;
+        for (int e = 0; e < E::kEventCount; ++e) {
+            auto event = static_cast<E::Event>(e);
+            if (sample.has(event)) {
+                state_.counters[E::name(event)] =
+                    benchmark::Counter(sample[event], benchmark::Counter::kAvgIterations);
+            }
+        }
+        if (sample.has(E::CYCLES) && sample.has(E::INSTRUCTIONS) && sample[E::CYCLES] > 0) {
+            state_.counters["ipc"] = sample[E::INSTRUCTIONS] / sample[E::CYCLES];
+        }
+    }
+
+    void pause() { counters_.pause(); }
+    void resume() { counters_.resume(); }
+
+private:
+    benchmark::State& state_;
+    trading::bench::PerfCounters counters_;
+};
+
+} // namespace
+
+// ==================== OrderBook Benchmarks ====================
+
+// Resting (non-crossing) bids spread over `range(0)` price levels.
+// The book is reset every batch so it does not grow without bound.
+static void BM_AddOrder(benchmark::State& state) {
+    const int levels = static_cast<int>(state.range(0));
+    constexpr size_t kBatch = 4096;
+    const auto prices = randomPrices(kBatch, levels);
+
+    OrderBook book;
+    size_t i = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.addOrder(OrderSide::BUY, prices[i], 1.0));
+        if (++i == kBatch) {
+            state.PauseTiming();
+            perf.pause();
+            book.reset();
+            i = 0;
+            perf.resume();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AddOrder)->RangeMultiplier(10)->Range(1, 10000);
+
+// One aggressive buy sweeping `range(0)` ask levels (one trade per level).
+static void BM_MatchOrdersSweep(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        OrderBook book;
+        for (int i = 0; i < depth; ++i) {
+            book.addOrder(OrderSide::SELL, kBasePrice + kTickSize * i, 1.0);
+        }
+        book.addOrder(OrderSide::BUY, kBasePrice + kTickSize * depth, depth);
+        perf.resume();
+        state.ResumeTiming();
+
+        auto trades = book.matchOrders();
+        benchmark::DoNotOptimize(trades.data());
+
+        state.PauseTiming();
+        perf.pause();
+        trades.clear();
+        book.reset();
+        perf.resume();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK(BM_MatchOrdersSweep)->RangeMultiplier(4)->Range(1, 1024);
+
+// matchOrders on a deep but uncrossed book: the common per-tick case.
+static void BM_MatchOrdersNoCross(benchmark::State& state) {
+    OrderBook book;
+    populateBook(book, static_cast<int>(state.range(0)));
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        auto trades = book.matchOrders();
+        benchmark::DoNotOptimize(trades.data());
+    }
+}
+BENCHMARK(BM_MatchOrdersNoCross)->RangeMultiplier(10)->Range(10, 10000);
+
+// One aggressive buy taking half of a `range(0)`-order ask level, per
+// matching policy: FIFO fills a prefix, pro rata touches every order.
+template <typename Book>
+static void BM_MatchLevel(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+
+    PerfScope perf(state);
+    std::vector<Trade> trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        Book book;
+        for (int i = 0; i < depth; ++i) {
+            book.addOrder(OrderSide::SELL, kBasePrice, 1.0 + i % 4);
+        }
+        book.addOrder(OrderSide::BUY, kBasePrice, 1.25 * depth);
+        perf.resume();
+        state.ResumeTiming();
+
+        book.matchOrders(trades);
+        benchmark::DoNotOptimize(trades.data());
+    }
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK_TEMPLATE(BM_MatchLevel, OrderBook)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_MatchLevel, ProRataOrderBook)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_MatchLevel, TopOrderProRataOrderBook)->RangeMultiplier(8)->Range(8, 4096);
+
+// ==================== Stop Order Benchmarks ====================
+
+// A tick that fires one stop while range(0) others wait on both sides;
+// the fired stop is replaced each iteration so the index stays the same size
+static void BM_StopTrigger(benchmark::State& state) {
+    const int waiting = static_cast<int>(state.range(0));
+    OrderBook book;
+    for (int i = 0; i < waiting / 2; ++i) {
+        book.addStopOrder(OrderSide::BUY, kBasePrice + kTickSize * (2 + i % 1000), 1.0);
+        book.addStopOrder(OrderSide::SELL, kBasePrice - kTickSize * (2 + i % 1000), 1.0);
+    }
+    book.addOrder(OrderSide::SELL, kBasePrice + kTickSize, 1e12);
+
+    std::vector<Trade> trades;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        book.addStopOrder(OrderSide::BUY, kBasePrice + kTickSize, 1.0);
+        book.processTick(kBasePrice + kTickSize, trades);
+        benchmark::DoNotOptimize(trades.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StopTrigger)->RangeMultiplier(10)->Range(100, 1000000);
+
+// ==================== Good-Till Order Benchmarks ====================
+
+// Bot quoting: each millisecond places range(0) quotes that live 1-500 ms,
+// then advances the clock; about 250 * range(0) quotes are resting
+static void BM_QuoteExpiry(benchmark::State& state) {
+    const int quotes = static_cast<int>(state.range(0));
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> life(1, 500);
+    std::uniform_int_distribution<int> level(1, 50);
+
+    OrderBook book;
+    long long now = 1717200000000;
+    book.advanceTime(now);
+    std::vector<ExpiredOrder> expired;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        for (int i = 0; i < quotes; ++i) {
+            const bool buy = i % 2 == 0;
+            const double price = kBasePrice + (buy ? -kTickSize : kTickSize) * level(rng);
+            book.addOrderGoodTill(buy ? OrderSide::BUY : OrderSide::SELL, price, 1.0, now + life(rng));
+        }
+        book.advanceTime(++now);
+        book.takeExpired(expired);
+        benchmark::DoNotOptimize(expired.data());
+    }
+    state.SetItemsProcessed(state.iterations() * quotes);
+}
+BENCHMARK(BM_QuoteExpiry)->Arg(10)->Arg(100)->Arg(1000);
+
+// ==================== Iceberg Order Benchmarks ====================
+
+// The best ask is range(0) icebergs showing one lot each out of a deep
+// reserve; every buy fills ten tranches, each refilled and re-queued
+static void BM_IcebergReplenish(benchmark::State& state) {
+    const int icebergs = static_cast<int>(state.range(0));
+    OrderBook book;
+    for (int i = 0; i < icebergs; ++i) {
+        book.addIcebergOrder(OrderSide::SELL, kBasePrice, 1.0, 1e12);
+    }
+
+    std::vector<Trade> trades;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        book.addOrder(OrderSide::BUY, kBasePrice, 10.0);
+        book.matchOrders(trades);
+        benchmark::DoNotOptimize(trades.data());
+    }
+    state.SetItemsProcessed(state.iterations() * 10);
+}
+BENCHMARK(BM_IcebergReplenish)->Arg(1)->Arg(10)->Arg(1000);
+
+// ==================== Simulation Benchmarks ====================
+
+// One simulated hour per iteration: a GBM step every 500 ms and range(0)
+// synthetic orders per simulated second, each living five seconds
+static void BM_SimulatedHour(benchmark::State& state) {
+    SimulationConfig config;
+    config.order_rate = static_cast<double>(state.range(0));
+    uint64_t events = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        config.seed++;
+        Simulation sim(config);
+        sim.runUntil(3600LL * 1000000);
+        events += sim.stats().events;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+}
+BENCHMARK(BM_SimulatedHour)->Arg(0)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
+// The same hour at 100 orders per second with a participant that, on
+// every price it sees, re-quotes a bid one spread below it through 50 us
+// order entry and exponential market-data latency, its queue position
+// tracked throughout; compare with BM_SimulatedHour/100
+static void BM_SimulatedHourWithParticipant(benchmark::State& state) {
+    SimulationConfig config;
+    config.order_rate = 100.0;
+    uint64_t events = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        config.seed++;
+        Simulation sim(config);
+        const size_t trader = sim.addParticipant({LatencyDistribution::FIXED, 50, 0.0},
+                                                 {LatencyDistribution::EXPONENTIAL, 100, 200.0});
+        uint64_t quote = 0;
+        sim.setPriceHandler(trader, [&quote, trader](Simulation& s, double price, long long) {
+            if (quote != 0) {
+                s.submitCancel(trader, quote);
+            }
+            quote = s.submitOrder(trader, OrderSide::BUY, std::round(price * 0.999 * 100.0) / 100.0, 0.5);
+        });
+        sim.runUntil(3600LL * 1000000);
+        events += sim.stats().events;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+}
+BENCHMARK(BM_SimulatedHourWithParticipant)->Unit(benchmark::kMillisecond);
+
+// A participant order joining the back of a level range(0) orders deep:
+// its queue position takes no scan of the level, however deep. The cancel
+// that keeps the depth steady is not timed, as the book's own cancel scans
+// the level; what it evicts from cache still shows at the deepest levels.
+static void BM_QueueAheadDeepLevel(benchmark::State& state) {
+    SimulationConfig config;
+    config.price_interval_us = 0;
+    config.order_rate = 0.0;
+    Simulation sim(config);
+    const size_t trader = sim.addParticipant();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        sim.scheduleOrder(0, OrderSide::BUY, kBasePrice, 1.0);
+    }
+    sim.runUntil(0);
+
+    PerfScope perf(state);
+    long long now = 0;
+    for (auto _ : state) {
+        const uint64_t quote = sim.submitOrder(trader, OrderSide::BUY, kBasePrice, 1.0);
+        sim.runUntil(++now);
+        benchmark::DoNotOptimize(sim.queueAhead(quote));
+
+        state.PauseTiming();
+        perf.pause();
+        sim.submitCancel(trader, quote);
+        sim.runUntil(++now);
+        perf.resume();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueueAheadDeepLevel)->Arg(10)->Arg(1000)->Arg(100000);
+
+// ==================== Backtest Benchmarks ====================
+
+// A simulated hour of 500 ms GBM ticks replayed through the reference SMA
+// crossover (20/100) against 20 synthetic orders per second; items are ticks
+static void BM_BacktestSMACrossover(benchmark::State& state) {
+    const size_t ticks = 7200;
+    const std::vector<double> prices = kernels::gbmPath(kBasePrice, 0.0, 0.0005, 0.5, 42, ticks);
+    std::vector<long long> times(ticks);
+    for (size_t i = 0; i < ticks; ++i) {
+        times[i] = static_cast<long long>(i + 1) * 500000;
+    }
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        SMACrossoverStrategy strategy(20, 100, 0.1);
+        Backtest backtest(strategy);
+        const BacktestResult result = backtest.replay(times.data(), prices.data(), ticks);
+        benchmark::DoNotOptimize(result.pnl);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ticks));
+}
+BENCHMARK(BM_BacktestSMACrossover)->Unit(benchmark::kMillisecond);
+
+// A 16-variant SMA window sweep over ten minutes of ticks on range(0)
+// workers; items are strategy-ticks, so per-item time should fall with
+// the thread count up to the cores available
+static void BM_ParallelBacktest(benchmark::State& state) {
+    const size_t ticks = 1200;
+    const size_t variants = 16;
+    const std::vector<double> prices = kernels::gbmPath(kBasePrice, 0.0, 0.0005, 0.5, 42, ticks);
+    std::vector<long long> times(ticks);
+    for (size_t i = 0; i < ticks; ++i) {
+        times[i] = static_cast<long long>(i + 1) * 500000;
+    }
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<SMACrossoverStrategy>> strategies;
+        ParallelBacktest parallel(static_cast<size_t>(state.range(0)));
+        for (size_t i = 0; i < variants; ++i) {
+            strategies.push_back(std::make_unique<SMACrossoverStrategy>(5 + i, 40 + 4 * i, 0.1));
+            parallel.add(*strategies.back());
+        }
+        const std::vector<BacktestResult> results = parallel.replay(times.data(), prices.data(), ticks, 256);
+        benchmark::DoNotOptimize(results.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ticks * variants));
+}
+BENCHMARK(BM_ParallelBacktest)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// ==================== Call Auction Benchmarks ====================
+
+// Opening-auction uncross of range(0) orders spread over 200 ticks either
+// side of the base price, so most of them cross
+static void BM_AuctionUncross(benchmark::State& state) {
+    const size_t orders = static_cast<size_t>(state.range(0));
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> level(-200, 200);
+    std::uniform_int_distribution<int> lots(1, 10);
+    std::vector<std::pair<double, double>> flow(orders);
+    for (auto& [price, quantity] : flow) {
+        price = kBasePrice + kTickSize * level(rng);
+        quantity = lots(rng);
+    }
+
+    std::vector<Trade> trades;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        OrderBook book;
+        book.setMode(TradingMode::AUCTION);
+        for (size_t i = 0; i < orders; ++i) {
+            book.addOrder(i % 2 ? OrderSide::SELL : OrderSide::BUY, flow[i].first, flow[i].second);
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(book.uncross(trades).volume);
+
+        state.PauseTiming();
+        perf.pause();
+        book.reset();
+        perf.resume();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AuctionUncross)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// One frequent-batch-auction clear of range(0) orders over the same spread;
+// arg 1 selects the marginal-level allocation (0 time, 1 pro rata) and arg 2
+// the output (0 numeric BatchFills, 1 Trades with order ID strings)
+static void BM_BatchClear(benchmark::State& state) {
+    const size_t orders = static_cast<size_t>(state.range(0));
+    const auto allocation = state.range(1) ? BatchAllocation::PRO_RATA : BatchAllocation::TIME;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> level(-200, 200);
+    std::uniform_int_distribution<int> lots(1, 10);
+    std::vector<std::pair<double, double>> flow(orders);
+    for (auto& [price, quantity] : flow) {
+        price = kBasePrice + kTickSize * level(rng);
+        quantity = lots(rng);
+    }
+
+    OrderBook book;
+    std::vector<BatchFill> fills;
+    std::vector<Trade> trades;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        book.reset();
+        book.setMode(TradingMode::BATCH);
+        for (size_t i = 0; i < orders; ++i) {
+            book.addOrder(i % 2 ? OrderSide::SELL : OrderSide::BUY, flow[i].first, flow[i].second);
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        const AuctionResult result = state.range(2)
+            ? book.clearBatch(trades, allocation) : book.clearBatch(fills, allocation);
+        benchmark::DoNotOptimize(result.volume);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BatchClear)
+    ->ArgsProduct({{10000, 100000, 300000, 1000000}, {0, 1}, {0}})
+    ->Args({300000, 1, 1})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_GetBids(benchmark::State& state) {
+    OrderBook book;
+    populateBook(book, static_cast<int>(state.range(0)));
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        auto bids = book.getBids();
+        benchmark::DoNotOptimize(bids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetBids)->RangeMultiplier(10)->Range(10, 10000);
+
+static void BM_GetAsks(benchmark::State& state) {
+    OrderBook book;
+    populateBook(book, static_cast<int>(state.range(0)));
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        auto asks = book.getAsks();
+        benchmark::DoNotOptimize(asks.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetAsks)->RangeMultiplier(10)->Range(10, 10000);
+
+// ==================== SMACalculator Benchmarks ====================
+
+static void BM_SMAAddPrice(benchmark::State& state) {
+    SMACalculator sma(static_cast<size_t>(state.range(0)));
+    const auto prices = randomPrices(1024, 100);
+
+    size_t i = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        sma.addPrice(prices[i++ & 1023]);
+    }
+    benchmark::DoNotOptimize(sma.getSMA());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SMAAddPrice)->Arg(20)->Arg(50)->Arg(100)->Arg(1000);
+
+static void BM_SMAGetSMA(benchmark::State& state) {
+    SMACalculator sma(static_cast<size_t>(state.range(0)));
+    for (double p : randomPrices(static_cast<size_t>(state.range(0)), 100)) {
+        sma.addPrice(p);
+    }
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sma.getSMA());
+    }
+}
+BENCHMARK(BM_SMAGetSMA)->Arg(20)->Arg(50)->Arg(100)->Arg(1000);
+
+static void BM_SMAAddPriceWithHistory(benchmark::State& state) {
+    SMACalculator sma(20);
+    PriceHistory history(static_cast<size_t>(state.range(0)));
+    const auto prices = randomPrices(1024, 100);
+
+    size_t i = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        sma.addPrice(prices[i & 1023], static_cast<double>(i), history);
+        i++;
+    }
+    benchmark::DoNotOptimize(history.prices());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SMAAddPriceWithHistory)->Arg(100)->Arg(100000);
+
+static void BM_PriceHistoryUnwrap(benchmark::State& state) {
+    const size_t capacity = static_cast<size_t>(state.range(0));
+    PriceHistory history(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        history.push(static_cast<double>(i), 100.0);
+    }
+
+    size_t t = capacity;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        // Worst case: a single push since the last unwrap
+        history.push(static_cast<double>(t++), 100.0);
+        history.unwrap();
+    }
+    benchmark::DoNotOptimize(history.timestamps());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PriceHistoryUnwrap)->Arg(100)->Arg(100000);
+
+// ==================== Batch Kernel Benchmarks ====================
+// Arg 0 selects the SIMD path (0 scalar, 1 avx2, 2 avx512); unsupported
+// paths are skipped so the same binary runs on any x86-64 host.
+
+static bool selectPath(benchmark::State& state) {
+    const auto path = static_cast<kernels::SimdPath>(state.range(0));
+    if (!kernels::simdPathSupported(path)) {
+        state.SkipWithError("SIMD path not supported on this CPU");
+        return false;
+    }
+    kernels::setSimdPath(path);
+    state.SetLabel(kernels::simdPathName(path));
+    return true;
+}
+
+static void BM_SMABatch(benchmark::State& state) {
+    if (!selectPath(state)) return;
+    const auto prices = randomPrices(static_cast<size_t>(state.range(1)), 100);
+    std::vector<double> out(prices.size());
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        kernels::smaBatch(prices.data(), prices.size(), 20, out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_SMABatch)->ArgsProduct({{0, 1, 2}, {4096, 1 << 20}});
+
+static void BM_IndicatorBank(benchmark::State& state) {
+    if (!selectPath(state)) return;
+    const auto prices = randomPrices(4096, 100);
+    const size_t windows[] = {5, 20, 50, 200};
+    std::vector<double> out(4 * prices.size());
+
+    PerfScope perf(state);
+    for (auto _ : state) {
+        kernels::indicatorBank(prices.data(), prices.size(), windows, 4, out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * 4 * 4096);
+}
+BENCHMARK(BM_IndicatorBank)->DenseRange(0, 2);
+
+static void BM_GaussianNormals(benchmark::State& state) {
+    if (!selectPath(state)) return;
+    std::vector<double> out(4096);
+
+    uint64_t offset = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        kernels::gaussianNormals(7, offset, out.size(), out.data());
+        offset += out.size();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+BENCHMARK(BM_GaussianNormals)->DenseRange(0, 2);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,270 @@
+/**
+ * Realistic order-book workload benchmark
+ *
+ * Replays a generated or recorded workload against OrderBook and reports
+ * sustained throughput plus a per-operation latency distribution. Hardware
+ * counters for the throughput pass are printed per operation when available,
+ * and heap allocations per operation when built with TRADING_ALLOC_TRACKING.
+ *
+ *   ./bench_workload --ops=2000000 --cancel-ratio=0.6 --burst-probability=0.002
+ *   ./bench_workload --save=workload.csv     # record the generated workload
+ *   ./bench_workload --file=workload.csv     # replay a recorded workload
+ */
+
+#include "alloc_tracking.hpp"
+#include "engine.hpp"
+#include "perf_counters.hpp"
+#include "workload.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace trading;
+using namespace trading::bench;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    WorkloadConfig workload;
+    std::string file;
+    std::string save;
+    int repeat = 3;
+};
+
+void printUsage() {
+    std::cout <<
+        "Usage: bench_workload [options]\n"
+        "  --file=PATH                replay a recorded workload instead of generating one\n"
+        "  --save=PATH                write the workload to PATH before running\n"
+        "  --repeat=N                 throughput passes (default 3, best is reported)\n"
+        "  --ops=N                    generated operations (default 1000000)\n"
+        "  --seed=N                   RNG seed\n"
+        "  --mid-price=X              starting mid price\n"
+        "  --tick-size=X              price tick\n"
+        "  --mid-volatility=X         mid random-walk stddev in ticks per add\n"
+        "  --mean-distance=X          mean price distance from mid, in ticks\n"
+        "  --cross-ratio=X            fraction of adds that cross the spread\n"
+        "  --size-log-mean=X          log-normal order size mu\n"
+        "  --size-log-stddev=X        log-normal order size sigma\n"
+        "  --cancel-ratio=X           fraction of ops that cancel a live order\n"
+        "  --snapshot-ratio=X         fraction of ops that read the book\n"
+        "  --match-every=N            matchOrders after every N adds (0 = never)\n"
+        "  --burst-probability=X      chance an add starts a same-side burst\n"
+        "  --burst-length=N           adds per burst\n";
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    auto& w = opt.workload;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+
+        auto eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos) {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            printUsage();
+            std::exit(1);
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+
+        if (key == "file") opt.file = value;
+        else if (key == "save") opt.save = value;
+        else if (key == "repeat") opt.repeat = std::max(1, std::stoi(value));
+        else if (key == "ops") w.num_ops = std::stoull(value);
+        else if (key == "seed") w.seed = static_cast<unsigned>(std::stoul(value));
+        else if (key == "mid-price") w.mid_price = std::stod(value);
+        else if (key == "tick-size") w.tick_size = std::stod(value);
+        else if (key == "mid-volatility") w.mid_volatility_ticks = std::stod(value);
+        else if (key == "mean-distance") w.mean_distance_ticks = std::stod(value);
+        else if (key == "cross-ratio") w.cross_ratio = std::stod(value);
+        else if (key == "size-log-mean") w.size_log_mean = std::stod(value);
+        else if (key == "size-log-stddev") w.size_log_stddev = std::stod(value);
+        else if (key == "cancel-ratio") w.cancel_ratio = std::stod(value);
+        else if (key == "snapshot-ratio") w.snapshot_ratio = std::stod(value);
+        else if (key == "match-every") w.match_every = std::stoull(value);
+        else if (key == "burst-probability") w.burst_probability = std::stod(value);
+        else if (key == "burst-length") w.burst_length = std::stoull(value);
+        else {
+            std::cerr << "Unknown option: --" << key << "\n";
+            printUsage();
+            std::exit(1);
+        }
+    }
+    return opt;
+}
+
+size_t countAdds(const std::vector<WorkloadOp>& ops) {
+    return std::count_if(ops.begin(), ops.end(),
+                         [](const WorkloadOp& op) { return op.type == OpType::ADD; });
+}
+
+/**
+ * @brief Replay the whole workload untimed per-op; returns elapsed seconds
+ */
+double throughputPass(const std::vector<WorkloadOp>& ops, size_t adds,
+                      PerfCounters& counters, PerfCounters::Sample& sample) {
+    OrderBook book;
+    WorkloadReplayer replayer(book, adds);
+
+    counters.start();
+    auto start = Clock::now();
+    for (const auto& op : ops) {
+        replayer.apply(op);
+    }
+    auto end = Clock::now();
+    sample = counters.stop();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+struct LatencyPassResult {
+    std::array<std::vector<uint64_t>, kOpTypeCount> samples;
+    std::array<alloc::Counters, kOpTypeCount> allocs{};
+};
+
+/**
+ * @brief Replay with a clock read (and allocation count) around every operation
+ */
+LatencyPassResult latencyPass(const std::vector<WorkloadOp>& ops, size_t adds) {
+    LatencyPassResult result;
+    for (auto& s : result.samples) {
+        s.reserve(ops.size());
+    }
+
+    OrderBook book;
+    WorkloadReplayer replayer(book, adds);
+    for (const auto& op : ops) {
+        const size_t t = static_cast<size_t>(op.type);
+        alloc::Scope scope;
+        auto start = Clock::now();
+        replayer.apply(op);
+        auto end = Clock::now();
+        alloc::Counters delta = scope.delta();
+        result.samples[t].push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        result.allocs[t].allocations += delta.allocations;
+        result.allocs[t].bytes += delta.bytes;
+    }
+    return result;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt = parseOptions(argc, argv);
+
+    std::vector<WorkloadOp> ops;
+    try {
+        ops = opt.file.empty() ? generateWorkload(opt.workload) : loadWorkload(opt.file);
+        if (!opt.save.empty()) {
+            saveWorkload(ops, opt.save);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    const size_t adds = countAdds(ops);
+    std::array<size_t, kOpTypeCount> mix{};
+    for (const auto& op : ops) {
+        ++mix[static_cast<size_t>(op.type)];
+    }
+
+    std::cout << "Workload: " << (opt.file.empty() ? "generated" : opt.file)
+              << ", " << ops.size() << " ops (";
+    for (size_t t = 0; t < kOpTypeCount; ++t) {
+        std::cout << (t ? ", " : "") << opTypeName(static_cast<OpType>(t)) << " " << mix[t];
+    }
+    std::cout << ")\n\n";
+
+    // Throughput: best of N untimed passes
+    PerfCounters counters;
+    PerfCounters::Sample best_sample{};
+    double best = 0.0;
+    for (int r = 0; r < opt.repeat; ++r) {
+        PerfCounters::Sample sample;
+        double secs = throughputPass(ops, adds, counters, sample);
+        if (r == 0 || secs < best) {
+            best = secs;
+            best_sample = sample;
+        }
+    }
+    std::printf("Sustained throughput: %.0f ops/sec (%.3f s for %zu ops, best of %d)\n",
+                ops.size() / best, best, ops.size(), opt.repeat);
+
+    if (counters.available()) {
+        std::printf("Hardware counters per op:");
+        for (int e = 0; e < PerfCounters::kEventCount; ++e) {
+            auto event = static_cast<PerfCounters::Event>(e);
+            if (best_sample.has(event)) {
+                std::printf(" %s=%.2f", PerfCounters::name(event),
+                            best_sample[event] / static_cast<double>(ops.size()));
+            }
+        }
+        if (best_sample.has(PerfCounters::CYCLES) && best_sample.has(PerfCounters::INSTRUCTIONS)
+                && best_sample[PerfCounters::CYCLES] > 0) {
+            std::printf(" ipc=%.2f",
+                        best_sample[PerfCounters::INSTRUCTIONS] / best_sample[PerfCounters::CYCLES]);
+        }
+        std::printf("\n\n");
+    } else {
+        std::printf("Hardware counters unavailable: %s\n\n", counters.unavailableReason().c_str());
+    }
+
+    // Latency distribution per operation type
+    auto pass = latencyPass(ops, adds);
+    auto& samples = pass.samples;
+    std::printf("%-10s | %10s | %8s | %8s | %8s | %8s | %8s | %10s\n",
+                "Operation", "Count", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "mean ns", "max ns");
+    std::printf("%s\n", std::string(90, '-').c_str());
+    for (size_t t = 0; t < kOpTypeCount; ++t) {
+        auto& s = samples[t];
+        if (s.empty()) continue;
+        std::sort(s.begin(), s.end());
+        double mean = 0.0;
+        for (uint64_t v : s) mean += static_cast<double>(v);
+        mean /= static_cast<double>(s.size());
+        std::printf("%-10s | %10zu | %8llu | %8llu | %8llu | %8llu | %8.0f | %10llu\n",
+                    opTypeName(static_cast<OpType>(t)), s.size(),
+                    static_cast<unsigned long long>(percentile(s, 50)),
+                    static_cast<unsigned long long>(percentile(s, 90)),
+                    static_cast<unsigned long long>(percentile(s, 99)),
+                    static_cast<unsigned long long>(percentile(s, 99.9)),
+                    mean,
+                    static_cast<unsigned long long>(s.back()));
+    }
+
+    // Includes warm-up growth (first levels, index rehashes, vector doubling)
+    if (alloc::enabled()) {
+        std::printf("\n%-10s | %12s | %12s\n", "Operation", "allocs/op", "bytes/op");
+        std::printf("%s\n", std::string(40, '-').c_str());
+        for (size_t t = 0; t < kOpTypeCount; ++t) {
+            if (samples[t].empty()) continue;
+            double n = static_cast<double>(samples[t].size());
+            std::printf("%-10s | %12.4f | %12.1f\n", opTypeName(static_cast<OpType>(t)),
+                        pass.allocs[t].allocations / n, pass.allocs[t].bytes / n);
+        }
+    }
+
+    return 0;
+}
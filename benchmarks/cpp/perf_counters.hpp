@@ -0,0 +1,200 @@
+#pragma once
+
+/**
+ * Hardware performance counters for the benchmark harness
+ *
+ * Reads cycles, instructions, L1D/LLC/dTLB misses and branch misses via
+ * perf_event_open(2) on Linux. Each event is opened separately so a missing
+ * one (common in VMs) only drops that column. Where counters cannot be
+ * opened at all (non-Linux, perf_event_paranoid, containers) everything
+ * degrades to a no-op and available() is false.
+ *
+ * Set BENCH_PERF_COUNTERS=0 to disable counters explicitly.
+ */
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace trading {
+namespace bench {
+
+class PerfCounters {
+public:
+    enum Event {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        DTLB_MISSES,
+        kEventCount
+    };
+
+    /**
+     * @brief Counter values, scaled for multiplexing; -1 for unavailable events
+     */
+    struct Sample {
+        std::array<double, kEventCount> values;
+
+        double operator[](Event e) const { return values[e]; }
+        bool has(Event e) const { return values[e] >= 0.0; }
+    };
+
+    static const char* name(Event e) {
+        static const char* const kNames[kEventCount] = {
+            "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+        };
+        return kNames[e];
+    }
+
+    PerfCounters() {
+        fds_.fill(-1);
+        const char* env = std::getenv("BENCH_PERF_COUNTERS");
+        if (env && std::strcmp(env, "0") == 0) {
+            reason_ = "disabled by BENCH_PERF_COUNTERS=0";
+            return;
+        }
+        open();
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return available_; }
+
+    /**
+     * @brief Why counters are unavailable (empty when available)
+     */
+    const std::string& unavailableReason() const { return reason_; }
+
+    /**
+     * @brief Zero and start all counters
+     */
+    void start() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /**
+     * @brief Pause counting (e.g. around PauseTiming sections); resume() continues
+     */
+    void pause() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    void resume() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /**
+     * @brief Stop counting and return the accumulated values
+     */
+    Sample stop() {
+        pause();
+        Sample sample;
+        sample.values.fill(-1.0);
+#if defined(__linux__)
+        for (int e = 0; e < kEventCount; ++e) {
+            if (fds_[e] < 0) continue;
+            // value, time_enabled, time_running
+            uint64_t buf[3] = {0, 0, 0};
+            if (read(fds_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) {
+                continue;
+            }
+            double value = static_cast<double>(buf[0]);
+            if (buf[2] > 0 && buf[2] < buf[1]) {
+                value *= static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+            }
+            sample.values[e] = value;
+        }
+#endif
+        return sample;
+    }
+
+private:
+    void open() {
+#if defined(__linux__)
+        struct Config {
+            uint32_t type;
+            uint64_t config;
+        };
+        constexpr uint64_t kCacheMissRead =
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const Config configs[kEventCount] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | kCacheMissRead},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | kCacheMissRead},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | kCacheMissRead},
+        };
+
+        int first_errno = 0;
+        for (int e = 0; e < kEventCount; ++e) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = configs[e].type;
+            attr.config = configs[e].config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fd < 0) {
+                if (!first_errno) first_errno = errno;
+                continue;
+            }
+            fds_[e] = static_cast<int>(fd);
+            available_ = true;
+        }
+
+        if (!available_) {
+            reason_ = std::string("perf_event_open failed: ") + std::strerror(first_errno)
+                + " (check /proc/sys/kernel/perf_event_paranoid)";
+        }
+#else
+        reason_ = "hardware counters are only supported on Linux";
+#endif
+    }
+
+    std::array<int, kEventCount> fds_;
+    bool available_ = false;
+    std::string reason_;
+};
+
+} // namespace bench
+} // namespace trading
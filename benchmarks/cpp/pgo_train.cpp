@@ -0,0 +1,125 @@
+/**
+ * Profile-guided optimization training run
+ *
+ * Drives the engine through the same mix the backend produces: a GBM price
+ * stream feeding the SMA calculator and tick pipeline, interleaved with the
+ * default bench_workload order flow (adds, cancels, matches, snapshots).
+ * Built against the instrumented engine objects when configured with
+ * -DTRADE_ENGINE_PGO=GENERATE; see benchmarks/pgo_build.sh.
+ *
+ *   ./pgo_train                       # bundled workload (fixed seed)
+ *   ./pgo_train --file=workload.csv   # train on a recorded workload instead
+ */
+
+#include "engine.hpp"
+#include "metrics.hpp"
+#include "pipeline_stats.hpp"
+#include "workload.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace trading;
+using namespace trading::bench;
+
+namespace {
+
+// Order-flow operations replayed per market-data tick
+constexpr size_t kOpsPerTick = 16;
+
+// Matches the backend's MarketSimulator defaults
+constexpr double kDrift = 0.0001;
+constexpr double kVolatility = 0.02;
+constexpr double kTickInterval = 0.5;
+constexpr size_t kSmaWindow = 20;
+
+/**
+ * @brief The bundled training workload: default traffic model, fixed seed
+ */
+WorkloadConfig trainingConfig() {
+    WorkloadConfig cfg;
+    cfg.num_ops = 1000000;
+    cfg.seed = 20240601;
+    return cfg;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string file;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--file=", 0) == 0) {
+            file = arg.substr(7);
+        } else {
+            std::cerr << "Usage: pgo_train [--file=workload.csv]\n";
+            return 1;
+        }
+    }
+
+    std::vector<WorkloadOp> ops;
+    try {
+        ops = file.empty() ? generateWorkload(trainingConfig()) : loadWorkload(file);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    size_t adds = 0;
+    for (const auto& op : ops) {
+        adds += op.type == OpType::ADD;
+    }
+
+    OrderBook book;
+    WorkloadReplayer replayer(book, adds);
+    SMACalculator sma(kSmaWindow);
+    PipelineStats pipeline;
+
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double price = 45000.0;
+    double sma_sum = 0.0;
+    size_t ticks = 0;
+    size_t message_bytes = 0;
+    char message[256];
+
+    for (size_t i = 0; i < ops.size(); i += kOpsPerTick) {
+        uint64_t start = monotonicNanos();
+
+        double dw = normal(rng);
+        price += kDrift * price * kTickInterval + kVolatility * price * dw * std::sqrt(kTickInterval);
+        price = std::max(price, 1.0);
+        uint64_t generated = monotonicNanos();
+
+        sma.addPrice(price);
+        sma_sum += sma.getSMA();
+        size_t end = std::min(i + kOpsPerTick, ops.size());
+        for (size_t j = i; j < end; ++j) {
+            replayer.apply(ops[j]);
+        }
+        uint64_t processed = monotonicNanos();
+
+        int len = std::snprintf(message, sizeof(message),
+                                "{\"price\":%.2f,\"sma\":%.2f,\"bid\":%.2f,\"ask\":%.2f}",
+                                price, sma.getSMA(), book.getBestBid(), book.getBestAsk());
+        message_bytes += static_cast<size_t>(std::max(len, 0));
+        uint64_t serialized = monotonicNanos();
+        pipeline.recordTick({start, generated, processed, serialized, monotonicNanos()});
+        ++ticks;
+
+        if (ticks % 1000 == 0) {
+            EngineMetrics::renderPrometheus();
+            book.memoryStats();
+        }
+    }
+
+    std::printf("Trained on %zu ops, %zu ticks (%zu trades, %zu message bytes, mean SMA %.2f)\n",
+                ops.size(), ticks, replayer.trades(), message_bytes,
+                sma_sum / static_cast<double>(ticks));
+    return 0;
+}
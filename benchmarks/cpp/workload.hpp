@@ -0,0 +1,287 @@
+#pragma once
+
+/**
+ * Order-book workload generation and recording
+ *
+ * A workload is a flat list of operations (add, cancel, match, snapshot)
+ * that can be generated from a parameterized traffic model or loaded from
+ * a recorded CSV file, then replayed against an OrderBook.
+ */
+
+#include "engine.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace trading {
+namespace bench {
+
+enum class OpType : uint8_t {
+    ADD,
+    CANCEL,
+    MATCH,
+    SNAPSHOT
+};
+
+constexpr size_t kOpTypeCount = 4;
+
+inline const char* opTypeName(OpType type) {
+    switch (type) {
+        case OpType::ADD: return "add";
+        case OpType::CANCEL: return "cancel";
+        case OpType::MATCH: return "match";
+        case OpType::SNAPSHOT: return "snapshot";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief One replayable operation
+ *
+ * For CANCEL, `target` is the index (among ADD operations, in order) of the
+ * order to cancel, since order IDs are only known at replay time.
+ */
+struct WorkloadOp {
+    OpType type;
+    OrderSide side = OrderSide::BUY;
+    double price = 0.0;
+    double quantity = 0.0;
+    uint32_t target = 0;
+};
+
+/**
+ * @brief Traffic model parameters
+ *
+ * Prices are placed a geometric number of ticks away from a drifting mid;
+ * a fraction of orders cross the spread instead. Sizes are log-normal.
+ */
+struct WorkloadConfig {
+    size_t num_ops = 1000000;
+    unsigned seed = 42;
+
+    double mid_price = 45000.0;
+    double tick_size = 0.5;
+    double mid_volatility_ticks = 0.2;  // Mid random-walk step (stddev, in ticks) per add
+
+    double mean_distance_ticks = 8.0;   // Mean of the geometric price distance
+    double cross_ratio = 0.05;          // Fraction of adds that cross the spread
+
+    double size_log_mean = 0.0;         // Log-normal size parameters
+    double size_log_stddev = 1.0;
+
+    double cancel_ratio = 0.4;          // Fraction of ops that cancel a live order
+    double snapshot_ratio = 0.02;       // Fraction of ops that read getBids/getAsks
+    size_t match_every = 1;             // matchOrders after every N adds (0 = never)
+
+    double burst_probability = 0.001;   // Chance an add starts a same-side burst
+    size_t burst_length = 200;          // Adds per burst, all near the touch
+};
+
+/**
+ * @brief Generate a synthetic workload from a traffic model
+ */
+inline std::vector<WorkloadOp> generateWorkload(const WorkloadConfig& cfg) {
+    std::mt19937_64 rng(cfg.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> mid_step(0.0, cfg.mid_volatility_ticks);
+    std::geometric_distribution<int> distance(1.0 / (1.0 + cfg.mean_distance_ticks));
+    std::lognormal_distribution<double> size(cfg.size_log_mean, cfg.size_log_stddev);
+
+    std::vector<WorkloadOp> ops;
+    ops.reserve(cfg.num_ops);
+
+    // Adds that may still be resting; cancels pick from these
+    std::vector<uint32_t> live;
+    uint32_t adds = 0;
+    size_t adds_since_match = 0;
+    size_t burst_left = 0;
+    OrderSide burst_side = OrderSide::BUY;
+    double mid = cfg.mid_price;
+
+    while (ops.size() < cfg.num_ops) {
+        double r = uniform(rng);
+
+        if (burst_left == 0 && r < cfg.cancel_ratio && !live.empty()) {
+            std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+            size_t i = pick(rng);
+            WorkloadOp op{OpType::CANCEL};
+            op.target = live[i];
+            live[i] = live.back();
+            live.pop_back();
+            ops.push_back(op);
+            continue;
+        }
+        if (burst_left == 0 && r < cfg.cancel_ratio + cfg.snapshot_ratio) {
+            ops.push_back(WorkloadOp{OpType::SNAPSHOT});
+            continue;
+        }
+
+        WorkloadOp op{OpType::ADD};
+        if (burst_left > 0) {
+            op.side = burst_side;
+            --burst_left;
+        } else {
+            op.side = uniform(rng) < 0.5 ? OrderSide::BUY : OrderSide::SELL;
+            if (uniform(rng) < cfg.burst_probability) {
+                burst_side = op.side;
+                burst_left = cfg.burst_length;
+            }
+        }
+
+        mid = std::max(cfg.tick_size * 100, mid + mid_step(rng) * cfg.tick_size);
+        double ticks = burst_left > 0 ? 1 + distance(rng) % 2 : 1 + distance(rng);
+        if (uniform(rng) < cfg.cross_ratio) {
+            ticks = -ticks;  // Marketable: placed through the mid
+        }
+        double offset = ticks * cfg.tick_size;
+        double price = op.side == OrderSide::BUY ? mid - offset : mid + offset;
+        op.price = std::max(cfg.tick_size, std::round(price / cfg.tick_size) * cfg.tick_size);
+        op.quantity = std::max(0.001, std::round(size(rng) * 1000.0) / 1000.0);
+
+        ops.push_back(op);
+        live.push_back(adds++);
+
+        if (cfg.match_every > 0 && ++adds_since_match >= cfg.match_every
+                && ops.size() < cfg.num_ops) {
+            ops.push_back(WorkloadOp{OpType::MATCH});
+            adds_since_match = 0;
+        }
+    }
+
+    return ops;
+}
+
+/**
+ * @brief Load a recorded workload
+ *
+ * One operation per line:
+ *   A,<B|S>,<price>,<quantity>   add an order
+ *   C,<add_index>                cancel the N-th added order (0-based)
+ *   M                            matchOrders
+ *   S                            getBids + getAsks
+ * Blank lines and lines starting with '#' are ignored.
+ */
+inline std::vector<WorkloadOp> loadWorkload(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open workload file: " + path);
+    }
+
+    std::vector<WorkloadOp> ops;
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string kind, a, b, c;
+        std::getline(fields, kind, ',');
+        std::getline(fields, a, ',');
+        std::getline(fields, b, ',');
+        std::getline(fields, c, ',');
+
+        WorkloadOp op{OpType::MATCH};
+        if (kind == "A" && (a == "B" || a == "S") && !b.empty() && !c.empty()) {
+            op.type = OpType::ADD;
+            op.side = a == "B" ? OrderSide::BUY : OrderSide::SELL;
+            op.price = std::stod(b);
+            op.quantity = std::stod(c);
+        } else if (kind == "C" && !a.empty()) {
+            op.type = OpType::CANCEL;
+            op.target = static_cast<uint32_t>(std::stoul(a));
+        } else if (kind == "M") {
+            op.type = OpType::MATCH;
+        } else if (kind == "S") {
+            op.type = OpType::SNAPSHOT;
+        } else {
+            throw std::runtime_error("Malformed workload line " + std::to_string(line_no)
+                                     + ": " + line);
+        }
+        ops.push_back(op);
+    }
+
+    return ops;
+}
+
+/**
+ * @brief Write a workload in the format read by loadWorkload
+ */
+inline void saveWorkload(const std::vector<WorkloadOp>& ops, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write workload file: " + path);
+    }
+
+    out.precision(10);
+    for (const auto& op : ops) {
+        switch (op.type) {
+            case OpType::ADD:
+                out << "A," << (op.side == OrderSide::BUY ? 'B' : 'S') << ','
+                    << op.price << ',' << op.quantity << '\n';
+                break;
+            case OpType::CANCEL: out << "C," << op.target << '\n'; break;
+            case OpType::MATCH: out << "M\n"; break;
+            case OpType::SNAPSHOT: out << "S\n"; break;
+        }
+    }
+}
+
+/**
+ * @brief Replays a workload against an OrderBook
+ *
+ * Keeps the ID of every added order so recorded cancels can be resolved.
+ * `apply` is kept tiny so timing wrappers around it measure the book,
+ * not the harness.
+ */
+class WorkloadReplayer {
+public:
+    explicit WorkloadReplayer(OrderBook& book, size_t expected_adds = 0) : book_(book) {
+        order_ids_.reserve(expected_adds);
+    }
+
+    void apply(const WorkloadOp& op) {
+        switch (op.type) {
+            case OpType::ADD:
+                order_ids_.push_back(book_.addOrder(op.side, op.price, op.quantity));
+                break;
+            case OpType::CANCEL:
+                if (op.target < order_ids_.size()) {
+                    book_.cancelOrder(order_ids_[op.target]);
+                }
+                break;
+            case OpType::MATCH:
+                trades_ += book_.matchOrders(trade_buf_);
+                break;
+            case OpType::SNAPSHOT:
+                book_.getBids(bid_buf_);
+                book_.getAsks(ask_buf_);
+                levels_ += bid_buf_.size() + ask_buf_.size();
+                break;
+        }
+    }
+
+    size_t trades() const { return trades_; }
+    size_t snapshotLevels() const { return levels_; }
+
+private:
+    OrderBook& book_;
+    std::vector<std::string> order_ids_;
+    std::vector<Trade> trade_buf_;
+    std::vector<std::pair<double, double>> bid_buf_;
+    std::vector<std::pair<double, double>> ask_buf_;
+    size_t trades_ = 0;
+    size_t levels_ = 0;
+};
+
+} // namespace bench
+} // namespace trading
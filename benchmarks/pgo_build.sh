@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+#
+# Profile-guided + link-time optimized build of the C++ engine
+#
+#   1. baseline  - plain Release build (bench_workload, bench_engine)
+#   2. generate  - instrumented build; pgo_train replays the bundled order
+#                  flow and SMA stream to record profiles
+#   3. use       - Release + LTO rebuild of trade_engine and the benchmarks
+#                  with those profiles
+#   4. compare   - bench_workload throughput for both builds, and a
+#                  compare_benchmarks.py diff when Google Benchmark is installed
+#
+# Usage: benchmarks/pgo_build.sh [build-dir]     (default: build-pgo)
+#
+# Environment:
+#   PGO_TRAIN_ARGS   extra pgo_train arguments (e.g. --file=workload.csv)
+#   BENCH_OPS        bench_workload operations per pass (default 1000000)
+#   CMAKE_ARGS       extra CMake arguments for every configure step
+#
+# Requires GCC 11+ or Clang (with llvm-profdata on PATH).
+
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+SRC="$ROOT/cpp_core"
+BUILD="$(mkdir -p "${1:-build-pgo}" && cd "${1:-build-pgo}" && pwd)"
+PROFILE_DIR="$BUILD/profile"
+BENCH_OPS="${BENCH_OPS:-1000000}"
+JOBS="$(nproc 2>/dev/null || echo 4)"
+
+read -r -a EXTRA_ARGS <<< "${CMAKE_ARGS:-}"
+COMMON_ARGS=(-DCMAKE_BUILD_TYPE=Release "${EXTRA_ARGS[@]}")
+
+configure() {
+    local dir="$1"
+    shift
+    cmake -S "$SRC" -B "$BUILD/$dir" "${COMMON_ARGS[@]}" "$@" > "$BUILD/$dir.configure.log"
+}
+
+has_target() {
+    [ -x "$BUILD/$1/$2" ]
+}
+
+echo "== Baseline build"
+configure baseline
+cmake --build "$BUILD/baseline" -j "$JOBS"
+
+echo "== Instrumented build"
+rm -rf "$PROFILE_DIR"
+configure generate -DTRADE_ENGINE_PGO=GENERATE -DTRADE_ENGINE_PGO_DIR="$PROFILE_DIR"
+cmake --build "$BUILD/generate" -j "$JOBS" --target pgo_train
+
+echo "== Training"
+"$BUILD/generate/pgo_train" ${PGO_TRAIN_ARGS:-}
+if ls "$PROFILE_DIR"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -o "$PROFILE_DIR/trade_engine.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "== Optimized build (PGO + LTO)"
+configure use -DTRADE_ENGINE_PGO=USE -DTRADE_ENGINE_PGO_DIR="$PROFILE_DIR" -DTRADE_ENGINE_LTO=ON
+cmake --build "$BUILD/use" -j "$JOBS"
+
+echo "== bench_workload ($BENCH_OPS ops, best of 5)"
+for build in baseline use; do
+    printf '%-9s ' "$build:"
+    "$BUILD/$build/bench_workload" --ops="$BENCH_OPS" --repeat=5 | grep "Sustained throughput"
+done
+
+if has_target baseline bench_engine && has_target use bench_engine; then
+    echo "== bench_engine (baseline -> PGO)"
+    for build in baseline use; do
+        BENCH_PERF_COUNTERS=0 "$BUILD/$build/bench_engine" \
+            --benchmark_out="$BUILD/$build.bench_engine.json" \
+            --benchmark_out_format=json > /dev/null
+    done
+    python3 "$ROOT/benchmarks/compare_benchmarks.py" \
+        "$BUILD/baseline.bench_engine.json" "$BUILD/use.bench_engine.json"
+fi
+
+echo
+echo "PGO module: $(ls "$BUILD"/use/trade_engine*.so 2>/dev/null || echo 'not built (pybind11 missing?)')"
+echo "Profiles:   $PROFILE_DIR"
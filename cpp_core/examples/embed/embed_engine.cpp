@@ -0,0 +1,36 @@
+/**
+ * Embedding the engine without Python
+ *
+ * Links trading::core from the installed (or build-tree) package, crosses
+ * a small book and prints the trades and engine metrics. Exits non-zero if
+ * the book does not match as expected, so it doubles as a package check.
+ */
+
+#include "engine.hpp"
+#include "metrics.hpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace trading;
+
+int main() {
+    OrderBook book;
+    book.addOrder(OrderSide::SELL, 45010.0, 1.0);
+    book.addOrder(OrderSide::SELL, 45020.0, 2.0);
+    book.addOrder(OrderSide::BUY, 45020.0, 2.5);
+
+    std::vector<Trade> trades;
+    book.matchOrders(trades);
+    for (const auto& trade : trades) {
+        std::printf("%s x %s: %.2f @ %.2f\n", trade.buy_order_id.c_str(),
+                    trade.sell_order_id.c_str(), trade.quantity, trade.price);
+    }
+
+    SMACalculator sma(2);
+    sma.addPrice(45010.0);
+    sma.addPrice(45020.0);
+    std::printf("SMA(2): %.2f\n\n%s", sma.getSMA(), EngineMetrics::renderPrometheus().c_str());
+
+    return trades.size() == 2 && book.getBestAsk() == 45020.0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+namespace trading {
+namespace alloc {
+
+/**
+ * @brief Heap activity of one thread
+ */
+struct Counters {
+    uint64_t allocations = 0;    // operator new calls (all forms)
+    uint64_t deallocations = 0;  // operator delete calls on non-null pointers
+    uint64_t bytes = 0;          // Bytes requested from operator new
+};
+
+/**
+ * @brief True when the counting operator new/delete is linked in
+ *
+ * Built with TRADING_ALLOC_TRACKING (CMake: -DTRADE_ENGINE_ALLOC_TRACKING=ON;
+ * test_engine always has it). Without it the counters stay at zero.
+ */
+bool enabled();
+
+/**
+ * @brief Totals for the calling thread since it started
+ */
+Counters threadCounters();
+
+/**
+ * @brief Measures the calling thread's allocations from construction onwards
+ *
+ *   alloc::Scope scope;
+ *   book.addOrder(OrderSide::BUY, 100.0, 1.0);
+ *   assert(scope.delta().allocations == 0);
+ */
+class Scope {
+public:
+    Scope() : start_(threadCounters()) {}
+
+    Counters delta() const {
+        Counters now = threadCounters();
+        Counters d;
+        d.allocations = now.allocations - start_.allocations;
+        d.deallocations = now.deallocations - start_.deallocations;
+        d.bytes = now.bytes - start_.bytes;
+        return d;
+    }
+
+private:
+    Counters start_;
+};
+
+} // namespace alloc
+} // namespace trading
@@ -2,12 +2,108 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <memory>
 #include <chrono>
+#include <cstdint>
+#include <array>
+#include <limits>
+#include "latency_histogram.hpp"
+#include "level_queue.hpp"
+#include "matching_policy.hpp"
+#include "metrics.hpp"
+#include "pool_allocator.hpp"
+#include "seq_map.hpp"
+#include "timing_wheel.hpp"
 
 namespace trading {
 
+/**
+ * @brief Fixed-capacity ring of (timestamp, price) samples
+ *
+ * Timestamps and prices live in two separate arrays allocated once, so
+ * recording a sample never allocates; once full, each push overwrites the
+ * oldest sample. unwrap() rotates both arrays in place so the samples are
+ * oldest-first from index 0, letting callers (e.g. numpy) view them as two
+ * contiguous arrays without copying. It only does work when pushes have
+ * wrapped the ring since the last unwrap.
+ */
+class PriceHistory {
+public:
+    /**
+     * @brief Construct an empty history
+     * @param capacity Number of samples kept before the oldest is overwritten
+     * @throws std::invalid_argument if capacity is 0
+     */
+    explicit PriceHistory(size_t capacity);
+
+    /**
+     * @brief Record a sample, overwriting the oldest one when full
+     */
+    void push(double timestamp, double price) {
+        timestamps_[next_] = timestamp;
+        prices_[next_] = price;
+        next_ = next_ + 1 == timestamps_.size() ? 0 : next_ + 1;
+        if (size_ < timestamps_.size()) {
+            size_++;
+        }
+    }
+
+    /**
+     * @brief Rotate the ring so the samples run oldest-first from index 0
+     *
+     * Pointers from timestamps()/prices() stay valid; the contents they
+     * show are in order until the next push.
+     */
+    void unwrap();
+
+    /**
+     * @brief Whether the samples are already oldest-first from index 0
+     */
+    bool contiguous() const { return size_ < timestamps_.size() || next_ == 0; }
+
+    const double* timestamps() const { return timestamps_.data(); }
+    const double* prices() const { return prices_.data(); }
+
+    /**
+     * @brief Price of the newest sample, read in place without unwrapping
+     * @return double The price, or 0.0 if there are no samples
+     */
+    double last() const {
+        if (size_ == 0) {
+            return 0.0;
+        }
+        return prices_[next_ == 0 ? prices_.size() - 1 : next_ - 1];
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return timestamps_.size(); }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * @brief Estimated heap + inline memory used by this history
+     * @return size_t Bytes (object plus both arrays)
+     */
+    size_t memoryBytes() const {
+        return sizeof(*this) + 2 * timestamps_.capacity() * sizeof(double);
+    }
+
+    /**
+     * @brief Drop all samples (capacity is kept)
+     */
+    void clear() {
+        size_ = 0;
+        next_ = 0;
+    }
+
+private:
+    std::vector<double> timestamps_;
+    std::vector<double> prices_;
+    size_t size_ = 0;
+    size_t next_ = 0;                // Slot the next push writes
+};
+
 /**
  * @brief High-performance Simple Moving Average calculator using circular buffer
  * 
@@ -28,6 +124,14 @@ public:
      */
     void addPrice(double price);
     
+    /**
+     * @brief Add a price and record it in a history in the same call
+     * @param price The price to add
+     * @param timestamp Sample time stored alongside the price
+     * @param history History the (timestamp, price) sample is pushed to
+     */
+    void addPrice(double price, double timestamp, PriceHistory& history);
+    
     /**
      * @brief Get the current Simple Moving Average
      * @return double The SMA value, or 0.0 if insufficient data
@@ -40,6 +144,14 @@ public:
      */
     size_t size() const { return current_size_; }
     
+    /**
+     * @brief Estimated heap + inline memory used by this calculator
+     * @return size_t Bytes (object plus circular buffer)
+     */
+    size_t memoryBytes() const {
+        return sizeof(*this) + prices_.capacity() * sizeof(double);
+    }
+    
     /**
      * @brief Reset the calculator
      */
@@ -67,17 +179,22 @@ enum class OrderSide {
 struct Order {
     std::string id;
     OrderSide side;
+    bool iceberg = false;  // Has a hidden reserve (sits in padding; see addIcebergOrder)
     double price;
     double quantity;
     long long timestamp;  // Unix timestamp in milliseconds
+    uint64_t seq;         // Numeric part of the order ID (arrival sequence)
     
-    Order(const std::string& order_id, OrderSide s, double p, double q)
-        : id(order_id), side(s), price(p), quantity(q) {
+    Order(const std::string& order_id, OrderSide s, double p, double q, uint64_t sequence = 0)
+        : id(order_id), side(s), price(p), quantity(q), seq(sequence) {
         auto now = std::chrono::system_clock::now();
         timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
             now.time_since_epoch()
         ).count();
     }
+    
+    Order(std::string order_id, OrderSide s, double p, double q, uint64_t sequence, long long time)
+        : id(std::move(order_id)), side(s), price(p), quantity(q), timestamp(time), seq(sequence) {}
 };
 
 /**
@@ -92,14 +209,128 @@ struct Trade {
 };
 
 /**
- * @brief Simple order matching engine with price-time priority
+ * @brief One fill of a batch clear, by order sequence number
+ *
+ * The numeric form of a Trade: order IDs are "ORD<seq>", so no strings
+ * are built until a caller asks for Trades.
+ */
+struct BatchFill {
+    uint64_t buy_seq;
+    uint64_t sell_seq;
+    double price;
+    double quantity;
+};
+
+/**
+ * @brief A tranche an iceberg order showed after its previous one filled
+ */
+struct IcebergRefill {
+    uint64_t seq;
+    OrderSide side;
+    double price;
+    double quantity;  // The new tranche
+};
+
+/**
+ * @brief A good-till order that left the book unfilled
+ */
+struct ExpiredOrder {
+    std::string order_id;
+    OrderSide side;
+    double price;
+    double quantity;      // What was still open
+    long long timestamp;  // Unix timestamp in milliseconds
+};
+
+/**
+ * @brief How matchOrders treats a crossed book
+ */
+enum class TradingMode {
+    CONTINUOUS,  // matchOrders trades crossing orders as they arrive
+    AUCTION,     // Orders accumulate (the book may cross) until uncross()
+    BATCH        // Orders are held back from the book until clearBatch()
+};
+
+/**
+ * @brief How clearBatch shares the marginal price level of the long side
+ */
+enum class BatchAllocation {
+    TIME,      // Earliest orders first
+    PRO_RATA   // In proportion to order size
+};
+
+/**
+ * @brief Equilibrium of a call auction
+ *
+ * The price is the one that executes the most quantity; ties go to the
+ * smallest surplus, then to market pressure (highest price if every tied
+ * price leaves buyers over, lowest if sellers), then to the reference price
+ * clamped into the tied range (its midpoint without a reference).
+ */
+struct AuctionResult {
+    double price = 0.0;        // Uncross price (0 when the book does not cross)
+    double volume = 0.0;       // Quantity executed at price
+    double buy_surplus = 0.0;  // Bids at or above price minus asks at or below (< 0: sell surplus)
+    size_t price_levels = 0;   // Crossing levels evaluated (both sides)
+};
+
+/**
+ * @brief Order book operations tracked by the latency histograms
+ */
+enum class LatencyOp {
+    ADD,
+    MATCH,
+    CANCEL,
+    SNAPSHOT
+};
+
+constexpr size_t kLatencyOpCount = 4;
+
+/**
+ * @brief Memory footprint of an OrderBook, broken down by component
+ *
+ * Byte counts are estimates derived from container sizes and capacities
+ * (node layouts of libstdc++/libc++; allocator headers excluded).
+ */
+struct MemoryStats {
+    size_t level_bytes = 0;      // Price-level map nodes (key + per-level vector header)
+    size_t order_bytes = 0;      // Order slots in use inside level vectors
+    size_t id_string_bytes = 0;  // Heap storage of order ID strings (0 when they fit SSO)
+    size_t index_bytes = 0;      // Order-location index nodes and bucket array
+    size_t pool_bytes = 0;       // Unused order slots in level vectors, incl. spare levels
+    size_t fixed_bytes = 0;      // The OrderBook object itself (incl. latency histograms)
+    size_t total_bytes = 0;
+    
+    size_t resting_orders = 0;
+    size_t price_levels = 0;
+    size_t stop_orders = 0;        // Untriggered stops (their bytes are in the totals above)
+    double bytes_per_order = 0.0;  // total_bytes / resting_orders (0 when empty)
+    
+    size_t pool_capacity = 0;      // Order slots allocated across all level vectors
+    size_t high_water_orders = 0;  // Most resting orders seen since construction/reset
+    size_t high_water_levels = 0;  // Most price levels seen since construction/reset
+};
+
+/**
+ * @brief Order matching engine, templated on its matching policy
  * 
- * Implements a basic order book with automatic matching when bid >= ask.
- * Uses price-time priority (FIFO at each price level).
+ * Implements an order book with automatic matching when bid >= ask. The
+ * policy (see matching_policy.hpp) decides how crossing levels share their
+ * quantity and what price trades execute at; it is inlined into
+ * matchOrders, so each venue's rules compile to their own loop with no
+ * runtime dispatch. Call and batch auctions are the same for every policy.
+ *
+ * The member definitions live in engine.cpp, which instantiates the book for
+ * every policy in matching_policy.hpp and every TradePrice; OrderBook is the
+ * price-time priority book that trades at the ask.
  */
-class OrderBook {
+template <typename MatchingPolicy>
+class BasicOrderBook {
 public:
-    OrderBook() = default;
+    using Policy = MatchingPolicy;
+    using OrderQueue = LevelQueue<Order>;
+    
+    BasicOrderBook() = default;
     
     /**
      * @brief Add an order to the book
@@ -110,24 +341,270 @@ public:
      */
     std::string addOrder(OrderSide side, double price, double quantity);
     
+    /**
+     * @brief Add an order that expires at a point on the engine clock
+     * @param expire_ms Engine time (see advanceTime) the order expires at
+     * @return std::string The generated order ID
+     * @throws std::invalid_argument as addOrder, or if expire_ms is not
+     *                               after the engine clock
+     */
+    std::string addOrderGoodTill(OrderSide side, double price, double quantity, long long expire_ms);
+    
+    /**
+     * @brief Add an order that expires after `ticks` more processTick calls
+     * @return std::string The generated order ID
+     * @throws std::invalid_argument as addOrder, or if ticks is 0
+     *
+     * The order can still trade during the last of those ticks.
+     */
+    std::string addOrderGoodForTicks(OrderSide side, double price, double quantity, uint64_t ticks);
+    
+    /**
+     * @brief Move the engine clock forward, expiring good-till orders due by then
+     * @param now_ms Engine time in milliseconds (an earlier time is ignored)
+     * @return size_t Number of orders expired
+     *
+     * Expiries are tracked in a hierarchical timing wheel, so scheduling
+     * and expiring cost O(1) amortized rather than a scan of the book.
+     * Filled and cancelled orders are dropped from the wheel when their
+     * time comes. Expired orders are queued for takeExpired().
+     */
+    size_t advanceTime(long long now_ms);
+    
+    /**
+     * @brief Engine clock: the latest time passed to advanceTime (0 if none)
+     */
+    long long clockMillis() const { return static_cast<long long>(time_expiries_.now()); }
+    
+    /**
+     * @brief processTick calls since construction or reset
+     */
+    uint64_t ticks() const { return ticks_; }
+    
+    /**
+     * @brief Hand over the orders expired since the last call
+     * @param expired Cleared, then filled with the expired orders
+     * @return size_t Number of expired orders
+     */
+    size_t takeExpired(std::vector<ExpiredOrder>& expired);
+    
     /**
      * @brief Match orders and execute trades
      * @return std::vector<Trade> Vector of executed trades
+     *
+     * While the best bid and ask levels cross, the policy trades them
+     * against each other; orders that fill leave the level in one pass.
      */
     std::vector<Trade> matchOrders();
     
+    /**
+     * @brief Match orders, writing trades into a caller-owned vector
+     * @param trades Cleared, then filled with the executed trades
+     * @return size_t Number of trades executed
+     *
+     * Reusing the same vector across calls keeps matching allocation-free
+     * once its capacity covers the largest batch.
+     */
+    size_t matchOrders(std::vector<Trade>& trades);
+    
+    /**
+     * @brief Iceberg tranches refilled by the latest matchOrders, processTick,
+     *        uncross or clearBatch call, in the order they were refilled
+     *
+     * Each refill rejoins the back of its level. One call can refill the
+     * same order several times, once per tranche its trades filled.
+     */
+    const std::vector<IcebergRefill>& lastRefills() const { return refills_; }
+    
+    /**
+     * @brief Add a stop or stop-limit order
+     * @param side Order side (BUY or SELL)
+     * @param stop_price Trigger price: a buy fires when the last price rises
+     *                   to it or above, a sell when it falls to it or below
+     * @param quantity Order quantity
+     * @param limit_price Limit the order enters the book at once triggered;
+     *                    0 for a stop (market) order
+     * @return std::string The generated order ID (cancel with cancelOrder)
+     * @throws std::invalid_argument if stop_price or quantity is not positive,
+     *                               or limit_price is negative
+     *
+     * The order waits off the book, unseen by getBids/getAsks, in a per-side
+     * trigger index sorted by stop price. It fires on the next tick or trade
+     * at or through its stop price, even one already passed.
+     */
+    std::string addStopOrder(OrderSide side, double stop_price, double quantity,
+                             double limit_price = 0.0);
+    
+    /**
+     * @brief Add an iceberg (reserve) order: only one tranche is shown at a time
+     * @param side Order side (BUY or SELL)
+     * @param price Limit price
+     * @param display_quantity Size of each displayed tranche
+     * @param total_quantity Displayed plus hidden quantity
+     * @return std::string The generated order ID (cancel with cancelOrder)
+     * @throws std::invalid_argument if any argument is not positive or
+     *                               total_quantity is below display_quantity
+     *
+     * getBids/getAsks and the auctions see only the displayed tranche, so
+     * a large order keeps its level's queue a single entry. When a tranche
+     * fills, the next one (up to display_quantity) is taken from the reserve
+     * and re-queued at the back of the level with the same order ID: O(1)
+     * per tranche. Cancelling or expiring the order reports the displayed
+     * and hidden quantity together.
+     */
+    std::string addIcebergOrder(OrderSide side, double price, double display_quantity,
+                                double total_quantity);
+    
+    /**
+     * @brief Iceberg orders that still have hidden quantity in reserve
+     */
+    size_t icebergOrders() const { return reserves_.size(); }
+    
+    /**
+     * @brief Record a last-traded price and fire the stops it triggers
+     * @param price The new last price
+     * @param trades Cleared, then filled with the trades triggered orders execute
+     * @return size_t Number of trades executed
+     *
+     * Triggered stops are popped off the front of the trigger index in
+     * O(k log n) for k fired out of n waiting. A fired stop sweeps the
+     * opposite side and drops what it cannot fill; a stop-limit trades
+     * what crosses its limit and rests the remainder. Trades that move the
+     * price fire further stops until the cascade runs dry. matchOrders does
+     * the same with the prices of its own trades. Stops only fire in
+     * CONTINUOUS mode.
+     *
+     * Every call counts one tick, in any mode, and expires the
+     * good-for-ticks orders whose last tick it was (see takeExpired).
+     */
+    size_t processTick(double price, std::vector<Trade>& trades);
+    
+    /**
+     * @brief Last price seen by processTick or traded by matchOrders (0 if none)
+     */
+    double lastPrice() const { return last_price_; }
+    
+    /**
+     * @brief Stop and stop-limit orders waiting for their trigger
+     */
+    size_t stopOrders() const { return stop_orders_; }
+    
+    /**
+     * @brief Switch between continuous matching, call auction and batch auction
+     *
+     * In AUCTION mode matchOrders executes nothing, so orders build up a
+     * crossed book for uncross(). In BATCH mode new orders are not even
+     * added to the book; they wait, unseen by getBids/getAsks, for
+     * clearBatch(). Leaving BATCH mode moves any waiting orders into the book
+     * unmatched; switching modes never trades by itself.
+     */
+    void setMode(TradingMode mode);
+    TradingMode mode() const { return mode_; }
+    
+    /**
+     * @brief Equilibrium price and volume the book would uncross at now
+     * @param reference_price Last price, used only to break remaining ties (0: none)
+     * @return AuctionResult Zero volume when the best bid is below the best ask
+     *
+     * One linear pass over the cumulative depth of the crossing levels.
+     * Iceberg orders count only their displayed tranche, not the reserve.
+     */
+    AuctionResult indicativeAuction(double reference_price = 0.0) const;
+    
+    /**
+     * @brief Execute every crossing order at the single equilibrium price
+     * @param trades Cleared, then filled with the executed trades
+     * @param reference_price As for indicativeAuction
+     * @return AuctionResult The price and volume executed
+     *
+     * Orders fill in price-time priority on each side; only the marginal
+     * level of the side with the surplus is left partly filled. Filled
+     * levels are removed in bulk. Works in either mode. The auction price
+     * becomes the last price; in CONTINUOUS mode the stops it reaches fire
+     * straight after, their trades appended, while in AUCTION mode they
+     * wait for the next tick or trade.
+     *
+     * An iceberg takes part with its displayed tranche only, as priced by
+     * indicativeAuction. A tranche the auction fills is refilled behind its
+     * level afterwards and does not trade in the same uncross, so the book
+     * can be left crossed for continuous matching (or the next auction).
+     */
+    AuctionResult uncross(std::vector<Trade>& trades, double reference_price = 0.0);
+    
+    /**
+     * @brief Clear the waiting batch together with the book at one uniform price
+     * @param trades Cleared, then filled with the executed trades
+     * @param allocation How the marginal level of the side with the surplus is shared
+     * @param reference_price As for indicativeAuction
+     * @return AuctionResult The clearing price and volume (zero volume if nothing crosses)
+     *
+     * Frequent batch auctions call this once per interval in BATCH mode.
+     * Waiting orders are grouped by price as they arrive, so the cost is
+     * linear in the batch; the Trades are built from the numeric fills of
+     * the overload below. Only resting levels the batch can trade with
+     * leave the price maps. Orders better than the clearing price fill
+     * completely. What is left rests in the book with one map lookup per
+     * price level. The clearing price becomes the last price and, as with
+     * uncross, the stops it reaches fire straight after in CONTINUOUS mode
+     * (their trades appended) and wait for the next tick or trade otherwise.
+     */
+    AuctionResult clearBatch(std::vector<Trade>& trades,
+                             BatchAllocation allocation = BatchAllocation::PRO_RATA,
+                             double reference_price = 0.0);
+    
+    /**
+     * @brief clearBatch for bulk callers: fills by sequence number, no order ID strings
+     * @param fills Cleared, then filled in the order the Trades would be
+     *
+     * Waiting orders are already grouped by price as they arrive, so the
+     * clear only ranks the levels. Fills are paired off level by level in
+     * priority order into the flat buffer, each order's fill taken off it
+     * in place. Levels that traded are then compacted, their filled orders
+     * dropped from the order index; a level rests as a whole, its vector
+     * swapped into the book's queue at that price when that is empty.
+     * The clearing price becomes the last price; stops are left for the
+     * next tick or trade, as their trades would not be BatchFills.
+     */
+    AuctionResult clearBatch(std::vector<BatchFill>& fills,
+                             BatchAllocation allocation = BatchAllocation::PRO_RATA,
+                             double reference_price = 0.0);
+    
+    /**
+     * @brief Orders waiting for the next clearBatch (BATCH mode)
+     */
+    size_t pendingOrders() const {
+        return pending_bids_.orders + pending_asks_.orders - pending_cancelled_;
+    }
+    
+    /**
+     * @brief Cancel a resting order
+     * @param order_id ID returned by addOrder
+     * @return bool True if the order was resting and has been removed
+     */
+    bool cancelOrder(const std::string& order_id);
+    
     /**
      * @brief Get all bid orders (sorted by price descending)
      * @return std::vector<std::pair<double, double>> Vector of (price, quantity) pairs
      */
     std::vector<std::pair<double, double>> getBids() const;
     
+    /**
+     * @brief Get all bid levels into a caller-owned vector (cleared first)
+     */
+    void getBids(std::vector<std::pair<double, double>>& levels) const;
+    
     /**
      * @brief Get all ask orders (sorted by price ascending)
      * @return std::vector<std::pair<double, double>> Vector of (price, quantity) pairs
      */
     std::vector<std::pair<double, double>> getAsks() const;
     
+    /**
+     * @brief Get all ask levels into a caller-owned vector (cleared first)
+     */
+    void getAsks(std::vector<std::pair<double, double>>& levels) const;
+    
     /**
      * @brief Get the best bid price
      * @return double Best bid price, or 0.0 if no bids
@@ -140,23 +617,220 @@ public:
      */
     double getBestAsk() const;
     
+    /**
+     * @brief Orders resting at one price level, in priority order
+     * @return const OrderQueue* The level's queue, or nullptr if no order rests there
+     *
+     * Valid until the book is next modified.
+     */
+    const OrderQueue* ordersAt(OrderSide side, double price) const;
+    
     /**
      * @brief Reset the order book
      */
     void reset();
+    
+    /**
+     * @brief Latency histogram for one operation type
+     *
+     * Only populated when built with TRADING_LATENCY_STATS; otherwise empty.
+     * getBids and getAsks are both recorded as SNAPSHOT.
+     */
+    const LatencyHistogram& latencyHistogram(LatencyOp op) const {
+        return latency_[static_cast<size_t>(op)];
+    }
+    
+    /**
+     * @brief Clear all latency histograms (book contents are unaffected)
+     */
+    void resetLatencyStats();
+    
+    /**
+     * @brief Estimate the memory used by the book, per component
+     * @return MemoryStats Byte breakdown, resting order count and high-water marks
+     */
+    MemoryStats memoryStats() const;
 
 private:
-    // Buy orders: price -> vector of orders (sorted by time)
+    using LevelAllocator = PoolAllocator<std::pair<const double, OrderQueue>>;
+    
+    // Buy orders: price -> queue of orders (sorted by time)
     // Using reverse order (greater price first)
-    std::map<double, std::vector<Order>, std::greater<double>> bids_;
+    std::map<double, OrderQueue, std::greater<double>, LevelAllocator> bids_;
     
-    // Sell orders: price -> vector of orders (sorted by time)
+    // Sell orders: price -> queue of orders (sorted by time)
     // Using natural order (lower price first)
-    std::map<double, std::vector<Order>> asks_;
+    std::map<double, OrderQueue, std::less<double>, LevelAllocator> asks_;
+    
+    // Orders waiting in BATCH mode, grouped by price as they arrive: each
+    // side's levels in first-seen order, every level's orders in arrival
+    // (seq) order, and a small open-addressing table from price to level.
+    // A level's orders move into the book's queue at that price when they
+    // rest; the levels themselves are kept between batches.
+    struct BatchLevel {
+        double price = 0.0;
+        double quantity = 0.0;   // Total not cancelled
+        bool traded = false;     // Reached by the last clear
+        OrderQueue orders;       // Quantity 0 once cancelled, or filled in a clear
+    };
+    struct BatchSlot {
+        uint64_t bits;    // Price bits; 0 marks a free slot (prices are positive)
+        uint32_t level;
+    };
+    struct PendingSide {
+        std::vector<BatchLevel> levels;   // The first `used` hold this batch
+        size_t used = 0;
+        size_t orders = 0;                // Cancelled ones included
+        uint64_t first_seq = 0;           // Oldest waiting order (0: none)
+        std::vector<BatchSlot> table;
+        unsigned shift = 64;              // 64 - log2 of the table size
+        std::vector<uint32_t> best_first; // Levels ranked for a clear
+    };
+    PendingSide pending_bids_;
+    PendingSide pending_asks_;
+    size_t pending_cancelled_ = 0;
+    std::vector<BatchFill> batch_fills_;   // What the Trade overload converts
+    
+    // Per-order shares of the pro-rata policies, reused across matches
+    std::vector<double> match_scratch_;
+    
+    // Untriggered stops: trigger price -> orders (sorted by time), each side
+    // ordered by which fires first. An Order's price is its limit (0: market).
+    std::map<double, OrderQueue, std::less<double>, LevelAllocator> buy_stops_;
+    std::map<double, OrderQueue, std::greater<double>, LevelAllocator> sell_stops_;
+    size_t stop_orders_ = 0;
+    double last_price_ = 0.0;
+    
+    // Stops fired in one round of a cascade, and the single-order queue a
+    // fired stop trades from; both keep their capacity
+    std::vector<Order> triggered_;
+    OrderQueue taker_;
+    
+    // Emptied level vectors kept with their capacity for the next new level
+    std::vector<OrderQueue> spare_levels_;
+    static constexpr size_t kMaxSpareLevels = 256;
+    
+    // Where each resting order lives, keyed by its sequence number.
+    // Lets cancelOrder go straight to the right level instead of scanning the book.
+    // Price first, so an index entry packs into 24 bytes
+    struct OrderLocation {
+        double price = 0.0;  // Trigger price for an untriggered stop
+        OrderSide side = OrderSide::BUY;
+        bool stop = false;   // Waiting in buy_stops_/sell_stops_
+    };
+    using OrderIndex = SeqMap<OrderLocation>;
+    OrderIndex order_index_;
+    
+    // Hidden quantity of iceberg orders, keyed by sequence number; an entry
+    // goes when its last tranche is displayed. Tranches refilled while a
+    // level is compacted wait in replenished_ to rejoin at its back; each
+    // refill is also recorded in refills_ for lastRefills().
+    struct Reserve {
+        double display;
+        double hidden;
+    };
+    std::unordered_map<uint64_t, Reserve, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       PoolAllocator<std::pair<const uint64_t, Reserve>>> reserves_;
+    std::vector<Order> replenished_;
+    std::vector<IcebergRefill> refills_;
+    
+    // Good-till orders by expiry (engine time in ms, and tick count), plus
+    // the buffers expiry fills; ids are sequence numbers
+    TimingWheel time_expiries_;
+    TimingWheel tick_expiries_;
+    uint64_t ticks_ = 0;
+    struct LevelExpiry {
+        OrderSide side;
+        double price;
+        uint64_t seq;
+    };
+    std::vector<uint64_t> expiring_;
+    std::vector<LevelExpiry> level_expiries_;
+    std::vector<ExpiredOrder> expired_;
     
     size_t next_order_id_ = 1;
+    TradingMode mode_ = TradingMode::CONTINUOUS;
+    
+    size_t high_water_orders_ = 0;
+    size_t high_water_levels_ = 0;
+    
+    // Per-operation latency; mutable so const snapshots can be timed too
+    mutable std::array<LatencyHistogram, kLatencyOpCount> latency_;
+    
+    // This book's share of the process-wide level/order gauges
+    GaugeContribution level_gauge_{Gauge::PRICE_LEVELS};
+    GaugeContribution order_gauge_{Gauge::RESTING_ORDERS};
     
     std::string generateOrderId();
+    void updateGauges();
+    
+    template <typename LevelMap>
+    bool removeFromLevel(LevelMap& levels, double price, uint64_t seq, double& quantity);
+    
+    bool removeOrder(typename OrderIndex::iterator loc, double& quantity);
+    double nextTranche(uint64_t seq);
+    bool replenish(const Order& order);
+    void requeueReplenished();
+    void expire(TimingWheel& wheel, uint64_t now);
+    
+    template <typename LevelMap>
+    void expireFromLevel(LevelMap& levels, typename std::vector<LevelExpiry>::iterator first,
+                         typename std::vector<LevelExpiry>::iterator last, long long timestamp);
+    
+    template <typename LevelMap>
+    OrderQueue& levelFor(LevelMap& levels, double price);
+    
+    template <typename LevelMap>
+    void eraseLevel(LevelMap& levels, typename LevelMap::iterator level);
+    
+    template <typename LevelMap>
+    void eraseLevels(LevelMap& levels, typename LevelMap::iterator first,
+                     typename LevelMap::iterator last);
+    
+    template <typename LevelMap>
+    void removeFilled(LevelMap& levels, typename LevelMap::iterator level);
+    
+    BatchLevel& batchLevel(PendingSide& side, double price);
+    BatchLevel* findBatchLevel(PendingSide& side, double price);
+    
+    // Waiting orders are newer than anything resting on their side
+    bool waiting(OrderSide side, uint64_t seq) const {
+        const PendingSide& pending = side == OrderSide::BUY ? pending_bids_ : pending_asks_;
+        return pending.first_seq != 0 && seq >= pending.first_seq;
+    }
+    
+    template <typename LevelMap>
+    void pullLevels(LevelMap& levels, typename LevelMap::iterator last, PendingSide& side);
+    
+    template <typename LevelMap>
+    void settleBatch(LevelMap& levels, PendingSide& pending);
+    
+    void dropCancelled();
+    void resetPending(PendingSide& side);
+    void releasePending();
+    
+    template <typename StopMap>
+    void popTriggered(StopMap& stops, double price);
+    
+    template <typename LevelMap, typename Fill>
+    void sweep(LevelMap& levels, Fill& fill);
+    
+    void fireStops(std::vector<Trade>& trades, double high, double low);
 };
 
+using OrderBook = BasicOrderBook<FifoMatching<>>;
+using ProRataOrderBook = BasicOrderBook<ProRataMatching<>>;
+using TopOrderProRataOrderBook = BasicOrderBook<TopOrderProRataMatching<>>;
+
+// Instantiated in engine.cpp
+extern template class BasicOrderBook<FifoMatching<TradePrice::ASK>>;
+extern template class BasicOrderBook<FifoMatching<TradePrice::PASSIVE>>;
+extern template class BasicOrderBook<FifoMatching<TradePrice::MIDPOINT>>;
+extern template class BasicOrderBook<ProRataMatching<TradePrice::ASK>>;
+extern template class BasicOrderBook<ProRataMatching<TradePrice::PASSIVE>>;
+extern template class BasicOrderBook<ProRataMatching<TradePrice::MIDPOINT>>;
+extern template class BasicOrderBook<TopOrderProRataMatching<TradePrice::ASK>>;
+extern template class BasicOrderBook<TopOrderProRataMatching<TradePrice::PASSIVE>>;
+extern template class BasicOrderBook<TopOrderProRataMatching<TradePrice::MIDPOINT>>;
+
 } // namespace trading
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace trading {
+namespace kernels {
+
+/**
+ * @brief Instruction-set variants the batch kernels are compiled for
+ *
+ * Every kernel is built once per variant (kernels_scalar.cpp,
+ * kernels_avx2.cpp, kernels_avx512.cpp, each with its own target flags) and
+ * the best one the CPU supports is selected on first use, so one binary
+ * runs everywhere and still uses AVX2/AVX-512 where available.
+ */
+enum class SimdPath {
+    SCALAR,   // Baseline x86-64 / any architecture
+    AVX2,     // AVX2 + FMA
+    AVX512    // AVX-512 F/DQ/VL
+};
+
+const char* simdPathName(SimdPath path);
+
+/**
+ * @brief Variant currently used by the kernels
+ *
+ * Initially the best supported path, capped by the TRADE_ENGINE_SIMD
+ * environment variable (scalar, avx2 or avx512) if set.
+ */
+SimdPath activeSimdPath();
+
+/**
+ * @brief Whether this build contains the variant and the CPU can run it
+ */
+bool simdPathSupported(SimdPath path);
+
+/**
+ * @brief Switch variants (benchmarks and tests); not safe while kernels run
+ * @throws std::invalid_argument if the path is not supported here
+ */
+void setSimdPath(SimdPath path);
+
+/**
+ * @brief Rolling simple moving average over a price series
+ * @param prices Input series
+ * @param n Number of prices
+ * @param window SMA window (> 0)
+ * @param out n results; out[i] matches SMACalculator::getSMA() after adding prices[0..i]
+ *
+ * Computed from prefix sums of (price - prices[0]); results agree with
+ * SMACalculator to within floating-point rounding, not bit-for-bit.
+ */
+void smaBatch(const double* prices, size_t n, size_t window, double* out);
+
+/**
+ * @brief Several rolling SMAs over the same series in one pass
+ * @param windows k window sizes (each > 0)
+ * @param out k x n row-major: out[j * n + i] is the windows[j] SMA at i
+ */
+void indicatorBank(const double* prices, size_t n, const size_t* windows, size_t k, double* out);
+
+/**
+ * @brief Cumulative depth along one side of the book
+ * @param prices Level prices, best first (as getBids/getAsks return them)
+ * @param quantities Level quantities
+ * @param cum_quantity n results: total quantity up to and including level i
+ * @param cum_notional n results: total price * quantity up to and including level i
+ */
+void cumulativeDepth(const double* prices, const double* quantities, size_t n,
+                     double* cum_quantity, double* cum_notional);
+
+/**
+ * @brief Standard normal draws for GBM shocks
+ * @param seed Stream seed
+ * @param offset Index of the first draw within the stream
+ * @param n Number of draws
+ * @param out n results
+ *
+ * Counter-based (draw i depends only on seed and offset + i), so a stream
+ * can be generated in blocks or in parallel and is the same on every path.
+ */
+void gaussianNormals(uint64_t seed, uint64_t offset, size_t n, double* out);
+
+/**
+ * @brief Geometric Brownian motion path driven by gaussianNormals
+ * @param s0 Starting price
+ * @param drift Drift per unit time
+ * @param volatility Volatility per sqrt unit time
+ * @param dt Time step
+ * @param seed Normal stream seed
+ * @param n Number of steps
+ * @return std::vector<double> n prices after each step
+ */
+std::vector<double> gbmPath(double s0, double drift, double volatility, double dt,
+                            uint64_t seed, size_t n);
+
+} // namespace kernels
+} // namespace trading
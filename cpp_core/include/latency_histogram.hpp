@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace trading {
+
+/**
+ * @brief Fixed-size HDR-style latency histogram (nanoseconds)
+ *
+ * Log-linear bucketing: values below 2^kSubBucketBits are recorded exactly,
+ * larger values get 2^kSubBucketBits sub-buckets per power of two, which
+ * bounds the relative error at ~3%. Recording is a couple of shifts and one
+ * increment, with no allocation; values above kMaxTrackable are clamped.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+    static constexpr unsigned kMaxValueBits = 36;  // ~68.7 seconds
+    static constexpr uint64_t kMaxTrackable = (uint64_t{1} << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    /**
+     * @brief Record one latency sample
+     * @param value_ns Latency in nanoseconds
+     */
+    void record(uint64_t value_ns) {
+        if (value_ns > kMaxTrackable) value_ns = kMaxTrackable;
+        ++counts_[bucketIndex(value_ns)];
+        ++total_count_;
+        sum_ += value_ns;
+        if (value_ns < min_) min_ = value_ns;
+        if (value_ns > max_) max_ = value_ns;
+    }
+
+    /**
+     * @brief Value at a given percentile
+     * @param percentile Percentile in [0, 100]
+     * @return uint64_t Representative value of the bucket holding that rank, or 0 if empty
+     */
+    uint64_t percentile(double percentile) const {
+        if (total_count_ == 0) return 0;
+        if (percentile <= 0.0) return min_;
+        if (percentile >= 100.0) return max_;
+
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * total_count_ + 0.5);
+        if (rank == 0) rank = 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                uint64_t v = bucketMidpoint(i);
+                return v < min_ ? min_ : (v > max_ ? max_ : v);
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return total_count_; }
+    uint64_t min() const { return total_count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const {
+        return total_count_ ? static_cast<double>(sum_) / static_cast<double>(total_count_) : 0.0;
+    }
+
+    /**
+     * @brief Add another histogram's samples into this one
+     */
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_count_ += other.total_count_;
+        sum_ += other.sum_;
+        if (other.total_count_ && other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    void reset() {
+        counts_.fill(0);
+        total_count_ = 0;
+        sum_ = 0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        unsigned shift = highestBit(value) - kSubBucketBits;
+        return static_cast<size_t>((shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets));
+    }
+
+    static uint64_t bucketLowerBound(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        unsigned shift = static_cast<unsigned>(index / kSubBuckets) - 1;
+        return (kSubBuckets + index % kSubBuckets) << shift;
+    }
+
+    static uint64_t bucketMidpoint(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        unsigned shift = static_cast<unsigned>(index / kSubBuckets) - 1;
+        return bucketLowerBound(index) + ((uint64_t{1} << shift) >> 1);
+    }
+
+private:
+    static unsigned highestBit(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+    }
+
+    std::array<uint64_t, kBucketCount> counts_;
+    uint64_t total_count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+/**
+ * @brief RAII timer that records its lifetime into a histogram
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        histogram_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace trading
+
+// Compile-time toggle: define TRADING_LATENCY_STATS to time engine operations.
+// When it is not defined the macro expands to nothing and costs nothing.
+#ifdef TRADING_LATENCY_STATS
+#define TRADING_LATENCY_SCOPE(histogram) ::trading::ScopedLatency trading_latency_scope_(histogram)
+#else
+#define TRADING_LATENCY_SCOPE(histogram) ((void)0)
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace trading {
+
+/**
+ * @brief Contiguous FIFO of the orders resting at one price level
+ *
+ * A vector with a head index: pop_front(n) only moves the head past the
+ * first n orders, so taking filled orders off the front of a level and
+ * re-queueing a refilled iceberg tranche at its back are both O(1). The
+ * orders behind the head stay in place, contiguous, for the matching
+ * policies to index. Dead slots in front of the head are reclaimed once
+ * they outnumber the live ones, so the compaction is paid for by the pops
+ * that made it necessary, and the storage stays within twice the orders.
+ *
+ * Otherwise it behaves like the std::vector it wraps: iterators are the
+ * vector's, and erase/insert take and invalidate them the same way.
+ */
+template <typename T>
+class LevelQueue {
+public:
+    using value_type = T;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    iterator begin() { return items_.begin() + static_cast<std::ptrdiff_t>(head_); }
+    iterator end() { return items_.end(); }
+    const_iterator begin() const { return items_.begin() + static_cast<std::ptrdiff_t>(head_); }
+    const_iterator end() const { return items_.end(); }
+
+    size_t size() const { return items_.size() - head_; }
+    bool empty() const { return head_ == items_.size(); }
+    size_t capacity() const { return items_.capacity(); }
+
+    T& operator[](size_t i) { return items_[head_ + i]; }
+    const T& operator[](size_t i) const { return items_[head_ + i]; }
+    T& front() { return items_[head_]; }
+    const T& front() const { return items_[head_]; }
+    T& back() { return items_.back(); }
+    const T& back() const { return items_.back(); }
+
+    void push_back(T&& item) { items_.push_back(std::move(item)); }
+    void push_back(const T& item) { items_.push_back(item); }
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        return items_.emplace_back(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Drop the first n orders
+     */
+    void pop_front(size_t n = 1) {
+        head_ += n;
+        if (head_ == items_.size()) {
+            clear();
+        } else if (head_ > items_.size() - head_) {
+            compact();
+        }
+    }
+
+    iterator erase(const_iterator pos) { return items_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return items_.erase(first, last); }
+
+    template <typename InputIt>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        return items_.insert(pos, first, last);
+    }
+
+    void clear() {
+        items_.clear();
+        head_ = 0;
+    }
+
+    void swap(LevelQueue& other) noexcept {
+        items_.swap(other.items_);
+        std::swap(head_, other.head_);
+    }
+
+private:
+    void compact() {
+        items_.erase(items_.begin(), items_.begin() + static_cast<std::ptrdiff_t>(head_));
+        head_ = 0;
+    }
+
+    std::vector<T> items_;
+    size_t head_ = 0;
+};
+
+} // namespace trading
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace trading {
+
+/**
+ * @brief Price a continuous-matching trade executes at
+ */
+enum class TradePrice {
+    ASK,       // The ask level's price
+    PASSIVE,   // The price of whichever order rested first (the maker)
+    MIDPOINT   // Halfway between the bid and ask levels
+};
+
+namespace matching {
+
+/**
+ * @brief Quantity each order of one level executes when the level trades `quantity`
+ * @param top_order_first The front order fills before the rest share pro rata
+ *
+ * Shares are proportional to order size. The last order takes what
+ * rounding left over, so the shares add up to `quantity` exactly.
+ */
+template <typename Queue>
+void proRataShares(const Queue& orders, double total, double quantity, bool top_order_first,
+                   std::vector<double>& shares) {
+    shares.resize(orders.size());
+    size_t first = 0;
+    if (top_order_first) {
+        shares[0] = std::min(orders[0].quantity, quantity);
+        quantity -= shares[0];
+        total -= orders[0].quantity;
+        first = 1;
+    }
+    if (quantity >= total) {
+        for (size_t i = first; i < orders.size(); ++i) {
+            shares[i] = orders[i].quantity;
+        }
+        return;
+    }
+    const double ratio = quantity / total;
+    double allocated = 0.0;
+    for (size_t i = first; i + 1 < orders.size(); ++i) {
+        shares[i] = orders[i].quantity * ratio;
+        allocated += shares[i];
+    }
+    if (first < orders.size()) {
+        shares.back() = std::clamp(quantity - allocated, 0.0, orders.back().quantity);
+    }
+}
+
+/**
+ * @brief Trade two crossing levels pro rata
+ *
+ * The smaller level fills completely, in time order; the larger one is
+ * shared out by proRataShares. fill(bid, ask, quantity) records each trade
+ * and takes the quantity off both orders. Rounding dust the shares leave
+ * over goes to the latest shared orders that still have quantity, never
+ * beyond what they hold.
+ */
+template <bool kTopOrderFirst, typename Queue, typename Fill>
+void matchProRata(Queue& bids, Queue& asks, std::vector<double>& shares, Fill&& fill) {
+    double bid_total = 0.0, ask_total = 0.0;
+    for (const auto& order : bids) bid_total += order.quantity;
+    for (const auto& order : asks) ask_total += order.quantity;
+
+    const bool bids_fill = bid_total <= ask_total;
+    Queue& full = bids_fill ? bids : asks;
+    Queue& shared = bids_fill ? asks : bids;
+    proRataShares(shared, bids_fill ? ask_total : bid_total, std::min(bid_total, ask_total),
+                  kTopOrderFirst, shares);
+
+    size_t j = 0;
+    for (auto& order : full) {
+        while (order.quantity > 0) {
+            while (j < shares.size() && shares[j] <= 0) ++j;
+            if (j == shares.size()) {
+                // Rounding dust: the latest counterparty with quantity left
+                // takes what it can; with none left, the dust stays put
+                while (j > 0 && shared[j - 1].quantity <= 0) --j;
+                if (j == 0) {
+                    return;
+                }
+                --j;
+                shares[j] = std::min(order.quantity, shared[j].quantity);
+            }
+            const double quantity = std::min(order.quantity, shares[j]);
+            if (bids_fill) {
+                fill(order, shared[j], quantity);
+            } else {
+                fill(shared[j], order, quantity);
+            }
+            shares[j] -= quantity;
+        }
+    }
+}
+
+template <TradePrice kRule, typename OrderT>
+double tradePrice(const OrderT& bid, const OrderT& ask) {
+    if constexpr (kRule == TradePrice::ASK) {
+        return ask.price;
+    } else if constexpr (kRule == TradePrice::PASSIVE) {
+        return bid.seq < ask.seq ? bid.price : ask.price;
+    } else {
+        return 0.5 * (bid.price + ask.price);
+    }
+}
+
+} // namespace matching
+
+/**
+ * @brief Matching policies for BasicOrderBook
+ *
+ * A policy decides how the best bid level and the best ask level of a
+ * crossed book trade against each other (matchLevels) and at what price
+ * (trade_price). matchLevels must use up at least one of the two levels
+ * and calls fill(bid, ask, quantity) for every trade; the book records the
+ * trade, reduces both orders and drops those that reach zero afterwards.
+ * A policy that only ever fills a level from its front sets fills_front,
+ * and the book then drops the filled orders without looking further.
+ * `scratch` is a buffer the book keeps between calls.
+ *
+ * Everything is static and resolved at compile time, so each book type
+ * gets its own matching loop with the policy inlined.
+ */
+
+/**
+ * @brief Price-time priority: orders at a level fill one after another
+ */
+template <TradePrice kTradePrice = TradePrice::ASK>
+struct FifoMatching {
+    static constexpr TradePrice trade_price = kTradePrice;
+    static constexpr bool fills_front = true;
+
+    template <typename Queue, typename Fill>
+    static void matchLevels(Queue& bids, Queue& asks, std::vector<double>& /*scratch*/, Fill&& fill) {
+        size_t i = 0, j = 0;
+        while (i < bids.size() && j < asks.size()) {
+            fill(bids[i], asks[j], std::min(bids[i].quantity, asks[j].quantity));
+            if (bids[i].quantity <= 0) ++i;
+            if (asks[j].quantity <= 0) ++j;
+        }
+    }
+};
+
+/**
+ * @brief Pro rata: the larger level is shared in proportion to order size
+ */
+template <TradePrice kTradePrice = TradePrice::ASK>
+struct ProRataMatching {
+    static constexpr TradePrice trade_price = kTradePrice;
+    static constexpr bool fills_front = false;
+
+    template <typename Queue, typename Fill>
+    static void matchLevels(Queue& bids, Queue& asks, std::vector<double>& scratch, Fill&& fill) {
+        matching::matchProRata<false>(bids, asks, scratch, fill);
+    }
+};
+
+/**
+ * @brief Pro rata with top-order priority: the earliest order at the
+ * larger level fills first, then the rest share pro rata
+ */
+template <TradePrice kTradePrice = TradePrice::ASK>
+struct TopOrderProRataMatching {
+    static constexpr TradePrice trade_price = kTradePrice;
+    static constexpr bool fills_front = false;
+
+    template <typename Queue, typename Fill>
+    static void matchLevels(Queue& bids, Queue& asks, std::vector<double>& scratch, Fill&& fill) {
+        matching::matchProRata<true>(bids, asks, scratch, fill);
+    }
+};
+
+} // namespace trading
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace trading {
+
+/**
+ * @brief Monotonic engine counters
+ */
+enum class Counter {
+    ORDERS_IN,        // addOrder calls (accepted or not)
+    ORDERS_REJECTED,  // addOrder calls that failed validation
+    FILLS,            // Trades executed by matchOrders and uncross
+    CANCELS,          // Successful cancelOrder calls
+    TICKS,            // Market-data ticks through the pipeline
+    SMA_UPDATES       // SMACalculator::addPrice calls
+};
+
+constexpr size_t kCounterCount = 6;
+
+/**
+ * @brief Engine gauges, summed across every live OrderBook
+ */
+enum class Gauge {
+    PRICE_LEVELS,
+    RESTING_ORDERS
+};
+
+constexpr size_t kGaugeCount = 2;
+
+/**
+ * @brief Process-wide engine metrics with per-thread sharding
+ *
+ * Every thread updates its own cache-line-aligned shard, so the hot path
+ * is an uncontended relaxed add on a line no other thread writes. Reads
+ * sum all shards on demand; they are cheap but not a consistent snapshot
+ * across metrics, which is fine for scraping.
+ */
+class EngineMetrics {
+public:
+    static constexpr size_t kShardCount = 64;
+
+    struct Snapshot {
+        std::array<uint64_t, kCounterCount> counters{};
+        std::array<int64_t, kGaugeCount> gauges{};
+
+        uint64_t operator[](Counter c) const { return counters[static_cast<size_t>(c)]; }
+        int64_t operator[](Gauge g) const { return gauges[static_cast<size_t>(g)]; }
+    };
+
+    static void increment(Counter counter, uint64_t n = 1) {
+        threadShard().values[static_cast<size_t>(counter)].fetch_add(
+            static_cast<int64_t>(n), std::memory_order_relaxed);
+    }
+
+    static void adjust(Gauge gauge, int64_t delta) {
+        threadShard().values[kCounterCount + static_cast<size_t>(gauge)].fetch_add(
+            delta, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sum every shard
+     */
+    static Snapshot snapshot();
+
+    /**
+     * @brief Render all metrics in Prometheus text exposition format (v0.0.4)
+     */
+    static std::string renderPrometheus();
+
+    /**
+     * @brief Zero the counters (gauges track live state and are kept)
+     */
+    static void resetCounters();
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<int64_t>, kCounterCount + kGaugeCount> values{};
+    };
+
+    static Shard& threadShard() {
+        thread_local Shard* shard = &assignShard();
+        return *shard;
+    }
+
+    static Shard& assignShard();
+    static std::array<Shard, kShardCount>& shards();
+};
+
+/**
+ * @brief One object's contribution to a gauge
+ *
+ * Removes its contribution when destroyed and re-adds it when copied, so
+ * an owner (e.g. OrderBook) keeps the process-wide gauge exact without
+ * writing its own copy/destroy logic.
+ */
+class GaugeContribution {
+public:
+    explicit GaugeContribution(Gauge gauge) : gauge_(gauge) {}
+
+    GaugeContribution(const GaugeContribution& other) : gauge_(other.gauge_) {
+        set(other.value_);
+    }
+
+    GaugeContribution& operator=(const GaugeContribution& other) {
+        if (this != &other) {
+            set(0);
+            gauge_ = other.gauge_;
+            set(other.value_);
+        }
+        return *this;
+    }
+
+    ~GaugeContribution() { set(0); }
+
+    void set(int64_t value) {
+        if (value != value_) {
+            EngineMetrics::adjust(gauge_, value - value_);
+            value_ = value;
+        }
+    }
+
+    int64_t value() const { return value_; }
+
+private:
+    Gauge gauge_;
+    int64_t value_ = 0;
+};
+
+} // namespace trading
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "latency_histogram.hpp"
+#include "metrics.hpp"
+
+namespace trading {
+
+/**
+ * @brief Stages a market-data tick passes through on its way to clients
+ */
+enum class PipelineStage {
+    GENERATE,   // Price model produces the tick
+    PROCESS,    // SMA update, matching, book reads
+    SERIALIZE,  // Market-data message encoding
+    FANOUT,     // Sends to every connected client
+    TOTAL       // First stamp to last stamp
+};
+
+constexpr size_t kPipelineStageCount = 5;
+
+/**
+ * @brief Monotonic clock shared by every pipeline stamp (nanoseconds)
+ *
+ * Same clock as Python's time.perf_counter_ns() / time.monotonic_ns()
+ * on Linux (CLOCK_MONOTONIC), so stamps from either side can be mixed.
+ */
+inline uint64_t monotonicNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Per-stage latency histograms for the end-to-end tick pipeline
+ *
+ * Each tick carries one timestamp per stage boundary; recordTick turns the
+ * five stamps into four stage latencies plus the total.
+ */
+class PipelineStats {
+public:
+    static constexpr size_t kStampCount = 5;
+
+    /**
+     * @brief Record one tick from its stage-boundary timestamps
+     * @param stamps Monotonic ns at: start, generated, processed, serialized, sent
+     *
+     * Out-of-order stamps are clamped so a stage never goes negative.
+     */
+    void recordTick(const std::array<uint64_t, kStampCount>& stamps) {
+        uint64_t prev = stamps[0];
+        for (size_t i = 1; i < kStampCount; ++i) {
+            uint64_t now = stamps[i] > prev ? stamps[i] : prev;
+            stages_[i - 1].record(now - prev);
+            prev = now;
+        }
+        stages_[static_cast<size_t>(PipelineStage::TOTAL)].record(prev - stamps[0]);
+        EngineMetrics::increment(Counter::TICKS);
+    }
+
+    const LatencyHistogram& stage(PipelineStage stage) const {
+        return stages_[static_cast<size_t>(stage)];
+    }
+
+    uint64_t ticks() const {
+        return stages_[static_cast<size_t>(PipelineStage::TOTAL)].count();
+    }
+
+    /**
+     * @brief Fraction of total pipeline time spent in a stage (by mean)
+     */
+    double share(PipelineStage stage) const {
+        double total = stages_[static_cast<size_t>(PipelineStage::TOTAL)].mean();
+        return total > 0.0 ? stages_[static_cast<size_t>(stage)].mean() / total : 0.0;
+    }
+
+    void reset() {
+        for (auto& histogram : stages_) {
+            histogram.reset();
+        }
+    }
+
+private:
+    std::array<LatencyHistogram, kPipelineStageCount> stages_;
+};
+
+} // namespace trading
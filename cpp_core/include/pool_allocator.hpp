@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+namespace trading {
+
+/**
+ * @brief Node allocator that recycles single-object blocks per thread
+ *
+ * Node-based containers (std::map, std::unordered_map) allocate exactly one
+ * node per element. Freed nodes go onto a thread-local free list for their
+ * type and are handed back on the next insert, so a book whose size has
+ * stopped growing stops touching the heap. Array allocations (n > 1, e.g.
+ * hash bucket arrays) go straight to operator new.
+ *
+ * Stateless, so containers using it copy, move and swap like the defaults.
+ * Cached nodes are released when the thread exits.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n == 1 && !t_torn_down) {
+            FreeList& list = freeList();
+            if (list.head) {
+                Node* node = list.head;
+                list.head = node->next;
+                return reinterpret_cast<T*>(node);
+            }
+            return static_cast<T*>(::operator new(kBlockBytes));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n == 1 && !t_torn_down) {
+            Node* node = reinterpret_cast<Node*>(p);
+            FreeList& list = freeList();
+            node->next = list.head;
+            list.head = node;
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+
+private:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "PoolAllocator does not support over-aligned types");
+
+    struct Node {
+        Node* next;
+    };
+
+    static constexpr std::size_t kBlockBytes = std::max(sizeof(T), sizeof(Node));
+
+    struct FreeList {
+        Node* head = nullptr;
+
+        ~FreeList() {
+            while (head) {
+                Node* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+            // Containers destroyed later on this thread free directly
+            t_torn_down = true;
+        }
+    };
+
+    static FreeList& freeList() {
+        thread_local FreeList list;
+        return list;
+    }
+
+    // Trivially destructible, so still readable after FreeList is gone
+    static thread_local bool t_torn_down;
+};
+
+template <typename T>
+thread_local bool PoolAllocator<T>::t_torn_down = false;
+
+} // namespace trading
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace trading {
+
+/**
+ * @brief Flat hash map keyed by order sequence number
+ *
+ * Sequence numbers are handed out in order, so an entry's home slot is
+ * just its seq modulo the power-of-two table size. Collisions probe
+ * linearly, Robin Hood style: runs stay sorted by home slot, so lookups
+ * stop as soon as they pass where the seq would be, and erase shifts the
+ * entries behind it back only up to the next one in its home slot. Orders
+ * live at the same time mostly sit in their home slots, one after
+ * another, and visiting many of them in seq order (a batch clear dropping
+ * its fills) is one forward pass over the table. The table doubles at 3/4
+ * full and keeps its size through clear().
+ *
+ * find() returns a pointer to the entry, or end() (nullptr) if absent;
+ * it is valid until the map is next modified. Sequence number 0 marks a
+ * free slot and cannot be a key.
+ */
+template <typename Value>
+class SeqMap {
+public:
+    struct Entry {
+        uint64_t first;   // Sequence number (0: free slot)
+        Value second;
+    };
+    using iterator = Entry*;
+    using value_type = Entry;
+
+    Entry* find(uint64_t seq) {
+        if (slots_.empty()) {
+            return nullptr;
+        }
+        for (size_t i = seq & mask_, dist = 0;; i = (i + 1) & mask_, ++dist) {
+            if (slots_[i].first == seq) {
+                return &slots_[i];
+            }
+            if (slots_[i].first == 0 || distance(i) < dist) {
+                return nullptr;
+            }
+        }
+    }
+
+    const Entry* find(uint64_t seq) const { return const_cast<SeqMap*>(this)->find(seq); }
+    Entry* end() const { return nullptr; }
+
+    /**
+     * @brief Start loading the home slot of seq, ahead of a find or erase
+     */
+    void prefetch(uint64_t seq) const {
+#if defined(__GNUC__) || defined(__clang__)
+        if (!slots_.empty()) {
+            __builtin_prefetch(&slots_[seq & mask_]);
+        }
+#else
+        (void)seq;
+#endif
+    }
+
+    /**
+     * @brief The value for seq, default-constructed if it was absent
+     */
+    Value& operator[](uint64_t seq) {
+        if (Entry* entry = find(seq)) {
+            return entry->second;
+        }
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        size_++;
+        return place(Entry{seq, Value()})->second;
+    }
+
+    size_t erase(uint64_t seq) {
+        Entry* entry = find(seq);
+        if (entry == nullptr) {
+            return 0;
+        }
+        erase(entry);
+        return 1;
+    }
+
+    void erase(Entry* entry) {
+        size_t hole = static_cast<size_t>(entry - slots_.data());
+        for (size_t j = (hole + 1) & mask_; slots_[j].first != 0 && distance(j) > 0; j = (j + 1) & mask_) {
+            slots_[hole] = std::move(slots_[j]);
+            hole = j;
+        }
+        slots_[hole].first = 0;
+        size_--;
+    }
+
+    void clear() {
+        if (size_ > 0) {
+            for (auto& slot : slots_) {
+                slot.first = 0;
+            }
+            size_ = 0;
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return slots_.size(); }
+    size_t memoryBytes() const { return slots_.capacity() * sizeof(Entry); }
+
+private:
+    // How far the entry in slot i sits past its home slot
+    size_t distance(size_t i) const { return (i - (slots_[i].first & mask_)) & mask_; }
+
+    // Inserts an entry known to be absent, displacing entries closer to
+    // home than it has come; returns where it landed
+    Entry* place(Entry entry) {
+        Entry* placed = nullptr;
+        for (size_t i = entry.first & mask_, dist = 0;; i = (i + 1) & mask_, ++dist) {
+            if (slots_[i].first == 0) {
+                slots_[i] = std::move(entry);
+                return placed != nullptr ? placed : &slots_[i];
+            }
+            const size_t resident = distance(i);
+            if (resident < dist) {
+                std::swap(entry, slots_[i]);
+                dist = resident;
+                if (placed == nullptr) {
+                    placed = &slots_[i];
+                }
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Entry> old(slots_.size() < 16 ? 16 : 2 * slots_.size(), Entry{0, Value()});
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        for (auto& slot : old) {
+            if (slot.first != 0) {
+                place(std::move(slot));
+            }
+        }
+    }
+
+    std::vector<Entry> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace trading
@@ -0,0 +1,440 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "engine.hpp"
+#include "seq_map.hpp"
+
+namespace trading {
+
+/**
+ * @brief Market model and order flow of a Simulation
+ *
+ * Times are simulated microseconds; drift and volatility are per simulated
+ * second (volatility per square-root second).
+ */
+struct SimulationConfig {
+    double initial_price = 45000.0;
+    double drift = 0.0;
+    double volatility = 0.0005;
+    long long price_interval_us = 500000;  // GBM step spacing; 0 disables the model
+    uint64_t seed = 0;
+    size_t sma_window = 20;
+
+    // Synthetic limit orders: Poisson arrivals, random side, priced within
+    // order_spread (a fraction of the price) of the last price; about one
+    // in five crosses it. They rest for order_lifetime_us (0: until filled).
+    double order_rate = 0.0;               // Orders per simulated second; 0 disables the flow
+    double order_spread = 0.002;
+    double max_quantity = 1.0;
+    double tick_size = 0.01;
+    long long order_lifetime_us = 5000000;
+};
+
+/**
+ * @brief What a Simulation has done so far
+ */
+struct SimulationStats {
+    uint64_t events = 0;
+    uint64_t price_steps = 0;   // Prices applied, from the model or schedulePrice
+    uint64_t orders = 0;        // Orders the book accepted
+    uint64_t rejected = 0;
+    uint64_t cancels = 0;       // Successful cancels
+    uint64_t trades = 0;
+    uint64_t expired = 0;
+    uint64_t wakeups = 0;
+    double volume = 0.0;
+};
+
+/**
+ * @brief Shape of one latency leg
+ */
+enum class LatencyDistribution {
+    FIXED,        // Always base_us
+    UNIFORM,      // base_us plus uniform in [0, spread_us)
+    EXPONENTIAL   // base_us plus exponential of mean spread_us: a long tail
+};
+
+/**
+ * @brief Latency of one leg between a participant and the exchange, in simulated us
+ */
+struct LatencyModel {
+    LatencyDistribution distribution = LatencyDistribution::FIXED;
+    long long base_us = 0;
+    double spread_us = 0.0;
+};
+
+/**
+ * @brief An execution of a participant order, as delivered to the participant
+ */
+struct ParticipantFill {
+    uint64_t client_id;          // From submitOrder
+    std::string order_id;        // The book's ID
+    OrderSide side;
+    double price;
+    double quantity;
+    double remaining;            // Still open after this fill
+    long long exchange_time_us;  // When it executed; delivered market-data latency later
+};
+
+/**
+ * @brief What one participant has done so far
+ */
+struct ParticipantStats {
+    uint64_t orders = 0;         // Orders the book accepted
+    uint64_t rejected = 0;
+    uint64_t cancels = 0;        // Cancels that reached a resting order
+    uint64_t fills = 0;
+    double filled_quantity = 0.0;
+};
+
+/**
+ * @brief Discrete-event simulation of the book, indicators and price model
+ *
+ * Events sit in a binary heap ordered by simulated time, ties in the order
+ * they were scheduled. run() pops and applies them one by one, jumping the
+ * clock from event to event, so a simulated day costs only its events:
+ * nothing waits on the wall clock. Every event first moves the book's
+ * engine clock (advanceTime, in ms) to the event time, so good-till orders
+ * expire on simulated time; trades are stamped with it too.
+ *
+ * Event kinds:
+ *  - price step: the next GBM price (exact log-normal step on
+ *    kernels::gaussianNormals, drawn in blocks) or a scheduled price. It
+ *    goes to the SMA and to OrderBook::processTick.
+ *  - order arrival: a synthetic or scheduled limit order, matched at once.
+ *  - cancel, and expiry (at each good-till order's deadline).
+ *  - wakeup: calls the wakeup handler with the caller's token.
+ *
+ * Participants (addParticipant) trade through latency: submitOrder and
+ * submitCancel reach the book one order-entry latency later; their fills,
+ * and the prices, public trades and top-of-book changes they subscribe to,
+ * reach them one market-data latency later. Each leg
+ * keeps its messages in order, like a session would. Latency draws have
+ * their own random stream, so adding participants leaves the market's
+ * price path and synthetic flow as they were.
+ *
+ * A resting participant order knows the quantity queued ahead of it at its
+ * level (queueAhead). With participants, the simulation follows every
+ * resting order by seq and keeps each level's total and the volume it has
+ * lost: an arriving participant order starts with everything at its level
+ * ahead, as an offset into that running total, and a trade, cancel or
+ * expiry costs one lookup and a few additions. Volume lost behind a
+ * participant order is set aside by arrival, and only added back when its
+ * queue position is read: at once for the oldest participant order at a
+ * level, which fills reach first, otherwise by summing the losses on the
+ * shorter side of its arrival. None of it scans the book, however deep. Orders
+ * already in the book are taken over once, on the first step; ones added
+ * to the book directly after that are not counted. An iceberg ahead counts
+ * only its displayed tranche: its refills join the back of the queue.
+ *
+ * A run with the same config and schedule is deterministic. Not thread-safe.
+ */
+class Simulation {
+public:
+    using WakeupHandler = std::function<void(Simulation&, uint64_t token)>;
+    using FillHandler = std::function<void(Simulation&, const ParticipantFill&)>;
+    using PriceHandler = std::function<void(Simulation&, double price, long long exchange_time_us)>;
+    using TradeHandler = std::function<void(Simulation&, const Trade&)>;
+    using BookHandler = std::function<void(Simulation&, double best_bid, double best_ask)>;
+
+    explicit Simulation(const SimulationConfig& config = SimulationConfig());
+
+    /**
+     * @brief Schedule a limit order
+     * @param lifetime_us Expire it this long after arrival (0: good till cancelled)
+     * @throws std::invalid_argument if time_us is before now()
+     *
+     * Invalid prices or quantities are counted as rejected when the order arrives.
+     */
+    void scheduleOrder(long long time_us, OrderSide side, double price, double quantity,
+                       long long lifetime_us = 0);
+
+    /**
+     * @brief Schedule a cancel of an order ID returned by the book
+     * @throws std::invalid_argument if time_us is before now()
+     */
+    void scheduleCancel(long long time_us, const std::string& order_id);
+
+    /**
+     * @brief Schedule an exogenous price (e.g. a replayed tick)
+     * @throws std::invalid_argument if time_us is before now()
+     */
+    void schedulePrice(long long time_us, double price);
+
+    /**
+     * @brief Schedule a call of the wakeup handler
+     * @throws std::invalid_argument if time_us is before now()
+     */
+    void scheduleWakeup(long long time_us, uint64_t token);
+
+    /**
+     * @brief Handler for wakeup events; it may schedule further events
+     */
+    void setWakeupHandler(WakeupHandler handler) { wakeup_handler_ = std::move(handler); }
+
+    /**
+     * @brief Add a participant that trades through latency
+     * @param order_entry Latency from the participant to the book
+     * @param market_data Latency from the book to the participant
+     * @return size_t The participant's index
+     * @throws std::invalid_argument for a negative base or spread
+     *
+     * Add participants before running, not from a handler.
+     */
+    size_t addParticipant(const LatencyModel& order_entry = LatencyModel(),
+                          const LatencyModel& market_data = LatencyModel());
+
+    /**
+     * @brief Handler for the participant's fill notices; it may submit orders
+     * @throws std::invalid_argument for an unknown participant
+     */
+    void setFillHandler(size_t participant, FillHandler handler);
+
+    /**
+     * @brief Handler for the prices the participant sees; it may submit orders
+     * @throws std::invalid_argument for an unknown participant
+     */
+    void setPriceHandler(size_t participant, PriceHandler handler);
+
+    /**
+     * @brief Handler for the public trade feed the participant sees
+     * @throws std::invalid_argument for an unknown participant
+     *
+     * Each trade arrives one market-data latency after it executed; its
+     * timestamp is the execution time in simulated milliseconds.
+     */
+    void setTradeHandler(size_t participant, TradeHandler handler);
+
+    /**
+     * @brief Handler for top-of-book changes the participant sees (0: side empty)
+     * @throws std::invalid_argument for an unknown participant
+     *
+     * A notice goes out after every event that moves the best bid or ask.
+     */
+    void setBookHandler(size_t participant, BookHandler handler);
+
+    /**
+     * @brief Send a limit order; it reaches the book after order-entry latency
+     * @return uint64_t Client ID for submitCancel and queueAhead
+     * @throws std::invalid_argument for an unknown participant
+     *
+     * Invalid prices or quantities are counted as rejected on arrival.
+     */
+    uint64_t submitOrder(size_t participant, OrderSide side, double price, double quantity);
+
+    /**
+     * @brief Send a cancel; it reaches the book after order-entry latency
+     * @throws std::invalid_argument for an unknown participant
+     *
+     * Cancels of orders that have filled, or were never sent, do nothing.
+     */
+    void submitCancel(size_t participant, uint64_t client_id);
+
+    /**
+     * @brief Quantity queued ahead of a resting participant order at its level
+     * @return double -1 unless the order rests in the book
+     */
+    double queueAhead(uint64_t client_id) const;
+
+    /**
+     * @throws std::invalid_argument for an unknown participant
+     */
+    const ParticipantStats& participantStats(size_t participant) const;
+    size_t participants() const { return participants_.size(); }
+
+    /**
+     * @brief Apply every event due at or before end_us, then move the clock there
+     * @return size_t Number of events applied
+     */
+    size_t runUntil(long long end_us);
+
+    /**
+     * @brief Apply the next event, if any
+     * @return bool False when nothing is scheduled
+     */
+    bool step();
+
+    long long now() const { return now_; }
+    size_t pendingEvents() const { return queue_.size(); }
+
+    double price() const { return price_; }
+    const SMACalculator& sma() const { return sma_; }
+    OrderBook& book() { return book_; }
+    const OrderBook& book() const { return book_; }
+    const SimulationStats& stats() const { return stats_; }
+    const SimulationConfig& config() const { return config_; }
+
+private:
+    enum class EventType : uint8_t {
+        PRICE_STEP,  // Next model price; schedules the one after
+        PRICE,       // Scheduled price
+        ORDER_FLOW,  // Next synthetic order; schedules the one after
+        ORDER,       // Scheduled order
+        CANCEL,
+        EXPIRY,      // Only moves the clock; the book's wheel does the rest
+        WAKEUP,
+        CLIENT_ORDER,   // Participant order reaching the book
+        CLIENT_CANCEL,  // Participant cancel reaching the book
+        FILL_NOTICE,    // Fill reaching the participant
+        PRICE_NOTICE,   // Price reaching the participant
+        TRADE_NOTICE,   // Public trade reaching the participant
+        BOOK_NOTICE     // Top of book reaching the participant
+    };
+
+    struct Event {
+        Event(long long t, EventType k) : time(t), type(k) {}
+
+        long long time;
+        uint64_t seq = 0;    // Scheduling order, breaks ties
+        EventType type;
+        OrderSide side = OrderSide::BUY;
+        uint32_t participant = 0;
+        double price = 0.0;      // BOOK_NOTICE: best bid
+        double quantity = 0.0;   // BOOK_NOTICE: best ask
+        double remaining = 0.0;  // FILL_NOTICE: quantity still open
+        uint64_t ref = 0;    // ORDER: lifetime in us; CANCEL: order seq; WAKEUP: token;
+                             // CLIENT_*, FILL_NOTICE: client ID; TRADE_NOTICE: buy order seq
+        uint64_t other = 0;  // TRADE_NOTICE: sell order seq
+        long long sent = 0;  // *_NOTICE: exchange time
+    };
+
+    // Heap order: the earliest event, then the earliest scheduled, on top
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+        }
+    };
+
+    struct Participant {
+        LatencyModel order_entry;
+        LatencyModel market_data;
+        long long last_entry = 0;   // Arrival of its latest message, keeping the leg in order
+        long long last_notice = 0;
+        FillHandler on_fill;
+        PriceHandler on_price;
+        TradeHandler on_trade;
+        BookHandler on_book;
+        ParticipantStats stats;
+    };
+
+    // A participant order from submission until it leaves the book and its
+    // last fill notice is delivered
+    struct ClientOrder {
+        uint32_t participant;
+        OrderSide side;
+        bool resting = false;
+        double price;
+        double remaining;
+        double offset = 0.0;        // Its level's consumed total once nothing is ahead
+        uint64_t seq = 0;           // Book sequence, once accepted
+        uint64_t arrival = 0;       // Participant orders at its level before it
+        uint32_t notices = 0;       // Fill notices in flight
+    };
+
+    // A resting order the simulation follows: its level, the quantity it
+    // still shows, and how many participant orders had joined its level
+    // before it (those are ahead of it; a requeued iceberg tranche counts
+    // again, from the back)
+    struct QueuedOrder {
+        OrderSide side;
+        bool iceberg;
+        double price;
+        double open;
+        uint64_t arrival;
+    };
+
+    // Everything resting at one price, and the participant orders among it.
+    // While any rest, consumed grows with every quantity the level loses;
+    // behind[i] is the part of it lost by orders with arrival
+    // first_behind + i, behind the participant orders before them, and
+    // behind_total is their sum.
+    struct QueueLevel {
+        double quantity = 0.0;
+        size_t orders = 0;
+        double consumed = 0.0;
+        uint64_t arrivals = 0;
+        uint64_t first_behind = 0;
+        double behind_total = 0.0;
+        std::deque<double> behind;
+        std::vector<std::pair<uint64_t, uint64_t>> clients;  // (arrival, client ID), oldest first
+    };
+
+    void push(Event event);
+    void checkTime(long long time_us) const;
+    Participant& participant(size_t index);
+    long long latency(const LatencyModel& model);
+    void apply(const Event& event);
+    void applyPrice(double price);
+    void applyOrder(OrderSide side, double price, double quantity, long long lifetime_us);
+    void applyClientOrder(const Event& event);
+    void applyClientCancel(const Event& event);
+    void deliverFill(const Event& event);
+    void recordTrades();
+    void settleExpired();
+    void publishBook();
+    long long entryTime(Participant& sender);
+    long long noticeTime(Participant& receiver);
+    void fillClient(uint64_t seq, const Trade& trade);
+    void follow(uint64_t seq, OrderSide side, double price, double quantity, bool iceberg = false);
+    void followBook();
+    void consumeAhead(uint64_t seq, double quantity);
+    void dropOrder(uint64_t seq);
+    void trackClient(uint64_t client_id, ClientOrder& order);
+    void untrackClient(ClientOrder& order);
+    double aheadOf(const ClientOrder& order) const;
+    std::unordered_map<double, QueueLevel>& queueSide(OrderSide side) {
+        return side == OrderSide::BUY ? queue_bids_ : queue_asks_;
+    }
+    const std::unordered_map<double, QueueLevel>& queueSide(OrderSide side) const {
+        return side == OrderSide::BUY ? queue_bids_ : queue_asks_;
+    }
+    double nextNormal();
+    long long nextArrival();
+
+    SimulationConfig config_;
+    OrderBook book_;
+    SMACalculator sma_;
+    SimulationStats stats_;
+
+    std::vector<Event> queue_;
+    uint64_t next_seq_ = 0;
+    long long now_ = 0;
+    double price_;
+
+    // GBM shocks come from the counter-based stream in blocks
+    std::vector<double> normals_;
+    size_t next_normal_ = 0;
+    uint64_t normal_offset_ = 0;
+    double step_mean_ = 0.0;
+    double step_scale_ = 0.0;
+
+    std::mt19937_64 flow_rng_;
+    std::mt19937_64 latency_rng_;
+    WakeupHandler wakeup_handler_;
+
+    std::vector<Participant> participants_;
+    double published_bid_ = 0.0;   // Top of book last sent to book handlers
+    double published_ask_ = 0.0;
+    uint64_t next_client_id_ = 1;
+    std::unordered_map<uint64_t, ClientOrder> client_orders_;  // By client ID
+    std::unordered_map<uint64_t, uint64_t> client_by_seq_;     // Book seq -> client ID, while resting
+    SeqMap<QueuedOrder> queued_;       // Followed orders by book seq, with participants
+    std::unordered_map<double, QueueLevel> queue_bids_;
+    std::unordered_map<double, QueueLevel> queue_asks_;
+    bool followed_book_ = false;       // Orders already resting taken over
+    size_t next_refill_ = 0;           // First of refills_ not yet followed
+
+    // Reused between events
+    std::vector<Trade> trades_;
+    std::vector<ExpiredOrder> expired_;
+    std::vector<IcebergRefill> refills_;
+};
+
+} // namespace trading
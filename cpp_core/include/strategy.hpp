@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "engine.hpp"
+#include "simulation.hpp"
+#include "tick_store.hpp"
+
+namespace trading {
+
+/**
+ * @brief What a strategy can see and do from its callbacks
+ *
+ * Orders go through the strategy's participant in the simulation, so they
+ * pay order-entry latency; what it sees has paid market-data latency.
+ * Position and cash follow the fills as they are delivered.
+ */
+class StrategyContext {
+public:
+    /**
+     * @brief Send a limit order
+     * @return uint64_t Client ID, as in the fills and for cancelOrder
+     */
+    uint64_t submitOrder(OrderSide side, double price, double quantity);
+
+    /**
+     * @brief Send a cancel of an order from submitOrder
+     */
+    void cancelOrder(uint64_t client_id);
+
+    /**
+     * @brief Quantity queued ahead of a resting order (-1 if not resting)
+     */
+    double queueAhead(uint64_t client_id) const;
+
+    long long now() const { return simulation_->now(); }
+    double position() const { return position_; }
+    double cash() const { return cash_; }
+    double lastPrice() const { return last_price_; }   // Latest price delivered
+    double bestBid() const { return best_bid_; }       // Latest top of book delivered
+    double bestAsk() const { return best_ask_; }
+
+private:
+    friend class Backtest;
+
+    Simulation* simulation_ = nullptr;
+    size_t participant_ = 0;
+    double position_ = 0.0;
+    double cash_ = 0.0;
+    double last_price_ = 0.0;
+    double best_bid_ = 0.0;
+    double best_ask_ = 0.0;
+};
+
+/**
+ * @brief Trading logic run next to the book by a Backtest
+ *
+ * Every callback runs on the simulation's thread, in simulated time, when
+ * the data reaches the strategy; none of them needs to be overridden.
+ */
+class Strategy {
+public:
+    virtual ~Strategy() = default;
+
+    virtual void onTick(StrategyContext& /*context*/, double /*price*/) {}
+    virtual void onTrade(StrategyContext& /*context*/, const Trade& /*trade*/) {}
+    virtual void onBookUpdate(StrategyContext& /*context*/, double /*best_bid*/, double /*best_ask*/) {}
+    virtual void onFill(StrategyContext& /*context*/, const ParticipantFill& /*fill*/) {}
+
+    /**
+     * @brief Called once when a run ends
+     */
+    virtual void onFinish(StrategyContext& /*context*/) {}
+};
+
+/**
+ * @brief Reference strategy: long above the slow SMA, short below it
+ *
+ * Each tick feeds a fast and a slow SMACalculator. Once the slow window is
+ * full, every change of sign of fast minus slow cancels the working order
+ * and sends one marketable limit order (slippage past the price) for the
+ * difference between the target position, +/-quantity, and the position.
+ */
+class SMACrossoverStrategy : public Strategy {
+public:
+    /**
+     * @throws std::invalid_argument unless 0 < fast_window < slow_window,
+     *         quantity > 0 and slippage >= 0
+     */
+    SMACrossoverStrategy(size_t fast_window, size_t slow_window, double quantity, double slippage = 0.001);
+
+    void onTick(StrategyContext& context, double price) override;
+    void onFill(StrategyContext& context, const ParticipantFill& fill) override;
+
+    uint64_t crossovers() const { return crossovers_; }
+    const SMACalculator& fast() const { return fast_; }
+    const SMACalculator& slow() const { return slow_; }
+
+private:
+    SMACalculator fast_;
+    SMACalculator slow_;
+    size_t slow_window_;
+    double quantity_;
+    double slippage_;
+    int signal_ = 0;         // +1 long, -1 short, 0 before the slow window fills
+    uint64_t working_ = 0;   // Client ID of the open order, 0 if none
+    uint64_t crossovers_ = 0;
+};
+
+/**
+ * @brief Everything a BatchStrategy collected since its last call
+ */
+struct StrategyBatch {
+    std::vector<long long> tick_times;   // Delivery times (simulated us)
+    std::vector<double> tick_prices;
+    std::vector<Trade> trades;
+    std::vector<ParticipantFill> fills;
+    double best_bid = 0.0;               // Latest top of book delivered
+    double best_ask = 0.0;
+
+    bool empty() const { return tick_times.empty() && trades.empty() && fills.empty(); }
+    void clear();
+};
+
+/**
+ * @brief Strategy that hands its callbacks over in batches
+ *
+ * For handlers that are expensive to call per event (e.g. Python): ticks,
+ * trades and fills are buffered and the handler gets them every
+ * batch_ticks ticks, and once more with the rest when the run ends.
+ */
+class BatchStrategy : public Strategy {
+public:
+    using Handler = std::function<void(StrategyContext&, const StrategyBatch&)>;
+
+    /**
+     * @throws std::invalid_argument if batch_ticks is 0
+     */
+    BatchStrategy(Handler handler, size_t batch_ticks);
+
+    void onTick(StrategyContext& context, double price) override;
+    void onTrade(StrategyContext& context, const Trade& trade) override;
+    void onBookUpdate(StrategyContext& context, double best_bid, double best_ask) override;
+    void onFill(StrategyContext& context, const ParticipantFill& fill) override;
+    void onFinish(StrategyContext& context) override;
+
+    uint64_t batches() const { return batches_; }
+
+private:
+    void flush(StrategyContext& context);
+
+    Handler handler_;
+    size_t batch_ticks_;
+    StrategyBatch batch_;
+    uint64_t batches_ = 0;
+};
+
+/**
+ * @brief Market and latency of a Backtest
+ *
+ * The market's synthetic flow is the liquidity the strategy trades
+ * against; it defaults to 20 orders per simulated second.
+ */
+struct BacktestConfig {
+    BacktestConfig() { market.order_rate = 20.0; }
+
+    SimulationConfig market;
+    LatencyModel order_entry;
+    LatencyModel market_data;
+};
+
+/**
+ * @brief Outcome of one backtest run
+ */
+struct BacktestResult {
+    uint64_t ticks = 0;          // Prices delivered to the strategy
+    uint64_t orders = 0;         // Strategy orders the book accepted
+    uint64_t rejected = 0;
+    uint64_t cancels = 0;
+    uint64_t fills = 0;
+    double traded_quantity = 0.0;
+    double position = 0.0;
+    double cash = 0.0;
+    double pnl = 0.0;            // Cash plus the position marked at the last price
+    double max_drawdown = 0.0;   // Largest fall of marked equity from its peak
+    long long end_us = 0;
+    SimulationStats market;
+};
+
+/**
+ * @brief Runs a Strategy against a simulated market
+ *
+ * The strategy is a participant of a Simulation (see addParticipant), so
+ * its orders meet latency and queue behind the orders ahead of them; its
+ * callbacks run inline with the event loop, with no calls across a
+ * language boundary. run() uses the simulation's price model; replay()
+ * feeds recorded prices instead, in chunks, so the event queue stays
+ * small. Each run starts a fresh market; the strategy keeps its state.
+ * Not thread-safe.
+ */
+class Backtest {
+public:
+    explicit Backtest(Strategy& strategy, const BacktestConfig& config = BacktestConfig());
+
+    /**
+     * @brief Run on the market's own price model until end_us
+     * @throws std::invalid_argument if the model is disabled (price_interval_us 0)
+     */
+    BacktestResult run(long long end_us);
+
+    /**
+     * @brief Run on recorded prices, the price model off
+     * @param times_us Non-decreasing, non-negative tick times (simulated us)
+     * @throws std::invalid_argument for unordered or negative times, or a price <= 0
+     */
+    BacktestResult replay(const long long* times_us, const double* prices, size_t count);
+
+    /**
+     * @brief The last run's market (nullptr before the first run)
+     */
+    const Simulation* simulation() const { return simulation_.get(); }
+    const BacktestConfig& config() const { return config_; }
+
+private:
+    friend class ParallelBacktest;
+
+    static void checkTicks(const long long* times_us, const double* prices, size_t count, long long after);
+    void start(SimulationConfig market);
+    void feed(const long long* times_us, const double* prices, size_t count);
+    BacktestResult finish(long long end_us);
+    void mark();
+
+    Strategy& strategy_;
+    BacktestConfig config_;
+    std::unique_ptr<Simulation> simulation_;
+    StrategyContext context_;
+    BacktestResult result_;
+    double peak_equity_ = 0.0;
+};
+
+/**
+ * @brief Runs many strategies over one recorded tick stream on worker threads
+ *
+ * Every strategy gets its own Backtest, i.e. its own market: book,
+ * synthetic liquidity and latency, so variants never see each other's
+ * orders. The stream is decoded once, a batch at a time, into a buffer
+ * the workers share read-only. Workers advance their backtests (assigned
+ * round-robin) through a batch while the next one is decoded into a
+ * second buffer, then all meet at a barrier: lock-step, with nothing
+ * shared between workers but the batch, so throughput grows with cores.
+ * Results match running each Backtest::replay alone.
+ *
+ * Strategy callbacks run on the worker threads; a strategy must not share
+ * mutable state with another one. Not thread-safe otherwise.
+ */
+class ParallelBacktest {
+public:
+    static constexpr size_t kDefaultBatch = 16384;
+
+    /**
+     * @param threads Worker threads (0: one per hardware thread)
+     */
+    explicit ParallelBacktest(size_t threads = 0);
+
+    /**
+     * @brief Add a strategy, to be run in its own market
+     * @return size_t Index of its result
+     */
+    size_t add(Strategy& strategy, const BacktestConfig& config = BacktestConfig());
+
+    /**
+     * @brief Replay ticks to every strategy
+     * @return std::vector<BacktestResult> One per strategy, in the order added
+     * @throws std::invalid_argument as Backtest::replay, or if batch_ticks is 0
+     */
+    std::vector<BacktestResult> replay(const long long* times_us, const double* prices, size_t count,
+                                       size_t batch_ticks = kDefaultBatch);
+
+    /**
+     * @brief Replay the ticks of a store with from <= timestamp < to
+     * @param time_unit_us Microseconds per store time unit (1000 for milliseconds)
+     * @return std::vector<BacktestResult> As replay(); simulated time starts at the first tick
+     *
+     * Blocks are decoded once per batch for all the strategies.
+     */
+    std::vector<BacktestResult> replay(const TickStore& store, int64_t from, int64_t to,
+                                       long long time_unit_us = 1000, size_t batch_ticks = kDefaultBatch);
+
+    size_t size() const { return backtests_.size(); }
+    size_t threads() const { return threads_; }
+    const Backtest& backtest(size_t index) const { return *backtests_.at(index); }
+
+private:
+    // Fills times/prices with the next batch; false when the stream is done
+    using Source = std::function<bool(std::vector<long long>& times, std::vector<double>& prices)>;
+
+    std::vector<BacktestResult> run(const Source& next);
+
+    std::vector<std::unique_ptr<Backtest>> backtests_;
+    size_t threads_;
+};
+
+} // namespace trading
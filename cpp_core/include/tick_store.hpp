@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trading {
+
+/**
+ * @brief One price or trade print
+ */
+struct Tick {
+    int64_t timestamp;   // Any fixed unit (the backend uses milliseconds)
+    double price;
+    double quantity;     // 0 for plain price ticks
+};
+
+/**
+ * @brief On-disk block header, also kept in memory as the block index
+ *
+ * Blocks are fixed-size (TickStore::kBlockBytes) and laid out back to back,
+ * so block i starts at byte i * kBlockBytes of the file. Fields are in host
+ * byte order.
+ */
+struct TickBlock {
+    uint32_t magic;        // kTickBlockMagic
+    uint32_t count;        // Ticks in the block
+    uint32_t bits;         // Payload bits used
+    uint32_t sealed;       // 1 once full; only the last block may be 0
+    int64_t first_time;
+    int64_t last_time;
+    double min_price;
+    double max_price;
+    int64_t min_time;      // First tick at min_price
+    int64_t max_time;      // First tick at max_price
+    double first_price;
+    double last_price;
+    double volume;         // Sum of quantities
+};
+
+constexpr uint32_t kTickBlockMagic = 0x32424B54;  // "TKB2"
+
+/**
+ * @brief One point of a downsampled price series
+ */
+struct TickPoint {
+    int64_t timestamp;
+    double price;
+};
+
+/**
+ * @brief How TickStore::downsample picks its points
+ */
+enum class Downsample {
+    MIN_MAX,  // Lowest and highest tick of each of points/2 equal time buckets
+    LTTB      // Largest-Triangle-Three-Buckets over min/max-preselected ticks
+};
+
+/**
+ * @brief Append-only compressed tick history
+ *
+ * Each block encodes its ticks as one bitstream in the style of Facebook's
+ * Gorilla: timestamps as delta-of-deltas in variable-width buckets (regular
+ * ticks cost one bit) and prices/quantities as the XOR with the previous
+ * value, storing only the meaningful bits. A random walk on a tick grid
+ * at regular intervals takes about 2 bytes per tick (24 raw); jittered
+ * timestamps and trade sizes bring it to about 5.
+ *
+ * With a path, sealed blocks are written to the file as they fill and read
+ * back through a read-only memory map; flush() also writes the partial
+ * last block, and reopening the file resumes appending where it stopped.
+ * Without a path the store is in memory only.
+ *
+ * Timestamps must be non-decreasing, so the block index is sorted and range
+ * reads binary-search it. Not thread-safe.
+ */
+class TickStore {
+public:
+    static constexpr size_t kBlockBytes = 4096;
+
+    /**
+     * @brief Open (or create) a store
+     * @param path File to store blocks in; empty for an in-memory store
+     * @throws std::runtime_error if the file cannot be opened or is corrupt
+     */
+    explicit TickStore(const std::string& path = "");
+    ~TickStore();
+
+    TickStore(const TickStore&) = delete;
+    TickStore& operator=(const TickStore&) = delete;
+
+    /**
+     * @brief Append one tick
+     * @throws std::invalid_argument if timestamp is before the last one
+     */
+    void append(int64_t timestamp, double price, double quantity = 0.0);
+
+    /**
+     * @brief Write the partial last block to the file (no-op in memory)
+     */
+    void flush();
+
+    /**
+     * @brief Ticks with from <= timestamp < to, appended to out in order
+     * @return size_t Number of ticks appended
+     */
+    size_t read(int64_t from, int64_t to, std::vector<Tick>& out) const;
+
+    /**
+     * @brief Prices with from <= timestamp < to reduced to at most `points`
+     * @param points Output budget (>= 2), e.g. the chart width in pixels
+     * @param method MIN_MAX keeps every bucket's extremes (spikes survive);
+     *               LTTB keeps the visually dominant shape (MinMaxLTTB: LTTB
+     *               over the extremes of 2 * points buckets)
+     * @param out Points appended in time order; all raw ticks if they fit
+     * @return size_t Number of points appended
+     * @throws std::invalid_argument if points < 2
+     *
+     * Buckets that span whole blocks are answered from the block index and
+     * only blocks straddling a bucket boundary are decoded, so the cost
+     * grows with `points` rather than with the ticks in the range.
+     */
+    size_t downsample(int64_t from, int64_t to, size_t points, Downsample method,
+                      std::vector<TickPoint>& out) const;
+
+    /**
+     * @brief Index entry for block i (the last one may still be filling)
+     */
+    const TickBlock& block(size_t i) const;
+
+    size_t blockCount() const;
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * @brief Bytes the history occupies (full blocks plus the used part of the last)
+     */
+    size_t storedBytes() const;
+
+    const std::string& path() const { return path_; }
+
+private:
+    struct Block;
+    struct CodecState {
+        int64_t time = 0;
+        int64_t delta = 0;
+        uint64_t price = 0;
+        uint64_t quantity = 0;
+        int price_lead = -1;   // Previous XOR window; -1 before the first
+        int price_trail = 0;
+        int quantity_lead = -1;
+        int quantity_trail = 0;
+    };
+
+    const Block& blockData(size_t i) const;
+    size_t firstBlockEndingAtOrAfter(int64_t timestamp) const;
+    void edgeTicks(int64_t from, int64_t to, TickPoint& first, TickPoint& last) const;
+    void minMaxBuckets(int64_t from, int64_t to, size_t buckets, std::vector<TickPoint>& out) const;
+    void startBlock(int64_t timestamp, double price);
+    void sealBlock();
+    void openFile();
+    void mapSealed();
+    void writeBlock(size_t i, const Block& block);
+
+    std::string path_;
+    int fd_ = -1;
+
+    // Sealed blocks: a read-only mapping of the file, or a memory buffer
+    const uint8_t* mapped_ = nullptr;
+    size_t mapped_bytes_ = 0;
+    std::vector<uint8_t> memory_;
+
+    std::vector<TickBlock> index_;   // Headers of sealed blocks
+
+    std::unique_ptr<Block> active_;  // Block being filled
+    CodecState state_;
+    bool active_dirty_ = false;
+    size_t size_ = 0;
+};
+
+} // namespace trading
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace trading {
+
+/**
+ * @brief Hierarchical timing wheel of (deadline, id) timers
+ *
+ * Eleven levels of 64 slots cover the whole 64-bit clock. A timer sits
+ * on the level of the highest 6-bit digit in which its deadline differs
+ * from the current time, in the slot named by that digit. Scheduling is
+ * O(1). advance() jumps straight to the next occupied slot using one
+ * occupancy word per level, so idle stretches cost nothing. It moves the
+ * timers of a slot it reaches down a level at a time. Each timer therefore
+ * moves at most once per level before it fires: O(1) amortized.
+ *
+ * Timers cannot be removed. Owners drop stale ids when they fire (lazy
+ * cancellation). The slot vectors are allocated on the first schedule and
+ * keep their capacity. Not thread-safe.
+ */
+class TimingWheel {
+public:
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+    static constexpr size_t kLevels = (64 + kSlotBits - 1) / kSlotBits;
+
+    explicit TimingWheel(uint64_t now = 0) : now_(now) {}
+
+    /**
+     * @brief Fire `id` once the clock reaches `deadline`
+     *
+     * A deadline at or before now() fires on the next advance().
+     */
+    void schedule(uint64_t deadline, uint64_t id);
+
+    /**
+     * @brief Move the clock to `now` and collect every timer due by then
+     * @param expired Ids of the fired timers are appended (not cleared)
+     * @return size_t Number of timers fired
+     *
+     * A `now` before the current time only fires timers already due.
+     */
+    size_t advance(uint64_t now, std::vector<uint64_t>& expired);
+
+    uint64_t now() const { return now_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * @brief Drop every timer and restart the clock at `now`
+     */
+    void reset(uint64_t now = 0);
+
+    /**
+     * @brief Estimated heap + inline memory used by the wheel
+     */
+    size_t memoryBytes() const;
+
+private:
+    struct Timer {
+        uint64_t deadline;
+        uint64_t id;
+    };
+
+    void place(const Timer& timer);
+
+    std::vector<std::vector<Timer>> slots_;  // kLevels * kSlots, level-major
+    std::array<uint64_t, kLevels> occupied_{};  // Bit s set: slot s of the level holds timers
+    std::vector<Timer> due_;       // Scheduled at or before now_
+    std::vector<Timer> cascade_;   // A slot's timers while they are re-placed
+    uint64_t now_;
+    size_t size_ = 0;
+};
+
+} // namespace trading
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace trading {
+namespace trace {
+
+/**
+ * @brief Engine events captured by the trace points
+ */
+enum class EventType : uint32_t {
+    ORDER_ADD = 1,    // a = order seq, b = side (0 buy, 1 sell), price, quantity
+    ORDER_CANCEL,     // a = order seq, b = 1 if removed
+    MATCH_BEGIN,      // start of matchOrders
+    MATCH_END,        // b = number of trades
+    TRADE,            // a = buy seq, b = sell seq, price, quantity
+    SMA_UPDATE,       // price = new price, quantity = SMA after the update
+    STOP_TRIGGER,     // a = order seq, b = side (0 buy, 1 sell), price = limit (0 market), quantity
+    ORDER_EXPIRE      // a = order seq, b = side (0 buy, 1 sell), price, quantity = unfilled
+};
+
+/**
+ * @brief Fixed-size binary trace record (48 bytes)
+ */
+struct Record {
+    uint64_t tsc;
+    uint64_t a;
+    uint64_t b;
+    double price;
+    double quantity;
+    uint32_t type;
+    uint32_t thread_id;
+};
+
+static_assert(sizeof(Record) == 48, "trace records must stay fixed-size");
+
+/**
+ * @brief Header at the start of a dump file, followed by `count` Records
+ */
+struct FileHeader {
+    char magic[8];           // "TRDTRACE"
+    uint32_t version;
+    uint32_t record_size;
+    double ticks_per_us;     // TSC ticks per microsecond, calibrated at dump time
+    uint64_t tsc_base;       // TSC value of the oldest record
+    uint64_t count;
+};
+
+constexpr uint32_t kFileVersion = 1;
+
+/**
+ * @brief Read the timestamp counter (rdtsc on x86, steady_clock elsewhere)
+ */
+inline uint64_t readTsc() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief Single-producer flight-recorder ring, one per thread
+ *
+ * The owning thread writes with a plain store plus a release increment of
+ * `head_`; when full the oldest records are overwritten. Readers never
+ * block the writer: snapshot() copies and then discards any slot the
+ * writer may have reused during the copy.
+ */
+class TraceRing {
+public:
+    static constexpr size_t kCapacity = size_t{1} << 16;  // 3 MiB per thread
+
+    explicit TraceRing(uint32_t thread_id)
+        : records_(new Record[kCapacity]), thread_id_(thread_id) {}
+
+    void write(EventType type, uint64_t a, uint64_t b, double price, double quantity) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        Record& r = records_[head & (kCapacity - 1)];
+        r.tsc = readTsc();
+        r.a = a;
+        r.b = b;
+        r.price = price;
+        r.quantity = quantity;
+        r.type = static_cast<uint32_t>(type);
+        r.thread_id = thread_id_;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Append the ring's consistent records, oldest first, to `out`
+     */
+    void snapshot(std::vector<Record>& out) const;
+
+    void clear() { head_.store(0, std::memory_order_release); }
+
+    uint32_t threadId() const { return thread_id_; }
+
+private:
+    std::unique_ptr<Record[]> records_;
+    std::atomic<uint64_t> head_{0};
+    uint32_t thread_id_;
+};
+
+/**
+ * @brief The calling thread's ring (registered on first use)
+ */
+TraceRing& threadRing();
+
+/**
+ * @brief Record an event on the calling thread's ring
+ */
+inline void emit(EventType type, uint64_t a = 0, uint64_t b = 0,
+                 double price = 0.0, double quantity = 0.0) {
+    thread_local TraceRing* ring = &threadRing();
+    ring->write(type, a, b, price, quantity);
+}
+
+/**
+ * @brief Collect the records of every thread, sorted by timestamp
+ */
+std::vector<Record> collect();
+
+/**
+ * @brief Write all rings to a binary dump file (see FileHeader)
+ * @param path Output file path
+ * @return size_t Number of records written
+ * @throws std::runtime_error if the file cannot be written
+ */
+size_t dump(const std::string& path);
+
+/**
+ * @brief Discard all recorded events on every thread
+ */
+void clear();
+
+/**
+ * @brief Estimated TSC ticks per microsecond
+ */
+double ticksPerMicrosecond();
+
+} // namespace trace
+} // namespace trading
+
+// Compile-time toggle: define TRADING_ENABLE_TRACE to compile the engine's
+// trace points in. Without it the macro expands to nothing.
+#ifdef TRADING_ENABLE_TRACE
+#define TRADING_TRACE(...) ::trading::trace::emit(__VA_ARGS__)
+#else
+#define TRADING_TRACE(...) ((void)0)
+#endif
@@ -3,6 +3,8 @@ High-Performance Crypto Trading Simulator - C++ Engine
 Build script using scikit-build for cross-platform compatibility
 """
 
+import os
+import shlex
 from skbuild import setup
 from pathlib import Path
 
@@ -41,9 +43,11 @@ setup(
     
     # CMake configuration
     cmake_install_dir=".",
+    # Extra CMake options, e.g. TRADE_ENGINE_CMAKE_ARGS="-DTRADE_ENGINE_PGO=USE ..."
     cmake_args=[
         "-DCMAKE_BUILD_TYPE=Release",
-    ],
+        "-DTRADE_ENGINE_PYTHON=ON",
+    ] + shlex.split(os.environ.get("TRADE_ENGINE_CMAKE_ARGS", "")),
     
     # Classifiers for PyPI
     classifiers=[
@@ -0,0 +1,126 @@
+#include "alloc_tracking.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace trading {
+namespace alloc {
+
+namespace {
+
+// Plain thread_locals: no constructor, so reading them never allocates
+thread_local uint64_t t_allocations = 0;
+thread_local uint64_t t_deallocations = 0;
+thread_local uint64_t t_bytes = 0;
+
+} // namespace
+
+bool enabled() {
+#ifdef TRADING_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+Counters threadCounters() {
+    Counters c;
+    c.allocations = t_allocations;
+    c.deallocations = t_deallocations;
+    c.bytes = t_bytes;
+    return c;
+}
+
+#ifdef TRADING_ALLOC_TRACKING
+
+namespace {
+
+void* countedAlloc(std::size_t size) {
+    ++t_allocations;
+    t_bytes += size;
+    return std::malloc(size ? size : 1);
+}
+
+void* countedAlignedAlloc(std::size_t size, std::size_t align) {
+    ++t_allocations;
+    t_bytes += size;
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+    // aligned_alloc wants a size that is a multiple of the alignment
+    std::size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+}
+
+void countedFree(void* p) noexcept {
+    if (p) {
+        ++t_deallocations;
+        std::free(p);
+    }
+}
+
+void* allocOrThrow(std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* alignedAllocOrThrow(std::size_t size, std::align_val_t align) {
+    void* p = countedAlignedAlloc(size, static_cast<std::size_t>(align));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+#endif
+
+} // namespace alloc
+} // namespace trading
+
+#ifdef TRADING_ALLOC_TRACKING
+
+// Replacement global allocation functions. <new> declares them with default
+// visibility, so they also replace the allocator for libstdc++ code called by
+// the engine (e.g. std::string growth). Counters are per thread; diff them
+// around the calls of interest.
+
+using trading::alloc::allocOrThrow;
+using trading::alloc::alignedAllocOrThrow;
+using trading::alloc::countedAlloc;
+using trading::alloc::countedAlignedAlloc;
+using trading::alloc::countedFree;
+
+void* operator new(std::size_t size) { return allocOrThrow(size); }
+void* operator new[](std::size_t size) { return allocOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void* operator new(std::size_t size, std::align_val_t align) { return alignedAllocOrThrow(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return alignedAllocOrThrow(size, align); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(p); }
+
+#endif
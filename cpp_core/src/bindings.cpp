@@ -1,10 +1,493 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
+#include "alloc_tracking.hpp"
 #include "engine.hpp"
+#include "kernels.hpp"
+#include "metrics.hpp"
+#include "pipeline_stats.hpp"
+#include "simulation.hpp"
+#include "strategy.hpp"
+#include "tick_store.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <map>
 
 namespace py = pybind11;
 using namespace trading;
 
+namespace {
+
+const char* latencyOpName(LatencyOp op) {
+    switch (op) {
+        case LatencyOp::ADD: return "add";
+        case LatencyOp::MATCH: return "match";
+        case LatencyOp::CANCEL: return "cancel";
+        case LatencyOp::SNAPSHOT: return "snapshot";
+    }
+    return "unknown";
+}
+
+py::dict latencySummary(const LatencyHistogram& hist) {
+    py::dict d;
+    d["count"] = hist.count();
+    d["mean_ns"] = hist.mean();
+    d["min_ns"] = hist.min();
+    d["p50_ns"] = hist.percentile(50.0);
+    d["p90_ns"] = hist.percentile(90.0);
+    d["p99_ns"] = hist.percentile(99.0);
+    d["p999_ns"] = hist.percentile(99.9);
+    d["max_ns"] = hist.max();
+    return d;
+}
+
+py::dict auctionDict(const AuctionResult& result) {
+    py::dict d;
+    d["price"] = result.price;
+    d["volume"] = result.volume;
+    d["buy_surplus"] = result.buy_surplus;
+    d["price_levels"] = result.price_levels;
+    return d;
+}
+
+const char* pipelineStageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::GENERATE: return "generate";
+        case PipelineStage::PROCESS: return "process";
+        case PipelineStage::SERIALIZE: return "serialize";
+        case PipelineStage::FANOUT: return "fanout";
+        case PipelineStage::TOTAL: return "total";
+    }
+    return "unknown";
+}
+
+using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+const DoubleArray& requireVector(const DoubleArray& array, const char* name) {
+    if (array.ndim() != 1) {
+        throw std::invalid_argument(std::string(name) + " must be one-dimensional");
+    }
+    return array;
+}
+
+kernels::SimdPath simdPathFromName(const std::string& name) {
+    for (auto path : {kernels::SimdPath::SCALAR, kernels::SimdPath::AVX2, kernels::SimdPath::AVX512}) {
+        if (name == kernels::simdPathName(path)) {
+            return path;
+        }
+    }
+    throw std::invalid_argument("Unknown SIMD path: " + name);
+}
+
+DoubleArray smaBatch(const DoubleArray& prices, size_t window) {
+    requireVector(prices, "prices");
+    const size_t n = static_cast<size_t>(prices.size());
+    DoubleArray out(n);
+    const double* in = prices.data();
+    double* result = out.mutable_data();
+    {
+        py::gil_scoped_release release;
+        kernels::smaBatch(in, n, window, result);
+    }
+    return out;
+}
+
+DoubleArray indicatorBank(const DoubleArray& prices, const std::vector<size_t>& windows) {
+    requireVector(prices, "prices");
+    const size_t n = static_cast<size_t>(prices.size());
+    DoubleArray out({windows.size(), n});
+    const double* in = prices.data();
+    double* result = out.mutable_data();
+    {
+        py::gil_scoped_release release;
+        kernels::indicatorBank(in, n, windows.data(), windows.size(), result);
+    }
+    return out;
+}
+
+py::tuple cumulativeDepth(const DoubleArray& prices, const DoubleArray& quantities) {
+    requireVector(prices, "prices");
+    requireVector(quantities, "quantities");
+    if (prices.size() != quantities.size()) {
+        throw std::invalid_argument("prices and quantities must have the same length");
+    }
+    const size_t n = static_cast<size_t>(prices.size());
+    DoubleArray cum_quantity(n);
+    DoubleArray cum_notional(n);
+    kernels::cumulativeDepth(prices.data(), quantities.data(), n,
+                             cum_quantity.mutable_data(), cum_notional.mutable_data());
+    return py::make_tuple(cum_quantity, cum_notional);
+}
+
+py::tuple readTicks(const TickStore& store, int64_t from, int64_t to) {
+    std::vector<Tick> ticks;
+    {
+        py::gil_scoped_release release;
+        store.read(from, to, ticks);
+    }
+    py::array_t<int64_t> timestamps(ticks.size());
+    DoubleArray prices(ticks.size());
+    DoubleArray quantities(ticks.size());
+    int64_t* t = timestamps.mutable_data();
+    double* p = prices.mutable_data();
+    double* q = quantities.mutable_data();
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        t[i] = ticks[i].timestamp;
+        p[i] = ticks[i].price;
+        q[i] = ticks[i].quantity;
+    }
+    return py::make_tuple(timestamps, prices, quantities);
+}
+
+py::tuple downsampleTicks(const TickStore& store, int64_t from, int64_t to, size_t points,
+                          const std::string& method) {
+    Downsample mode;
+    if (method == "minmax") {
+        mode = Downsample::MIN_MAX;
+    } else if (method == "lttb") {
+        mode = Downsample::LTTB;
+    } else {
+        throw std::invalid_argument("Unknown downsampling method: " + method);
+    }
+    std::vector<TickPoint> out;
+    {
+        py::gil_scoped_release release;
+        store.downsample(from, to, points, mode, out);
+    }
+    py::array_t<int64_t> timestamps(out.size());
+    DoubleArray prices(out.size());
+    int64_t* t = timestamps.mutable_data();
+    double* p = prices.mutable_data();
+    for (size_t i = 0; i < out.size(); ++i) {
+        t[i] = out[i].timestamp;
+        p[i] = out[i].price;
+    }
+    return py::make_tuple(timestamps, prices);
+}
+
+// Read-only array over the history's storage; `owner` keeps it alive
+DoubleArray historyView(const double* data, size_t n, py::handle owner) {
+    DoubleArray view(static_cast<py::ssize_t>(n), data, owner);
+    view.attr("setflags")(py::arg("write") = false);
+    return view;
+}
+
+py::tuple historyArrays(py::object self) {
+    auto& history = self.cast<PriceHistory&>();
+    history.unwrap();
+    return py::make_tuple(historyView(history.timestamps(), history.size(), self),
+                          historyView(history.prices(), history.size(), self));
+}
+
+DoubleArray gaussianNormals(size_t n, uint64_t seed, uint64_t offset) {
+    DoubleArray out(n);
+    double* result = out.mutable_data();
+    {
+        py::gil_scoped_release release;
+        kernels::gaussianNormals(seed, offset, n, result);
+    }
+    return out;
+}
+
+// Binds one pre-instantiated BasicOrderBook; every policy has the same interface
+template <typename Book>
+void bindOrderBook(py::module_& m, const char* name, const char* doc) {
+    py::class_<Book>(m, name, doc)
+        .def(py::init<>(),
+             "Construct an empty order book")
+        .def("add_order", &Book::addOrder,
+             py::arg("side"), py::arg("price"), py::arg("quantity"),
+             "Add an order to the book\n\n"
+             "Args:\n"
+             "    side: Order side (OrderSide.BUY or OrderSide.SELL)\n"
+             "    price: Order price (must be positive)\n"
+             "    quantity: Order quantity (must be positive)\n\n"
+             "Returns:\n"
+             "    str: The generated order ID")
+        .def("add_order_good_till", &Book::addOrderGoodTill,
+             py::arg("side"), py::arg("price"), py::arg("quantity"), py::arg("expire_ms"),
+             "Add an order that expires at a point on the engine clock\n\n"
+             "Args:\n"
+             "    side: Order side (OrderSide.BUY or OrderSide.SELL)\n"
+             "    price: Order price (must be positive)\n"
+             "    quantity: Order quantity (must be positive)\n"
+             "    expire_ms: Engine time the order expires at (after clock_millis())\n\n"
+             "Returns:\n"
+             "    str: The generated order ID")
+        .def("add_order_good_for_ticks", &Book::addOrderGoodForTicks,
+             py::arg("side"), py::arg("price"), py::arg("quantity"), py::arg("ticks"),
+             "Add an order that expires after `ticks` more process_tick calls\n\n"
+             "Args:\n"
+             "    side: Order side (OrderSide.BUY or OrderSide.SELL)\n"
+             "    price: Order price (must be positive)\n"
+             "    quantity: Order quantity (must be positive)\n"
+             "    ticks: Ticks the order stays good for (at least 1)\n\n"
+             "Returns:\n"
+             "    str: The generated order ID")
+        .def("advance_time", &Book::advanceTime, py::arg("now_ms"),
+             "Move the engine clock forward and expire good-till orders due by then\n\n"
+             "Args:\n"
+             "    now_ms: Engine time in milliseconds (an earlier time is ignored)\n\n"
+             "Returns:\n"
+             "    int: Number of orders expired (collect them with take_expired)")
+        .def("clock_millis", &Book::clockMillis,
+             "Engine clock: the latest time passed to advance_time (0 if none)")
+        .def("ticks", &Book::ticks,
+             "process_tick calls since construction or reset")
+        .def("take_expired",
+             [](Book& book) {
+                 std::vector<ExpiredOrder> expired;
+                 book.takeExpired(expired);
+                 return expired;
+             },
+             "Hand over the orders expired since the last call\n\n"
+             "Returns:\n"
+             "    List[ExpiredOrder]: order_id, side, price, unfilled quantity, timestamp")
+        .def("match_orders", py::overload_cast<>(&Book::matchOrders),
+             "Match orders and execute trades\n\n"
+             "Returns:\n"
+             "    List[Trade]: List of executed trades")
+        .def("add_stop_order", &Book::addStopOrder,
+             py::arg("side"), py::arg("stop_price"), py::arg("quantity"), py::arg("limit_price") = 0.0,
+             "Add a stop or stop-limit order, held off the book until triggered\n\n"
+             "A buy fires when the last price rises to stop_price or above, a sell\n"
+             "when it falls to it or below (see process_tick).\n\n"
+             "Args:\n"
+             "    side: Order side (OrderSide.BUY or OrderSide.SELL)\n"
+             "    stop_price: Trigger price (must be positive)\n"
+             "    quantity: Order quantity (must be positive)\n"
+             "    limit_price: Limit once triggered; 0 for a stop (market) order\n\n"
+             "Returns:\n"
+             "    str: The generated order ID")
+        .def("add_iceberg_order", &Book::addIcebergOrder,
+             py::arg("side"), py::arg("price"), py::arg("display_quantity"), py::arg("total_quantity"),
+             "Add an iceberg order that shows one tranche of its size at a time\n\n"
+             "Each time the displayed tranche fills, the next one is taken from the\n"
+             "hidden reserve and re-queued at the back of the price level.\n\n"
+             "Args:\n"
+             "    side: Order side (OrderSide.BUY or OrderSide.SELL)\n"
+             "    price: Limit price (must be positive)\n"
+             "    display_quantity: Size of each displayed tranche (must be positive)\n"
+             "    total_quantity: Displayed plus hidden quantity (at least display_quantity)\n\n"
+             "Returns:\n"
+             "    str: The generated order ID")
+        .def("iceberg_orders", &Book::icebergOrders,
+             "Iceberg orders that still have hidden quantity in reserve")
+        .def("process_tick",
+             [](Book& book, double price) {
+                 std::vector<Trade> trades;
+                 book.processTick(price, trades);
+                 return trades;
+             },
+             py::arg("price"),
+             "Record a last-traded price and fire the stops it triggers\n\n"
+             "Fired stops sweep the book (stop-limits rest what is past their\n"
+             "limit); their trades fire further stops until the cascade ends.\n"
+             "Stops only fire in CONTINUOUS mode. Each call also counts one\n"
+             "tick for good-for-ticks orders.\n\n"
+             "Args:\n"
+             "    price: The new last price (must be positive)\n\n"
+             "Returns:\n"
+             "    List[Trade]: Trades executed by triggered orders")
+        .def("last_price", &Book::lastPrice,
+             "Last price seen by process_tick or traded by match_orders (0.0 if none)")
+        .def("stop_orders", &Book::stopOrders,
+             "Stop and stop-limit orders waiting for their trigger")
+        .def("set_mode", &Book::setMode, py::arg("mode"),
+             "Switch between continuous matching, call auction and batch auction\n\n"
+             "In AUCTION mode match_orders executes nothing until uncross(). In\n"
+             "BATCH mode new orders wait outside the book for clear_batch();\n"
+             "leaving BATCH rests them unmatched.\n\n"
+             "Args:\n"
+             "    mode: TradingMode.CONTINUOUS, TradingMode.AUCTION or TradingMode.BATCH")
+        .def("mode", &Book::mode,
+             "Current TradingMode")
+        .def("indicative_auction",
+             [](const Book& book, double reference_price) {
+                 return auctionDict(book.indicativeAuction(reference_price));
+             },
+             py::arg("reference_price") = 0.0,
+             "Equilibrium the book would uncross at now, without trading\n\n"
+             "Iceberg orders count only their displayed tranche.\n\n"
+             "Args:\n"
+             "    reference_price: Last price, only breaks remaining ties (0: none)\n\n"
+             "Returns:\n"
+             "    dict: price, volume, buy_surplus (< 0: sell surplus), price_levels")
+        .def("uncross",
+             [](Book& book, double reference_price) {
+                 std::vector<Trade> trades;
+                 py::dict d = auctionDict(book.uncross(trades, reference_price));
+                 d["trades"] = std::move(trades);
+                 return d;
+             },
+             py::arg("reference_price") = 0.0,
+             "Execute every crossing order at the single volume-maximising price\n\n"
+             "The price becomes last_price(). In CONTINUOUS mode the stops it\n"
+             "reaches fire straight after; in AUCTION mode they wait for a tick.\n"
+             "Icebergs trade their displayed tranche only; refills rejoin the book\n"
+             "after the auction and may leave it crossed for continuous matching.\n\n"
+             "Args:\n"
+             "    reference_price: Last price, only breaks remaining ties (0: none)\n\n"
+             "Returns:\n"
+             "    dict: As indicative_auction, plus trades (List[Trade])")
+        .def("clear_batch",
+             [](Book& book, BatchAllocation allocation, double reference_price) {
+                 std::vector<Trade> trades;
+                 py::dict d = auctionDict(book.clearBatch(trades, allocation, reference_price));
+                 d["trades"] = std::move(trades);
+                 return d;
+             },
+             py::arg("allocation") = BatchAllocation::PRO_RATA, py::arg("reference_price") = 0.0,
+             "Clear the waiting batch together with the book at one uniform price\n\n"
+             "The clearing price becomes last_price(); stops it reaches fire as\n"
+             "after uncross.\n\n"
+             "Args:\n"
+             "    allocation: How the marginal level is shared (BatchAllocation.PRO_RATA or TIME)\n"
+             "    reference_price: Last price, only breaks remaining ties (0: none)\n\n"
+             "Returns:\n"
+             "    dict: As uncross; unfilled orders rest in the book")
+        .def("clear_batch_fills",
+             [](Book& book, BatchAllocation allocation, double reference_price) {
+                 std::vector<BatchFill> fills;
+                 py::dict d = auctionDict(book.clearBatch(fills, allocation, reference_price));
+                 py::array_t<uint64_t> buy_seq(fills.size());
+                 py::array_t<uint64_t> sell_seq(fills.size());
+                 DoubleArray prices(fills.size());
+                 DoubleArray quantities(fills.size());
+                 uint64_t* b = buy_seq.mutable_data();
+                 uint64_t* a = sell_seq.mutable_data();
+                 double* p = prices.mutable_data();
+                 double* q = quantities.mutable_data();
+                 for (size_t i = 0; i < fills.size(); ++i) {
+                     b[i] = fills[i].buy_seq;
+                     a[i] = fills[i].sell_seq;
+                     p[i] = fills[i].price;
+                     q[i] = fills[i].quantity;
+                 }
+                 d["buy_seq"] = buy_seq;
+                 d["sell_seq"] = sell_seq;
+                 d["prices"] = prices;
+                 d["quantities"] = quantities;
+                 return d;
+             },
+             py::arg("allocation") = BatchAllocation::PRO_RATA, py::arg("reference_price") = 0.0,
+             "clear_batch for bulk callers: numeric fills, no Trade objects or ID strings\n\n"
+             "The order IDs of a fill are \"ORD\" followed by its sequence numbers.\n"
+             "The clearing price becomes last_price(); stops wait for the next tick.\n\n"
+             "Args:\n"
+             "    allocation: As clear_batch\n"
+             "    reference_price: As clear_batch\n\n"
+             "Returns:\n"
+             "    dict: As indicative_auction, plus buy_seq and sell_seq (numpy uint64)\n"
+             "        and prices and quantities (numpy float64), one entry per fill")
+        .def("pending_orders", &Book::pendingOrders,
+             "Orders waiting for the next clear_batch (BATCH mode)")
+        .def("cancel_order", &Book::cancelOrder, py::arg("order_id"),
+             "Cancel a resting order\n\n"
+             "Args:\n"
+             "    order_id: ID returned by add_order\n\n"
+             "Returns:\n"
+             "    bool: True if the order was resting and has been removed")
+        .def("get_bids", py::overload_cast<>(&Book::getBids, py::const_),
+             "Get all bid orders\n\n"
+             "Returns:\n"
+             "    List[Tuple[float, float]]: List of (price, quantity) pairs, sorted by price descending")
+        .def("get_asks", py::overload_cast<>(&Book::getAsks, py::const_),
+             "Get all ask orders\n\n"
+             "Returns:\n"
+             "    List[Tuple[float, float]]: List of (price, quantity) pairs, sorted by price ascending")
+        .def("get_best_bid", &Book::getBestBid,
+             "Get the best bid price\n\n"
+             "Returns:\n"
+             "    float: Best bid price, or 0.0 if no bids")
+        .def("get_best_ask", &Book::getBestAsk,
+             "Get the best ask price\n\n"
+             "Returns:\n"
+             "    float: Best ask price, or 0.0 if no asks")
+        .def("reset", &Book::reset,
+             "Reset the order book, removing all orders")
+        .def("get_latency_stats",
+             [](const Book& book) {
+                 py::dict stats;
+                 for (size_t i = 0; i < kLatencyOpCount; ++i) {
+                     auto op = static_cast<LatencyOp>(i);
+                     stats[latencyOpName(op)] = latencySummary(book.latencyHistogram(op));
+                 }
+                 return stats;
+             },
+             "Get per-operation latency percentiles\n\n"
+             "Returns:\n"
+             "    dict: {operation: {count, mean_ns, min_ns, p50_ns, p90_ns, p99_ns, p999_ns, max_ns}}\n"
+             "    for add, match, cancel and snapshot. Counts stay at 0 when the module\n"
+             "    was built without TRADE_ENGINE_LATENCY_STATS.")
+        .def("reset_latency_stats", &Book::resetLatencyStats,
+             "Clear the latency histograms (book contents are unaffected)")
+        .def("memory_stats",
+             [](const Book& book) {
+                 MemoryStats stats = book.memoryStats();
+                 py::dict d;
+                 d["level_bytes"] = stats.level_bytes;
+                 d["order_bytes"] = stats.order_bytes;
+                 d["id_string_bytes"] = stats.id_string_bytes;
+                 d["index_bytes"] = stats.index_bytes;
+                 d["pool_bytes"] = stats.pool_bytes;
+                 d["fixed_bytes"] = stats.fixed_bytes;
+                 d["total_bytes"] = stats.total_bytes;
+                 d["resting_orders"] = stats.resting_orders;
+                 d["price_levels"] = stats.price_levels;
+                 d["stop_orders"] = stats.stop_orders;
+                 d["bytes_per_order"] = stats.bytes_per_order;
+                 d["pool_capacity"] = stats.pool_capacity;
+                 d["high_water_orders"] = stats.high_water_orders;
+                 d["high_water_levels"] = stats.high_water_levels;
+                 return d;
+             },
+             "Estimate the memory used by the book\n\n"
+             "Returns:\n"
+             "    dict: Bytes per component (levels, orders, ID strings, index, pool slack,\n"
+             "    fixed object), total, bytes per resting order, untriggered stops,\n"
+             "    pool capacity and high-water marks for resting orders and price levels");
+}
+
+using TimeArray = py::array_t<long long, py::array::c_style | py::array::forcecast>;
+
+py::dict strategyBatchDict(const StrategyBatch& batch) {
+    TimeArray times(batch.tick_times.size());
+    DoubleArray prices(batch.tick_prices.size());
+    std::copy(batch.tick_times.begin(), batch.tick_times.end(), times.mutable_data());
+    std::copy(batch.tick_prices.begin(), batch.tick_prices.end(), prices.mutable_data());
+    py::dict d;
+    d["tick_times"] = times;
+    d["tick_prices"] = prices;
+    d["trades"] = py::cast(batch.trades);
+    d["fills"] = py::cast(batch.fills);
+    d["best_bid"] = batch.best_bid;
+    d["best_ask"] = batch.best_ask;
+    return d;
+}
+
+py::dict backtestResultDict(const BacktestResult& result) {
+    py::dict d;
+    d["ticks"] = result.ticks;
+    d["orders"] = result.orders;
+    d["rejected"] = result.rejected;
+    d["cancels"] = result.cancels;
+    d["fills"] = result.fills;
+    d["traded_quantity"] = result.traded_quantity;
+    d["position"] = result.position;
+    d["cash"] = result.cash;
+    d["pnl"] = result.pnl;
+    d["max_drawdown"] = result.max_drawdown;
+    d["end_us"] = result.end_us;
+    d["market_trades"] = result.market.trades;
+    d["market_volume"] = result.market.volume;
+    return d;
+}
+
+} // namespace
+
 PYBIND11_MODULE(trade_engine, m) {
     m.doc() = "High-performance C++ trading engine for cryptocurrency simulation";
 
@@ -14,6 +497,17 @@ PYBIND11_MODULE(trade_engine, m) {
         .value("SELL", OrderSide::SELL)
         .export_values();
 
+    py::enum_<TradingMode>(m, "TradingMode")
+        .value("CONTINUOUS", TradingMode::CONTINUOUS)
+        .value("AUCTION", TradingMode::AUCTION)
+        .value("BATCH", TradingMode::BATCH)
+        .export_values();
+
+    py::enum_<BatchAllocation>(m, "BatchAllocation")
+        .value("TIME", BatchAllocation::TIME)
+        .value("PRO_RATA", BatchAllocation::PRO_RATA)
+        .export_values();
+
     // Expose Order struct
     py::class_<Order>(m, "Order")
         .def_readonly("id", &Order::id)
@@ -30,16 +524,62 @@ PYBIND11_MODULE(trade_engine, m) {
         .def_readonly("quantity", &Trade::quantity)
         .def_readonly("timestamp", &Trade::timestamp);
 
+    // Expose ExpiredOrder struct
+    py::class_<ExpiredOrder>(m, "ExpiredOrder")
+        .def_readonly("order_id", &ExpiredOrder::order_id)
+        .def_readonly("side", &ExpiredOrder::side)
+        .def_readonly("price", &ExpiredOrder::price)
+        .def_readonly("quantity", &ExpiredOrder::quantity)
+        .def_readonly("timestamp", &ExpiredOrder::timestamp);
+
+    // Expose PriceHistory class
+    py::class_<PriceHistory>(m, "PriceHistory")
+        .def(py::init<size_t>(), py::arg("capacity"),
+             "Construct a fixed-capacity (timestamp, price) ring\n\n"
+             "Args:\n"
+             "    capacity: Samples kept before the oldest is overwritten")
+        .def("push", &PriceHistory::push, py::arg("timestamp"), py::arg("price"),
+             "Record a sample, overwriting the oldest one when full")
+        .def("arrays", &historyArrays,
+             "Samples oldest-first as read-only numpy views of the ring (no copy)\n\n"
+             "The ring is rotated in place if it has wrapped; the views show\n"
+             "the samples in order until the next push or add_price.\n\n"
+             "Returns:\n"
+             "    Tuple[numpy.ndarray, numpy.ndarray]: timestamps and prices")
+        .def("timestamps", [](py::object self) -> py::object { return historyArrays(self)[0]; },
+             "Timestamps oldest-first (a view, see arrays())")
+        .def("prices", [](py::object self) -> py::object { return historyArrays(self)[1]; },
+             "Prices oldest-first (a view, see arrays())")
+        .def("last", &PriceHistory::last,
+             "Price of the newest sample, without unwrapping the ring (0.0 if empty)")
+        .def("capacity", &PriceHistory::capacity,
+             "Maximum number of samples kept")
+        .def("memory_bytes", &PriceHistory::memoryBytes,
+             "Estimated memory used by this history\n\n"
+             "Returns:\n"
+             "    int: Bytes (object plus both arrays)")
+        .def("clear", &PriceHistory::clear,
+             "Drop all samples (capacity is kept)")
+        .def("__len__", &PriceHistory::size);
+
     // Expose SMACalculator class
     py::class_<SMACalculator>(m, "SMACalculator")
         .def(py::init<size_t>(), py::arg("window_size"),
              "Construct a Simple Moving Average calculator\n\n"
              "Args:\n"
              "    window_size: Number of prices to average over")
-        .def("add_price", &SMACalculator::addPrice, py::arg("price"),
+        .def("add_price", py::overload_cast<double>(&SMACalculator::addPrice), py::arg("price"),
              "Add a new price to the calculation\n\n"
              "Args:\n"
              "    price: The price value to add")
+        .def("add_price",
+             py::overload_cast<double, double, PriceHistory&>(&SMACalculator::addPrice),
+             py::arg("price"), py::arg("timestamp"), py::arg("history"),
+             "Add a new price and record it in a PriceHistory in one call\n\n"
+             "Args:\n"
+             "    price: The price value to add\n"
+             "    timestamp: Sample time stored with the price\n"
+             "    history: PriceHistory the sample is pushed to")
         .def("get_sma", &SMACalculator::getSMA,
              "Get the current Simple Moving Average\n\n"
              "Returns:\n"
@@ -48,44 +588,593 @@ PYBIND11_MODULE(trade_engine, m) {
              "Get the number of prices currently stored\n\n"
              "Returns:\n"
              "    int: Number of prices")
+        .def("memory_bytes", &SMACalculator::memoryBytes,
+             "Estimated memory used by this calculator\n\n"
+             "Returns:\n"
+             "    int: Bytes (object plus circular buffer)")
         .def("reset", &SMACalculator::reset,
              "Reset the calculator, clearing all stored prices");
 
-    // Expose OrderBook class
-    py::class_<OrderBook>(m, "OrderBook")
+    // Order books: one class per matching policy and trade-price rule
+    bindOrderBook<OrderBook>(m, "OrderBook",
+        "Price-time priority order book; trades at the ask level's price");
+    bindOrderBook<BasicOrderBook<FifoMatching<TradePrice::PASSIVE>>>(m, "OrderBookPassivePrice",
+        "Price-time priority order book; trades at the resting order's price");
+    bindOrderBook<BasicOrderBook<FifoMatching<TradePrice::MIDPOINT>>>(m, "OrderBookMidPrice",
+        "Price-time priority order book; trades at the bid/ask midpoint");
+    bindOrderBook<ProRataOrderBook>(m, "ProRataOrderBook",
+        "Pro-rata order book; trades at the ask level's price");
+    bindOrderBook<BasicOrderBook<ProRataMatching<TradePrice::PASSIVE>>>(m, "ProRataOrderBookPassivePrice",
+        "Pro-rata order book; trades at the resting order's price");
+    bindOrderBook<BasicOrderBook<ProRataMatching<TradePrice::MIDPOINT>>>(m, "ProRataOrderBookMidPrice",
+        "Pro-rata order book; trades at the bid/ask midpoint");
+    bindOrderBook<TopOrderProRataOrderBook>(m, "TopOrderProRataOrderBook",
+        "Pro-rata order book with top-order priority; trades at the ask level's price");
+    bindOrderBook<BasicOrderBook<TopOrderProRataMatching<TradePrice::PASSIVE>>>(m, "TopOrderProRataOrderBookPassivePrice",
+        "Pro-rata order book with top-order priority; trades at the resting order's price");
+    bindOrderBook<BasicOrderBook<TopOrderProRataMatching<TradePrice::MIDPOINT>>>(m, "TopOrderProRataOrderBookMidPrice",
+        "Pro-rata order book with top-order priority; trades at the bid/ask midpoint");
+
+    m.def("make_order_book",
+          [](const std::string& matching, const std::string& trade_price) -> py::object {
+              static const std::map<std::string, std::string> prefixes = {
+                  {"fifo", ""}, {"pro_rata", "ProRata"}, {"top_order_pro_rata", "TopOrderProRata"}};
+              static const std::map<std::string, std::string> suffixes = {
+                  {"ask", ""}, {"passive", "PassivePrice"}, {"midpoint", "MidPrice"}};
+              auto prefix = prefixes.find(matching);
+              auto suffix = suffixes.find(trade_price);
+              if (prefix == prefixes.end() || suffix == suffixes.end()) {
+                  throw std::invalid_argument("Unknown matching policy or trade price rule");
+              }
+              auto module = py::module_::import("trade_engine");
+              return module.attr((prefix->second + "OrderBook" + suffix->second).c_str())();
+          },
+          py::arg("matching") = "fifo", py::arg("trade_price") = "ask",
+          "Construct the order book class for a venue's matching rules\n\n"
+          "Args:\n"
+          "    matching: \"fifo\", \"pro_rata\" or \"top_order_pro_rata\"\n"
+          "    trade_price: \"ask\", \"passive\" (resting order's price) or \"midpoint\"\n\n"
+          "Returns:\n"
+          "    An empty order book of the matching pre-instantiated class");
+
+    // Expose PipelineStats class
+    py::class_<PipelineStats>(m, "PipelineStats")
         .def(py::init<>(),
-             "Construct an empty order book")
-        .def("add_order", &OrderBook::addOrder,
-             py::arg("side"), py::arg("price"), py::arg("quantity"),
-             "Add an order to the book\n\n"
+             "Per-stage latency histograms for the end-to-end tick pipeline")
+        .def("record_tick",
+             [](PipelineStats& stats, uint64_t start, uint64_t generated, uint64_t processed,
+                uint64_t serialized, uint64_t sent) {
+                 stats.recordTick({start, generated, processed, serialized, sent});
+             },
+             py::arg("start"), py::arg("generated"), py::arg("processed"),
+             py::arg("serialized"), py::arg("sent"),
+             "Record one tick from its stage-boundary timestamps\n\n"
              "Args:\n"
-             "    side: Order side (OrderSide.BUY or OrderSide.SELL)\n"
-             "    price: Order price (must be positive)\n"
-             "    quantity: Order quantity (must be positive)\n\n"
+             "    start: time.perf_counter_ns() before the price is generated\n"
+             "    generated: after the price model\n"
+             "    processed: after the engine (SMA, matching, book reads)\n"
+             "    serialized: after the market-data message is encoded\n"
+             "    sent: after the message went to every client")
+        .def("get_report",
+             [](const PipelineStats& stats) {
+                 py::dict stages;
+                 for (size_t i = 0; i < kPipelineStageCount; ++i) {
+                     auto stage = static_cast<PipelineStage>(i);
+                     py::dict summary = latencySummary(stats.stage(stage));
+                     summary["share"] = stats.share(stage);
+                     stages[pipelineStageName(stage)] = summary;
+                 }
+                 py::dict report;
+                 report["ticks"] = stats.ticks();
+                 report["stages"] = stages;
+                 return report;
+             },
+             "Get per-stage latency percentiles\n\n"
              "Returns:\n"
-             "    str: The generated order ID")
-        .def("match_orders", &OrderBook::matchOrders,
-             "Match orders and execute trades\n\n"
+             "    dict: {ticks, stages: {generate|process|serialize|fanout|total:\n"
+             "    {count, mean_ns, min_ns, p50_ns, p90_ns, p99_ns, p999_ns, max_ns, share}}}\n"
+             "    where share is the stage's fraction of the mean total")
+        .def("reset", &PipelineStats::reset,
+             "Clear all stage histograms");
+
+    m.def("monotonic_ns", &monotonicNanos,
+          "Monotonic clock used for pipeline stamps (nanoseconds)");
+
+    // Expose TickStore class
+    py::class_<TickStore>(m, "TickStore")
+        .def(py::init<const std::string&>(), py::arg("path") = "",
+             "Open (or create) a compressed tick history\n\n"
+             "Args:\n"
+             "    path: Block file to append to; empty for an in-memory store")
+        .def("append", &TickStore::append,
+             py::arg("timestamp"), py::arg("price"), py::arg("quantity") = 0.0,
+             "Append one tick (timestamps must be non-decreasing)\n\n"
+             "Args:\n"
+             "    timestamp: Integer timestamp (the backend uses milliseconds)\n"
+             "    price: Price\n"
+             "    quantity: Traded quantity, 0 for price ticks")
+        .def("flush", &TickStore::flush,
+             "Write the partially filled last block to the file")
+        .def("read", &readTicks, py::arg("t_from"), py::arg("t_to"),
+             "Ticks with t_from <= timestamp < t_to\n\n"
              "Returns:\n"
-             "    List[Trade]: List of executed trades")
-        .def("get_bids", &OrderBook::getBids,
-             "Get all bid orders\n\n"
+             "    Tuple[numpy.ndarray, numpy.ndarray, numpy.ndarray]: timestamps (int64), prices, quantities")
+        .def("downsample", &downsampleTicks,
+             py::arg("t_from"), py::arg("t_to"), py::arg("points"), py::arg("method") = "minmax",
+             "Prices in [t_from, t_to) reduced to at most `points` points for charting\n\n"
+             "Args:\n"
+             "    t_from: Range start (inclusive)\n"
+             "    t_to: Range end (exclusive)\n"
+             "    points: Output budget (>= 2), e.g. the chart width in pixels\n"
+             "    method: \"minmax\" (each bucket's low and high) or \"lttb\"\n\n"
              "Returns:\n"
-             "    List[Tuple[float, float]]: List of (price, quantity) pairs, sorted by price descending")
-        .def("get_asks", &OrderBook::getAsks,
-             "Get all ask orders\n\n"
+             "    Tuple[numpy.ndarray, numpy.ndarray]: timestamps (int64) and prices; raw ticks if they fit")
+        .def("block_index",
+             [](const TickStore& store) {
+                 py::list blocks;
+                 for (size_t i = 0; i < store.blockCount(); ++i) {
+                     const TickBlock& b = store.block(i);
+                     py::dict d;
+                     d["count"] = b.count;
+                     d["first_time"] = b.first_time;
+                     d["last_time"] = b.last_time;
+                     d["min_price"] = b.min_price;
+                     d["max_price"] = b.max_price;
+                     d["first_price"] = b.first_price;
+                     d["last_price"] = b.last_price;
+                     d["volume"] = b.volume;
+                     blocks.append(d);
+                 }
+                 return blocks;
+             },
+             "Per-block summaries (time range, price range, open/close, volume)\n\n"
              "Returns:\n"
-             "    List[Tuple[float, float]]: List of (price, quantity) pairs, sorted by price ascending")
-        .def("get_best_bid", &OrderBook::getBestBid,
-             "Get the best bid price\n\n"
+             "    list: One dict per block, oldest first")
+        .def("stats",
+             [](const TickStore& store) {
+                 py::dict d;
+                 d["ticks"] = store.size();
+                 d["blocks"] = store.blockCount();
+                 d["bytes"] = store.storedBytes();
+                 d["bytes_per_tick"] = store.empty() ? 0.0
+                     : static_cast<double>(store.storedBytes()) / static_cast<double>(store.size());
+                 d["path"] = store.path();
+                 return d;
+             },
+             "Size of the history\n\n"
              "Returns:\n"
-             "    float: Best bid price, or 0.0 if no bids")
-        .def("get_best_ask", &OrderBook::getBestAsk,
-             "Get the best ask price\n\n"
+             "    dict: ticks, blocks, bytes, bytes_per_tick, path")
+        .def("__len__", &TickStore::size);
+
+    // Discrete-event simulation
+    py::class_<SimulationConfig>(m, "SimulationConfig",
+                                 "Price model and synthetic order flow of a Simulation\n\n"
+                                 "Times are simulated microseconds; drift and volatility are per\n"
+                                 "simulated second.")
+        .def(py::init<>())
+        .def_readwrite("initial_price", &SimulationConfig::initial_price)
+        .def_readwrite("drift", &SimulationConfig::drift)
+        .def_readwrite("volatility", &SimulationConfig::volatility)
+        .def_readwrite("price_interval_us", &SimulationConfig::price_interval_us,
+                       "GBM step spacing; 0 disables the price model")
+        .def_readwrite("seed", &SimulationConfig::seed)
+        .def_readwrite("sma_window", &SimulationConfig::sma_window)
+        .def_readwrite("order_rate", &SimulationConfig::order_rate,
+                       "Synthetic orders per simulated second; 0 disables the flow")
+        .def_readwrite("order_spread", &SimulationConfig::order_spread,
+                       "Synthetic orders are priced within this fraction of the price")
+        .def_readwrite("max_quantity", &SimulationConfig::max_quantity)
+        .def_readwrite("tick_size", &SimulationConfig::tick_size)
+        .def_readwrite("order_lifetime_us", &SimulationConfig::order_lifetime_us,
+                       "Synthetic orders expire after this long (0: never)");
+
+    py::enum_<LatencyDistribution>(m, "LatencyDistribution")
+        .value("FIXED", LatencyDistribution::FIXED)
+        .value("UNIFORM", LatencyDistribution::UNIFORM)
+        .value("EXPONENTIAL", LatencyDistribution::EXPONENTIAL)
+        .export_values();
+
+    py::class_<LatencyModel>(m, "LatencyModel",
+                             "One latency leg of a participant, in simulated microseconds\n\n"
+                             "UNIFORM adds [0, spread_us) to base_us; EXPONENTIAL adds an\n"
+                             "exponential draw of mean spread_us.")
+        .def(py::init([](LatencyDistribution distribution, long long base_us, double spread_us) {
+                 return LatencyModel{distribution, base_us, spread_us};
+             }),
+             py::arg("distribution") = LatencyDistribution::FIXED, py::arg("base_us") = 0,
+             py::arg("spread_us") = 0.0)
+        .def_readwrite("distribution", &LatencyModel::distribution)
+        .def_readwrite("base_us", &LatencyModel::base_us)
+        .def_readwrite("spread_us", &LatencyModel::spread_us);
+
+    py::class_<ParticipantFill>(m, "ParticipantFill", "A fill of a participant order, as delivered")
+        .def_readonly("client_id", &ParticipantFill::client_id)
+        .def_readonly("order_id", &ParticipantFill::order_id)
+        .def_readonly("side", &ParticipantFill::side)
+        .def_readonly("price", &ParticipantFill::price)
+        .def_readonly("quantity", &ParticipantFill::quantity)
+        .def_readonly("remaining", &ParticipantFill::remaining)
+        .def_readonly("exchange_time_us", &ParticipantFill::exchange_time_us);
+
+    py::class_<Simulation>(m, "Simulation",
+                           "Discrete-event simulation of an OrderBook, an SMA and a GBM price\n\n"
+                           "Events run in simulated-time order as fast as the CPU allows.")
+        .def(py::init<const SimulationConfig&>(), py::arg("config") = SimulationConfig())
+        .def("schedule_order", &Simulation::scheduleOrder,
+             py::arg("time_us"), py::arg("side"), py::arg("price"), py::arg("quantity"),
+             py::arg("lifetime_us") = 0,
+             "Schedule a limit order (lifetime_us 0: good till cancelled)")
+        .def("schedule_cancel", &Simulation::scheduleCancel, py::arg("time_us"), py::arg("order_id"),
+             "Schedule a cancel of an order ID")
+        .def("schedule_price", &Simulation::schedulePrice, py::arg("time_us"), py::arg("price"),
+             "Schedule an exogenous price, e.g. a replayed tick")
+        .def("schedule_wakeup", &Simulation::scheduleWakeup, py::arg("time_us"), py::arg("token"),
+             "Schedule a call of the wakeup handler with token")
+        .def("set_wakeup_handler",
+             [](Simulation& sim, py::function handler) {
+                 sim.setWakeupHandler([handler](Simulation& s, uint64_t token) {
+                     py::gil_scoped_acquire gil;
+                     handler(py::cast(&s, py::return_value_policy::reference), token);
+                 });
+             },
+             py::arg("handler"),
+             "Set handler(simulation, token), called for wakeup events")
+        .def("add_participant", &Simulation::addParticipant,
+             py::arg("order_entry") = LatencyModel(), py::arg("market_data") = LatencyModel(),
+             "Add a participant that trades through latency\n\n"
+             "Args:\n"
+             "    order_entry: LatencyModel from the participant to the book\n"
+             "    market_data: LatencyModel from the book to the participant\n\n"
              "Returns:\n"
-             "    float: Best ask price, or 0.0 if no asks")
-        .def("reset", &OrderBook::reset,
-             "Reset the order book, removing all orders");
+             "    int: Participant index")
+        .def("set_fill_handler",
+             [](Simulation& sim, size_t participant, py::function handler) {
+                 sim.setFillHandler(participant, [handler](Simulation& s, const ParticipantFill& fill) {
+                     py::gil_scoped_acquire gil;
+                     handler(py::cast(&s, py::return_value_policy::reference), fill);
+                 });
+             },
+             py::arg("participant"), py::arg("handler"),
+             "Set handler(simulation, fill), called as fill notices arrive")
+        .def("set_price_handler",
+             [](Simulation& sim, size_t participant, py::function handler) {
+                 sim.setPriceHandler(participant,
+                                     [handler](Simulation& s, double price, long long exchange_time_us) {
+                                         py::gil_scoped_acquire gil;
+                                         handler(py::cast(&s, py::return_value_policy::reference),
+                                                 price, exchange_time_us);
+                                     });
+             },
+             py::arg("participant"), py::arg("handler"),
+             "Set handler(simulation, price, exchange_time_us), called as prices arrive")
+        .def("set_trade_handler",
+             [](Simulation& sim, size_t participant, py::function handler) {
+                 sim.setTradeHandler(participant, [handler](Simulation& s, const Trade& trade) {
+                     py::gil_scoped_acquire gil;
+                     handler(py::cast(&s, py::return_value_policy::reference), trade);
+                 });
+             },
+             py::arg("participant"), py::arg("handler"),
+             "Set handler(simulation, trade), called as public trades arrive")
+        .def("set_book_handler",
+             [](Simulation& sim, size_t participant, py::function handler) {
+                 sim.setBookHandler(participant, [handler](Simulation& s, double best_bid, double best_ask) {
+                     py::gil_scoped_acquire gil;
+                     handler(py::cast(&s, py::return_value_policy::reference), best_bid, best_ask);
+                 });
+             },
+             py::arg("participant"), py::arg("handler"),
+             "Set handler(simulation, best_bid, best_ask), called as top-of-book changes arrive\n"
+             "(0: side empty)")
+        .def("submit_order", &Simulation::submitOrder,
+             py::arg("participant"), py::arg("side"), py::arg("price"), py::arg("quantity"),
+             "Send a limit order; it reaches the book after order-entry latency\n\n"
+             "Returns:\n"
+             "    int: Client ID for submit_cancel and queue_ahead")
+        .def("submit_cancel", &Simulation::submitCancel, py::arg("participant"), py::arg("client_id"),
+             "Send a cancel; it reaches the book after order-entry latency")
+        .def("queue_ahead", &Simulation::queueAhead, py::arg("client_id"),
+             "Quantity queued ahead of a resting participant order at its level (-1 if not resting)")
+        .def("participant_stats",
+             [](const Simulation& sim, size_t participant) {
+                 const ParticipantStats& stats = sim.participantStats(participant);
+                 py::dict d;
+                 d["orders"] = stats.orders;
+                 d["rejected"] = stats.rejected;
+                 d["cancels"] = stats.cancels;
+                 d["fills"] = stats.fills;
+                 d["filled_quantity"] = stats.filled_quantity;
+                 return d;
+             },
+             py::arg("participant"),
+             "Counts for one participant\n\n"
+             "Returns:\n"
+             "    dict: orders, rejected, cancels, fills, filled_quantity")
+        .def("run_until", &Simulation::runUntil, py::arg("end_us"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Apply every event due at or before end_us, then move the clock there\n\n"
+             "Releases the GIL; a wakeup handler takes it back while it runs.\n\n"
+             "Returns:\n"
+             "    int: Number of events applied")
+        .def("step", &Simulation::step,
+             "Apply the next event; False when nothing is scheduled")
+        .def("now", &Simulation::now, "Simulated time (microseconds)")
+        .def("pending_events", &Simulation::pendingEvents)
+        .def("price", &Simulation::price, "Last price applied")
+        .def("sma", [](const Simulation& sim) { return sim.sma().getSMA(); },
+             "Current SMA of the applied prices")
+        .def("book", py::overload_cast<>(&Simulation::book), py::return_value_policy::reference_internal,
+             "The simulated OrderBook")
+        .def("stats",
+             [](const Simulation& sim) {
+                 const SimulationStats& stats = sim.stats();
+                 py::dict d;
+                 d["events"] = stats.events;
+                 d["price_steps"] = stats.price_steps;
+                 d["orders"] = stats.orders;
+                 d["rejected"] = stats.rejected;
+                 d["cancels"] = stats.cancels;
+                 d["trades"] = stats.trades;
+                 d["expired"] = stats.expired;
+                 d["wakeups"] = stats.wakeups;
+                 d["volume"] = stats.volume;
+                 d["now_us"] = sim.now();
+                 return d;
+             },
+             "Counts so far\n\n"
+             "Returns:\n"
+             "    dict: events, price_steps, orders, rejected, cancels, trades, expired,\n"
+             "    wakeups, volume, now_us");
+
+    // Native strategies and the backtest runner
+    py::class_<StrategyContext>(m, "StrategyContext",
+                                "What a strategy sees and does; orders pay order-entry latency")
+        .def("submit_order", &StrategyContext::submitOrder,
+             py::arg("side"), py::arg("price"), py::arg("quantity"),
+             "Send a limit order\n\n"
+             "Returns:\n"
+             "    int: Client ID, as in the fills and for cancel_order")
+        .def("cancel_order", &StrategyContext::cancelOrder, py::arg("client_id"))
+        .def("queue_ahead", &StrategyContext::queueAhead, py::arg("client_id"),
+             "Quantity queued ahead of a resting order (-1 if not resting)")
+        .def("now", &StrategyContext::now, "Simulated time (microseconds)")
+        .def("position", &StrategyContext::position)
+        .def("cash", &StrategyContext::cash)
+        .def("last_price", &StrategyContext::lastPrice, "Latest price delivered")
+        .def("best_bid", &StrategyContext::bestBid, "Latest best bid delivered")
+        .def("best_ask", &StrategyContext::bestAsk, "Latest best ask delivered");
+
+    py::class_<Strategy>(m, "Strategy", "Base of the native strategies a Backtest runs");
+
+    py::class_<SMACrossoverStrategy, Strategy>(m, "SMACrossoverStrategy",
+                                               "Long while the fast SMA is above the slow one, short below")
+        .def(py::init<size_t, size_t, double, double>(),
+             py::arg("fast_window"), py::arg("slow_window"), py::arg("quantity"), py::arg("slippage") = 0.001)
+        .def("crossovers", &SMACrossoverStrategy::crossovers)
+        .def("fast_sma", [](const SMACrossoverStrategy& strategy) { return strategy.fast().getSMA(); })
+        .def("slow_sma", [](const SMACrossoverStrategy& strategy) { return strategy.slow().getSMA(); });
+
+    py::class_<BatchStrategy, Strategy>(m, "BatchStrategy",
+                                        "Strategy written in Python, called with batches of events")
+        .def(py::init([](py::function handler, size_t batch_ticks) {
+                 return std::make_unique<BatchStrategy>(
+                     [handler](StrategyContext& context, const StrategyBatch& batch) {
+                         py::gil_scoped_acquire gil;
+                         handler(py::cast(&context, py::return_value_policy::reference),
+                                 strategyBatchDict(batch));
+                     },
+                     batch_ticks);
+             }),
+             py::arg("handler"), py::arg("batch_ticks") = 1000,
+             "Args:\n"
+             "    handler: handler(context, batch), called every batch_ticks ticks and at\n"
+             "        the end; batch is a dict of tick_times and tick_prices (numpy),\n"
+             "        trades, fills, best_bid and best_ask\n"
+             "    batch_ticks: Ticks per call")
+        .def("batches", &BatchStrategy::batches, "Calls of the handler so far");
+
+    py::class_<BacktestConfig>(m, "BacktestConfig",
+                               "Market (price model and synthetic liquidity) and latency of a Backtest")
+        .def(py::init<>())
+        .def_readwrite("market", &BacktestConfig::market)
+        .def_readwrite("order_entry", &BacktestConfig::order_entry)
+        .def_readwrite("market_data", &BacktestConfig::market_data);
+
+    py::class_<Backtest>(m, "Backtest",
+                         "Runs a strategy next to a simulated book\n\n"
+                         "Each run starts a fresh market; the strategy keeps its state.")
+        .def(py::init<Strategy&, const BacktestConfig&>(), py::arg("strategy"),
+             py::arg("config") = BacktestConfig(), py::keep_alive<1, 2>())
+        .def("run",
+             [](Backtest& backtest, long long end_us) {
+                 BacktestResult result;
+                 {
+                     py::gil_scoped_release release;
+                     result = backtest.run(end_us);
+                 }
+                 return backtestResultDict(result);
+             },
+             py::arg("end_us"),
+             "Run on the market's price model until end_us\n\n"
+             "Returns:\n"
+             "    dict: ticks, orders, rejected, cancels, fills, traded_quantity, position,\n"
+             "    cash, pnl, max_drawdown, end_us, market_trades, market_volume")
+        .def("replay",
+             [](Backtest& backtest, const TimeArray& times_us, const DoubleArray& prices) {
+                 requireVector(prices, "prices");
+                 if (times_us.ndim() != 1 || times_us.size() != prices.size()) {
+                     throw std::invalid_argument("times_us and prices must be 1-D and the same length");
+                 }
+                 BacktestResult result;
+                 {
+                     py::gil_scoped_release release;
+                     result = backtest.replay(times_us.data(), prices.data(), static_cast<size_t>(prices.size()));
+                 }
+                 return backtestResultDict(result);
+             },
+             py::arg("times_us"), py::arg("prices"),
+             "Run on recorded prices (times in simulated microseconds, non-decreasing)\n\n"
+             "Returns:\n"
+             "    dict: As run()");
+
+    py::class_<ParallelBacktest>(m, "ParallelBacktest",
+                                 "Runs many strategies, each in its own market, over one tick stream\n\n"
+                                 "The stream is decoded once per batch and the backtests advance on\n"
+                                 "worker threads; results match running each Backtest alone.")
+        .def(py::init<size_t>(), py::arg("threads") = 0,
+             "Args:\n"
+             "    threads: Worker threads (0: one per hardware thread)")
+        .def("add", &ParallelBacktest::add, py::arg("strategy"), py::arg("config") = BacktestConfig(),
+             py::keep_alive<1, 2>(), "Add a strategy; returns the index of its result")
+        .def("replay",
+             [](ParallelBacktest& parallel, const TimeArray& times_us, const DoubleArray& prices,
+                size_t batch_ticks) {
+                 requireVector(prices, "prices");
+                 if (times_us.ndim() != 1 || times_us.size() != prices.size()) {
+                     throw std::invalid_argument("times_us and prices must be 1-D and the same length");
+                 }
+                 std::vector<BacktestResult> results;
+                 {
+                     py::gil_scoped_release release;
+                     results = parallel.replay(times_us.data(), prices.data(),
+                                               static_cast<size_t>(prices.size()), batch_ticks);
+                 }
+                 py::list out;
+                 for (const auto& result : results) {
+                     out.append(backtestResultDict(result));
+                 }
+                 return out;
+             },
+             py::arg("times_us"), py::arg("prices"), py::arg("batch_ticks") = ParallelBacktest::kDefaultBatch,
+             "Replay recorded prices to every strategy\n\n"
+             "Returns:\n"
+             "    list: One Backtest result dict per strategy, in the order added")
+        .def("replay_store",
+             [](ParallelBacktest& parallel, const TickStore& store, int64_t from, int64_t to,
+                long long time_unit_us, size_t batch_ticks) {
+                 std::vector<BacktestResult> results;
+                 {
+                     py::gil_scoped_release release;
+                     results = parallel.replay(store, from, to, time_unit_us, batch_ticks);
+                 }
+                 py::list out;
+                 for (const auto& result : results) {
+                     out.append(backtestResultDict(result));
+                 }
+                 return out;
+             },
+             py::arg("store"), py::arg("t_from"), py::arg("t_to"), py::arg("time_unit_us") = 1000,
+             py::arg("batch_ticks") = ParallelBacktest::kDefaultBatch,
+             "Replay a TickStore's ticks with t_from <= timestamp < t_to\n\n"
+             "Args:\n"
+             "    time_unit_us: Microseconds per store time unit (1000 for milliseconds)\n\n"
+             "Returns:\n"
+             "    list: As replay(); simulated time starts at the first tick")
+        .def("__len__", &ParallelBacktest::size)
+        .def("threads", &ParallelBacktest::threads);
+
+    // Engine metrics
+    m.def("render_prometheus", &EngineMetrics::renderPrometheus,
+          "Render engine counters and gauges in Prometheus text format\n\n"
+          "Returns:\n"
+          "    str: Exposition text (version 0.0.4), one HELP/TYPE/value block per metric");
+    m.def("reset_metric_counters", &EngineMetrics::resetCounters,
+          "Zero the engine counters (gauges track live state and are kept)");
+
+    // Batch kernels (SIMD variant chosen from CPUID at import)
+    m.def("sma_batch", &smaBatch, py::arg("prices"), py::arg("window"),
+          "Rolling SMA over a whole price series\n\n"
+          "Args:\n"
+          "    prices: 1-D array of prices\n"
+          "    window: SMA window size\n\n"
+          "Returns:\n"
+          "    numpy.ndarray: SMA after each price (same as feeding SMACalculator)");
+    m.def("indicator_bank", &indicatorBank, py::arg("prices"), py::arg("windows"),
+          "Several rolling SMAs over the same series in one pass\n\n"
+          "Args:\n"
+          "    prices: 1-D array of prices\n"
+          "    windows: List of window sizes\n\n"
+          "Returns:\n"
+          "    numpy.ndarray: Shape (len(windows), len(prices))");
+    m.def("cumulative_depth", &cumulativeDepth, py::arg("prices"), py::arg("quantities"),
+          "Cumulative quantity and notional along one side of the book\n\n"
+          "Args:\n"
+          "    prices: Level prices, best first\n"
+          "    quantities: Level quantities\n\n"
+          "Returns:\n"
+          "    Tuple[numpy.ndarray, numpy.ndarray]: (cumulative quantity, cumulative notional)");
+    m.def("gaussian_normals", &gaussianNormals,
+          py::arg("n"), py::arg("seed") = 0, py::arg("offset") = 0,
+          "Standard normal draws for GBM shocks (counter-based stream)\n\n"
+          "Args:\n"
+          "    n: Number of draws\n"
+          "    seed: Stream seed\n"
+          "    offset: Index of the first draw within the stream\n\n"
+          "Returns:\n"
+          "    numpy.ndarray: n draws, identical on every SIMD path");
+    m.def("gbm_path",
+          [](double s0, double drift, double volatility, double dt, size_t n, uint64_t seed) {
+              std::vector<double> path = kernels::gbmPath(s0, drift, volatility, dt, seed, n);
+              return DoubleArray(static_cast<py::ssize_t>(path.size()), path.data());
+          },
+          py::arg("s0"), py::arg("drift"), py::arg("volatility"), py::arg("dt"),
+          py::arg("n"), py::arg("seed") = 0,
+          "Geometric Brownian motion path driven by gaussian_normals\n\n"
+          "Returns:\n"
+          "    numpy.ndarray: n prices after each step");
+    m.def("simd_path", []() { return kernels::simdPathName(kernels::activeSimdPath()); },
+          "SIMD variant the batch kernels are using (scalar, avx2 or avx512)");
+    m.def("set_simd_path",
+          [](const std::string& name) { kernels::setSimdPath(simdPathFromName(name)); },
+          py::arg("name"),
+          "Switch the batch kernels to another supported SIMD variant (for benchmarking)");
+    py::list simd_paths;
+    for (auto path : {kernels::SimdPath::SCALAR, kernels::SimdPath::AVX2, kernels::SimdPath::AVX512}) {
+        if (kernels::simdPathSupported(path)) {
+            simd_paths.append(kernels::simdPathName(path));
+        }
+    }
+    m.attr("SIMD_PATHS_SUPPORTED") = simd_paths;
+    m.attr("SIMD_PATH") = kernels::simdPathName(kernels::activeSimdPath());
+
+    // Allocation tracking
+    m.def("allocation_counters",
+          []() {
+              alloc::Counters c = alloc::threadCounters();
+              py::dict d;
+              d["allocations"] = c.allocations;
+              d["deallocations"] = c.deallocations;
+              d["bytes"] = c.bytes;
+              return d;
+          },
+          "Heap activity of the calling thread inside the engine\n\n"
+          "Diff two calls around an engine call to get its allocations.\n"
+          "All zero unless built with TRADE_ENGINE_ALLOC_TRACKING.\n\n"
+          "Returns:\n"
+          "    dict: {allocations, deallocations, bytes}");
+    m.attr("ALLOC_TRACKING_ENABLED") = alloc::enabled();
+
+    // Event tracing
+    m.def("dump_trace", &trace::dump, py::arg("path"),
+          "Write all recorded engine trace events to a binary file\n\n"
+          "Convert it with the trace_dump tool to Chrome trace JSON.\n\n"
+          "Args:\n"
+          "    path: Output file path\n\n"
+          "Returns:\n"
+          "    int: Number of events written");
+    m.def("clear_trace", &trace::clear,
+          "Discard all recorded engine trace events");
+#ifdef TRADING_ENABLE_TRACE
+    m.attr("TRACE_ENABLED") = true;
+#else
+    m.attr("TRACE_ENABLED") = false;
+#endif
+
+#ifdef TRADING_LATENCY_STATS
+    m.attr("LATENCY_STATS_ENABLED") = true;
+#else
+    m.attr("LATENCY_STATS_ENABLED") = false;
+#endif
 
     // Module version
     m.attr("__version__") = "1.0.0";
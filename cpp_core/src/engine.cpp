@@ -1,11 +1,39 @@
 #include "engine.hpp"
+#include "kernels.hpp"
+#include "trace.hpp"
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <numeric>
 #include <stdexcept>
-#include <sstream>
+#include <tuple>
 
 namespace trading {
 
+// ==================== PriceHistory Implementation ====================
+
+PriceHistory::PriceHistory(size_t capacity)
+    : timestamps_(capacity, 0.0),
+      prices_(capacity, 0.0) {
+    if (capacity == 0) {
+        throw std::invalid_argument("History capacity must be greater than 0");
+    }
+}
+
+void PriceHistory::unwrap() {
+    if (contiguous()) {
+        return;
+    }
+    // Full and wrapped: the oldest sample sits at next_
+    std::rotate(timestamps_.begin(), timestamps_.begin() + next_, timestamps_.end());
+    std::rotate(prices_.begin(), prices_.begin() + next_, prices_.end());
+    next_ = 0;
+}
+
 // ==================== SMACalculator Implementation ====================
 
 SMACalculator::SMACalculator(size_t window_size)
@@ -40,6 +68,14 @@ void SMACalculator::addPrice(double price) {
     if (current_size_ < window_size_) {
         current_size_++;
     }
+    
+    EngineMetrics::increment(Counter::SMA_UPDATES);
+    TRADING_TRACE(trace::EventType::SMA_UPDATE, 0, 0, price, getSMA());
+}
+
+void SMACalculator::addPrice(double price, double timestamp, PriceHistory& history) {
+    addPrice(price);
+    history.push(timestamp, price);
 }
 
 double SMACalculator::getSMA() const {
@@ -58,143 +94,1463 @@ void SMACalculator::reset() {
 
 // ==================== OrderBook Implementation ====================
 
-std::string OrderBook::generateOrderId() {
-    std::ostringstream oss;
-    oss << "ORD" << next_order_id_++;
-    return oss.str();
+namespace {
+
+// Formatted on the stack; "ORD" + up to 12 digits fits the string's inline buffer
+std::string orderIdFor(uint64_t seq) {
+    char buf[24] = {'O', 'R', 'D'};
+    char* end = std::to_chars(buf + 3, buf + sizeof(buf), seq).ptr;
+    return std::string(buf, static_cast<size_t>(end - buf));
+}
+
+// The same, written over an existing string without constructing a new one
+void assignOrderId(std::string& id, uint64_t seq) {
+    char buf[24] = {'O', 'R', 'D'};
+    char* end = std::to_chars(buf + 3, buf + sizeof(buf), seq).ptr;
+    id.assign(buf, static_cast<size_t>(end - buf));
+}
+
+long long nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+template <typename Policy>
+std::string BasicOrderBook<Policy>::generateOrderId() {
+    return orderIdFor(next_order_id_++);
+}
+
+template <typename Policy>
+template <typename LevelMap>
+typename BasicOrderBook<Policy>::OrderQueue& BasicOrderBook<Policy>::levelFor(LevelMap& levels, double price) {
+    auto [level, inserted] = levels.try_emplace(price);
+    if (inserted && !spare_levels_.empty()) {
+        level->second.swap(spare_levels_.back());
+        spare_levels_.pop_back();
+    }
+    return level->second;
+}
+
+template <typename Policy>
+template <typename LevelMap>
+void BasicOrderBook<Policy>::eraseLevel(LevelMap& levels, typename LevelMap::iterator level) {
+    if (spare_levels_.size() < kMaxSpareLevels) {
+        level->second.clear();
+        spare_levels_.push_back(std::move(level->second));
+    }
+    levels.erase(level);
+}
+
+template <typename Policy>
+template <typename LevelMap>
+void BasicOrderBook<Policy>::eraseLevels(LevelMap& levels, typename LevelMap::iterator first,
+                            typename LevelMap::iterator last) {
+    for (auto level = first; level != last && spare_levels_.size() < kMaxSpareLevels; ++level) {
+        level->second.clear();
+        spare_levels_.push_back(std::move(level->second));
+    }
+    levels.erase(first, last);
+}
+
+template <typename Policy>
+template <typename LevelMap>
+void BasicOrderBook<Policy>::removeFilled(LevelMap& levels, typename LevelMap::iterator level) {
+    auto& orders = level->second;
+    auto filled = [this](const Order& order) {
+        if (order.quantity > 0) {
+            return false;
+        }
+        if (!(order.iceberg && replenish(order))) {
+            order_index_.erase(order.seq);
+        }
+        return true;
+    };
+    // Filled orders at the front go by moving the head past them; when
+    // the policy fills levels in time order, that is all of them
+    size_t front = 0;
+    while (front < orders.size() && filled(orders[front])) {
+        ++front;
+    }
+    orders.pop_front(front);
+    if constexpr (!Policy::fills_front) {
+        orders.erase(std::remove_if(orders.begin(), orders.end(), filled), orders.end());
+    }
+    // Refilled icebergs rejoin at the back of the level
+    for (auto& order : replenished_) {
+        orders.push_back(std::move(order));
+    }
+    replenished_.clear();
+    if (orders.empty()) {
+        eraseLevel(levels, level);
+    }
 }
 
-std::string OrderBook::addOrder(OrderSide side, double price, double quantity) {
+template <typename Policy>
+std::string BasicOrderBook<Policy>::addOrder(OrderSide side, double price, double quantity) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::ADD)]);
+    EngineMetrics::increment(Counter::ORDERS_IN);
+    
     if (price <= 0 || quantity <= 0) {
+        EngineMetrics::increment(Counter::ORDERS_REJECTED);
         throw std::invalid_argument("Price and quantity must be positive");
     }
     
+    uint64_t seq = next_order_id_;
     std::string order_id = generateOrderId();
-    Order order(order_id, side, price, quantity);
+    order_index_[seq] = OrderLocation{price, side};
+    TRADING_TRACE(trace::EventType::ORDER_ADD, seq, side == OrderSide::SELL ? 1 : 0, price, quantity);
+    
+    // Batch auction: held back at its price, in arrival order, until clearBatch()
+    if (mode_ == TradingMode::BATCH) {
+        PendingSide& pending = side == OrderSide::BUY ? pending_bids_ : pending_asks_;
+        BatchLevel& level = batchLevel(pending, price);
+        level.orders.emplace_back(order_id, side, price, quantity, seq, nowMillis());
+        level.quantity += quantity;
+        pending.orders++;
+        if (pending.first_seq == 0) {
+            pending.first_seq = seq;
+        }
+        updateGauges();
+        high_water_orders_ = std::max(high_water_orders_, order_index_.size());
+        return order_id;
+    }
     
+    Order order(order_id, side, price, quantity, seq);
     if (side == OrderSide::BUY) {
-        bids_[price].push_back(std::move(order));
+        levelFor(bids_, price).push_back(std::move(order));
     } else {
-        asks_[price].push_back(std::move(order));
+        levelFor(asks_, price).push_back(std::move(order));
     }
     
+    updateGauges();
+    high_water_orders_ = std::max(high_water_orders_, order_index_.size());
+    high_water_levels_ = std::max(high_water_levels_, bids_.size() + asks_.size());
+    
     return order_id;
 }
 
-std::vector<Trade> OrderBook::matchOrders() {
+// ==================== Iceberg Orders ====================
+
+template <typename Policy>
+std::string BasicOrderBook<Policy>::addIcebergOrder(OrderSide side, double price, double display_quantity,
+                                                    double total_quantity) {
+    if (display_quantity <= 0 || total_quantity < display_quantity) {
+        EngineMetrics::increment(Counter::ORDERS_IN);
+        EngineMetrics::increment(Counter::ORDERS_REJECTED);
+        throw std::invalid_argument("Display quantity must be positive and at most the total");
+    }
+    const uint64_t seq = next_order_id_;
+    std::string order_id = addOrder(side, price, display_quantity);
+    if (total_quantity > display_quantity) {
+        reserves_.emplace(seq, Reserve{display_quantity, total_quantity - display_quantity});
+        auto& queue = mode_ == TradingMode::BATCH
+            ? findBatchLevel(side == OrderSide::BUY ? pending_bids_ : pending_asks_, price)->orders
+            : side == OrderSide::BUY ? bids_.find(price)->second : asks_.find(price)->second;
+        queue.back().iceberg = true;
+    }
+    return order_id;
+}
+
+template <typename Policy>
+double BasicOrderBook<Policy>::nextTranche(uint64_t seq) {
+    auto reserve = reserves_.find(seq);
+    if (reserve == reserves_.end()) {
+        return 0.0;
+    }
+    const double tranche = std::min(reserve->second.display, reserve->second.hidden);
+    reserve->second.hidden -= tranche;
+    if (reserve->second.hidden <= 0) {
+        reserves_.erase(reserve);
+    }
+    return tranche;
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::replenish(const Order& order) {
+    // The filled tranche's order, refilled from the reserve, waits in
+    // replenished_; false once the reserve is spent
+    const double tranche = nextTranche(order.seq);
+    if (tranche <= 0) {
+        return false;
+    }
+    replenished_.push_back(order);
+    replenished_.back().quantity = tranche;
+    refills_.push_back(IcebergRefill{order.seq, order.side, order.price, tranche});
+    return true;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::requeueReplenished() {
+    for (auto& order : replenished_) {
+        auto& queue = order.side == OrderSide::BUY ? levelFor(bids_, order.price) : levelFor(asks_, order.price);
+        queue.push_back(std::move(order));
+    }
+    replenished_.clear();
+}
+
+// ==================== Good-Till Orders ====================
+
+template <typename Policy>
+std::string BasicOrderBook<Policy>::addOrderGoodTill(OrderSide side, double price, double quantity,
+                                                     long long expire_ms) {
+    if (expire_ms <= clockMillis()) {
+        EngineMetrics::increment(Counter::ORDERS_IN);
+        EngineMetrics::increment(Counter::ORDERS_REJECTED);
+        throw std::invalid_argument("Expiry must be after the engine clock");
+    }
+    const uint64_t seq = next_order_id_;
+    std::string order_id = addOrder(side, price, quantity);
+    time_expiries_.schedule(static_cast<uint64_t>(expire_ms), seq);
+    return order_id;
+}
+
+template <typename Policy>
+std::string BasicOrderBook<Policy>::addOrderGoodForTicks(OrderSide side, double price, double quantity,
+                                                         uint64_t ticks) {
+    if (ticks == 0) {
+        EngineMetrics::increment(Counter::ORDERS_IN);
+        EngineMetrics::increment(Counter::ORDERS_REJECTED);
+        throw std::invalid_argument("Tick count must be greater than 0");
+    }
+    const uint64_t seq = next_order_id_;
+    std::string order_id = addOrder(side, price, quantity);
+    tick_expiries_.schedule(ticks_ + ticks, seq);
+    return order_id;
+}
+
+template <typename Policy>
+size_t BasicOrderBook<Policy>::advanceTime(long long now_ms) {
+    const size_t before = expired_.size();
+    if (now_ms > clockMillis()) {
+        expire(time_expiries_, static_cast<uint64_t>(now_ms));
+    }
+    return expired_.size() - before;
+}
+
+template <typename Policy>
+size_t BasicOrderBook<Policy>::takeExpired(std::vector<ExpiredOrder>& expired) {
+    expired.clear();
+    expired.swap(expired_);
+    return expired.size();
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::expire(TimingWheel& wheel, uint64_t now) {
+    expiring_.clear();
+    if (wheel.advance(now, expiring_) == 0) {
+        return;
+    }
+    
+    // Stops and batch orders leave one by one. Book orders are grouped by
+    // level so each level is filtered once, however many of its quotes expire.
+    const long long timestamp = nowMillis();
+    level_expiries_.clear();
+    for (uint64_t seq : expiring_) {
+        auto loc = order_index_.find(seq);
+        if (loc == order_index_.end()) {
+            continue;  // Filled or cancelled since it was scheduled
+        }
+        const OrderLocation where = loc->second;
+        if (!where.stop && !waiting(where.side, seq)) {
+            level_expiries_.push_back(LevelExpiry{where.side, where.price, seq});
+            order_index_.erase(loc);
+            continue;
+        }
+        double quantity = 0.0;
+        if (removeOrder(loc, quantity)) {
+            expired_.push_back(ExpiredOrder{orderIdFor(seq), where.side, where.price, quantity, timestamp});
+            TRADING_TRACE(trace::EventType::ORDER_EXPIRE, seq, where.side == OrderSide::SELL ? 1 : 0,
+                          where.price, quantity);
+        }
+    }
+    
+    std::sort(level_expiries_.begin(), level_expiries_.end(), [](const LevelExpiry& a, const LevelExpiry& b) {
+        return std::tie(a.side, a.price, a.seq) < std::tie(b.side, b.price, b.seq);
+    });
+    for (auto first = level_expiries_.begin(); first != level_expiries_.end();) {
+        auto last = std::find_if(first, level_expiries_.end(), [first](const LevelExpiry& e) {
+            return e.side != first->side || e.price != first->price;
+        });
+        if (first->side == OrderSide::BUY) {
+            expireFromLevel(bids_, first, last, timestamp);
+        } else {
+            expireFromLevel(asks_, first, last, timestamp);
+        }
+        first = last;
+    }
+    updateGauges();
+}
+
+template <typename Policy>
+template <typename LevelMap>
+void BasicOrderBook<Policy>::expireFromLevel(LevelMap& levels, typename std::vector<LevelExpiry>::iterator first,
+                                             typename std::vector<LevelExpiry>::iterator last,
+                                             long long timestamp) {
+    auto level = levels.find(first->price);
+    if (level == levels.end()) {
+        return;
+    }
+    auto& orders = level->second;
+    auto expiring = [&](const Order& order) {
+        auto it = std::lower_bound(first, last, order.seq,
+                                   [](const LevelExpiry& e, uint64_t seq) { return e.seq < seq; });
+        if (it == last || it->seq != order.seq) {
+            return false;
+        }
+        double quantity = order.quantity;
+        if (order.iceberg) {
+            auto reserve = reserves_.find(order.seq);
+            if (reserve != reserves_.end()) {
+                quantity += reserve->second.hidden;
+                reserves_.erase(reserve);
+            }
+        }
+        expired_.push_back(ExpiredOrder{order.id, order.side, order.price, quantity, timestamp});
+        TRADING_TRACE(trace::EventType::ORDER_EXPIRE, order.seq, order.side == OrderSide::SELL ? 1 : 0,
+                      order.price, quantity);
+        return true;
+    };
+    orders.erase(std::remove_if(orders.begin(), orders.end(), expiring), orders.end());
+    if (orders.empty()) {
+        eraseLevel(levels, level);
+    }
+}
+
+template <typename Policy>
+std::vector<Trade> BasicOrderBook<Policy>::matchOrders() {
     std::vector<Trade> trades;
+    matchOrders(trades);
+    return trades;
+}
+
+template <typename Policy>
+size_t BasicOrderBook<Policy>::matchOrders(std::vector<Trade>& trades) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::MATCH)]);
+    TRADING_TRACE(trace::EventType::MATCH_BEGIN);
     
-    // Continue matching while we have both bids and asks
+    trades.clear();
+    refills_.clear();
+    
+    // Call or batch auction: the book may stay crossed until uncross()/clearBatch()
+    if (mode_ != TradingMode::CONTINUOUS) {
+        TRADING_TRACE(trace::EventType::MATCH_END, 0, 0);
+        return 0;
+    }
+    
+    // Trade the best levels against each other until the book no longer crosses
+    const long long timestamp = nowMillis();
+    auto fill = [&trades, timestamp](Order& bid, Order& ask, double quantity) {
+        const double price = matching::tradePrice<Policy::trade_price>(bid, ask);
+        trades.push_back(Trade{bid.id, ask.id, price, quantity, timestamp});
+        TRADING_TRACE(trace::EventType::TRADE, bid.seq, ask.seq, price, quantity);
+        bid.quantity -= quantity;
+        ask.quantity -= quantity;
+    };
     while (!bids_.empty() && !asks_.empty()) {
-        // Get best bid and ask
-        auto& best_bid_level = bids_.begin();
-        auto& best_ask_level = asks_.begin();
-        
-        double best_bid_price = best_bid_level->first;
-        double best_ask_price = best_ask_level->first;
-        
-        // Check if prices cross (bid >= ask)
-        if (best_bid_price < best_ask_price) {
+        auto best_bid_level = bids_.begin();
+        auto best_ask_level = asks_.begin();
+        if (best_bid_level->first < best_ask_level->first) {
             break;  // No match possible
         }
         
-        // Get the first order at each price level (FIFO)
-        auto& bid_orders = best_bid_level->second;
-        auto& ask_orders = best_ask_level->second;
-        
-        if (bid_orders.empty() || ask_orders.empty()) {
-            // Clean up empty levels
-            if (bid_orders.empty()) bids_.erase(best_bid_level);
-            if (ask_orders.empty()) asks_.erase(best_ask_level);
-            continue;
+        Policy::matchLevels(best_bid_level->second, best_ask_level->second, match_scratch_, fill);
+        removeFilled(bids_, best_bid_level);
+        removeFilled(asks_, best_ask_level);
+    }
+    
+    if (!trades.empty()) {
+        if (stop_orders_ > 0) {
+            auto [low, high] = std::minmax_element(
+                trades.begin(), trades.end(),
+                [](const Trade& a, const Trade& b) { return a.price < b.price; });
+            fireStops(trades, high->price, low->price);
+        }
+        last_price_ = trades.back().price;
+        EngineMetrics::increment(Counter::FILLS, trades.size());
+        updateGauges();
+    }
+    
+    TRADING_TRACE(trace::EventType::MATCH_END, 0, trades.size());
+    return trades.size();
+}
+
+// ==================== Stop Orders ====================
+
+template <typename Policy>
+std::string BasicOrderBook<Policy>::addStopOrder(OrderSide side, double stop_price, double quantity,
+                                                 double limit_price) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::ADD)]);
+    EngineMetrics::increment(Counter::ORDERS_IN);
+    
+    if (stop_price <= 0 || quantity <= 0 || limit_price < 0) {
+        EngineMetrics::increment(Counter::ORDERS_REJECTED);
+        throw std::invalid_argument("Stop price and quantity must be positive, limit non-negative");
+    }
+    
+    uint64_t seq = next_order_id_;
+    std::string order_id = generateOrderId();
+    order_index_[seq] = OrderLocation{stop_price, side, true};
+    TRADING_TRACE(trace::EventType::ORDER_ADD, seq, side == OrderSide::SELL ? 1 : 0, limit_price, quantity);
+    
+    Order order(order_id, side, limit_price, quantity, seq);
+    if (side == OrderSide::BUY) {
+        levelFor(buy_stops_, stop_price).push_back(std::move(order));
+    } else {
+        levelFor(sell_stops_, stop_price).push_back(std::move(order));
+    }
+    stop_orders_++;
+    
+    updateGauges();
+    high_water_orders_ = std::max(high_water_orders_, order_index_.size());
+    return order_id;
+}
+
+template <typename Policy>
+size_t BasicOrderBook<Policy>::processTick(double price, std::vector<Trade>& trades) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::MATCH)]);
+    
+    if (price <= 0) {
+        throw std::invalid_argument("Price must be positive");
+    }
+    
+    trades.clear();
+    refills_.clear();
+    last_price_ = price;
+    if (mode_ == TradingMode::CONTINUOUS && stop_orders_ > 0) {
+        fireStops(trades, price, price);
+        if (!trades.empty()) {
+            last_price_ = trades.back().price;
+            EngineMetrics::increment(Counter::FILLS, trades.size());
+        }
+        updateGauges();
+    }
+    
+    // Good-for-ticks orders expire at the end of their last tick
+    expire(tick_expiries_, ++ticks_);
+    return trades.size();
+}
+
+template <typename Policy>
+template <typename StopMap>
+void BasicOrderBook<Policy>::popTriggered(StopMap& stops, double price) {
+    // Stops are ordered by which fires first, so the triggered ones are a prefix
+    auto last = stops.begin();
+    while (last != stops.end() && !stops.key_comp()(price, last->first)) {
+        for (auto& order : last->second) {
+            triggered_.push_back(std::move(order));
+        }
+        stop_orders_ -= last->second.size();
+        ++last;
+    }
+    eraseLevels(stops, stops.begin(), last);
+}
+
+template <typename Policy>
+template <typename LevelMap, typename Fill>
+void BasicOrderBook<Policy>::sweep(LevelMap& levels, Fill& fill) {
+    Order& taker = taker_.front();
+    const bool market = taker.price == 0.0;
+    while (taker.quantity > 0 && !levels.empty()) {
+        auto level = levels.begin();
+        if (!market && levels.key_comp()(taker.price, level->first)) {
+            break;  // Past the limit
+        }
+        if (taker.side == OrderSide::BUY) {
+            Policy::matchLevels(taker_, level->second, match_scratch_, fill);
+        } else {
+            Policy::matchLevels(level->second, taker_, match_scratch_, fill);
+        }
+        removeFilled(levels, level);
+    }
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::fireStops(std::vector<Trade>& trades, double high, double low) {
+    // A fired stop takes liquidity, so it trades at the resting order's
+    // price unless the rule prices a limit crossing differently
+    const long long timestamp = nowMillis();
+    auto fill = [this, &trades, timestamp](Order& bid, Order& ask, double quantity) {
+        const Order& taker = taker_.front();
+        const Order& resting = &bid == &taker ? ask : bid;
+        const double price = taker.price == 0.0 || Policy::trade_price == TradePrice::PASSIVE
+            ? resting.price : matching::tradePrice<Policy::trade_price>(bid, ask);
+        trades.push_back(Trade{bid.id, ask.id, price, quantity, timestamp});
+        TRADING_TRACE(trace::EventType::TRADE, bid.seq, ask.seq, price, quantity);
+        bid.quantity -= quantity;
+        ask.quantity -= quantity;
+    };
+    
+    // Each round fires the stops the previous round's prices reached; the
+    // cascade ends when a round trades nothing or nothing more triggers
+    size_t checked = trades.size();
+    while (stop_orders_ > 0) {
+        triggered_.clear();
+        popTriggered(buy_stops_, high);
+        popTriggered(sell_stops_, low);
+        if (triggered_.empty()) {
+            break;
         }
         
-        Order& bid_order = bid_orders.front();
-        Order& ask_order = ask_orders.front();
-        
-        // Execute trade at the ask price (price-time priority)
-        double trade_price = best_ask_price;
-        double trade_quantity = std::min(bid_order.quantity, ask_order.quantity);
-        
-        // Create trade record
-        Trade trade;
-        trade.buy_order_id = bid_order.id;
-        trade.sell_order_id = ask_order.id;
-        trade.price = trade_price;
-        trade.quantity = trade_quantity;
-        
-        auto now = std::chrono::system_clock::now();
-        trade.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()
-        ).count();
+        for (auto& order : triggered_) {
+            TRADING_TRACE(trace::EventType::STOP_TRIGGER, order.seq,
+                          order.side == OrderSide::SELL ? 1 : 0, order.price, order.quantity);
+            taker_.push_back(std::move(order));
+            if (taker_.front().side == OrderSide::BUY) {
+                sweep(asks_, fill);
+            } else {
+                sweep(bids_, fill);
+            }
+            
+            // A stop-limit rests what it could not trade; a stop drops it
+            Order& rest = taker_.front();
+            auto loc = order_index_.find(rest.seq);
+            if (rest.quantity > 0 && rest.price > 0) {
+                loc->second = OrderLocation{rest.price, rest.side};
+                if (rest.side == OrderSide::BUY) {
+                    levelFor(bids_, rest.price).push_back(std::move(rest));
+                } else {
+                    levelFor(asks_, rest.price).push_back(std::move(rest));
+                }
+            } else {
+                order_index_.erase(loc);
+            }
+            taker_.clear();
+        }
         
-        trades.push_back(trade);
+        if (trades.size() == checked) {
+            break;
+        }
+        high = low = trades[checked].price;
+        for (size_t i = checked; i < trades.size(); ++i) {
+            high = std::max(high, trades[i].price);
+            low = std::min(low, trades[i].price);
+        }
+        checked = trades.size();
+    }
+    high_water_levels_ = std::max(high_water_levels_, bids_.size() + asks_.size());
+}
+
+// ==================== Call Auction ====================
+
+namespace {
+
+// Crossing levels of one side, best first, with cumulative quantity
+struct AuctionDepth {
+    std::vector<double> prices;
+    std::vector<double> quantities;
+    std::vector<double> cum_quantity;
+    std::vector<double> cum_notional;
+
+    // Quantity on levels at `price` or better; `better` orders the side best first
+    template <typename Better>
+    double quantityThrough(double price, Better better) const {
+        auto end = std::partition_point(prices.begin(), prices.end(),
+                                        [&](double level) { return !better(price, level); });
+        size_t n = static_cast<size_t>(end - prices.begin());
+        return n > 0 ? cum_quantity[n - 1] : 0.0;
+    }
+};
+
+template <typename LevelMap, typename Crosses>
+void collectDepth(const LevelMap& levels, Crosses crosses, AuctionDepth& depth) {
+    for (const auto& [price, orders] : levels) {
+        if (!crosses(price)) {
+            break;
+        }
+        double quantity = 0.0;
+        for (const auto& order : orders) {
+            quantity += order.quantity;
+        }
+        depth.prices.push_back(price);
+        depth.quantities.push_back(quantity);
+    }
+    const size_t n = depth.prices.size();
+    depth.cum_quantity.resize(n);
+    depth.cum_notional.resize(n);
+    kernels::cumulativeDepth(depth.prices.data(), depth.quantities.data(), n,
+                             depth.cum_quantity.data(), depth.cum_notional.data());
+}
+
+AuctionResult equilibrium(const AuctionDepth& bids, const AuctionDepth& asks, double reference_price) {
+    AuctionResult result;
+    const size_t nb = bids.prices.size();
+    const size_t na = asks.prices.size();
+    result.price_levels = nb + na;
+    if (nb == 0 || na == 0) {
+        return result;
+    }
+    
+    // Walk every crossing price once, lowest first. Asks are ascending and
+    // bids descending, so supply at p is the ask depth through the asks
+    // consumed so far and demand is the depth of the bids not yet passed.
+    // Volume rises then falls and surplus falls monotonically, so the tied
+    // best prices form one contiguous range [low, high].
+    double best_volume = 0.0;
+    double best_surplus = 0.0;
+    double low = 0.0, high = 0.0;
+    bool buy_pressure = false, sell_pressure = false;
+    size_t ia = 0, ib = nb;
+    while (ia < na || ib > 0) {
+        const double p = (ib == 0 || (ia < na && asks.prices[ia] <= bids.prices[ib - 1]))
+            ? asks.prices[ia] : bids.prices[ib - 1];
+        const double demand = ib > 0 ? bids.cum_quantity[ib - 1] : 0.0;
+        if (ia < na && asks.prices[ia] == p) ia++;
+        if (ib > 0 && bids.prices[ib - 1] == p) ib--;
+        const double supply = ia > 0 ? asks.cum_quantity[ia - 1] : 0.0;
         
-        // Update order quantities
-        bid_order.quantity -= trade_quantity;
-        ask_order.quantity -= trade_quantity;
+        const double volume = std::min(demand, supply);
+        const double surplus = demand - supply;
+        if (volume > best_volume
+                || (volume == best_volume && std::fabs(surplus) < std::fabs(best_surplus))) {
+            best_volume = volume;
+            best_surplus = surplus;
+            low = high = p;
+            buy_pressure = surplus > 0;
+            sell_pressure = surplus < 0;
+        } else if (volume == best_volume && std::fabs(surplus) == std::fabs(best_surplus)) {
+            high = p;
+            buy_pressure = buy_pressure && surplus > 0;
+            sell_pressure = sell_pressure && surplus < 0;
+        }
+    }
+    
+    if (buy_pressure) {
+        result.price = high;
+    } else if (sell_pressure) {
+        result.price = low;
+    } else if (reference_price > 0) {
+        result.price = std::clamp(reference_price, low, high);
+    } else {
+        result.price = low + (high - low) / 2;
+    }
+    
+    // A price between two levels can only do better than its neighbours
+    const double demand = bids.quantityThrough(result.price, std::greater<double>());
+    const double supply = asks.quantityThrough(result.price, std::less<double>());
+    result.volume = std::min(demand, supply);
+    result.buy_surplus = demand - supply;
+    return result;
+}
+
+} // namespace
+
+template <typename Policy>
+AuctionResult BasicOrderBook<Policy>::indicativeAuction(double reference_price) const {
+    AuctionDepth bids, asks;
+    if (!bids_.empty() && !asks_.empty()) {
+        const double best_bid = bids_.begin()->first;
+        const double best_ask = asks_.begin()->first;
+        collectDepth(bids_, [best_ask](double price) { return price >= best_ask; }, bids);
+        collectDepth(asks_, [best_bid](double price) { return price <= best_bid; }, asks);
+    }
+    return equilibrium(bids, asks, reference_price);
+}
+
+template <typename Policy>
+AuctionResult BasicOrderBook<Policy>::uncross(std::vector<Trade>& trades, double reference_price) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::MATCH)]);
+    TRADING_TRACE(trace::EventType::MATCH_BEGIN);
+    
+    trades.clear();
+    refills_.clear();
+    AuctionResult result = indicativeAuction(reference_price);
+    if (result.volume <= 0) {
+        TRADING_TRACE(trace::EventType::MATCH_END, 0, 0);
+        return result;
+    }
+    
+    const double price = result.price;
+    const long long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    
+    // Pair orders off in priority order on each side while both still cross
+    // the uncross price; positions are advanced instead of erasing per order
+    auto bid_level = bids_.begin();
+    auto ask_level = asks_.begin();
+    size_t bid_pos = 0, ask_pos = 0;
+    while (bid_level != bids_.end() && bid_level->first >= price
+           && ask_level != asks_.end() && ask_level->first <= price) {
+        Order& bid_order = bid_level->second[bid_pos];
+        Order& ask_order = ask_level->second[ask_pos];
+        const double quantity = std::min(bid_order.quantity, ask_order.quantity);
+        trades.push_back(Trade{bid_order.id, ask_order.id, price, quantity, timestamp});
+        TRADING_TRACE(trace::EventType::TRADE, bid_order.seq, ask_order.seq, price, quantity);
         
-        // Remove fully filled orders
+        bid_order.quantity -= quantity;
+        ask_order.quantity -= quantity;
         if (bid_order.quantity == 0) {
-            bid_orders.erase(bid_orders.begin());
-            if (bid_orders.empty()) {
-                bids_.erase(best_bid_level);
+            if (!(bid_order.iceberg && replenish(bid_order))) {
+                order_index_.erase(bid_order.seq);
+            }
+            if (++bid_pos == bid_level->second.size()) {
+                ++bid_level;
+                bid_pos = 0;
             }
         }
-        
         if (ask_order.quantity == 0) {
-            ask_orders.erase(ask_orders.begin());
-            if (ask_orders.empty()) {
-                asks_.erase(best_ask_level);
+            if (!(ask_order.iceberg && replenish(ask_order))) {
+                order_index_.erase(ask_order.seq);
+            }
+            if (++ask_pos == ask_level->second.size()) {
+                ++ask_level;
+                ask_pos = 0;
             }
         }
     }
     
-    return trades;
+    // Drop the filled levels in one go, then the filled front of the marginal ones
+    eraseLevels(bids_, bids_.begin(), bid_level);
+    eraseLevels(asks_, asks_.begin(), ask_level);
+    if (bid_pos > 0) {
+        bid_level->second.pop_front(bid_pos);
+    }
+    if (ask_pos > 0) {
+        ask_level->second.pop_front(ask_pos);
+    }
+    // Icebergs show their next tranche after the auction, behind their level
+    requeueReplenished();
+    
+    // The auction price is the last price; once trading is continuous the
+    // stops it reaches fire at once, and any others their trades reach
+    last_price_ = price;
+    if (mode_ == TradingMode::CONTINUOUS && stop_orders_ > 0) {
+        const size_t auction_trades = trades.size();
+        fireStops(trades, price, price);
+        if (trades.size() > auction_trades) {
+            last_price_ = trades.back().price;
+        }
+    }
+    
+    EngineMetrics::increment(Counter::FILLS, trades.size());
+    updateGauges();
+    TRADING_TRACE(trace::EventType::MATCH_END, 0, trades.size());
+    return result;
+}
+
+// ==================== Batch Auction ====================
+
+namespace {
+
+// Fibonacci hashing: the top bits of the product depend on every bit of the
+// price, which matters as round prices have all-zero low bits
+inline size_t priceSlot(double price, unsigned shift, uint64_t& bits) {
+    std::memcpy(&bits, &price, sizeof(bits));
+    return static_cast<size_t>((bits * 0x9E3779B97F4A7C15ULL) >> shift);
+}
+
+/**
+ * Depth of the levels of one side that can trade, best first
+ */
+template <typename Level, typename Crosses>
+void batchDepth(const std::vector<Level>& levels, const std::vector<uint32_t>& best_first,
+                Crosses crosses, AuctionDepth& depth) {
+    for (uint32_t l : best_first) {
+        if (!crosses(levels[l].price)) {
+            break;
+        }
+        depth.prices.push_back(levels[l].price);
+        depth.quantities.push_back(levels[l].quantity);
+    }
+    const size_t n = depth.prices.size();
+    depth.cum_quantity.resize(n);
+    depth.cum_notional.resize(n);
+    kernels::cumulativeDepth(depth.prices.data(), depth.quantities.data(), n,
+                             depth.cum_quantity.data(), depth.cum_notional.data());
+}
+
+/**
+ * Hands out the orders of one side that execute, in priority order, with
+ * the quantity each executes: whole levels at or better than the clearing
+ * price until `volume` runs out, then the marginal level shared by time or
+ * pro rata
+ */
+template <typename Level>
+class FillCursor {
+public:
+    using Order = typename decltype(Level::orders)::value_type;
+    
+    FillCursor(std::vector<Level>& levels, const std::vector<uint32_t>& best_first, bool descending,
+               double price, double volume, BatchAllocation allocation)
+        : levels_(levels), best_first_(best_first), descending_(descending), price_(price),
+          remaining_(volume), allocation_(allocation) {}
+    
+    // The next order and its fill, or nullptr once the side is done
+    Order* next(double& fill) {
+        while (true) {
+            if (level_ == nullptr || index_ == level_->orders.size()) {
+                if (marginal_ || !enterLevel()) {
+                    return nullptr;
+                }
+            }
+            Order& order = level_->orders[index_++];
+            fill = order.quantity;
+            if (marginal_) {
+                if (allocation_ == BatchAllocation::TIME) {
+                    fill = std::min(fill, remaining_);
+                    remaining_ -= fill;
+                } else if (index_ < level_->orders.size()) {
+                    fill *= share_;
+                    allocated_ += fill;
+                } else {
+                    // The last order takes what rounding left over
+                    fill = std::clamp(remaining_ - allocated_, 0.0, fill);
+                }
+            }
+            if (fill > 0) {
+                return &order;
+            }
+        }
+    }
+    
+private:
+    bool enterLevel() {
+        if (rank_ == best_first_.size() || remaining_ <= 0) {
+            return false;
+        }
+        level_ = &levels_[best_first_[rank_++]];
+        index_ = 0;
+        if (descending_ ? level_->price < price_ : level_->price > price_) {
+            return false;
+        }
+        level_->traded = true;
+        if (level_->quantity > remaining_) {
+            marginal_ = true;
+            share_ = remaining_ / level_->quantity;
+        } else {
+            remaining_ -= level_->quantity;
+        }
+        return true;
+    }
+    
+    std::vector<Level>& levels_;
+    const std::vector<uint32_t>& best_first_;
+    bool descending_;
+    double price_;
+    double remaining_;
+    BatchAllocation allocation_;
+    size_t rank_ = 0;
+    Level* level_ = nullptr;
+    size_t index_ = 0;
+    bool marginal_ = false;
+    double share_ = 0.0;
+    double allocated_ = 0.0;
+};
+
+// Takes what an order executed off it; rounding can leave dust on an
+// order, and it counts as filled (quantity 0)
+template <typename Order>
+void takeFill(Order& order, double executed) {
+    const double original = order.quantity;
+    order.quantity -= executed;
+    if (order.quantity <= original * 1e-9) {
+        order.quantity = 0.0;
+    }
 }
 
-std::vector<std::pair<double, double>> OrderBook::getBids() const {
+} // namespace
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::BatchLevel* BasicOrderBook<Policy>::findBatchLevel(PendingSide& side,
+                                                                                    double price) {
+    if (side.table.empty()) {
+        return nullptr;
+    }
+    uint64_t bits;
+    const size_t mask = side.table.size() - 1;
+    for (size_t i = priceSlot(price, side.shift, bits); side.table[i].bits != 0; i = (i + 1) & mask) {
+        if (side.table[i].bits == bits) {
+            return &side.levels[side.table[i].level];
+        }
+    }
+    return nullptr;
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::BatchLevel& BasicOrderBook<Policy>::batchLevel(PendingSide& side,
+                                                                               double price) {
+    if (BatchLevel* level = findBatchLevel(side, price)) {
+        return *level;
+    }
+    // Kept at most half full; growing rehashes the levels already in use
+    if (2 * (side.used + 1) > side.table.size()) {
+        side.shift = side.table.empty() ? 58 : side.shift - 1;
+        side.table.assign(size_t{1} << (64 - side.shift), BatchSlot{0, 0});
+        for (size_t l = 0; l < side.used; ++l) {
+            uint64_t bits;
+            const size_t mask = side.table.size() - 1;
+            size_t i = priceSlot(side.levels[l].price, side.shift, bits);
+            while (side.table[i].bits != 0) {
+                i = (i + 1) & mask;
+            }
+            side.table[i] = BatchSlot{bits, static_cast<uint32_t>(l)};
+        }
+    }
+    uint64_t bits;
+    const size_t mask = side.table.size() - 1;
+    size_t i = priceSlot(price, side.shift, bits);
+    while (side.table[i].bits != 0) {
+        i = (i + 1) & mask;
+    }
+    side.table[i] = BatchSlot{bits, static_cast<uint32_t>(side.used)};
+    if (side.used == side.levels.size()) {
+        side.levels.emplace_back();
+    }
+    BatchLevel& level = side.levels[side.used++];
+    level.price = price;
+    return level;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::resetPending(PendingSide& side) {
+    for (size_t l = 0; l < side.used; ++l) {
+        side.levels[l].quantity = 0.0;
+        side.levels[l].traded = false;
+        side.levels[l].orders.clear();
+    }
+    std::fill(side.table.begin(), side.table.end(), BatchSlot{0, 0});
+    side.used = 0;
+    side.orders = 0;
+    side.first_seq = 0;
+}
+
+template <typename Policy>
+template <typename LevelMap>
+void BasicOrderBook<Policy>::pullLevels(LevelMap& levels, typename LevelMap::iterator last, PendingSide& side) {
+    // Resting orders go ahead of the batch at their price: time priority
+    for (auto level = levels.begin(); level != last; ++level) {
+        BatchLevel& batch = batchLevel(side, level->first);
+        for (const Order& order : level->second) {
+            batch.quantity += order.quantity;
+        }
+        batch.orders.insert(batch.orders.begin(), std::make_move_iterator(level->second.begin()),
+                            std::make_move_iterator(level->second.end()));
+    }
+    eraseLevels(levels, levels.begin(), last);
+}
+
+template <typename Policy>
+template <typename LevelMap>
+void BasicOrderBook<Policy>::settleBatch(LevelMap& levels, PendingSide& pending) {
+    // Levels the clear reached lose their filled orders, whose index
+    // entries are fetched a few orders ahead as a level's seqs are spread
+    // over the index; filled icebergs with hidden quantity left wait in
+    // replenished_. Each level then rests whole, behind any book orders at
+    // its price.
+    constexpr size_t kAhead = 8;
+    for (size_t l = 0; l < pending.used; ++l) {
+        BatchLevel& level = pending.levels[l];
+        auto& orders = level.orders;
+        if (level.traded) {
+            size_t kept = 0;
+            for (size_t i = 0; i < orders.size(); ++i) {
+                if (i + kAhead < orders.size() && orders[i + kAhead].quantity <= 0) {
+                    order_index_.prefetch(orders[i + kAhead].seq);
+                }
+                Order& order = orders[i];
+                if (order.quantity > 0) {
+                    if (kept != i) {
+                        orders[kept] = std::move(order);
+                    }
+                    kept++;
+                } else if (!(order.iceberg && replenish(order))) {
+                    order_index_.erase(order.seq);
+                }
+            }
+            orders.erase(orders.begin() + kept, orders.end());
+        }
+        if (orders.empty()) {
+            continue;
+        }
+        OrderQueue& queue = levelFor(levels, level.price);
+        if (queue.empty()) {
+            queue.swap(orders);
+        } else {
+            queue.insert(queue.end(), std::make_move_iterator(orders.begin()), std::make_move_iterator(orders.end()));
+        }
+    }
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::dropCancelled() {
+    if (pending_cancelled_ == 0) {
+        return;
+    }
+    auto cancelled = [](const Order& order) { return order.quantity <= 0; };
+    for (PendingSide* side : {&pending_bids_, &pending_asks_}) {
+        for (size_t l = 0; l < side->used; ++l) {
+            auto& orders = side->levels[l].orders;
+            orders.erase(std::remove_if(orders.begin(), orders.end(), cancelled), orders.end());
+        }
+    }
+    pending_cancelled_ = 0;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::releasePending() {
+    dropCancelled();
+    settleBatch(bids_, pending_bids_);
+    settleBatch(asks_, pending_asks_);
+    resetPending(pending_bids_);
+    resetPending(pending_asks_);
+    pending_cancelled_ = 0;
+    high_water_levels_ = std::max(high_water_levels_, bids_.size() + asks_.size());
+    updateGauges();
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::setMode(TradingMode mode) {
+    if (mode_ == TradingMode::BATCH && mode != TradingMode::BATCH) {
+        releasePending();
+    }
+    mode_ = mode;
+}
+
+template <typename Policy>
+AuctionResult BasicOrderBook<Policy>::clearBatch(std::vector<Trade>& trades, BatchAllocation allocation,
+                                    double reference_price) {
+    const AuctionResult result = clearBatch(batch_fills_, allocation, reference_price);
+    // Trades already in the vector are overwritten in place rather than
+    // destroyed and rebuilt: a reused vector only writes the new values
+    trades.resize(batch_fills_.size());
+    const long long timestamp = nowMillis();
+    for (size_t i = 0; i < batch_fills_.size(); ++i) {
+        const BatchFill& fill = batch_fills_[i];
+        Trade& trade = trades[i];
+        assignOrderId(trade.buy_order_id, fill.buy_seq);
+        assignOrderId(trade.sell_order_id, fill.sell_seq);
+        trade.price = fill.price;
+        trade.quantity = fill.quantity;
+        trade.timestamp = timestamp;
+    }
+    // As after uncross, the stops the clearing price reaches fire once
+    // trading is continuous
+    if (!trades.empty() && mode_ == TradingMode::CONTINUOUS && stop_orders_ > 0) {
+        const size_t batch_trades = trades.size();
+        fireStops(trades, result.price, result.price);
+        if (trades.size() > batch_trades) {
+            last_price_ = trades.back().price;
+            EngineMetrics::increment(Counter::FILLS, trades.size() - batch_trades);
+            updateGauges();
+        }
+    }
+    return result;
+}
+
+template <typename Policy>
+AuctionResult BasicOrderBook<Policy>::clearBatch(std::vector<BatchFill>& fills, BatchAllocation allocation,
+                                    double reference_price) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::MATCH)]);
+    TRADING_TRACE(trace::EventType::MATCH_BEGIN);
+    
+    fills.clear();
+    refills_.clear();
+    dropCancelled();
+    auto& bids = pending_bids_;
+    auto& asks = pending_asks_;
+    
+    // Best prices across book and batch bound the resting levels that can trade
+    double best_bid = bids_.empty() ? 0.0 : bids_.begin()->first;
+    double best_ask = asks_.empty() ? std::numeric_limits<double>::infinity() : asks_.begin()->first;
+    for (size_t l = 0; l < bids.used; ++l) {
+        if (!bids.levels[l].orders.empty()) best_bid = std::max(best_bid, bids.levels[l].price);
+    }
+    for (size_t l = 0; l < asks.used; ++l) {
+        if (!asks.levels[l].orders.empty()) best_ask = std::min(best_ask, asks.levels[l].price);
+    }
+    const bool crosses = best_bid >= best_ask;
+    
+    AuctionResult result;
+    if (crosses) {
+        pullLevels(bids_, bids_.upper_bound(best_ask), bids);
+        pullLevels(asks_, asks_.upper_bound(best_bid), asks);
+        
+        // Only the levels are ranked; their orders stay where they are
+        auto rank = [](PendingSide& side, bool descending) {
+            side.best_first.clear();
+            for (size_t l = 0; l < side.used; ++l) {
+                if (!side.levels[l].orders.empty()) {
+                    side.best_first.push_back(static_cast<uint32_t>(l));
+                }
+            }
+            const auto& levels = side.levels;
+            std::sort(side.best_first.begin(), side.best_first.end(), [&levels, descending](uint32_t a, uint32_t b) {
+                return descending ? levels[a].price > levels[b].price : levels[a].price < levels[b].price;
+            });
+        };
+        rank(bids, true);
+        rank(asks, false);
+        
+        AuctionDepth bid_depth, ask_depth;
+        batchDepth(bids.levels, bids.best_first, [best_ask](double price) { return price >= best_ask; }, bid_depth);
+        batchDepth(asks.levels, asks.best_first, [best_bid](double price) { return price <= best_bid; }, ask_depth);
+        result = equilibrium(bid_depth, ask_depth, reference_price);
+        
+        // Pair the fills off in priority order, taking each order's fill off
+        // it once it has been paired in full
+        const double price = result.price;
+        FillCursor<BatchLevel> bid_cursor(bids.levels, bids.best_first, true, price, result.volume, allocation);
+        FillCursor<BatchLevel> ask_cursor(asks.levels, asks.best_first, false, price, result.volume, allocation);
+        double bid_fill = 0.0, ask_fill = 0.0;
+        Order* bid = bid_cursor.next(bid_fill);
+        Order* ask = ask_cursor.next(ask_fill);
+        double bid_left = bid_fill, ask_left = ask_fill;
+        while (bid != nullptr && ask != nullptr) {
+            const double quantity = std::min(bid_left, ask_left);
+            fills.push_back(BatchFill{bid->seq, ask->seq, price, quantity});
+            TRADING_TRACE(trace::EventType::TRADE, bid->seq, ask->seq, price, quantity);
+            bid_left -= quantity;
+            ask_left -= quantity;
+            if (bid_left <= 0) {
+                takeFill(*bid, bid_fill);
+                bid = bid_cursor.next(bid_fill);
+                bid_left = bid_fill;
+            }
+            if (ask_left <= 0) {
+                takeFill(*ask, ask_fill);
+                ask = ask_cursor.next(ask_fill);
+                ask_left = ask_fill;
+            }
+        }
+        // What pro-rata rounding allocated to one side beyond the other
+        // does not execute
+        if (bid != nullptr) {
+            takeFill(*bid, bid_fill - bid_left);
+        }
+        if (ask != nullptr) {
+            takeFill(*ask, ask_fill - ask_left);
+        }
+    }
+    
+    // Filled orders leave; whatever is left rests in the book, and icebergs
+    // show their next tranche behind everything else at their price
+    settleBatch(bids_, bids);
+    settleBatch(asks_, asks);
+    requeueReplenished();
+    resetPending(bids);
+    resetPending(asks);
+    if (!fills.empty()) {
+        last_price_ = result.price;
+    }
+    
+    EngineMetrics::increment(Counter::FILLS, fills.size());
+    high_water_levels_ = std::max(high_water_levels_, bids_.size() + asks_.size());
+    updateGauges();
+    TRADING_TRACE(trace::EventType::MATCH_END, 0, fills.size());
+    return result;
+}
+
+template <typename Policy>
+template <typename LevelMap>
+bool BasicOrderBook<Policy>::removeFromLevel(LevelMap& levels, double price, uint64_t seq, double& quantity) {
+    auto level = levels.find(price);
+    if (level == levels.end()) {
+        return false;
+    }
+    
+    auto& orders = level->second;
+    auto it = std::find_if(orders.begin(), orders.end(),
+                           [seq](const Order& o) { return o.seq == seq; });
+    if (it == orders.end()) {
+        return false;
+    }
+    
+    quantity = it->quantity;
+    orders.erase(it);
+    if (orders.empty()) {
+        eraseLevel(levels, level);
+    }
+    return true;
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::cancelOrder(const std::string& order_id) {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::CANCEL)]);
+    
+    // IDs are "ORD<seq>" exactly as orderIdFor writes them: no sign,
+    // whitespace or leading zeros. Anything else cannot be one of ours
+    if (order_id.size() <= 3 || order_id.compare(0, 3, "ORD") != 0
+            || order_id[3] < '1' || order_id[3] > '9') {
+        return false;
+    }
+    uint64_t seq = 0;
+    const char* last = order_id.data() + order_id.size();
+    auto [end, error] = std::from_chars(order_id.data() + 3, last, seq);
+    if (error != std::errc() || end != last) {
+        return false;
+    }
+    
+    auto loc = order_index_.find(seq);
+    if (loc == order_index_.end()) {
+        return false;  // Unknown, already filled or already cancelled
+    }
+    
+    double quantity = 0.0;
+    bool removed = removeOrder(loc, quantity);
+    if (removed) {
+        EngineMetrics::increment(Counter::CANCELS);
+        updateGauges();
+    }
+    TRADING_TRACE(trace::EventType::ORDER_CANCEL, seq, removed ? 1 : 0);
+    return removed;
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::removeOrder(typename OrderIndex::iterator loc, double& quantity) {
+    const uint64_t seq = loc->first;
+    const OrderLocation where = loc->second;
+    order_index_.erase(loc);
+    
+    // Untriggered stop: removed from the trigger index instead of the book
+    if (where.stop) {
+        bool removed = where.side == OrderSide::BUY
+            ? removeFromLevel(buy_stops_, where.price, seq, quantity)
+            : removeFromLevel(sell_stops_, where.price, seq, quantity);
+        stop_orders_ -= removed ? 1 : 0;
+        return removed;
+    }
+    
+    // Still waiting for a batch: a level's waiting orders are in seq order,
+    // so they are found by binary search
+    bool removed = true;
+    if (waiting(where.side, seq)) {
+        BatchLevel* level = findBatchLevel(where.side == OrderSide::BUY ? pending_bids_ : pending_asks_,
+                                           where.price);
+        auto it = std::lower_bound(level->orders.begin(), level->orders.end(), seq,
+                                   [](const Order& order, uint64_t s) { return order.seq < s; });
+        quantity = it->quantity;
+        level->quantity -= it->quantity;
+        it->quantity = 0.0;
+        pending_cancelled_++;
+    } else {
+        removed = where.side == OrderSide::BUY
+            ? removeFromLevel(bids_, where.price, seq, quantity)
+            : removeFromLevel(asks_, where.price, seq, quantity);
+    }
+    
+    // An iceberg takes its hidden quantity with it
+    if (removed && !reserves_.empty()) {
+        auto reserve = reserves_.find(seq);
+        if (reserve != reserves_.end()) {
+            quantity += reserve->second.hidden;
+            reserves_.erase(reserve);
+        }
+    }
+    return removed;
+}
+
+template <typename Policy>
+std::vector<std::pair<double, double>> BasicOrderBook<Policy>::getBids() const {
     std::vector<std::pair<double, double>> result;
+    getBids(result);
+    return result;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::getBids(std::vector<std::pair<double, double>>& levels) const {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::SNAPSHOT)]);
     
+    levels.clear();
     for (const auto& [price, orders] : bids_) {
         double total_quantity = 0.0;
         for (const auto& order : orders) {
             total_quantity += order.quantity;
         }
-        result.emplace_back(price, total_quantity);
+        levels.emplace_back(price, total_quantity);
     }
-    
-    return result;
 }
 
-std::vector<std::pair<double, double>> OrderBook::getAsks() const {
+template <typename Policy>
+std::vector<std::pair<double, double>> BasicOrderBook<Policy>::getAsks() const {
     std::vector<std::pair<double, double>> result;
+    getAsks(result);
+    return result;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::getAsks(std::vector<std::pair<double, double>>& levels) const {
+    TRADING_LATENCY_SCOPE(latency_[static_cast<size_t>(LatencyOp::SNAPSHOT)]);
     
+    levels.clear();
     for (const auto& [price, orders] : asks_) {
         double total_quantity = 0.0;
         for (const auto& order : orders) {
             total_quantity += order.quantity;
         }
-        result.emplace_back(price, total_quantity);
+        levels.emplace_back(price, total_quantity);
     }
-    
-    return result;
 }
 
-double OrderBook::getBestBid() const {
+template <typename Policy>
+double BasicOrderBook<Policy>::getBestBid() const {
     if (bids_.empty()) return 0.0;
     return bids_.begin()->first;
 }
 
-double OrderBook::getBestAsk() const {
+template <typename Policy>
+double BasicOrderBook<Policy>::getBestAsk() const {
     if (asks_.empty()) return 0.0;
     return asks_.begin()->first;
 }
 
-void OrderBook::reset() {
+template <typename Policy>
+const typename BasicOrderBook<Policy>::OrderQueue* BasicOrderBook<Policy>::ordersAt(OrderSide side, double price) const {
+    if (side == OrderSide::BUY) {
+        auto level = bids_.find(price);
+        return level == bids_.end() ? nullptr : &level->second;
+    }
+    auto level = asks_.find(price);
+    return level == asks_.end() ? nullptr : &level->second;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::reset() {
     bids_.clear();
     asks_.clear();
+    spare_levels_.clear();
+    resetPending(pending_bids_);
+    resetPending(pending_asks_);
+    pending_cancelled_ = 0;
+    buy_stops_.clear();
+    sell_stops_.clear();
+    stop_orders_ = 0;
+    last_price_ = 0.0;
+    triggered_.clear();
+    taker_.clear();
+    order_index_.clear();
+    reserves_.clear();
+    replenished_.clear();
+    refills_.clear();
+    time_expiries_.reset();
+    tick_expiries_.reset();
+    ticks_ = 0;
+    level_expiries_.clear();
+    expired_.clear();
     next_order_id_ = 1;
+    mode_ = TradingMode::CONTINUOUS;
+    high_water_orders_ = 0;
+    high_water_levels_ = 0;
+    updateGauges();
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::updateGauges() {
+    level_gauge_.set(static_cast<int64_t>(bids_.size() + asks_.size()));
+    order_gauge_.set(static_cast<int64_t>(order_index_.size()));
+}
+
+namespace {
+
+// Red-black tree node: colour + parent/left/right pointers, then the value
+template <typename Value>
+constexpr size_t mapNodeBytes() {
+    return 4 * sizeof(void*) + sizeof(Value);
 }
 
+// Heap bytes owned by a std::string beyond the object itself
+size_t stringHeapBytes(const std::string& s) {
+    const char* data = s.data();
+    const char* self = reinterpret_cast<const char*>(&s);
+    bool inline_storage = data >= self && data < self + sizeof(std::string);
+    return inline_storage ? 0 : s.capacity() + 1;
+}
+
+template <typename LevelMap>
+void accumulateLevels(const LevelMap& levels, MemoryStats& stats) {
+    stats.level_bytes += levels.size() * mapNodeBytes<typename LevelMap::value_type>();
+    stats.price_levels += levels.size();
+    for (const auto& [price, orders] : levels) {
+        (void)price;
+        stats.order_bytes += orders.size() * sizeof(Order);
+        stats.pool_bytes += (orders.capacity() - orders.size()) * sizeof(Order);
+        stats.pool_capacity += orders.capacity();
+        stats.resting_orders += orders.size();
+        for (const auto& order : orders) {
+            stats.id_string_bytes += stringHeapBytes(order.id);
+        }
+    }
+}
+
+} // namespace
+
+template <typename Policy>
+MemoryStats BasicOrderBook<Policy>::memoryStats() const {
+    MemoryStats stats;
+    accumulateLevels(bids_, stats);
+    accumulateLevels(asks_, stats);
+    for (const auto& spare : spare_levels_) {
+        stats.pool_bytes += spare.capacity() * sizeof(Order);
+        stats.pool_capacity += spare.capacity();
+    }
+    // Untriggered stops count towards the bytes but not the book's orders/levels
+    MemoryStats stops;
+    accumulateLevels(buy_stops_, stops);
+    accumulateLevels(sell_stops_, stops);
+    stats.level_bytes += stops.level_bytes;
+    stats.order_bytes += stops.order_bytes;
+    stats.id_string_bytes += stops.id_string_bytes;
+    stats.pool_bytes += stops.pool_bytes
+        + (triggered_.capacity() + taker_.capacity()) * sizeof(Order);
+    stats.pool_capacity += stops.pool_capacity;
+    stats.stop_orders = stops.resting_orders;
+    // Batch buffers (waiting orders included) are kept between batches
+    stats.pool_bytes += batch_fills_.capacity() * sizeof(BatchFill);
+    for (const PendingSide* side : {&pending_bids_, &pending_asks_}) {
+        stats.pool_bytes += side->levels.capacity() * sizeof(BatchLevel)
+            + side->table.capacity() * sizeof(BatchSlot) + side->best_first.capacity() * sizeof(uint32_t);
+        for (const auto& level : side->levels) {
+            stats.pool_bytes += level.orders.capacity() * sizeof(Order);
+        }
+    }
+    
+    // The order index is one flat table; reserves are hash nodes (next
+    // pointer + value) plus one pointer per bucket
+    stats.index_bytes = order_index_.memoryBytes();
+    using ReserveValue = typename decltype(reserves_)::value_type;
+    stats.index_bytes += reserves_.size() * (sizeof(void*) + sizeof(ReserveValue))
+        + reserves_.bucket_count() * sizeof(void*);
+    stats.pool_bytes += replenished_.capacity() * sizeof(Order)
+        + refills_.capacity() * sizeof(IcebergRefill);
+    // Expiry wheels; their inline part is in fixed_bytes
+    stats.index_bytes += time_expiries_.memoryBytes() + tick_expiries_.memoryBytes()
+        - 2 * sizeof(TimingWheel);
+    stats.pool_bytes += expiring_.capacity() * sizeof(uint64_t)
+        + level_expiries_.capacity() * sizeof(LevelExpiry)
+        + expired_.capacity() * sizeof(ExpiredOrder);
+    
+    stats.fixed_bytes = sizeof(*this);
+    stats.total_bytes = stats.level_bytes + stats.order_bytes + stats.id_string_bytes
+        + stats.index_bytes + stats.pool_bytes + stats.fixed_bytes;
+    if (stats.resting_orders > 0) {
+        stats.bytes_per_order = static_cast<double>(stats.total_bytes)
+            / static_cast<double>(stats.resting_orders);
+    }
+    stats.high_water_orders = high_water_orders_;
+    stats.high_water_levels = high_water_levels_;
+    return stats;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::resetLatencyStats() {
+    for (auto& histogram : latency_) {
+        histogram.reset();
+    }
+}
+
+// ==================== Instantiations ====================
+
+// Every policy with every trade-price rule (declared extern in engine.hpp)
+template class BasicOrderBook<FifoMatching<TradePrice::ASK>>;
+template class BasicOrderBook<FifoMatching<TradePrice::PASSIVE>>;
+template class BasicOrderBook<FifoMatching<TradePrice::MIDPOINT>>;
+template class BasicOrderBook<ProRataMatching<TradePrice::ASK>>;
+template class BasicOrderBook<ProRataMatching<TradePrice::PASSIVE>>;
+template class BasicOrderBook<ProRataMatching<TradePrice::MIDPOINT>>;
+template class BasicOrderBook<TopOrderProRataMatching<TradePrice::ASK>>;
+template class BasicOrderBook<TopOrderProRataMatching<TradePrice::PASSIVE>>;
+template class BasicOrderBook<TopOrderProRataMatching<TradePrice::MIDPOINT>>;
+
 } // namespace trading
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace trading {
+namespace kernels {
+
+/**
+ * @brief One instruction-set variant of every batch kernel
+ *
+ * Filled in by kernels_impl.hpp in each per-ISA translation unit; the
+ * dispatcher in kernels.cpp points at one of them.
+ */
+struct KernelTable {
+    void (*sma_batch)(const double* prices, size_t n, size_t window, double* out);
+    void (*indicator_bank)(const double* prices, size_t n, const size_t* windows, size_t k,
+                           double* out);
+    void (*cumulative_depth)(const double* prices, const double* quantities, size_t n,
+                             double* cum_quantity, double* cum_notional);
+    void (*gaussian_normals)(uint64_t seed, uint64_t offset, size_t n, double* out);
+};
+
+namespace scalar { const KernelTable& table(); }
+#ifdef TRADING_KERNELS_X86
+namespace avx2 { const KernelTable& table(); }
+namespace avx512 { const KernelTable& table(); }
+#endif
+
+} // namespace kernels
+} // namespace trading
@@ -0,0 +1,145 @@
+#include "kernels.hpp"
+#include "kernel_table.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace trading {
+namespace kernels {
+
+namespace {
+
+bool cpuSupports(SimdPath path) {
+    switch (path) {
+        case SimdPath::SCALAR:
+            return true;
+#ifdef TRADING_KERNELS_X86
+        case SimdPath::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case SimdPath::AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+                && __builtin_cpu_supports("avx512vl");
+#endif
+        default:
+            return false;
+    }
+}
+
+const KernelTable& tableFor(SimdPath path) {
+    switch (path) {
+#ifdef TRADING_KERNELS_X86
+        case SimdPath::AVX2: return avx2::table();
+        case SimdPath::AVX512: return avx512::table();
+#endif
+        default: return scalar::table();
+    }
+}
+
+/**
+ * @brief Best supported path, capped by TRADE_ENGINE_SIMD if set
+ */
+SimdPath initialPath() {
+    SimdPath best = SimdPath::SCALAR;
+    for (SimdPath path : {SimdPath::AVX2, SimdPath::AVX512}) {
+        if (cpuSupports(path)) {
+            best = path;
+        }
+    }
+
+    const char* cap = std::getenv("TRADE_ENGINE_SIMD");
+    if (cap) {
+        for (SimdPath path : {SimdPath::SCALAR, SimdPath::AVX2, SimdPath::AVX512}) {
+            if (std::strcmp(cap, simdPathName(path)) == 0 && path < best) {
+                best = path;
+            }
+        }
+    }
+    return best;
+}
+
+std::atomic<SimdPath>& activeSlot() {
+    static std::atomic<SimdPath> slot{initialPath()};
+    return slot;
+}
+
+const KernelTable& active() {
+    return tableFor(activeSlot().load(std::memory_order_relaxed));
+}
+
+void checkWindow(size_t window) {
+    if (window == 0) {
+        throw std::invalid_argument("Window size must be greater than 0");
+    }
+}
+
+} // namespace
+
+const char* simdPathName(SimdPath path) {
+    switch (path) {
+        case SimdPath::SCALAR: return "scalar";
+        case SimdPath::AVX2: return "avx2";
+        case SimdPath::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+SimdPath activeSimdPath() {
+    return activeSlot().load(std::memory_order_relaxed);
+}
+
+bool simdPathSupported(SimdPath path) {
+    return cpuSupports(path);
+}
+
+void setSimdPath(SimdPath path) {
+    if (!simdPathSupported(path)) {
+        throw std::invalid_argument(std::string("SIMD path not supported here: ") + simdPathName(path));
+    }
+    activeSlot().store(path, std::memory_order_relaxed);
+}
+
+void smaBatch(const double* prices, size_t n, size_t window, double* out) {
+    checkWindow(window);
+    active().sma_batch(prices, n, window, out);
+}
+
+void indicatorBank(const double* prices, size_t n, const size_t* windows, size_t k, double* out) {
+    for (size_t j = 0; j < k; ++j) {
+        checkWindow(windows[j]);
+    }
+    active().indicator_bank(prices, n, windows, k, out);
+}
+
+void cumulativeDepth(const double* prices, const double* quantities, size_t n,
+                     double* cum_quantity, double* cum_notional) {
+    active().cumulative_depth(prices, quantities, n, cum_quantity, cum_notional);
+}
+
+void gaussianNormals(uint64_t seed, uint64_t offset, size_t n, double* out) {
+    active().gaussian_normals(seed, offset, n, out);
+}
+
+std::vector<double> gbmPath(double s0, double drift, double volatility, double dt,
+                            uint64_t seed, size_t n) {
+    std::vector<double> path(n);
+    gaussianNormals(seed, 0, n, path.data());
+
+    // Exact log-normal step: S *= exp((mu - sigma^2 / 2) dt + sigma sqrt(dt) Z)
+    const double mean = (drift - 0.5 * volatility * volatility) * dt;
+    const double scale = volatility * std::sqrt(dt);
+    double price = s0;
+    for (size_t i = 0; i < n; ++i) {
+        price *= std::exp(mean + scale * path[i]);
+        path[i] = price;
+    }
+    return path;
+}
+
+} // namespace kernels
+} // namespace trading
@@ -0,0 +1,3 @@
+// AVX2 + FMA kernel variant (built with -mavx2 -mfma; only called when the CPU has both)
+#define TRADING_KERNEL_ISA avx2
+#include "kernels_impl.hpp"
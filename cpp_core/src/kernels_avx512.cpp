@@ -0,0 +1,3 @@
+// AVX-512 kernel variant (built with -mavx512f -mavx512dq -mavx512vl; only called when the CPU has all three)
+#define TRADING_KERNEL_ISA avx512
+#include "kernels_impl.hpp"
@@ -0,0 +1,262 @@
+// Batch kernel bodies, compiled once per instruction set.
+//
+// Each kernels_<isa>.cpp defines TRADING_KERNEL_ISA and includes this file
+// under its own target flags. Everything here has internal linkage and
+// avoids std:: templates, so no AVX code can leak into another variant
+// through a shared inline definition picked by the linker.
+
+#include "kernel_table.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#ifndef TRADING_KERNEL_ISA
+#error "define TRADING_KERNEL_ISA before including kernels_impl.hpp"
+#endif
+
+// Iterations only read elements a later iteration writes (never the
+// reverse), so vector blocks that load before they store are safe
+#if defined(__clang__)
+#define TRADING_KERNEL_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define TRADING_KERNEL_IVDEP _Pragma("GCC ivdep")
+#else
+#define TRADING_KERNEL_IVDEP
+#endif
+
+namespace trading {
+namespace kernels {
+namespace TRADING_KERNEL_ISA {
+
+namespace {
+
+// ==================== Prefix sums ====================
+
+#if defined(__AVX512F__)
+// In-register inclusive scan of 8 doubles (log-step shifts)
+inline __m512d scanVector(__m512d v) {
+    const __m512i shift1 = _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 0);
+    const __m512i shift2 = _mm512_set_epi64(5, 4, 3, 2, 1, 0, 0, 0);
+    const __m512i shift4 = _mm512_set_epi64(3, 2, 1, 0, 0, 0, 0, 0);
+    v = _mm512_add_pd(v, _mm512_maskz_permutexvar_pd(0xFE, shift1, v));
+    v = _mm512_add_pd(v, _mm512_maskz_permutexvar_pd(0xFC, shift2, v));
+    v = _mm512_add_pd(v, _mm512_maskz_permutexvar_pd(0xF0, shift4, v));
+    return v;
+}
+#elif defined(__AVX2__)
+// In-register inclusive scan of 4 doubles
+inline __m256d scanVector(__m256d v) {
+    __m256d t = _mm256_permute4x64_pd(v, _MM_SHUFFLE(2, 1, 0, 0));      // v0 v0 v1 v2
+    v = _mm256_add_pd(v, _mm256_blend_pd(t, _mm256_setzero_pd(), 0x1));  // +  0 v0 v1 v2
+    t = _mm256_permute2f128_pd(v, v, 0x08);                              // +  0  0 s0 s1
+    return _mm256_add_pd(v, t);
+}
+#endif
+
+/**
+ * out[i] = sum over j <= i of (x[j] - bias), or of x[j] * y[j] when kProduct
+ */
+template <bool kProduct>
+void prefixSum(const double* x, const double* y, double bias, size_t n, double* out) {
+    size_t i = 0;
+    double carry = 0.0;
+
+#if defined(__AVX512F__)
+    const __m512d b = _mm512_set1_pd(bias);
+    const __m512i last = _mm512_set1_epi64(7);
+    __m512d c = _mm512_setzero_pd();
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(x + i);
+        if constexpr (kProduct) {
+            v = _mm512_mul_pd(v, _mm512_loadu_pd(y + i));
+        } else {
+            v = _mm512_sub_pd(v, b);
+        }
+        v = _mm512_add_pd(scanVector(v), c);
+        _mm512_storeu_pd(out + i, v);
+        c = _mm512_maskz_permutexvar_pd(0xFF, last, v);
+    }
+#elif defined(__AVX2__)
+    const __m256d b = _mm256_set1_pd(bias);
+    __m256d c = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        if constexpr (kProduct) {
+            v = _mm256_mul_pd(v, _mm256_loadu_pd(y + i));
+        } else {
+            v = _mm256_sub_pd(v, b);
+        }
+        v = _mm256_add_pd(scanVector(v), c);
+        _mm256_storeu_pd(out + i, v);
+        c = _mm256_permute4x64_pd(v, 0xFF);
+    }
+#endif
+
+    if (i > 0) {
+        carry = out[i - 1];
+    }
+    for (; i < n; ++i) {
+        if constexpr (kProduct) {
+            carry += x[i] * y[i];
+        } else {
+            carry += x[i] - bias;
+        }
+        out[i] = carry;
+    }
+}
+
+// ==================== Moving averages ====================
+
+/**
+ * SMA from biased prefix sums; out may be the prefix array itself
+ * (walks backwards so prefix[i - window] is read before it is replaced)
+ */
+void smaFromPrefix(const double* prefix, size_t n, size_t window, double bias, double* out) {
+    const double inv_window = 1.0 / static_cast<double>(window);
+    TRADING_KERNEL_IVDEP
+    for (size_t i = n; i-- > window;) {
+        out[i] = (prefix[i] - prefix[i - window]) * inv_window + bias;
+    }
+    const size_t warmup = n < window ? n : window;
+    for (size_t i = 0; i < warmup; ++i) {
+        out[i] = prefix[i] / static_cast<double>(i + 1) + bias;
+    }
+}
+
+void smaBatch(const double* prices, size_t n, size_t window, double* out) {
+    if (n == 0) {
+        return;
+    }
+    // Offsetting by the first price keeps the running sums small
+    const double bias = prices[0];
+    prefixSum<false>(prices, nullptr, bias, n, out);
+    smaFromPrefix(out, n, window, bias, out);
+}
+
+void indicatorBank(const double* prices, size_t n, const size_t* windows, size_t k, double* out) {
+    if (n == 0 || k == 0) {
+        return;
+    }
+    // The last row holds the shared prefix sums until it is converted itself
+    const double bias = prices[0];
+    double* prefix = out + (k - 1) * n;
+    prefixSum<false>(prices, nullptr, bias, n, prefix);
+    for (size_t j = 0; j + 1 < k; ++j) {
+        smaFromPrefix(prefix, n, windows[j], bias, out + j * n);
+    }
+    smaFromPrefix(prefix, n, windows[k - 1], bias, prefix);
+}
+
+// ==================== Book depth ====================
+
+void cumulativeDepth(const double* prices, const double* quantities, size_t n,
+                     double* cum_quantity, double* cum_notional) {
+    prefixSum<false>(quantities, nullptr, 0.0, n, cum_quantity);
+    prefixSum<true>(prices, quantities, 0.0, n, cum_notional);
+}
+
+// ==================== Gaussian draws ====================
+
+inline uint64_t mix64(uint64_t z) {
+    z ^= z >> 30;
+    z *= 0xBF58476D1CE4E5B9ULL;
+    z ^= z >> 27;
+    z *= 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline double bitsToDouble(uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+inline uint64_t doubleToBits(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+// Uniform in [1, 2) from the top 52 bits (no int64 -> double conversion,
+// which AVX2 lacks)
+inline double unitPlusOne(uint64_t h) {
+    return bitsToDouble((h >> 12) | 0x3FF0000000000000ULL);
+}
+
+// Natural log for x in (0, 1]: exponent/mantissa split, then the atanh
+// series on a mantissa centred around 1 (|s| < 0.172, error < 1e-14)
+inline double logUnit(double x) {
+    const uint64_t bits = doubleToBits(x);
+    // Biased exponent as a double via the 2^52 trick
+    double e = bitsToDouble(0x4330000000000000ULL | (bits >> 52)) - 4503599627370496.0 - 1023.0;
+    double m = bitsToDouble((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+    const bool high = m > 1.4142135623730951;
+    m = high ? m * 0.5 : m;
+    e = high ? e + 1.0 : e;
+
+    const double s = (m - 1.0) / (m + 1.0);
+    const double s2 = s * s;
+    double p = 1.0 / 17.0;
+    p = p * s2 + 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2 + 1.0;
+    return e * 0.6931471805599453 + 2.0 * s * p;
+}
+
+// cos(2 * pi * u) for u in [0, 1): fold to [0, pi/2], Taylor to x^18
+inline double cosTwoPi(double u) {
+    const double t = u - 0.5;                 // cos(2pi u) = -cos(2pi t)
+    const double a = std::fabs(t);            // [0, 0.5]
+    const bool far = a > 0.25;
+    const double b = far ? 0.5 - a : a;       // [0, 0.25]
+    const double x = 6.283185307179586 * b;
+    const double x2 = x * x;
+    double c = 1.0 / 6402373705728000.0;      // 1/18!
+    c = c * x2 - 1.0 / 20922789888000.0;
+    c = c * x2 + 1.0 / 87178291200.0;
+    c = c * x2 - 1.0 / 479001600.0;
+    c = c * x2 + 1.0 / 3628800.0;
+    c = c * x2 - 1.0 / 40320.0;
+    c = c * x2 + 1.0 / 720.0;
+    c = c * x2 - 1.0 / 24.0;
+    c = c * x2 + 0.5;
+    c = 1.0 - c * x2;
+    return far ? c : -c;
+}
+
+void gaussianNormals(uint64_t seed, uint64_t offset, size_t n, double* out) {
+    const uint64_t key = mix64(seed ^ 0x5DEECE66DULL);
+    for (size_t i = 0; i < n; ++i) {
+        // Box-Muller on two counter-derived uniforms
+        const uint64_t index = (offset + i) * 2;
+        const double u1 = 2.0 - unitPlusOne(mix64(key + (index + 1) * 0x9E3779B97F4A7C15ULL));
+        const double u2 = unitPlusOne(mix64(key + (index + 2) * 0x9E3779B97F4A7C15ULL)) - 1.0;
+        out[i] = std::sqrt(-2.0 * logUnit(u1)) * cosTwoPi(u2);
+    }
+}
+
+const KernelTable kTable{
+    smaBatch,
+    indicatorBank,
+    cumulativeDepth,
+    gaussianNormals,
+};
+
+} // namespace
+
+const KernelTable& table() {
+    return kTable;
+}
+
+} // namespace TRADING_KERNEL_ISA
+} // namespace kernels
+} // namespace trading
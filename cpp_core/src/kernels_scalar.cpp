@@ -0,0 +1,3 @@
+// Baseline kernel variant (no target flags beyond the project defaults)
+#define TRADING_KERNEL_ISA scalar
+#include "kernels_impl.hpp"
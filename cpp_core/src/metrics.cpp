@@ -0,0 +1,79 @@
+#include "metrics.hpp"
+
+#include <sstream>
+
+namespace trading {
+
+namespace {
+
+struct MetricInfo {
+    const char* name;
+    const char* help;
+};
+
+const MetricInfo kCounterInfo[kCounterCount] = {
+    {"trade_engine_orders_total", "Orders submitted to the order book"},
+    {"trade_engine_orders_rejected_total", "Orders rejected by validation"},
+    {"trade_engine_fills_total", "Trades executed by the matcher"},
+    {"trade_engine_cancels_total", "Orders cancelled"},
+    {"trade_engine_ticks_total", "Market-data ticks processed"},
+    {"trade_engine_sma_updates_total", "Prices added to SMA calculators"},
+};
+
+const MetricInfo kGaugeInfo[kGaugeCount] = {
+    {"trade_engine_price_levels", "Price levels across all order books"},
+    {"trade_engine_resting_orders", "Resting orders across all order books"},
+};
+
+} // namespace
+
+std::array<EngineMetrics::Shard, EngineMetrics::kShardCount>& EngineMetrics::shards() {
+    static std::array<Shard, kShardCount> instance;
+    return instance;
+}
+
+EngineMetrics::Shard& EngineMetrics::assignShard() {
+    // Threads beyond kShardCount share shards; fetch_add keeps that correct
+    static std::atomic<size_t> next{0};
+    return shards()[next.fetch_add(1, std::memory_order_relaxed) % kShardCount];
+}
+
+EngineMetrics::Snapshot EngineMetrics::snapshot() {
+    Snapshot snap;
+    for (const auto& shard : shards()) {
+        for (size_t i = 0; i < kCounterCount; ++i) {
+            snap.counters[i] += static_cast<uint64_t>(shard.values[i].load(std::memory_order_relaxed));
+        }
+        for (size_t i = 0; i < kGaugeCount; ++i) {
+            snap.gauges[i] += shard.values[kCounterCount + i].load(std::memory_order_relaxed);
+        }
+    }
+    return snap;
+}
+
+std::string EngineMetrics::renderPrometheus() {
+    Snapshot snap = snapshot();
+    std::ostringstream out;
+
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        out << "# HELP " << kCounterInfo[i].name << ' ' << kCounterInfo[i].help << '\n'
+            << "# TYPE " << kCounterInfo[i].name << " counter\n"
+            << kCounterInfo[i].name << ' ' << snap.counters[i] << '\n';
+    }
+    for (size_t i = 0; i < kGaugeCount; ++i) {
+        out << "# HELP " << kGaugeInfo[i].name << ' ' << kGaugeInfo[i].help << '\n'
+            << "# TYPE " << kGaugeInfo[i].name << " gauge\n"
+            << kGaugeInfo[i].name << ' ' << snap.gauges[i] << '\n';
+    }
+    return out.str();
+}
+
+void EngineMetrics::resetCounters() {
+    for (auto& shard : shards()) {
+        for (size_t i = 0; i < kCounterCount; ++i) {
+            shard.values[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace trading
@@ -0,0 +1,679 @@
+#include "simulation.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace trading {
+
+namespace {
+
+constexpr size_t kNormalBlock = 1024;
+
+// Flow draws use their own stream, decorrelated from the price shocks
+constexpr uint64_t kFlowSeedMix = 0x9E3779B97F4A7C15ULL;
+constexpr uint64_t kLatencySeedMix = 0xD1B54A32D192ED03ULL;
+
+constexpr double kWholeOrder = std::numeric_limits<double>::infinity();
+
+inline long long toMillis(long long time_us) {
+    return time_us / 1000;
+}
+
+// Book IDs are "ORD<seq>"
+inline uint64_t orderSeq(const std::string& order_id) {
+    return order_id.size() > 3 ? std::strtoull(order_id.c_str() + 3, nullptr, 10) : 0;
+}
+
+} // namespace
+
+Simulation::Simulation(const SimulationConfig& config)
+    : config_(config),
+      sma_(config.sma_window),
+      price_(config.initial_price),
+      flow_rng_(config.seed ^ kFlowSeedMix),
+      latency_rng_(config.seed ^ kLatencySeedMix) {
+    if (config.initial_price <= 0 || config.volatility < 0 || config.price_interval_us < 0
+            || config.order_rate < 0 || config.order_spread < 0 || config.max_quantity <= 0
+            || config.tick_size <= 0 || config.order_lifetime_us < 0) {
+        throw std::invalid_argument("Invalid simulation config");
+    }
+    if (config.price_interval_us > 0) {
+        const double dt = static_cast<double>(config.price_interval_us) * 1e-6;
+        step_mean_ = (config.drift - 0.5 * config.volatility * config.volatility) * dt;
+        step_scale_ = config.volatility * std::sqrt(dt);
+        push(Event(config.price_interval_us, EventType::PRICE_STEP));
+    }
+    if (config.order_rate > 0) {
+        push(Event(nextArrival(), EventType::ORDER_FLOW));
+    }
+}
+
+void Simulation::push(Event event) {
+    event.seq = next_seq_++;
+    queue_.push_back(event);
+    std::push_heap(queue_.begin(), queue_.end(), Later());
+}
+
+void Simulation::checkTime(long long time_us) const {
+    if (time_us < now_) {
+        throw std::invalid_argument("Cannot schedule an event in the simulated past");
+    }
+}
+
+void Simulation::scheduleOrder(long long time_us, OrderSide side, double price, double quantity,
+                               long long lifetime_us) {
+    checkTime(time_us);
+    if (lifetime_us < 0) {
+        throw std::invalid_argument("Lifetime must not be negative");
+    }
+    Event event(time_us, EventType::ORDER);
+    event.side = side;
+    event.price = price;
+    event.quantity = quantity;
+    event.ref = static_cast<uint64_t>(lifetime_us);
+    push(event);
+}
+
+void Simulation::scheduleCancel(long long time_us, const std::string& order_id) {
+    checkTime(time_us);
+    // Spelled exactly as the book writes them, like OrderBook::cancelOrder expects
+    uint64_t seq = 0;
+    const char* last = order_id.data() + order_id.size();
+    const bool canonical = order_id.size() > 3 && order_id.compare(0, 3, "ORD") == 0
+        && order_id[3] >= '1' && order_id[3] <= '9';
+    const auto parsed = canonical ? std::from_chars(order_id.data() + 3, last, seq) : std::from_chars_result{};
+    if (!canonical || parsed.ec != std::errc() || parsed.ptr != last) {
+        throw std::invalid_argument("Not an order ID: " + order_id);
+    }
+    Event event(time_us, EventType::CANCEL);
+    event.ref = seq;
+    push(event);
+}
+
+void Simulation::schedulePrice(long long time_us, double price) {
+    checkTime(time_us);
+    if (price <= 0) {
+        throw std::invalid_argument("Price must be positive");
+    }
+    Event event(time_us, EventType::PRICE);
+    event.price = price;
+    push(event);
+}
+
+void Simulation::scheduleWakeup(long long time_us, uint64_t token) {
+    checkTime(time_us);
+    Event event(time_us, EventType::WAKEUP);
+    event.ref = token;
+    push(event);
+}
+
+// ==================== Participants ====================
+
+size_t Simulation::addParticipant(const LatencyModel& order_entry, const LatencyModel& market_data) {
+    if (order_entry.base_us < 0 || order_entry.spread_us < 0
+            || market_data.base_us < 0 || market_data.spread_us < 0) {
+        throw std::invalid_argument("Latency must not be negative");
+    }
+    Participant participant;
+    participant.order_entry = order_entry;
+    participant.market_data = market_data;
+    participants_.push_back(std::move(participant));
+    return participants_.size() - 1;
+}
+
+Simulation::Participant& Simulation::participant(size_t index) {
+    if (index >= participants_.size()) {
+        throw std::invalid_argument("Unknown participant");
+    }
+    return participants_[index];
+}
+
+const ParticipantStats& Simulation::participantStats(size_t participant) const {
+    if (participant >= participants_.size()) {
+        throw std::invalid_argument("Unknown participant");
+    }
+    return participants_[participant].stats;
+}
+
+void Simulation::setFillHandler(size_t index, FillHandler handler) {
+    participant(index).on_fill = std::move(handler);
+}
+
+void Simulation::setPriceHandler(size_t index, PriceHandler handler) {
+    participant(index).on_price = std::move(handler);
+}
+
+void Simulation::setTradeHandler(size_t index, TradeHandler handler) {
+    participant(index).on_trade = std::move(handler);
+}
+
+void Simulation::setBookHandler(size_t index, BookHandler handler) {
+    participant(index).on_book = std::move(handler);
+}
+
+long long Simulation::latency(const LatencyModel& model) {
+    if (model.distribution == LatencyDistribution::FIXED || model.spread_us <= 0) {
+        return model.base_us;
+    }
+    const double u = static_cast<double>(latency_rng_() >> 11) * 0x1.0p-53;
+    const double extra = model.distribution == LatencyDistribution::UNIFORM
+        ? u * model.spread_us
+        : -std::log1p(-u) * model.spread_us;
+    return model.base_us + static_cast<long long>(extra);
+}
+
+long long Simulation::entryTime(Participant& sender) {
+    // A message never overtakes the one sent before it on the same leg
+    sender.last_entry = std::max(now_ + latency(sender.order_entry), sender.last_entry);
+    return sender.last_entry;
+}
+
+long long Simulation::noticeTime(Participant& receiver) {
+    receiver.last_notice = std::max(now_ + latency(receiver.market_data), receiver.last_notice);
+    return receiver.last_notice;
+}
+
+uint64_t Simulation::submitOrder(size_t index, OrderSide side, double price, double quantity) {
+    Event event(entryTime(participant(index)), EventType::CLIENT_ORDER);
+    event.side = side;
+    event.participant = static_cast<uint32_t>(index);
+    event.price = price;
+    event.quantity = quantity;
+    event.ref = next_client_id_++;
+    push(event);
+    return event.ref;
+}
+
+void Simulation::submitCancel(size_t index, uint64_t client_id) {
+    Event event(entryTime(participant(index)), EventType::CLIENT_CANCEL);
+    event.participant = static_cast<uint32_t>(index);
+    event.ref = client_id;
+    push(event);
+}
+
+double Simulation::queueAhead(uint64_t client_id) const {
+    auto order = client_orders_.find(client_id);
+    return order != client_orders_.end() && order->second.resting ? aheadOf(order->second) : -1.0;
+}
+
+size_t Simulation::runUntil(long long end_us) {
+    size_t applied = 0;
+    while (!queue_.empty() && queue_.front().time <= end_us) {
+        step();
+        applied++;
+    }
+    if (end_us > now_) {
+        now_ = end_us;
+        book_.advanceTime(toMillis(now_));
+        settleExpired();
+        publishBook();
+    }
+    return applied;
+}
+
+bool Simulation::step() {
+    if (queue_.empty()) {
+        return false;
+    }
+    std::pop_heap(queue_.begin(), queue_.end(), Later());
+    const Event event = queue_.back();
+    queue_.pop_back();
+    now_ = event.time;
+    stats_.events++;
+
+    // The book's clock follows simulated time: good-till orders due by now go first
+    book_.advanceTime(toMillis(now_));
+    if (!followed_book_ && !participants_.empty()) {
+        followBook();
+    }
+    apply(event);
+    settleExpired();
+    publishBook();
+    return true;
+}
+
+void Simulation::apply(const Event& event) {
+    switch (event.type) {
+        case EventType::PRICE_STEP:
+            applyPrice(price_ * std::exp(step_mean_ + step_scale_ * nextNormal()));
+            push(Event(now_ + config_.price_interval_us, EventType::PRICE_STEP));
+            break;
+        case EventType::PRICE:
+            applyPrice(event.price);
+            break;
+        case EventType::ORDER_FLOW: {
+            // Mostly passive: the offset from the last price is on the far
+            // side of it for about one order in five
+            const OrderSide side = flow_rng_() & 1 ? OrderSide::SELL : OrderSide::BUY;
+            const double u = static_cast<double>(flow_rng_() >> 11) * 0x1.0p-53;
+            const double offset = (1.25 * u - 0.25) * config_.order_spread;
+            const double raw = price_ * (side == OrderSide::BUY ? 1.0 - offset : 1.0 + offset);
+            const double price = std::max(config_.tick_size,
+                                          std::round(raw / config_.tick_size) * config_.tick_size);
+            const double v = static_cast<double>((flow_rng_() >> 11) + 1) * 0x1.0p-53;
+            applyOrder(side, price, config_.max_quantity * v, config_.order_lifetime_us);
+            push(Event(nextArrival(), EventType::ORDER_FLOW));
+            break;
+        }
+        case EventType::ORDER:
+            applyOrder(event.side, event.price, event.quantity, static_cast<long long>(event.ref));
+            break;
+        case EventType::CANCEL:
+            if (book_.cancelOrder("ORD" + std::to_string(event.ref))) {
+                stats_.cancels++;
+                dropOrder(event.ref);
+            }
+            break;
+        case EventType::EXPIRY:
+            break;
+        case EventType::WAKEUP:
+            stats_.wakeups++;
+            if (wakeup_handler_) {
+                wakeup_handler_(*this, event.ref);
+            }
+            break;
+        case EventType::CLIENT_ORDER:
+            applyClientOrder(event);
+            break;
+        case EventType::CLIENT_CANCEL:
+            applyClientCancel(event);
+            break;
+        case EventType::FILL_NOTICE:
+            deliverFill(event);
+            break;
+        case EventType::PRICE_NOTICE: {
+            const auto& handler = participants_[event.participant].on_price;
+            if (handler) {
+                handler(*this, event.price, event.sent);
+            }
+            break;
+        }
+        case EventType::TRADE_NOTICE: {
+            const auto& handler = participants_[event.participant].on_trade;
+            if (handler) {
+                const Trade trade{"ORD" + std::to_string(event.ref), "ORD" + std::to_string(event.other),
+                                  event.price, event.quantity, toMillis(event.sent)};
+                handler(*this, trade);
+            }
+            break;
+        }
+        case EventType::BOOK_NOTICE: {
+            const auto& handler = participants_[event.participant].on_book;
+            if (handler) {
+                handler(*this, event.price, event.quantity);
+            }
+            break;
+        }
+    }
+}
+
+void Simulation::applyPrice(double price) {
+    price_ = price;
+    sma_.addPrice(price);
+    book_.processTick(price, trades_);
+    recordTrades();
+    stats_.price_steps++;
+
+    for (size_t i = 0; i < participants_.size(); i++) {
+        Participant& receiver = participants_[i];
+        if (!receiver.on_price) {
+            continue;
+        }
+        Event notice(noticeTime(receiver), EventType::PRICE_NOTICE);
+        notice.participant = static_cast<uint32_t>(i);
+        notice.price = price;
+        notice.sent = now_;
+        push(notice);
+    }
+}
+
+void Simulation::applyOrder(OrderSide side, double price, double quantity, long long lifetime_us) {
+    std::string order_id;
+    try {
+        if (lifetime_us > 0) {
+            // Rounded up to the book's millisecond clock, and woken for at the deadline
+            const long long expire_ms = (now_ + lifetime_us + 999) / 1000;
+            order_id = book_.addOrderGoodTill(side, price, quantity, expire_ms);
+            push(Event(expire_ms * 1000, EventType::EXPIRY));
+        } else {
+            order_id = book_.addOrder(side, price, quantity);
+        }
+    } catch (const std::invalid_argument&) {
+        stats_.rejected++;
+        return;
+    }
+    stats_.orders++;
+    if (!participants_.empty()) {
+        follow(orderSeq(order_id), side, price, quantity);
+    }
+    book_.matchOrders(trades_);
+    recordTrades();
+}
+
+void Simulation::applyClientOrder(const Event& event) {
+    Participant& sender = participants_[event.participant];
+    std::string order_id;
+    try {
+        order_id = book_.addOrder(event.side, event.price, event.quantity);
+    } catch (const std::invalid_argument&) {
+        stats_.rejected++;
+        sender.stats.rejected++;
+        return;
+    }
+    stats_.orders++;
+    sender.stats.orders++;
+
+    // Known by its book seq before matching, so taking fills count too
+    ClientOrder& order = client_orders_[event.ref];
+    order.participant = event.participant;
+    order.side = event.side;
+    order.price = event.price;
+    order.remaining = event.quantity;
+    order.seq = orderSeq(order_id);
+    client_by_seq_[order.seq] = event.ref;
+    follow(order.seq, event.side, event.price, event.quantity);
+
+    book_.matchOrders(trades_);
+    recordTrades();
+    if (order.remaining > 0) {
+        trackClient(event.ref, order);
+    }
+}
+
+void Simulation::applyClientCancel(const Event& event) {
+    auto found = client_orders_.find(event.ref);
+    if (found == client_orders_.end() || !found->second.resting
+            || found->second.participant != event.participant) {
+        return;
+    }
+    if (book_.cancelOrder("ORD" + std::to_string(found->second.seq))) {
+        stats_.cancels++;
+        participants_[event.participant].stats.cancels++;
+        dropOrder(found->second.seq);
+    }
+}
+
+void Simulation::deliverFill(const Event& event) {
+    auto found = client_orders_.find(event.ref);
+    ClientOrder& order = found->second;
+    const ParticipantFill fill{event.ref, "ORD" + std::to_string(order.seq), event.side, event.price,
+                               event.quantity, event.remaining, event.sent};
+    if (--order.notices == 0 && !order.resting) {
+        client_orders_.erase(found);
+    }
+    const auto& handler = participants_[event.participant].on_fill;
+    if (handler) {
+        handler(*this, fill);
+    }
+}
+
+void Simulation::recordTrades() {
+    const long long timestamp = toMillis(now_);
+    for (auto& trade : trades_) {
+        trade.timestamp = timestamp;
+        stats_.volume += trade.quantity;
+    }
+    stats_.trades += trades_.size();
+
+    for (size_t i = 0; i < participants_.size(); i++) {
+        Participant& receiver = participants_[i];
+        if (!receiver.on_trade) {
+            continue;
+        }
+        for (const auto& trade : trades_) {
+            Event notice(noticeTime(receiver), EventType::TRADE_NOTICE);
+            notice.participant = static_cast<uint32_t>(i);
+            notice.price = trade.price;
+            notice.quantity = trade.quantity;
+            notice.ref = orderSeq(trade.buy_order_id);
+            notice.other = orderSeq(trade.sell_order_id);
+            notice.sent = now_;
+            push(notice);
+        }
+    }
+
+    if (queued_.empty() && client_by_seq_.empty()) {
+        return;
+    }
+    refills_.assign(book_.lastRefills().begin(), book_.lastRefills().end());
+    next_refill_ = 0;
+    for (const auto& trade : trades_) {
+        for (const std::string* id : {&trade.buy_order_id, &trade.sell_order_id}) {
+            const uint64_t seq = orderSeq(*id);
+            consumeAhead(seq, trade.quantity);
+            fillClient(seq, trade);
+        }
+    }
+}
+
+void Simulation::settleExpired() {
+    stats_.expired += book_.takeExpired(expired_);
+    if (queued_.empty() && client_by_seq_.empty()) {
+        return;
+    }
+    for (const auto& order : expired_) {
+        dropOrder(orderSeq(order.order_id));
+    }
+}
+
+void Simulation::publishBook() {
+    const double bid = book_.getBestBid();
+    const double ask = book_.getBestAsk();
+    if (bid == published_bid_ && ask == published_ask_) {
+        return;
+    }
+    published_bid_ = bid;
+    published_ask_ = ask;
+    for (size_t i = 0; i < participants_.size(); i++) {
+        Participant& receiver = participants_[i];
+        if (!receiver.on_book) {
+            continue;
+        }
+        Event notice(noticeTime(receiver), EventType::BOOK_NOTICE);
+        notice.participant = static_cast<uint32_t>(i);
+        notice.price = bid;
+        notice.quantity = ask;
+        notice.sent = now_;
+        push(notice);
+    }
+}
+
+// ==================== Queue Positions ====================
+
+void Simulation::follow(uint64_t seq, OrderSide side, double price, double quantity, bool iceberg) {
+    // Joins the back of its level
+    QueueLevel& level = queueSide(side)[price];
+    level.quantity += quantity;
+    level.orders++;
+    queued_[seq] = QueuedOrder{side, iceberg, price, quantity, level.arrivals};
+}
+
+void Simulation::followBook() {
+    // Once, before the first event: what already rests, in queue order
+    followed_book_ = true;
+    for (OrderSide side : {OrderSide::BUY, OrderSide::SELL}) {
+        for (const auto& level : side == OrderSide::BUY ? book_.getBids() : book_.getAsks()) {
+            for (const Order& order : *book_.ordersAt(side, level.first)) {
+                follow(order.seq, side, order.price, order.quantity, order.iceberg);
+            }
+        }
+    }
+}
+
+void Simulation::trackClient(uint64_t client_id, ClientOrder& order) {
+    // Everything else at its level arrived before it
+    QueueLevel& level = queueSide(order.side)[order.price];
+    order.arrival = level.arrivals++;
+    if (level.clients.empty()) {
+        // Nobody else to keep the running totals for: they start over
+        level.consumed = 0.0;
+        level.first_behind = level.arrivals;
+        level.behind_total = 0.0;
+        level.behind.clear();
+    }
+    order.offset = level.consumed + std::max(0.0, level.quantity - order.remaining);
+    order.resting = true;
+    level.clients.emplace_back(order.arrival, client_id);
+}
+
+void Simulation::untrackClient(ClientOrder& order) {
+    client_by_seq_.erase(order.seq);
+    if (!order.resting) {
+        return;
+    }
+    order.resting = false;
+    auto& levels = queueSide(order.side);
+    auto level = levels.find(order.price);
+    auto& clients = level->second.clients;
+    const bool oldest = clients.front().first == order.arrival;
+    clients.erase(std::lower_bound(clients.begin(), clients.end(), std::make_pair(order.arrival, uint64_t{0})));
+    if (oldest && !clients.empty()) {
+        // What was lost before the new oldest participant order is ahead of them all
+        QueueLevel& queue = level->second;
+        for (; queue.first_behind <= clients.front().first; queue.first_behind++) {
+            if (!queue.behind.empty()) {
+                queue.behind_total -= queue.behind.front();
+                queue.behind.pop_front();
+            }
+        }
+    }
+    if (clients.empty() && level->second.orders == 0) {
+        levels.erase(level);
+    }
+}
+
+double Simulation::aheadOf(const ClientOrder& order) const {
+    // The level's losses since it arrived, less those behind it. Those are
+    // all of behind for the oldest participant order; for a later one the
+    // losses on the shorter side of its arrival are summed
+    const QueueLevel& level = queueSide(order.side).find(order.price)->second;
+    const size_t split = std::min<size_t>(order.arrival + 1 - level.first_behind, level.behind.size());
+    double behind = 0.0;
+    if (split <= level.behind.size() / 2) {
+        double before = 0.0;
+        for (size_t i = 0; i < split; i++) {
+            before += level.behind[i];
+        }
+        behind = level.behind_total - before;
+    } else {
+        for (size_t i = split; i < level.behind.size(); i++) {
+            behind += level.behind[i];
+        }
+    }
+    return std::max(0.0, order.offset - level.consumed + behind);
+}
+
+void Simulation::consumeAhead(uint64_t seq, double quantity) {
+    auto found = queued_.find(seq);
+    if (found == queued_.end()) {
+        return;
+    }
+    const QueuedOrder queued = found->second;
+    const double consumed = std::min(quantity, queued.open);
+    auto& levels = queueSide(queued.side);
+    auto level = levels.find(queued.price);
+    QueueLevel& queue = level->second;
+    queue.quantity -= consumed;
+    if (!queue.clients.empty()) {
+        queue.consumed += consumed;
+        if (queued.arrival >= queue.first_behind) {
+            // Behind the participant orders that arrived before it
+            const size_t i = queued.arrival - queue.first_behind;
+            if (i >= queue.behind.size()) {
+                queue.behind.resize(i + 1, 0.0);
+            }
+            queue.behind[i] += consumed;
+            queue.behind_total += consumed;
+        }
+    }
+    found->second.open -= consumed;
+    if (found->second.open > 0) {
+        return;
+    }
+    queued_.erase(found);
+    level->second.orders--;
+    if (queued.iceberg && quantity < kWholeOrder) {
+        // A filled tranche: the book reported its refill, if the reserve had
+        // one. Refills mostly come in trade order, so the search stops at
+        // the first one not yet followed; a followed one moves behind it
+        for (size_t i = next_refill_; i < refills_.size(); i++) {
+            if (refills_[i].seq == seq) {
+                follow(seq, queued.side, queued.price, refills_[i].quantity, true);
+                std::swap(refills_[i], refills_[next_refill_++]);
+                break;
+            }
+        }
+    }
+    if (level->second.orders == 0 && level->second.clients.empty()) {
+        levels.erase(level);
+    }
+}
+
+void Simulation::fillClient(uint64_t seq, const Trade& trade) {
+    auto found = client_by_seq_.find(seq);
+    if (found == client_by_seq_.end()) {
+        return;
+    }
+    const uint64_t client_id = found->second;
+    ClientOrder& order = client_orders_.find(client_id)->second;
+    order.remaining -= trade.quantity;
+    if (order.resting) {
+        // Filled, so nothing is ahead of it any more
+        order.offset -= aheadOf(order);
+    }
+
+    Participant& owner = participants_[order.participant];
+    owner.stats.fills++;
+    owner.stats.filled_quantity += trade.quantity;
+    Event notice(noticeTime(owner), EventType::FILL_NOTICE);
+    notice.side = order.side;
+    notice.participant = order.participant;
+    notice.price = trade.price;
+    notice.quantity = trade.quantity;
+    notice.remaining = std::max(0.0, order.remaining);
+    notice.ref = client_id;
+    notice.sent = now_;
+    push(notice);
+    order.notices++;
+
+    if (order.remaining <= 0) {
+        untrackClient(order);
+    }
+}
+
+void Simulation::dropOrder(uint64_t seq) {
+    // Cancelled or expired: whatever it still showed is no longer ahead
+    consumeAhead(seq, kWholeOrder);
+    auto found = client_by_seq_.find(seq);
+    if (found == client_by_seq_.end()) {
+        return;
+    }
+    auto order = client_orders_.find(found->second);
+    untrackClient(order->second);
+    if (order->second.notices == 0) {
+        client_orders_.erase(order);
+    }
+}
+
+double Simulation::nextNormal() {
+    if (next_normal_ == normals_.size()) {
+        normals_.resize(kNormalBlock);
+        kernels::gaussianNormals(config_.seed, normal_offset_, kNormalBlock, normals_.data());
+        normal_offset_ += kNormalBlock;
+        next_normal_ = 0;
+    }
+    return normals_[next_normal_++];
+}
+
+long long Simulation::nextArrival() {
+    // Exponential gap of mean 1 / order_rate seconds
+    const double u = static_cast<double>((flow_rng_() >> 11) + 1) * 0x1.0p-53;
+    return now_ + static_cast<long long>(-std::log(u) / config_.order_rate * 1e6);
+}
+
+} // namespace trading
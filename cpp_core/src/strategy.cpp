@@ -0,0 +1,422 @@
+#include "strategy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace trading {
+
+namespace {
+
+// Recorded prices are scheduled this many at a time
+constexpr size_t kReplayChunk = 4096;
+
+// Reusable rendezvous of a fixed number of threads (std::barrier is C++20)
+class Barrier {
+public:
+    explicit Barrier(size_t parties) : parties_(parties) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const uint64_t generation = generation_;
+        if (++waiting_ == parties_) {
+            waiting_ = 0;
+            generation_++;
+            released_.notify_all();
+            return;
+        }
+        released_.wait(lock, [&] { return generation_ != generation; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    size_t parties_;
+    size_t waiting_ = 0;
+    uint64_t generation_ = 0;
+};
+
+} // namespace
+
+// ==================== StrategyContext ====================
+
+uint64_t StrategyContext::submitOrder(OrderSide side, double price, double quantity) {
+    return simulation_->submitOrder(participant_, side, price, quantity);
+}
+
+void StrategyContext::cancelOrder(uint64_t client_id) {
+    simulation_->submitCancel(participant_, client_id);
+}
+
+double StrategyContext::queueAhead(uint64_t client_id) const {
+    return simulation_->queueAhead(client_id);
+}
+
+// ==================== SMACrossoverStrategy ====================
+
+SMACrossoverStrategy::SMACrossoverStrategy(size_t fast_window, size_t slow_window, double quantity,
+                                           double slippage)
+    : fast_(fast_window), slow_(slow_window), slow_window_(slow_window),
+      quantity_(quantity), slippage_(slippage) {
+    if (fast_window == 0 || fast_window >= slow_window || quantity <= 0 || slippage < 0) {
+        throw std::invalid_argument("Need 0 < fast_window < slow_window, quantity > 0 and slippage >= 0");
+    }
+}
+
+void SMACrossoverStrategy::onTick(StrategyContext& context, double price) {
+    fast_.addPrice(price);
+    slow_.addPrice(price);
+    if (slow_.size() < slow_window_) {
+        return;
+    }
+    const double gap = fast_.getSMA() - slow_.getSMA();
+    const int signal = gap > 0 ? 1 : gap < 0 ? -1 : signal_;
+    if (signal == signal_) {
+        return;
+    }
+    if (signal_ != 0) {
+        crossovers_++;
+    }
+    signal_ = signal;
+
+    if (working_ != 0) {
+        context.cancelOrder(working_);
+        working_ = 0;
+    }
+    const double delta = signal * quantity_ - context.position();
+    if (std::abs(delta) <= quantity_ * 1e-9) {
+        return;
+    }
+    working_ = delta > 0
+        ? context.submitOrder(OrderSide::BUY, price * (1.0 + slippage_), delta)
+        : context.submitOrder(OrderSide::SELL, price * (1.0 - slippage_), -delta);
+}
+
+void SMACrossoverStrategy::onFill(StrategyContext& /*context*/, const ParticipantFill& fill) {
+    if (fill.client_id == working_ && fill.remaining <= 0) {
+        working_ = 0;
+    }
+}
+
+// ==================== BatchStrategy ====================
+
+void StrategyBatch::clear() {
+    tick_times.clear();
+    tick_prices.clear();
+    trades.clear();
+    fills.clear();
+}
+
+BatchStrategy::BatchStrategy(Handler handler, size_t batch_ticks)
+    : handler_(std::move(handler)), batch_ticks_(batch_ticks) {
+    if (batch_ticks == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    batch_.tick_times.reserve(batch_ticks);
+    batch_.tick_prices.reserve(batch_ticks);
+}
+
+void BatchStrategy::onTick(StrategyContext& context, double price) {
+    batch_.tick_times.push_back(context.now());
+    batch_.tick_prices.push_back(price);
+    if (batch_.tick_times.size() >= batch_ticks_) {
+        flush(context);
+    }
+}
+
+void BatchStrategy::onTrade(StrategyContext& /*context*/, const Trade& trade) {
+    batch_.trades.push_back(trade);
+}
+
+void BatchStrategy::onBookUpdate(StrategyContext& /*context*/, double best_bid, double best_ask) {
+    batch_.best_bid = best_bid;
+    batch_.best_ask = best_ask;
+}
+
+void BatchStrategy::onFill(StrategyContext& /*context*/, const ParticipantFill& fill) {
+    batch_.fills.push_back(fill);
+}
+
+void BatchStrategy::onFinish(StrategyContext& context) {
+    if (!batch_.empty()) {
+        flush(context);
+    }
+}
+
+void BatchStrategy::flush(StrategyContext& context) {
+    batches_++;
+    if (handler_) {
+        handler_(context, batch_);
+    }
+    batch_.clear();
+}
+
+// ==================== Backtest ====================
+
+Backtest::Backtest(Strategy& strategy, const BacktestConfig& config)
+    : strategy_(strategy), config_(config) {}
+
+BacktestResult Backtest::run(long long end_us) {
+    if (config_.market.price_interval_us <= 0) {
+        throw std::invalid_argument("run() needs the price model; use replay() for recorded prices");
+    }
+    start(config_.market);
+    return finish(end_us);
+}
+
+BacktestResult Backtest::replay(const long long* times_us, const double* prices, size_t count) {
+    checkTicks(times_us, prices, count, 0);
+    SimulationConfig market = config_.market;
+    market.price_interval_us = 0;
+    if (count > 0) {
+        market.initial_price = prices[0];
+    }
+    start(market);
+    feed(times_us, prices, count);
+    return finish(count > 0 ? times_us[count - 1] : 0);
+}
+
+void Backtest::checkTicks(const long long* times_us, const double* prices, size_t count, long long after) {
+    for (size_t i = 0; i < count; i++) {
+        if (times_us[i] < (i > 0 ? times_us[i - 1] : after) || prices[i] <= 0) {
+            throw std::invalid_argument("Ticks need non-decreasing, non-negative times and positive prices");
+        }
+    }
+}
+
+void Backtest::start(SimulationConfig market) {
+    simulation_ = std::make_unique<Simulation>(market);
+    Simulation& sim = *simulation_;
+    const size_t me = sim.addParticipant(config_.order_entry, config_.market_data);
+    context_ = StrategyContext();
+    context_.simulation_ = &sim;
+    context_.participant_ = me;
+    result_ = BacktestResult();
+    peak_equity_ = 0.0;
+
+    sim.setPriceHandler(me, [this](Simulation&, double price, long long) {
+        context_.last_price_ = price;
+        result_.ticks++;
+        mark();
+        strategy_.onTick(context_, price);
+    });
+    sim.setFillHandler(me, [this](Simulation&, const ParticipantFill& fill) {
+        const double signed_quantity = fill.side == OrderSide::BUY ? fill.quantity : -fill.quantity;
+        context_.position_ += signed_quantity;
+        context_.cash_ -= signed_quantity * fill.price;
+        strategy_.onFill(context_, fill);
+    });
+    sim.setTradeHandler(me, [this](Simulation&, const Trade& trade) {
+        strategy_.onTrade(context_, trade);
+    });
+    sim.setBookHandler(me, [this](Simulation&, double best_bid, double best_ask) {
+        context_.best_bid_ = best_bid;
+        context_.best_ask_ = best_ask;
+        strategy_.onBookUpdate(context_, best_bid, best_ask);
+    });
+}
+
+void Backtest::feed(const long long* times_us, const double* prices, size_t count) {
+    for (size_t begin = 0; begin < count; begin += kReplayChunk) {
+        const size_t end = std::min(count, begin + kReplayChunk);
+        for (size_t i = begin; i < end; i++) {
+            simulation_->schedulePrice(times_us[i], prices[i]);
+        }
+        simulation_->runUntil(times_us[end - 1]);
+    }
+}
+
+BacktestResult Backtest::finish(long long end_us) {
+    Simulation& sim = *simulation_;
+    sim.runUntil(end_us);
+    strategy_.onFinish(context_);
+
+    const ParticipantStats& stats = sim.participantStats(context_.participant_);
+    result_.orders = stats.orders;
+    result_.rejected = stats.rejected;
+    result_.cancels = stats.cancels;
+    result_.fills = stats.fills;
+    result_.traded_quantity = stats.filled_quantity;
+    result_.position = context_.position_;
+    result_.cash = context_.cash_;
+    result_.pnl = context_.cash_ + context_.position_ * sim.price();
+    result_.end_us = sim.now();
+    result_.market = sim.stats();
+    return result_;
+}
+
+void Backtest::mark() {
+    const double equity = context_.cash_ + context_.position_ * context_.last_price_;
+    peak_equity_ = std::max(peak_equity_, equity);
+    result_.max_drawdown = std::max(result_.max_drawdown, peak_equity_ - equity);
+}
+
+// ==================== ParallelBacktest ====================
+
+ParallelBacktest::ParallelBacktest(size_t threads)
+    : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+size_t ParallelBacktest::add(Strategy& strategy, const BacktestConfig& config) {
+    backtests_.push_back(std::make_unique<Backtest>(strategy, config));
+    return backtests_.size() - 1;
+}
+
+std::vector<BacktestResult> ParallelBacktest::replay(const long long* times_us, const double* prices,
+                                                     size_t count, size_t batch_ticks) {
+    if (batch_ticks == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    Backtest::checkTicks(times_us, prices, count, 0);
+    size_t offset = 0;
+    return run([&](std::vector<long long>& times, std::vector<double>& batch_prices) {
+        if (offset == count) {
+            return false;
+        }
+        const size_t end = std::min(count, offset + batch_ticks);
+        times.assign(times_us + offset, times_us + end);
+        batch_prices.assign(prices + offset, prices + end);
+        offset = end;
+        return true;
+    });
+}
+
+std::vector<BacktestResult> ParallelBacktest::replay(const TickStore& store, int64_t from, int64_t to,
+                                                     long long time_unit_us, size_t batch_ticks) {
+    if (batch_ticks == 0 || time_unit_us <= 0) {
+        throw std::invalid_argument("Batch size and time unit must be positive");
+    }
+    // Each batch reads the time window of whole blocks holding about
+    // batch_ticks ticks; windows are disjoint, so no tick is read twice
+    size_t block = 0;
+    while (block < store.blockCount() && store.block(block).last_time < from) {
+        block++;
+    }
+    int64_t cursor = from;
+    int64_t origin = 0;
+    bool started = false;
+    long long last_us = 0;
+    std::vector<Tick> ticks;
+    return run([&](std::vector<long long>& times, std::vector<double>& prices) {
+        times.clear();
+        prices.clear();
+        while (times.empty()) {
+            if (cursor >= to || block >= store.blockCount()) {
+                return false;
+            }
+            int64_t end = to;
+            size_t pending = 0;
+            while (block < store.blockCount()) {
+                const TickBlock& header = store.block(block++);
+                pending += header.count;
+                if (pending >= batch_ticks) {
+                    end = std::min(to, header.last_time + 1);
+                    break;
+                }
+            }
+            ticks.clear();
+            store.read(cursor, end, ticks);
+            cursor = end;
+            if (!started && !ticks.empty()) {
+                origin = ticks.front().timestamp;
+                started = true;
+            }
+            for (const Tick& tick : ticks) {
+                times.push_back(static_cast<long long>(tick.timestamp - origin) * time_unit_us);
+                prices.push_back(tick.price);
+            }
+        }
+        Backtest::checkTicks(times.data(), prices.data(), times.size(), last_us);
+        last_us = times.back();
+        return true;
+    });
+}
+
+std::vector<BacktestResult> ParallelBacktest::run(const Source& next) {
+    std::vector<long long> times[2];
+    std::vector<double> prices[2];
+    const bool any = next(times[0], prices[0]);
+    for (auto& backtest : backtests_) {
+        SimulationConfig market = backtest->config_.market;
+        market.price_interval_us = 0;
+        if (any) {
+            market.initial_price = prices[0].front();
+        }
+        backtest->start(market);
+    }
+
+    long long end_us = 0;
+    if (any && !backtests_.empty()) {
+        // Lock-step: the workers feed batch `current` while this thread
+        // decodes the next one into the other buffer
+        const size_t workers = std::min(threads_, backtests_.size());
+        Barrier barrier(workers + 1);
+        size_t current = 0;
+        bool done = false;
+        std::vector<std::exception_ptr> errors(workers);
+        std::vector<std::thread> pool;
+        pool.reserve(workers);
+        for (size_t w = 0; w < workers; w++) {
+            pool.emplace_back([&, w] {
+                for (;;) {
+                    barrier.wait();
+                    if (done) {
+                        return;
+                    }
+                    const std::vector<long long>& batch_times = times[current];
+                    const std::vector<double>& batch_prices = prices[current];
+                    if (!errors[w]) {
+                        try {
+                            for (size_t i = w; i < backtests_.size(); i += workers) {
+                                backtests_[i]->feed(batch_times.data(), batch_prices.data(), batch_times.size());
+                            }
+                        } catch (...) {
+                            errors[w] = std::current_exception();
+                        }
+                    }
+                    barrier.wait();
+                }
+            });
+        }
+
+        std::exception_ptr source_error;
+        for (bool more = true; more;) {
+            barrier.wait();   // Workers take the batch
+            end_us = times[current].back();
+            const size_t spare = current ^ 1;
+            try {
+                more = next(times[spare], prices[spare]);
+            } catch (...) {
+                source_error = std::current_exception();
+                more = false;
+            }
+            barrier.wait();   // and are done with it
+            current = spare;
+        }
+        done = true;
+        barrier.wait();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        if (source_error) {
+            std::rethrow_exception(source_error);
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    std::vector<BacktestResult> results;
+    results.reserve(backtests_.size());
+    for (auto& backtest : backtests_) {
+        results.push_back(backtest->finish(end_us));
+    }
+    return results;
+}
+
+} // namespace trading
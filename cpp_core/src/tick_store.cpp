@@ -0,0 +1,654 @@
+#include "tick_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace trading {
+
+constexpr size_t kPayloadWords = (TickStore::kBlockBytes - sizeof(TickBlock)) / sizeof(uint64_t);
+
+struct TickStore::Block {
+    TickBlock header;
+    uint64_t payload[kPayloadWords];   // MSB-first bitstream
+};
+
+static_assert(sizeof(TickBlock) == 88, "TickBlock is part of the file format");
+
+namespace {
+
+constexpr uint32_t kPayloadBits = kPayloadWords * 64;
+
+// Largest encoding of one tick: 5 + 64 timestamp bits, 2 + 5 + 6 + 64 per value
+constexpr uint32_t kMaxTickBits = 69 + 2 * 77;
+
+uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// ==================== Bitstream ====================
+
+/**
+ * @brief Append the low n bits of value (1 <= n <= 64, higher bits zero)
+ */
+inline void writeBits(uint64_t* words, uint32_t& pos, uint64_t value, unsigned n) {
+    const uint32_t word = pos >> 6;
+    const unsigned off = pos & 63;
+    if (off + n <= 64) {
+        words[word] |= value << (64 - off - n);
+    } else {
+        words[word] |= value >> (off + n - 64);
+        words[word + 1] |= value << (128 - off - n);
+    }
+    pos += n;
+}
+
+inline uint64_t readBits(const uint64_t* words, uint32_t& pos, unsigned n) {
+    const uint32_t word = pos >> 6;
+    const unsigned off = pos & 63;
+    uint64_t value = words[word] << off;
+    if (off + n > 64) {
+        value |= words[word + 1] >> (64 - off);
+    }
+    pos += n;
+    return value >> (64 - n);
+}
+
+inline int leadingZeros(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+inline int trailingZeros(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+inline uint64_t lowBits(int64_t value, unsigned n) {
+    return static_cast<uint64_t>(value) & ((uint64_t{1} << n) - 1);
+}
+
+// Delta-of-delta buckets: prefix of `prefix_bits` ones-then-zero, then the
+// value biased into `value_bits` unsigned bits
+struct DodBucket {
+    uint64_t prefix;
+    unsigned prefix_bits;
+    unsigned value_bits;
+};
+
+constexpr DodBucket kDodBuckets[] = {
+    {0b10, 2, 7},
+    {0b110, 3, 12},
+    {0b1110, 4, 20},
+    {0b11110, 5, 32},
+};
+
+// ==================== Encoding ====================
+
+template <typename State>
+void encodeTime(uint64_t* words, uint32_t& pos, State& state, int64_t timestamp) {
+    const int64_t delta = timestamp - state.time;
+    const int64_t dod = delta - state.delta;
+    state.time = timestamp;
+    state.delta = delta;
+
+    if (dod == 0) {
+        writeBits(words, pos, 0, 1);
+        return;
+    }
+    for (const auto& bucket : kDodBuckets) {
+        const int64_t bias = (int64_t{1} << (bucket.value_bits - 1)) - 1;
+        if (dod >= -bias && dod <= bias + 1) {
+            writeBits(words, pos, (bucket.prefix << bucket.value_bits) | lowBits(dod + bias, bucket.value_bits),
+                      bucket.prefix_bits + bucket.value_bits);
+            return;
+        }
+    }
+    writeBits(words, pos, 0b11111, 5);
+    writeBits(words, pos, static_cast<uint64_t>(dod), 64);
+}
+
+void encodeValue(uint64_t* words, uint32_t& pos, uint64_t& prev, int& prev_lead, int& prev_trail,
+                 double value) {
+    const uint64_t bits = bitsOf(value);
+    const uint64_t x = bits ^ prev;
+    prev = bits;
+
+    if (x == 0) {
+        writeBits(words, pos, 0, 1);
+        return;
+    }
+    int lead = leadingZeros(x);
+    const int trail = trailingZeros(x);
+    lead = lead > 31 ? 31 : lead;
+
+    if (prev_lead >= 0 && lead >= prev_lead && trail >= prev_trail) {
+        // Fits the previous window: control bits 10 and the window's bits
+        writeBits(words, pos, 0b10, 2);
+        writeBits(words, pos, x >> prev_trail, 64 - prev_lead - prev_trail);
+        return;
+    }
+    // New window: 11, 5-bit leading zeros, 6-bit length (64 stored as 0)
+    const unsigned length = 64 - lead - trail;
+    writeBits(words, pos, (uint64_t{0b11} << 11) | (uint64_t(lead) << 6) | (length & 63), 13);
+    writeBits(words, pos, x >> trail, length);
+    prev_lead = lead;
+    prev_trail = trail;
+}
+
+// ==================== Decoding ====================
+
+template <typename State>
+int64_t decodeTime(const uint64_t* words, uint32_t& pos, State& state) {
+    unsigned ones = 0;
+    while (ones < 5 && readBits(words, pos, 1)) {
+        ++ones;
+    }
+    int64_t dod = 0;
+    if (ones == 5) {
+        dod = static_cast<int64_t>(readBits(words, pos, 64));
+    } else if (ones > 0) {
+        const DodBucket& bucket = kDodBuckets[ones - 1];
+        const int64_t bias = (int64_t{1} << (bucket.value_bits - 1)) - 1;
+        dod = static_cast<int64_t>(readBits(words, pos, bucket.value_bits)) - bias;
+    }
+    state.delta += dod;
+    state.time += state.delta;
+    return state.time;
+}
+
+double decodeValue(const uint64_t* words, uint32_t& pos, uint64_t& prev, int& prev_lead, int& prev_trail) {
+    if (readBits(words, pos, 1)) {
+        if (readBits(words, pos, 1)) {
+            prev_lead = static_cast<int>(readBits(words, pos, 5));
+            unsigned length = static_cast<unsigned>(readBits(words, pos, 6));
+            length = length == 0 ? 64 : length;
+            prev_trail = 64 - prev_lead - static_cast<int>(length);
+        }
+        prev ^= readBits(words, pos, 64 - prev_lead - prev_trail) << prev_trail;
+    }
+    return fromBits(prev);
+}
+
+#ifndef _WIN32
+[[noreturn]] void throwErrno(const std::string& what, const std::string& path) {
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+#endif
+
+/**
+ * @brief Walks one block's ticks in order
+ */
+class TickDecoder {
+public:
+    template <typename Block, typename State>
+    TickDecoder(const Block& block, State& state)
+        : words_(block.payload), remaining_(block.header.count) {
+        state = State{};
+        state.time = block.header.first_time;
+    }
+
+    template <typename State>
+    bool next(State& state, Tick& tick) {
+        if (remaining_ == 0) {
+            return false;
+        }
+        --remaining_;
+        tick.timestamp = decodeTime(words_, pos_, state);
+        tick.price = decodeValue(words_, pos_, state.price, state.price_lead, state.price_trail);
+        tick.quantity = decodeValue(words_, pos_, state.quantity, state.quantity_lead, state.quantity_trail);
+        return true;
+    }
+
+private:
+    const uint64_t* words_;
+    uint32_t remaining_;
+    uint32_t pos_ = 0;
+};
+
+} // namespace
+
+TickStore::TickStore(const std::string& path)
+    : path_(path), active_(std::make_unique<Block>()) {
+    static_assert(sizeof(Block) == kBlockBytes, "blocks must fill kBlockBytes exactly");
+    std::memset(active_.get(), 0, sizeof(Block));
+    if (!path_.empty()) {
+        openFile();
+    }
+}
+
+TickStore::~TickStore() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        try {
+            flush();
+        } catch (...) {
+            // Destructors must not throw; the data up to the last seal is on disk
+        }
+        if (mapped_) {
+            munmap(const_cast<uint8_t*>(mapped_), mapped_bytes_);
+        }
+        close(fd_);
+    }
+#endif
+}
+
+void TickStore::openFile() {
+#ifdef _WIN32
+    throw std::runtime_error("File-backed TickStore needs POSIX mmap: " + path_);
+#else
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        throwErrno("Cannot open tick store", path_);
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        throwErrno("Cannot stat tick store", path_);
+    }
+    if (st.st_size % kBlockBytes != 0) {
+        throw std::runtime_error("Tick store size is not a whole number of blocks: " + path_);
+    }
+
+    const size_t blocks = static_cast<size_t>(st.st_size) / kBlockBytes;
+    std::vector<uint8_t> buffer(kBlockBytes);
+    for (size_t i = 0; i < blocks; ++i) {
+        if (pread(fd_, buffer.data(), kBlockBytes, static_cast<off_t>(i * kBlockBytes))
+                != static_cast<ssize_t>(kBlockBytes)) {
+            throwErrno("Cannot read tick store", path_);
+        }
+        TickBlock header;
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        if (header.magic != kTickBlockMagic || (!header.sealed && i + 1 != blocks)) {
+            throw std::runtime_error("Corrupt tick store block " + std::to_string(i) + ": " + path_);
+        }
+        size_ += header.count;
+        if (header.sealed) {
+            index_.push_back(header);
+            continue;
+        }
+
+        // Partial last block: decode it to rebuild the encoder state
+        std::memcpy(active_.get(), buffer.data(), kBlockBytes);
+        TickDecoder decoder(*active_, state_);
+        Tick tick;
+        while (decoder.next(state_, tick)) {
+        }
+    }
+    mapSealed();
+#endif
+}
+
+void TickStore::mapSealed() {
+#ifndef _WIN32
+    const size_t needed = index_.size() * kBlockBytes;
+    if (needed <= mapped_bytes_) {
+        return;
+    }
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(mapped_), mapped_bytes_);
+        mapped_ = nullptr;
+        mapped_bytes_ = 0;
+    }
+    // Reserve headroom so the map is replaced O(log n) times; pages past
+    // the end of the file are never touched
+    const size_t bytes = std::max(needed * 2, size_t{1} << 20);
+    void* map = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        throwErrno("Cannot map tick store", path_);
+    }
+    mapped_ = static_cast<const uint8_t*>(map);
+    mapped_bytes_ = bytes;
+#endif
+}
+
+void TickStore::writeBlock(size_t i, const Block& block) {
+#ifndef _WIN32
+    if (pwrite(fd_, &block, kBlockBytes, static_cast<off_t>(i * kBlockBytes)) != static_cast<ssize_t>(kBlockBytes)) {
+        throwErrno("Cannot write tick store", path_);
+    }
+#else
+    (void)i;
+    (void)block;
+#endif
+}
+
+const TickStore::Block& TickStore::blockData(size_t i) const {
+    if (i == index_.size()) {
+        return *active_;
+    }
+    const uint8_t* base = fd_ >= 0 ? mapped_ : memory_.data();
+    return *reinterpret_cast<const Block*>(base + i * kBlockBytes);
+}
+
+void TickStore::startBlock(int64_t timestamp, double price) {
+    std::memset(active_.get(), 0, sizeof(Block));
+    TickBlock& h = active_->header;
+    h.magic = kTickBlockMagic;
+    h.first_time = timestamp;
+    h.last_time = timestamp;
+    h.min_price = price;
+    h.max_price = price;
+    h.min_time = timestamp;
+    h.max_time = timestamp;
+    h.first_price = price;
+    state_ = CodecState{};
+    state_.time = timestamp;
+}
+
+void TickStore::sealBlock() {
+    active_->header.sealed = 1;
+    const size_t i = index_.size();
+    if (fd_ >= 0) {
+        writeBlock(i, *active_);
+    } else {
+        if (memory_.size() == memory_.capacity()) {
+            memory_.reserve(std::max(memory_.capacity() * 2, 64 * kBlockBytes));
+        }
+        const auto* bytes = reinterpret_cast<const uint8_t*>(active_.get());
+        memory_.insert(memory_.end(), bytes, bytes + kBlockBytes);
+    }
+    index_.push_back(active_->header);
+    if (fd_ >= 0) {
+        mapSealed();
+    }
+    std::memset(active_.get(), 0, sizeof(Block));
+    active_dirty_ = false;
+}
+
+void TickStore::append(int64_t timestamp, double price, double quantity) {
+    TickBlock& h = active_->header;
+    if (size_ > 0 && timestamp < (h.count ? h.last_time : index_.back().last_time)) {
+        throw std::invalid_argument("Tick timestamps must be non-decreasing");
+    }
+    if (h.count == 0) {
+        startBlock(timestamp, price);
+    }
+
+    encodeTime(active_->payload, h.bits, state_, timestamp);
+    encodeValue(active_->payload, h.bits, state_.price, state_.price_lead, state_.price_trail, price);
+    encodeValue(active_->payload, h.bits, state_.quantity, state_.quantity_lead, state_.quantity_trail, quantity);
+
+    ++h.count;
+    h.last_time = timestamp;
+    if (price < h.min_price) {
+        h.min_price = price;
+        h.min_time = timestamp;
+    }
+    if (price > h.max_price) {
+        h.max_price = price;
+        h.max_time = timestamp;
+    }
+    h.last_price = price;
+    h.volume += quantity;
+    ++size_;
+    active_dirty_ = true;
+
+    if (kPayloadBits - h.bits < kMaxTickBits) {
+        sealBlock();
+    }
+}
+
+void TickStore::flush() {
+    if (fd_ >= 0 && active_dirty_) {
+        writeBlock(index_.size(), *active_);
+        active_dirty_ = false;
+    }
+}
+
+size_t TickStore::firstBlockEndingAtOrAfter(int64_t timestamp) const {
+    return static_cast<size_t>(std::partition_point(index_.begin(), index_.end(),
+        [timestamp](const TickBlock& b) { return b.last_time < timestamp; }) - index_.begin());
+}
+
+size_t TickStore::read(int64_t from, int64_t to, std::vector<Tick>& out) const {
+    const size_t before = out.size();
+    const size_t blocks = blockCount();
+
+    CodecState state;
+    Tick tick;
+    for (size_t i = firstBlockEndingAtOrAfter(from); i < blocks && block(i).first_time < to; ++i) {
+        TickDecoder decoder(blockData(i), state);
+        while (decoder.next(state, tick)) {
+            if (tick.timestamp >= to) {
+                break;
+            }
+            if (tick.timestamp >= from) {
+                out.push_back(tick);
+            }
+        }
+    }
+    return out.size() - before;
+}
+
+void TickStore::edgeTicks(int64_t from, int64_t to, TickPoint& first, TickPoint& last) const {
+    const size_t blocks = blockCount();
+    CodecState state;
+    Tick tick{};
+
+    // Both come from the index unless the range cuts into a block
+    size_t i = firstBlockEndingAtOrAfter(from);
+    first = {block(i).first_time, block(i).first_price};
+    if (block(i).first_time < from) {
+        TickDecoder decoder(blockData(i), state);
+        while (decoder.next(state, tick) && tick.timestamp < from) {
+        }
+        first = {tick.timestamp, tick.price};
+    }
+
+    size_t j = firstBlockEndingAtOrAfter(to);
+    if (j < blocks && block(j).first_time < to) {
+        TickDecoder decoder(blockData(j), state);
+        while (decoder.next(state, tick) && tick.timestamp < to) {
+            last = {tick.timestamp, tick.price};
+        }
+    } else {
+        last = {block(j - 1).last_time, block(j - 1).last_price};
+    }
+}
+
+void TickStore::minMaxBuckets(int64_t from, int64_t to, size_t buckets, std::vector<TickPoint>& out) const {
+    struct Extremes {
+        TickPoint min;
+        TickPoint max;
+        bool any = false;
+
+        void add(int64_t min_time, double min_price, int64_t max_time, double max_price) {
+            if (!any || min_price < min.price) {
+                min = {min_time, min_price};
+            }
+            if (!any || max_price > max.price) {
+                max = {max_time, max_price};
+            }
+            any = true;
+        }
+    };
+    std::vector<Extremes> extremes(buckets);
+
+    // Equal-width buckets over [from, to); the caller clamps the range to the data
+    const uint64_t span = static_cast<uint64_t>(to - from);
+    const uint64_t width = span / buckets + (span % buckets != 0);
+    auto bucketOf = [from, width](int64_t t) {
+        return static_cast<size_t>(static_cast<uint64_t>(t - from) / width);
+    };
+
+    CodecState state;
+    Tick tick;
+    const size_t blocks = blockCount();
+    for (size_t i = firstBlockEndingAtOrAfter(from); i < blocks && block(i).first_time < to; ++i) {
+        const TickBlock& b = block(i);
+        if (b.first_time >= from && b.last_time < to && bucketOf(b.first_time) == bucketOf(b.last_time)) {
+            extremes[bucketOf(b.first_time)].add(b.min_time, b.min_price, b.max_time, b.max_price);
+            continue;
+        }
+        TickDecoder decoder(blockData(i), state);
+        while (decoder.next(state, tick)) {
+            if (tick.timestamp >= to) {
+                break;
+            }
+            if (tick.timestamp >= from) {
+                extremes[bucketOf(tick.timestamp)].add(tick.timestamp, tick.price, tick.timestamp, tick.price);
+            }
+        }
+    }
+
+    for (const auto& e : extremes) {
+        if (!e.any) {
+            continue;
+        }
+        const bool min_first = e.min.timestamp <= e.max.timestamp;
+        out.push_back(min_first ? e.min : e.max);
+        if (e.min.timestamp != e.max.timestamp || e.min.price != e.max.price) {
+            out.push_back(min_first ? e.max : e.min);
+        }
+    }
+}
+
+size_t TickStore::downsample(int64_t from, int64_t to, size_t points, Downsample method,
+                             std::vector<TickPoint>& out) const {
+    if (points < 2) {
+        throw std::invalid_argument("Downsampling needs at least 2 points");
+    }
+    const size_t before = out.size();
+    if (empty()) {
+        return 0;
+    }
+
+    // Clamp to the stored span so bucket widths follow the data
+    const size_t blocks = blockCount();
+    from = std::max(from, block(0).first_time);
+    const int64_t last_time = block(blocks - 1).last_time;
+    to = last_time < to ? last_time + 1 : to;
+    if (from >= to) {
+        return 0;
+    }
+
+    // Few enough ticks (counted from the index): return them all
+    size_t ticks = 0;
+    for (size_t i = firstBlockEndingAtOrAfter(from); i < blocks && block(i).first_time < to; ++i) {
+        ticks += block(i).count;
+    }
+    if (ticks <= points) {
+        std::vector<Tick> raw;
+        read(from, to, raw);
+        for (const auto& t : raw) {
+            out.push_back({t.timestamp, t.price});
+        }
+        return out.size() - before;
+    }
+
+    if (method == Downsample::MIN_MAX) {
+        minMaxBuckets(from, to, points / 2, out);
+        return out.size() - before;
+    }
+
+    // Candidates: bucket extremes plus the range's end ticks, which LTTB keeps
+    std::vector<TickPoint> candidates;
+    minMaxBuckets(from, to, 2 * points, candidates);
+    if (candidates.empty()) {
+        return 0;
+    }
+    TickPoint first, last;
+    edgeTicks(from, to, first, last);
+    if (candidates.front().timestamp != first.timestamp || candidates.front().price != first.price) {
+        candidates.insert(candidates.begin(), first);
+    }
+    if (candidates.back().timestamp != last.timestamp || candidates.back().price != last.price) {
+        candidates.push_back(last);
+    }
+    const size_t n = candidates.size();
+    if (n <= points) {
+        out.insert(out.end(), candidates.begin(), candidates.end());
+        return out.size() - before;
+    }
+
+    // LTTB: keep the ends; from each of the points - 2 middle buckets keep
+    // the candidate forming the largest triangle with the previous pick and
+    // the average of the next bucket
+    const int64_t t0 = candidates[0].timestamp;
+    auto x = [&](size_t i) { return static_cast<double>(candidates[i].timestamp - t0); };
+    const double every = static_cast<double>(n - 2) / static_cast<double>(points - 2);
+
+    out.push_back(candidates[0]);
+    size_t a = 0;
+    for (size_t k = 0; k + 2 < points; ++k) {
+        const size_t start = static_cast<size_t>(static_cast<double>(k) * every) + 1;
+        const size_t end = static_cast<size_t>(static_cast<double>(k + 1) * every) + 1;
+        const size_t next_end = std::min(static_cast<size_t>(static_cast<double>(k + 2) * every) + 1, n);
+
+        double avg_x = 0.0, avg_y = 0.0;
+        for (size_t j = end; j < next_end; ++j) {
+            avg_x += x(j);
+            avg_y += candidates[j].price;
+        }
+        const double m = static_cast<double>(next_end - end);
+        avg_x /= m;
+        avg_y /= m;
+
+        size_t pick = start;
+        double best = -1.0;
+        for (size_t j = start; j < end; ++j) {
+            const double area = std::abs((x(a) - avg_x) * (candidates[j].price - candidates[a].price)
+                                         - (x(a) - x(j)) * (avg_y - candidates[a].price));
+            if (area > best) {
+                best = area;
+                pick = j;
+            }
+        }
+        out.push_back(candidates[pick]);
+        a = pick;
+    }
+    out.push_back(candidates[n - 1]);
+    return out.size() - before;
+}
+
+const TickBlock& TickStore::block(size_t i) const {
+    if (i >= blockCount()) {
+        throw std::out_of_range("Tick block index out of range");
+    }
+    return i < index_.size() ? index_[i] : active_->header;
+}
+
+size_t TickStore::blockCount() const {
+    return index_.size() + (active_->header.count > 0 ? 1 : 0);
+}
+
+size_t TickStore::storedBytes() const {
+    size_t bytes = index_.size() * kBlockBytes;
+    if (active_->header.count > 0) {
+        bytes += sizeof(TickBlock) + (active_->header.bits + 7) / 8;
+    }
+    return bytes;
+}
+
+} // namespace trading
@@ -0,0 +1,120 @@
+#include "timing_wheel.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace trading {
+
+namespace {
+
+inline unsigned highestBit(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return static_cast<unsigned>(index);
+#else
+    return 63u - static_cast<unsigned>(__builtin_clzll(x));
+#endif
+}
+
+inline unsigned lowestBit(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+}
+
+} // namespace
+
+void TimingWheel::place(const Timer& timer) {
+    if (timer.deadline <= now_) {
+        due_.push_back(timer);
+        return;
+    }
+    // The deadline agrees with now_ above this level and is later in its
+    // digit, so slots past now_'s digit are in time order
+    const unsigned level = highestBit(timer.deadline ^ now_) / kSlotBits;
+    const unsigned slot = static_cast<unsigned>(timer.deadline >> (level * kSlotBits)) & (kSlots - 1);
+    slots_[level * kSlots + slot].push_back(timer);
+    occupied_[level] |= uint64_t{1} << slot;
+}
+
+void TimingWheel::schedule(uint64_t deadline, uint64_t id) {
+    if (slots_.empty()) {
+        slots_.resize(kLevels * kSlots);
+    }
+    place(Timer{deadline, id});
+    size_++;
+}
+
+size_t TimingWheel::advance(uint64_t now, std::vector<uint64_t>& expired) {
+    const size_t before = expired.size();
+    for (const auto& timer : due_) {
+        expired.push_back(timer.id);
+    }
+    due_.clear();
+
+    while (now > now_) {
+        // The lowest occupied level holds the earliest timers, its lowest slot first
+        size_t level = 0;
+        while (level < kLevels && occupied_[level] == 0) {
+            level++;
+        }
+        if (level == kLevels) {
+            break;
+        }
+        const unsigned shift = static_cast<unsigned>(level) * kSlotBits;
+        const unsigned slot = lowestBit(occupied_[level]);
+        const unsigned above = shift + kSlotBits;
+        const uint64_t prefix = above >= 64 ? 0 : (now_ >> above) << above;
+        const uint64_t start = prefix | (uint64_t{slot} << shift);
+        if (start > now) {
+            break;
+        }
+
+        // Step to the start of the slot and fire or re-place its timers
+        now_ = start;
+        occupied_[level] &= ~(uint64_t{1} << slot);
+        cascade_.swap(slots_[level * kSlots + slot]);
+        for (const auto& timer : cascade_) {
+            if (timer.deadline <= now) {
+                expired.push_back(timer.id);
+            } else {
+                place(timer);
+            }
+        }
+        cascade_.clear();
+    }
+    if (now > now_) {
+        now_ = now;
+    }
+
+    const size_t fired = expired.size() - before;
+    size_ -= fired;
+    return fired;
+}
+
+void TimingWheel::reset(uint64_t now) {
+    for (auto& slot : slots_) {
+        slot.clear();
+    }
+    occupied_.fill(0);
+    due_.clear();
+    now_ = now;
+    size_ = 0;
+}
+
+size_t TimingWheel::memoryBytes() const {
+    size_t bytes = sizeof(*this) + slots_.capacity() * sizeof(std::vector<Timer>)
+        + (due_.capacity() + cascade_.capacity()) * sizeof(Timer);
+    for (const auto& slot : slots_) {
+        bytes += slot.capacity() * sizeof(Timer);
+    }
+    return bytes;
+}
+
+} // namespace trading
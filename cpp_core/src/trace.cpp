@@ -0,0 +1,127 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace trading {
+namespace trace {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+/**
+ * @brief All rings ever created; rings outlive their threads so a dump
+ *        after a worker exits still sees its events
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceRing>> rings;
+
+    // Calibration anchor for TSC -> wall time conversion
+    uint64_t tsc_anchor = readTsc();
+    SteadyClock::time_point clock_anchor = SteadyClock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace
+
+void TraceRing::snapshot(std::vector<Record>& out) const {
+    uint64_t end = head_.load(std::memory_order_acquire);
+    uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+    size_t first = out.size();
+
+    for (uint64_t i = begin; i < end; ++i) {
+        out.push_back(records_[i & (kCapacity - 1)]);
+    }
+
+    // Anything the writer lapped while we were copying is torn; drop it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = head_.load(std::memory_order_acquire);
+    if (after > kCapacity && after - kCapacity > begin) {
+        uint64_t stale = std::min(after - kCapacity - begin, end - begin);
+        out.erase(out.begin() + first, out.begin() + first + static_cast<ptrdiff_t>(stale));
+    }
+}
+
+TraceRing& threadRing() {
+    thread_local std::shared_ptr<TraceRing> ring = [] {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto created = std::make_shared<TraceRing>(static_cast<uint32_t>(reg.rings.size() + 1));
+        reg.rings.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+std::vector<Record> collect() {
+    std::vector<Record> records;
+    auto& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& ring : reg.rings) {
+            ring->snapshot(records);
+        }
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const Record& x, const Record& y) { return x.tsc < y.tsc; });
+    return records;
+}
+
+void clear() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& ring : reg.rings) {
+        ring->clear();
+    }
+}
+
+double ticksPerMicrosecond() {
+    auto& reg = registry();
+
+    // Ensure a measurable interval since the anchor (at least 10 ms)
+    auto elapsed = SteadyClock::now() - reg.clock_anchor;
+    while (elapsed < std::chrono::milliseconds(10)) {
+        elapsed = SteadyClock::now() - reg.clock_anchor;
+    }
+    uint64_t ticks = readTsc() - reg.tsc_anchor;
+    double us = std::chrono::duration<double, std::micro>(elapsed).count();
+    return static_cast<double>(ticks) / us;
+}
+
+size_t dump(const std::string& path) {
+    std::vector<Record> records = collect();
+
+    FileHeader header;
+    std::memcpy(header.magic, "TRDTRACE", sizeof(header.magic));
+    header.version = kFileVersion;
+    header.record_size = sizeof(Record);
+    header.ticks_per_us = ticksPerMicrosecond();
+    header.tsc_base = records.empty() ? 0 : records.front().tsc;
+    header.count = records.size();
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file for writing: " + path);
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !records.empty()) {
+        ok = std::fwrite(records.data(), sizeof(Record), records.size(), file) == records.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        throw std::runtime_error("Failed to write trace file: " + path);
+    }
+    return records.size();
+}
+
+} // namespace trace
+} // namespace trading
@@ -0,0 +1,146 @@
+/**
+ * Convert an engine trace dump to Chrome trace JSON
+ *
+ *   trace_dump engine.trace [engine.json]
+ *
+ * Open the output in chrome://tracing or https://ui.perfetto.dev.
+ * matchOrders shows up as a duration slice per call; orders, cancels,
+ * trades and SMA updates are instant events with their fields as args.
+ */
+
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace trading::trace;
+
+namespace {
+
+const char* eventName(uint32_t type) {
+    switch (static_cast<EventType>(type)) {
+        case EventType::ORDER_ADD: return "add_order";
+        case EventType::ORDER_CANCEL: return "cancel_order";
+        case EventType::MATCH_BEGIN:
+        case EventType::MATCH_END: return "match_orders";
+        case EventType::TRADE: return "trade";
+        case EventType::SMA_UPDATE: return "sma_update";
+        case EventType::STOP_TRIGGER: return "stop_trigger";
+        case EventType::ORDER_EXPIRE: return "expire_order";
+    }
+    return "unknown";
+}
+
+void writeEvent(std::ostream& out, const Record& r, const FileHeader& header, bool first) {
+    double ts = static_cast<double>(r.tsc - header.tsc_base) / header.ticks_per_us;
+    auto type = static_cast<EventType>(r.type);
+
+    char buf[512];
+    const char* phase = type == EventType::MATCH_BEGIN ? "B"
+                      : type == EventType::MATCH_END ? "E" : "i";
+    int n = std::snprintf(buf, sizeof(buf),
+                          "%s{\"name\":\"%s\",\"cat\":\"engine\",\"ph\":\"%s\",\"ts\":%.3f,"
+                          "\"pid\":1,\"tid\":%u",
+                          first ? "" : ",\n", eventName(r.type), phase, ts, r.thread_id);
+    out.write(buf, n);
+
+    switch (type) {
+        case EventType::ORDER_ADD:
+        case EventType::STOP_TRIGGER:
+        case EventType::ORDER_EXPIRE:
+            n = std::snprintf(buf, sizeof(buf),
+                              ",\"s\":\"t\",\"args\":{\"order\":\"ORD%llu\",\"side\":\"%s\","
+                              "\"price\":%.8g,\"quantity\":%.8g}",
+                              static_cast<unsigned long long>(r.a), r.b ? "sell" : "buy",
+                              r.price, r.quantity);
+            break;
+        case EventType::ORDER_CANCEL:
+            n = std::snprintf(buf, sizeof(buf),
+                              ",\"s\":\"t\",\"args\":{\"order\":\"ORD%llu\",\"removed\":%s}",
+                              static_cast<unsigned long long>(r.a), r.b ? "true" : "false");
+            break;
+        case EventType::TRADE:
+            n = std::snprintf(buf, sizeof(buf),
+                              ",\"s\":\"t\",\"args\":{\"buy_order\":\"ORD%llu\","
+                              "\"sell_order\":\"ORD%llu\",\"price\":%.8g,\"quantity\":%.8g}",
+                              static_cast<unsigned long long>(r.a),
+                              static_cast<unsigned long long>(r.b), r.price, r.quantity);
+            break;
+        case EventType::SMA_UPDATE:
+            n = std::snprintf(buf, sizeof(buf),
+                              ",\"s\":\"t\",\"args\":{\"price\":%.8g,\"sma\":%.8g}",
+                              r.price, r.quantity);
+            break;
+        case EventType::MATCH_END:
+            n = std::snprintf(buf, sizeof(buf), ",\"args\":{\"trades\":%llu}",
+                              static_cast<unsigned long long>(r.b));
+            break;
+        default:
+            n = 0;
+            break;
+    }
+    out.write(buf, n);
+    out << '}';
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: trace_dump <trace file> [output.json]\n";
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: cannot open " << argv[1] << "\n";
+        return 1;
+    }
+
+    FileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, "TRDTRACE", sizeof(header.magic)) != 0) {
+        std::cerr << "Error: " << argv[1] << " is not an engine trace file\n";
+        return 1;
+    }
+    if (header.version != kFileVersion || header.record_size != sizeof(Record)) {
+        std::cerr << "Error: unsupported trace version " << header.version << "\n";
+        return 1;
+    }
+    if (header.ticks_per_us <= 0) {
+        header.ticks_per_us = 1000.0;  // Nanosecond timestamps
+    }
+
+    std::vector<Record> records(header.count);
+    if (!records.empty() && !in.read(reinterpret_cast<char*>(records.data()),
+                                     static_cast<std::streamsize>(records.size() * sizeof(Record)))) {
+        std::cerr << "Error: " << argv[1] << " is truncated\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if (argc == 3) {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "Error: cannot write " << argv[2] << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = argc == 3 ? file : std::cout;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& r : records) {
+        writeEvent(out, r, header, first);
+        first = false;
+    }
+    out << "\n]}\n";
+
+    if (argc == 3) {
+        std::cerr << "Wrote " << records.size() << " events to " << argv[2] << "\n";
+    }
+    return 0;
+}
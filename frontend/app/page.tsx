@@ -5,10 +5,19 @@ import { useWebSocket } from '@/hooks/useWebSocket';
 import PriceChart from '@/components/PriceChart';
 import OrderBook from '@/components/OrderBook';
 import TradingPanel from '@/components/TradingPanel';
-import { PricePoint, OrderBook as OrderBookType } from '@/types/api';
+import { PricePoint, OrderBook as OrderBookType, HistoryResponse } from '@/types/api';
 import styles from './page.module.css';
 
-const API_URL = process.env.NEXT_PUBLIC_API_URL;
+const API_URL = process.env.NEXT_PUBLIC_API_URL || 'http://localhost:8000';
+
+// Chart ranges beyond the live window come from the stored tick history,
+// downsampled server-side to about one point per chart pixel
+const HISTORY_RANGES: Record<string, number> = {
+    '1H': 60 * 60 * 1000,
+    '24H': 24 * 60 * 60 * 1000,
+    '30D': 30 * 24 * 60 * 60 * 1000,
+};
+const HISTORY_POINTS = 800;
 
 
 export default function Home() {
@@ -16,6 +25,31 @@ export default function Home() {
     const [priceHistory, setPriceHistory] = useState<PricePoint[]>([]);
     const [orderbook, setOrderbook] = useState<OrderBookType>({ bids: [], asks: [] });
     const [currentPrice, setCurrentPrice] = useState(0);
+    const [range, setRange] = useState<string>('Live');
+    const [history, setHistory] = useState<PricePoint[]>([]);
+
+    useEffect(() => {
+        if (range === 'Live') {
+            return;
+        }
+        const end = Date.now();
+        const params = new URLSearchParams({
+            start: String(end - HISTORY_RANGES[range]),
+            end: String(end),
+            points: String(HISTORY_POINTS),
+            method: 'minmax',
+        });
+        fetch(`${API_URL}/api/history?${params}`)
+            .then(response => response.json())
+            .then((result: HistoryResponse) => {
+                setHistory(result.timestamps.map((timestamp, i) => ({
+                    timestamp: timestamp / 1000,
+                    price: result.prices[i],
+                    sma: 0,
+                })));
+            })
+            .catch(() => setHistory([]));
+    }, [range]);
 
     useEffect(() => {
         if (data) {
@@ -85,6 +119,17 @@ export default function Home() {
                     <div className={styles.cardHeader}>
                         <h3>Market Price & SMA</h3>
                         <div className={styles.chartInfo}>
+                            <div className={styles.rangeButtons}>
+                                {['Live', ...Object.keys(HISTORY_RANGES)].map(r => (
+                                    <button
+                                        key={r}
+                                        className={`${styles.rangeButton} ${r === range ? styles.rangeButtonActive : ''}`}
+                                        onClick={() => setRange(r)}
+                                    >
+                                        {r}
+                                    </button>
+                                ))}
+                            </div>
                             <span className={styles.chartLegend}>
                                 <span style={{ color: '#3b82f6' }}>●</span> Real-time Price
                             </span>
@@ -93,7 +138,7 @@ export default function Home() {
                             </span>
                         </div>
                     </div>
-                    <PriceChart data={priceHistory} />
+                    <PriceChart data={range === 'Live' ? priceHistory : history} />
                 </div>
 
                 {/* Order Book */}
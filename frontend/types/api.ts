@@ -60,4 +60,11 @@ export interface PricePoint {
     sma: number;
 }
 
+export interface HistoryResponse {
+    method: 'minmax' | 'lttb';
+    total_ticks: number;
+    timestamps: number[];  // epoch milliseconds
+    prices: number[];
+}
+
 export type WebSocketMessage = MarketDataMessage | OrderEvent | TradeEvent;
@@ -0,0 +1,151 @@
+#include "alloc_tracking.hpp"
+#include "engine.hpp"
+#include <gtest/gtest.h>
+
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace trading;
+
+// Steady state: the book has already reached its working size once, so
+// every container has the capacity it needs. From then on the hot paths
+// must not touch the heap.
+
+namespace {
+
+void skipWithoutTracking() {
+  if (!alloc::enabled()) {
+    GTEST_SKIP() << "built without TRADING_ALLOC_TRACKING";
+  }
+}
+
+} // namespace
+
+// ==================== Allocation Tracking Tests ====================
+
+TEST(AllocTrackingTest, CountsHeapCalls) {
+  skipWithoutTracking();
+
+  alloc::Scope scope;
+  void* p = ::operator new(64);
+  ::operator delete(p);
+  auto delta = scope.delta();
+
+  EXPECT_EQ(delta.allocations, 1);
+  EXPECT_EQ(delta.deallocations, 1);
+  EXPECT_EQ(delta.bytes, 64);
+}
+
+TEST(AllocTrackingTest, AddAndCancelSteadyState) {
+  skipWithoutTracking();
+  OrderBook book;
+  std::vector<std::string> ids(8);
+
+  auto cycle = [&] {
+    for (size_t i = 0; i < ids.size(); i++) {
+      ids[i] = book.addOrder(i % 2 ? OrderSide::SELL : OrderSide::BUY,
+                             i % 2 ? 101.0 + i : 99.0 - i, 1.0);
+    }
+    for (const auto& id : ids) {
+      book.cancelOrder(id);
+    }
+  };
+  cycle();  // Warm up: level nodes, index nodes and buckets, spare levels
+
+  alloc::Scope scope;
+  for (int i = 0; i < 100; i++) {
+    cycle();
+  }
+  auto delta = scope.delta();
+
+  EXPECT_EQ(delta.allocations, 0);
+  EXPECT_EQ(delta.bytes, 0);
+}
+
+TEST(AllocTrackingTest, MatchSteadyState) {
+  skipWithoutTracking();
+  OrderBook book;
+  std::vector<Trade> trades;
+  trades.reserve(4);
+  book.addOrder(OrderSide::BUY, 99.0, 5.0);  // Resting depth that never trades
+
+  auto cycle = [&] {
+    book.addOrder(OrderSide::SELL, 100.0, 1.0);
+    book.addOrder(OrderSide::SELL, 100.0, 1.0);
+    book.addOrder(OrderSide::BUY, 100.0, 2.0);
+    return book.matchOrders(trades);
+  };
+  ASSERT_EQ(cycle(), 2);
+
+  alloc::Scope scope;
+  size_t matched = 0;
+  for (int i = 0; i < 100; i++) {
+    matched += cycle();
+  }
+  auto delta = scope.delta();
+
+  EXPECT_EQ(matched, 200);
+  EXPECT_EQ(delta.allocations, 0);
+}
+
+TEST(AllocTrackingTest, SnapshotIntoReusedVectors) {
+  skipWithoutTracking();
+  OrderBook book;
+  for (int i = 0; i < 10; i++) {
+    book.addOrder(OrderSide::BUY, 90.0 + i, 1.0);
+    book.addOrder(OrderSide::SELL, 110.0 + i, 1.0);
+  }
+  std::vector<std::pair<double, double>> bids;
+  std::vector<std::pair<double, double>> asks;
+  book.getBids(bids);
+  book.getAsks(asks);
+
+  alloc::Scope scope;
+  for (int i = 0; i < 100; i++) {
+    book.getBids(bids);
+    book.getAsks(asks);
+  }
+  auto delta = scope.delta();
+
+  EXPECT_EQ(bids.size(), 10);
+  EXPECT_EQ(asks.size(), 10);
+  EXPECT_EQ(delta.allocations, 0);
+}
+
+TEST(AllocTrackingTest, SMAUpdatesNeverAllocate) {
+  skipWithoutTracking();
+  SMACalculator sma(20);
+  sma.addPrice(1.0);
+
+  alloc::Scope scope;
+  double sum = 0.0;
+  for (int i = 0; i < 1000; i++) {
+    sma.addPrice(100.0 + i % 7);
+    sum += sma.getSMA();
+  }
+  auto delta = scope.delta();
+
+  EXPECT_GT(sum, 0.0);
+  EXPECT_EQ(delta.allocations, 0);
+}
+
+TEST(AllocTrackingTest, PriceHistoryNeverAllocates) {
+  skipWithoutTracking();
+  SMACalculator sma(20);
+  PriceHistory history(256);
+
+  // Wraps the ring several times and unwraps it in place
+  alloc::Scope scope;
+  for (int i = 0; i < 1000; i++) {
+    sma.addPrice(100.0 + i % 7, i, history);
+    if (i % 300 == 0) {
+      history.unwrap();
+    }
+  }
+  history.unwrap();
+  auto delta = scope.delta();
+
+  EXPECT_DOUBLE_EQ(history.timestamps()[0], 1000 - 256);
+  EXPECT_EQ(delta.allocations, 0);
+}
@@ -1,6 +1,10 @@
 #include "engine.hpp"
 #include <gtest/gtest.h>
 
+#include <map>
+#include <random>
+#include <set>
+
 
 using namespace trading;
 
@@ -71,6 +75,70 @@ TEST(SMACalculatorTest, NegativePriceTest) {
   EXPECT_THROW(sma.addPrice(-10.0), std::invalid_argument);
 }
 
+// ==================== PriceHistory Tests ====================
+
+TEST(PriceHistoryTest, InvalidCapacity) {
+  EXPECT_THROW(PriceHistory history(0), std::invalid_argument);
+}
+
+TEST(PriceHistoryTest, FillsInOrder) {
+  PriceHistory history(4);
+  history.push(1.0, 100.0);
+  history.push(2.0, 101.0);
+
+  EXPECT_EQ(history.size(), 2);
+  EXPECT_TRUE(history.contiguous());
+  EXPECT_DOUBLE_EQ(history.timestamps()[1], 2.0);
+  EXPECT_DOUBLE_EQ(history.prices()[0], 100.0);
+}
+
+TEST(PriceHistoryTest, UnwrapKeepsNewestOldestFirst) {
+  PriceHistory history(5);
+  const double* timestamps = history.timestamps();
+  for (int i = 1; i <= 12; i++) {
+    history.push(i, i * 10.0);
+  }
+  EXPECT_EQ(history.size(), 5);
+  EXPECT_FALSE(history.contiguous());
+
+  EXPECT_DOUBLE_EQ(history.last(), 120.0);
+
+  history.unwrap();
+  EXPECT_TRUE(history.contiguous());
+  // Same storage, rotated in place: samples 8..12
+  EXPECT_EQ(history.timestamps(), timestamps);
+  for (size_t i = 0; i < history.size(); i++) {
+    EXPECT_DOUBLE_EQ(history.timestamps()[i], 8.0 + i);
+    EXPECT_DOUBLE_EQ(history.prices()[i], 80.0 + 10.0 * i);
+  }
+
+  // Pushing after an unwrap continues from the oldest slot
+  history.push(13, 130.0);
+  history.unwrap();
+  EXPECT_DOUBLE_EQ(history.timestamps()[0], 9.0);
+  EXPECT_DOUBLE_EQ(history.prices()[4], 130.0);
+
+  history.clear();
+  EXPECT_TRUE(history.empty());
+  EXPECT_DOUBLE_EQ(history.last(), 0.0);
+  EXPECT_EQ(history.capacity(), 5);
+}
+
+TEST(PriceHistoryTest, FedBySMACalculator) {
+  SMACalculator sma(3);
+  PriceHistory history(10);
+  for (int i = 1; i <= 4; i++) {
+    sma.addPrice(i * 10.0, i, history);
+  }
+  EXPECT_DOUBLE_EQ(sma.getSMA(), 30.0);
+  EXPECT_EQ(history.size(), 4);
+  EXPECT_DOUBLE_EQ(history.prices()[3], 40.0);
+
+  // A rejected price is not recorded either
+  EXPECT_THROW(sma.addPrice(-1.0, 5.0, history), std::invalid_argument);
+  EXPECT_EQ(history.size(), 4);
+}
+
 // ==================== OrderBook Tests ====================
 
 TEST(OrderBookTest, InitializationTest) {
@@ -162,9 +230,15 @@ TEST(OrderBookTest, PriceTimePriorityTest) {
 
   auto trades = book.matchOrders();
 
-  // Should match with first sell order first (FIFO)
-  EXPECT_EQ(trades.size(), 1);
+  // Should match with first sell order first (FIFO), then the second
+  ASSERT_EQ(trades.size(), 2);
   EXPECT_DOUBLE_EQ(trades[0].quantity, 1.0);
+  EXPECT_DOUBLE_EQ(trades[1].quantity, 0.5);
+
+  // Second sell order keeps its remaining quantity
+  auto asks = book.getAsks();
+  ASSERT_EQ(asks.size(), 1);
+  EXPECT_DOUBLE_EQ(asks[0].second, 1.5);
 }
 
 TEST(OrderBookTest, MultipleMatchesTest) {
@@ -181,6 +255,87 @@ TEST(OrderBookTest, MultipleMatchesTest) {
   EXPECT_DOUBLE_EQ(trades[1].price, 45050.0);
 }
 
+TEST(OrderBookTest, CancelOrderTest) {
+  OrderBook book;
+  std::string first = book.addOrder(OrderSide::BUY, 45000.0, 1.0);
+  std::string second = book.addOrder(OrderSide::BUY, 45000.0, 2.0);
+
+  EXPECT_TRUE(book.cancelOrder(first));
+  auto bids = book.getBids();
+  ASSERT_EQ(bids.size(), 1);
+  EXPECT_DOUBLE_EQ(bids[0].second, 2.0);
+
+  // Cancelling again or cancelling an unknown ID is a no-op
+  EXPECT_FALSE(book.cancelOrder(first));
+  EXPECT_FALSE(book.cancelOrder("ORD999"));
+  EXPECT_FALSE(book.cancelOrder("bogus"));
+
+  // Only the canonical spelling of an ID matches
+  for (const char* id : {"ORD 2", "ORD+2", "ORD02", "ORD2 ", "ORD-2", "ORD2x", "ORD18446744073709551618"}) {
+    EXPECT_FALSE(book.cancelOrder(id)) << id;
+  }
+
+  // Removing the last order removes the level
+  EXPECT_TRUE(book.cancelOrder(second));
+  EXPECT_EQ(book.getBids().size(), 0);
+  EXPECT_DOUBLE_EQ(book.getBestBid(), 0.0);
+}
+
+TEST(OrderBookTest, CancelFilledOrderTest) {
+  OrderBook book;
+  std::string bid = book.addOrder(OrderSide::BUY, 45000.0, 1.0);
+  std::string ask = book.addOrder(OrderSide::SELL, 45000.0, 2.0);
+  book.matchOrders();
+
+  // Fully filled orders can no longer be cancelled; partial fills can
+  EXPECT_FALSE(book.cancelOrder(bid));
+  EXPECT_TRUE(book.cancelOrder(ask));
+  EXPECT_EQ(book.getAsks().size(), 0);
+}
+
+TEST(OrderBookTest, MemoryStatsTest) {
+  OrderBook book;
+  MemoryStats empty = book.memoryStats();
+  EXPECT_EQ(empty.resting_orders, 0);
+  EXPECT_EQ(empty.order_bytes, 0);
+  EXPECT_DOUBLE_EQ(empty.bytes_per_order, 0.0);
+  EXPECT_EQ(empty.total_bytes, empty.fixed_bytes + empty.index_bytes);
+
+  for (int i = 0; i < 10; i++) {
+    book.addOrder(OrderSide::BUY, 45000.0 - i, 1.0);
+    book.addOrder(OrderSide::BUY, 45000.0 - i, 1.0);
+  }
+  MemoryStats stats = book.memoryStats();
+  EXPECT_EQ(stats.resting_orders, 20);
+  EXPECT_EQ(stats.price_levels, 10);
+  EXPECT_EQ(stats.order_bytes, 20 * sizeof(Order));
+  EXPECT_GE(stats.pool_capacity, 20);
+  EXPECT_GT(stats.level_bytes, 0);
+  EXPECT_GT(stats.index_bytes, 0);
+  EXPECT_EQ(stats.total_bytes,
+            stats.level_bytes + stats.order_bytes + stats.id_string_bytes +
+                stats.index_bytes + stats.pool_bytes + stats.fixed_bytes);
+  EXPECT_DOUBLE_EQ(stats.bytes_per_order, stats.total_bytes / 20.0);
+
+  // High-water marks remember the peak after orders leave
+  book.addOrder(OrderSide::SELL, 44000.0, 20.0);
+  book.matchOrders();
+  stats = book.memoryStats();
+  EXPECT_EQ(stats.resting_orders, 0);
+  EXPECT_EQ(stats.high_water_orders, 21);
+  EXPECT_EQ(stats.high_water_levels, 11);
+
+  book.reset();
+  EXPECT_EQ(book.memoryStats().high_water_orders, 0);
+}
+
+TEST(SMACalculatorTest, MemoryBytesTest) {
+  SMACalculator small(10);
+  SMACalculator large(1000);
+  EXPECT_GE(small.memoryBytes(), 10 * sizeof(double));
+  EXPECT_EQ(large.memoryBytes() - small.memoryBytes(), 990 * sizeof(double));
+}
+
 TEST(OrderBookTest, ResetTest) {
   OrderBook book;
   book.addOrder(OrderSide::BUY, 45000.0, 1.0);
@@ -196,3 +351,861 @@ int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
 }
+
+// ==================== Call Auction Tests ====================
+
+TEST(AuctionTest, OrdersAccumulateInAuctionMode) {
+  OrderBook book;
+  book.setMode(TradingMode::AUCTION);
+  book.addOrder(OrderSide::BUY, 101.0, 2.0);
+  book.addOrder(OrderSide::SELL, 99.0, 1.0);
+
+  EXPECT_TRUE(book.matchOrders().empty());
+  EXPECT_GT(book.getBestBid(), book.getBestAsk());
+
+  book.setMode(TradingMode::CONTINUOUS);
+  EXPECT_EQ(book.matchOrders().size(), 1);
+}
+
+TEST(AuctionTest, UncrossMaximisesVolume) {
+  OrderBook book;
+  book.setMode(TradingMode::AUCTION);
+  book.addOrder(OrderSide::BUY, 102.0, 3.0);
+  book.addOrder(OrderSide::BUY, 101.0, 2.0);
+  book.addOrder(OrderSide::BUY, 100.0, 4.0);
+  book.addOrder(OrderSide::BUY, 99.0, 5.0);
+  book.addOrder(OrderSide::SELL, 98.0, 2.0);
+  book.addOrder(OrderSide::SELL, 99.0, 3.0);
+  book.addOrder(OrderSide::SELL, 100.0, 3.0);
+  book.addOrder(OrderSide::SELL, 101.0, 4.0);
+  book.addOrder(OrderSide::SELL, 103.0, 1.0);
+
+  // Executable volume by price: 98:2 99:5 100:8 101:5 102:3
+  AuctionResult indicative = book.indicativeAuction();
+  EXPECT_DOUBLE_EQ(indicative.price, 100.0);
+  EXPECT_DOUBLE_EQ(indicative.volume, 8.0);
+  EXPECT_DOUBLE_EQ(indicative.buy_surplus, 1.0);
+  EXPECT_EQ(indicative.price_levels, 8);
+
+  std::vector<Trade> trades;
+  EXPECT_DOUBLE_EQ(book.lastPrice(), 0.0);
+  AuctionResult result = book.uncross(trades);
+  EXPECT_DOUBLE_EQ(result.price, 100.0);
+  EXPECT_DOUBLE_EQ(book.lastPrice(), 100.0);
+  ASSERT_EQ(trades.size(), 4);
+  double volume = 0.0;
+  for (const auto& t : trades) {
+    EXPECT_DOUBLE_EQ(t.price, 100.0);
+    volume += t.quantity;
+  }
+  EXPECT_DOUBLE_EQ(volume, 8.0);
+  EXPECT_EQ(trades[0].buy_order_id, "ORD1");
+  EXPECT_EQ(trades[0].sell_order_id, "ORD5");
+
+  // The 100 bid is left with 1 of its 4; everything below 100 on the ask side is gone
+  auto bids = book.getBids();
+  ASSERT_EQ(bids.size(), 2);
+  EXPECT_DOUBLE_EQ(bids[0].first, 100.0);
+  EXPECT_DOUBLE_EQ(bids[0].second, 1.0);
+  EXPECT_DOUBLE_EQ(book.getBestAsk(), 101.0);
+  EXPECT_FALSE(book.cancelOrder("ORD1"));
+  EXPECT_TRUE(book.cancelOrder("ORD3"));
+  EXPECT_EQ(book.mode(), TradingMode::AUCTION);
+}
+
+TEST(AuctionTest, TieBreaking) {
+  std::vector<Trade> trades;
+
+  // Buyers left over at every best price: highest price
+  OrderBook buy_pressure;
+  buy_pressure.addOrder(OrderSide::BUY, 101.0, 10.0);
+  buy_pressure.addOrder(OrderSide::SELL, 99.0, 5.0);
+  EXPECT_DOUBLE_EQ(buy_pressure.indicativeAuction().price, 101.0);
+
+  OrderBook sell_pressure;
+  sell_pressure.addOrder(OrderSide::BUY, 101.0, 5.0);
+  sell_pressure.addOrder(OrderSide::SELL, 99.0, 10.0);
+  EXPECT_DOUBLE_EQ(sell_pressure.indicativeAuction().price, 99.0);
+
+  // Balanced: reference price clamped into the range, else its midpoint
+  OrderBook balanced;
+  balanced.addOrder(OrderSide::BUY, 101.0, 5.0);
+  balanced.addOrder(OrderSide::SELL, 99.0, 5.0);
+  EXPECT_DOUBLE_EQ(balanced.indicativeAuction().price, 100.0);
+  EXPECT_DOUBLE_EQ(balanced.indicativeAuction(100.5).price, 100.5);
+  EXPECT_DOUBLE_EQ(balanced.indicativeAuction(200.0).price, 101.0);
+  EXPECT_DOUBLE_EQ(balanced.uncross(trades, 99.5).volume, 5.0);
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_DOUBLE_EQ(trades[0].price, 99.5);
+}
+
+TEST(AuctionTest, UncrossFiresStopsOnceContinuous) {
+  // The auction trades at 100, where a buy stop waits
+  auto crossed = [](OrderBook& book) {
+    book.addOrder(OrderSide::BUY, 101.0, 2.0);
+    book.addOrder(OrderSide::SELL, 99.0, 2.0);
+    book.addOrder(OrderSide::SELL, 102.0, 3.0);
+    return book.addStopOrder(OrderSide::BUY, 100.0, 1.0);
+  };
+  std::vector<Trade> trades;
+
+  // Still in the auction: the stop waits for continuous trading
+  OrderBook auction;
+  auction.setMode(TradingMode::AUCTION);
+  crossed(auction);
+  EXPECT_DOUBLE_EQ(auction.uncross(trades).price, 100.0);
+  EXPECT_EQ(trades.size(), 1);
+  EXPECT_EQ(auction.stopOrders(), 1);
+  EXPECT_DOUBLE_EQ(auction.lastPrice(), 100.0);
+  auction.setMode(TradingMode::CONTINUOUS);
+  EXPECT_EQ(auction.processTick(100.0, trades), 1);
+  EXPECT_EQ(auction.stopOrders(), 0);
+
+  // Continuous: the stop fires with the auction and takes the 102 ask
+  OrderBook continuous;
+  const std::string stop = crossed(continuous);
+  AuctionResult result = continuous.uncross(trades);
+  EXPECT_DOUBLE_EQ(result.volume, 2.0);
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_DOUBLE_EQ(trades[0].price, 100.0);
+  EXPECT_EQ(trades[1].buy_order_id, stop);
+  EXPECT_DOUBLE_EQ(trades[1].price, 102.0);
+  EXPECT_DOUBLE_EQ(trades[1].quantity, 1.0);
+  EXPECT_EQ(continuous.stopOrders(), 0);
+  EXPECT_DOUBLE_EQ(continuous.lastPrice(), 102.0);
+  EXPECT_DOUBLE_EQ(continuous.getAsks()[0].second, 2.0);
+}
+
+TEST(AuctionTest, UncrossedBookDoesNothing) {
+  OrderBook book;
+  book.addOrder(OrderSide::BUY, 99.0, 1.0);
+  book.addOrder(OrderSide::SELL, 100.0, 1.0);
+
+  std::vector<Trade> trades;
+  AuctionResult result = book.uncross(trades);
+  EXPECT_DOUBLE_EQ(result.volume, 0.0);
+  EXPECT_DOUBLE_EQ(result.price, 0.0);
+  EXPECT_TRUE(trades.empty());
+  EXPECT_EQ(book.getBids().size(), 1);
+}
+
+TEST(AuctionTest, MatchesBruteForceOnRandomBooks) {
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> tick(-40, 40);
+  std::uniform_int_distribution<int> lots(1, 20);
+
+  for (int round = 0; round < 20; round++) {
+    OrderBook book;
+    book.setMode(TradingMode::AUCTION);
+    std::vector<std::pair<double, double>> buys, sells;
+    double total = 0.0;
+    for (int i = 0; i < 400; i++) {
+      double price = 1000.0 + 0.5 * tick(rng);
+      double quantity = 0.25 * lots(rng);
+      bool buy = i % 2 == 0;
+      book.addOrder(buy ? OrderSide::BUY : OrderSide::SELL, price, quantity);
+      (buy ? buys : sells).emplace_back(price, quantity);
+      total += quantity;
+    }
+
+    // Best volume over every order price
+    auto volumeAt = [&](double p) {
+      double demand = 0.0, supply = 0.0;
+      for (const auto& b : buys) demand += b.first >= p ? b.second : 0.0;
+      for (const auto& s : sells) supply += s.first <= p ? s.second : 0.0;
+      return std::min(demand, supply);
+    };
+    double best = 0.0;
+    for (const auto& order : buys) best = std::max(best, volumeAt(order.first));
+    for (const auto& order : sells) best = std::max(best, volumeAt(order.first));
+
+    std::vector<Trade> trades;
+    AuctionResult result = book.uncross(trades);
+    EXPECT_NEAR(result.volume, best, 1e-9);
+
+    double traded = 0.0;
+    for (const auto& t : trades) {
+      ASSERT_DOUBLE_EQ(t.price, result.price);
+      traded += t.quantity;
+    }
+    EXPECT_NEAR(traded, result.volume, 1e-9);
+
+    // Nothing crosses afterwards and no quantity was lost
+    if (!book.getBids().empty() && !book.getAsks().empty()) {
+      EXPECT_LT(book.getBestBid(), book.getBestAsk());
+    }
+    double resting = 0.0;
+    for (const auto& level : book.getBids()) resting += level.second;
+    for (const auto& level : book.getAsks()) resting += level.second;
+    EXPECT_NEAR(resting + 2 * traded, total, 1e-9);
+  }
+}
+
+// ==================== Batch Auction Tests ====================
+
+TEST(BatchAuctionTest, OrdersWaitForTheBatch) {
+  OrderBook book;
+  book.setMode(TradingMode::BATCH);
+  book.addOrder(OrderSide::BUY, 101.0, 1.0);
+  book.addOrder(OrderSide::SELL, 99.0, 1.0);
+
+  EXPECT_EQ(book.pendingOrders(), 2);
+  EXPECT_TRUE(book.getBids().empty());
+  EXPECT_TRUE(book.matchOrders().empty());
+
+  std::vector<Trade> trades;
+  AuctionResult result = book.clearBatch(trades);
+  EXPECT_DOUBLE_EQ(result.price, 100.0);
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].buy_order_id, "ORD1");
+  EXPECT_EQ(trades[0].sell_order_id, "ORD2");
+  EXPECT_DOUBLE_EQ(trades[0].price, 100.0);
+  EXPECT_DOUBLE_EQ(book.lastPrice(), 100.0);
+  EXPECT_EQ(book.pendingOrders(), 0);
+  EXPECT_TRUE(book.getBids().empty());
+  EXPECT_TRUE(book.getAsks().empty());
+}
+
+TEST(BatchAuctionTest, ClearingPriceFiresStopsOnceContinuous) {
+  auto crossed = [](OrderBook& book) {
+    book.addOrder(OrderSide::SELL, 102.0, 3.0);
+    const std::string stop = book.addStopOrder(OrderSide::BUY, 100.0, 1.0);
+    book.addOrder(OrderSide::BUY, 101.0, 2.0);
+    book.addOrder(OrderSide::SELL, 99.0, 2.0);
+    return stop;
+  };
+
+  // Batching: the clearing price is recorded, the stop waits
+  OrderBook batch;
+  batch.setMode(TradingMode::BATCH);
+  crossed(batch);
+  std::vector<BatchFill> fills;
+  EXPECT_DOUBLE_EQ(batch.clearBatch(fills).price, 100.0);
+  EXPECT_EQ(fills.size(), 1);
+  EXPECT_DOUBLE_EQ(batch.lastPrice(), 100.0);
+  EXPECT_EQ(batch.stopOrders(), 1);
+
+  // Clearing a crossed book in continuous mode fires it straight after
+  OrderBook continuous;
+  const std::string stop = crossed(continuous);
+  std::vector<Trade> trades;
+  EXPECT_DOUBLE_EQ(continuous.clearBatch(trades, BatchAllocation::TIME).price, 100.0);
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[1].buy_order_id, stop);
+  EXPECT_DOUBLE_EQ(trades[1].price, 102.0);
+  EXPECT_EQ(continuous.stopOrders(), 0);
+  EXPECT_DOUBLE_EQ(continuous.lastPrice(), 102.0);
+}
+
+TEST(BatchAuctionTest, MarginalLevelAllocation) {
+  for (auto allocation : {BatchAllocation::TIME, BatchAllocation::PRO_RATA}) {
+    OrderBook book;
+    book.setMode(TradingMode::BATCH);
+    book.addOrder(OrderSide::BUY, 100.0, 1.0);
+    book.addOrder(OrderSide::BUY, 100.0, 3.0);
+    book.addOrder(OrderSide::SELL, 100.0, 2.0);
+
+    std::vector<Trade> trades;
+    EXPECT_DOUBLE_EQ(book.clearBatch(trades, allocation).volume, 2.0);
+    ASSERT_EQ(trades.size(), 2);
+    if (allocation == BatchAllocation::TIME) {
+      EXPECT_DOUBLE_EQ(trades[0].quantity, 1.0);
+      EXPECT_DOUBLE_EQ(trades[1].quantity, 1.0);
+      EXPECT_FALSE(book.cancelOrder("ORD1"));
+    } else {
+      EXPECT_DOUBLE_EQ(trades[0].quantity, 0.5);
+      EXPECT_DOUBLE_EQ(trades[1].quantity, 1.5);
+      EXPECT_TRUE(book.cancelOrder("ORD1"));
+    }
+    EXPECT_EQ(trades[1].buy_order_id, "ORD2");
+  }
+}
+
+TEST(BatchAuctionTest, RestingOrdersTradeWithTheBatch) {
+  OrderBook book;
+  book.addOrder(OrderSide::SELL, 100.0, 1.0);
+  book.addOrder(OrderSide::BUY, 98.0, 1.0);
+  book.setMode(TradingMode::BATCH);
+  book.addOrder(OrderSide::SELL, 100.0, 1.0);
+  book.addOrder(OrderSide::BUY, 100.0, 1.0);
+
+  // The resting ask keeps time priority over the batch's ask at its price
+  std::vector<Trade> trades;
+  book.clearBatch(trades, BatchAllocation::TIME);
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].sell_order_id, "ORD1");
+  EXPECT_DOUBLE_EQ(trades[0].price, 100.0);
+
+  auto asks = book.getAsks();
+  ASSERT_EQ(asks.size(), 1);
+  EXPECT_DOUBLE_EQ(asks[0].second, 1.0);
+  EXPECT_TRUE(book.cancelOrder("ORD3"));
+  EXPECT_DOUBLE_EQ(book.getBestBid(), 98.0);
+}
+
+TEST(BatchAuctionTest, CancelAndRelease) {
+  OrderBook book;
+  book.setMode(TradingMode::BATCH);
+  book.addOrder(OrderSide::BUY, 101.0, 1.0);
+  book.addOrder(OrderSide::SELL, 99.0, 1.0);
+  book.addOrder(OrderSide::SELL, 99.5, 1.0);
+
+  EXPECT_TRUE(book.cancelOrder("ORD2"));
+  EXPECT_FALSE(book.cancelOrder("ORD2"));
+  EXPECT_EQ(book.pendingOrders(), 2);
+
+  // Leaving BATCH mode moves waiting orders into the book without trading
+  book.setMode(TradingMode::CONTINUOUS);
+  EXPECT_EQ(book.pendingOrders(), 0);
+  EXPECT_DOUBLE_EQ(book.getBestAsk(), 99.5);
+  auto trades = book.matchOrders();
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].sell_order_id, "ORD3");
+}
+
+TEST(BatchAuctionTest, TimeAllocationMatchesCallAuction) {
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<int> tick(-30, 30);
+  std::uniform_int_distribution<int> lots(1, 12);
+
+  for (int round = 0; round < 10; round++) {
+    OrderBook batch, call;
+    call.setMode(TradingMode::AUCTION);
+    for (int i = 0; i < 300; i++) {
+      // The first orders rest in the batch book before the batch opens
+      if (i == 50) batch.setMode(TradingMode::BATCH);
+      OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+      double price = 1000.0 + 0.5 * tick(rng) + (i < 50 ? (side == OrderSide::BUY ? -20.0 : 20.0) : 0.0);
+      double quantity = 0.5 * lots(rng);
+      batch.addOrder(side, price, quantity);
+      call.addOrder(side, price, quantity);
+    }
+
+    std::vector<Trade> batch_trades, call_trades;
+    AuctionResult b = batch.clearBatch(batch_trades, BatchAllocation::TIME);
+    AuctionResult c = call.uncross(call_trades);
+    EXPECT_DOUBLE_EQ(b.price, c.price);
+    EXPECT_DOUBLE_EQ(b.volume, c.volume);
+    EXPECT_EQ(batch_trades.size(), call_trades.size());
+    EXPECT_EQ(batch.getBids(), call.getBids());
+    EXPECT_EQ(batch.getAsks(), call.getAsks());
+  }
+}
+
+TEST(BatchAuctionTest, NumericFillsMatchTrades) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> tick(-20, 20);
+  std::uniform_int_distribution<int> lots(1, 9);
+
+  // Several batches in a row: what rests from one trades in the next
+  OrderBook numeric, named;
+  numeric.setMode(TradingMode::BATCH);
+  named.setMode(TradingMode::BATCH);
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 400; i++) {
+      OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+      double price = 500.0 + 0.25 * tick(rng);
+      double quantity = lots(rng);
+      numeric.addOrder(side, price, quantity);
+      named.addOrder(side, price, quantity);
+    }
+
+    std::vector<BatchFill> fills;
+    std::vector<Trade> trades;
+    AuctionResult n = numeric.clearBatch(fills);
+    AuctionResult t = named.clearBatch(trades);
+    EXPECT_DOUBLE_EQ(n.price, t.price);
+    ASSERT_EQ(fills.size(), trades.size());
+    for (size_t i = 0; i < fills.size(); i++) {
+      EXPECT_EQ("ORD" + std::to_string(fills[i].buy_seq), trades[i].buy_order_id);
+      EXPECT_EQ("ORD" + std::to_string(fills[i].sell_seq), trades[i].sell_order_id);
+      EXPECT_DOUBLE_EQ(fills[i].quantity, trades[i].quantity);
+    }
+    EXPECT_EQ(numeric.getBids(), named.getBids());
+    EXPECT_EQ(numeric.getAsks(), named.getAsks());
+    EXPECT_LT(numeric.getBestBid(), numeric.getBestAsk());
+  }
+}
+
+// ==================== Matching Policy Tests ====================
+
+namespace {
+
+// Quantity each sell order executed, by order ID
+std::map<std::string, double> soldBy(const std::vector<Trade>& trades) {
+  std::map<std::string, double> sold;
+  for (const auto& t : trades) sold[t.sell_order_id] += t.quantity;
+  return sold;
+}
+
+} // namespace
+
+TEST(MatchingPolicyTest, TradePriceRules) {
+  // The bid rests first, so it is the passive side
+  auto priceUnder = [](auto book) {
+    book.addOrder(OrderSide::BUY, 101.0, 1.0);
+    book.addOrder(OrderSide::SELL, 99.0, 1.0);
+    auto trades = book.matchOrders();
+    EXPECT_EQ(trades.size(), 1);
+    return trades.empty() ? 0.0 : trades[0].price;
+  };
+  EXPECT_DOUBLE_EQ(priceUnder(BasicOrderBook<FifoMatching<TradePrice::ASK>>()), 99.0);
+  EXPECT_DOUBLE_EQ(priceUnder(BasicOrderBook<FifoMatching<TradePrice::PASSIVE>>()), 101.0);
+  EXPECT_DOUBLE_EQ(priceUnder(BasicOrderBook<FifoMatching<TradePrice::MIDPOINT>>()), 100.0);
+  EXPECT_DOUBLE_EQ(priceUnder(BasicOrderBook<ProRataMatching<TradePrice::PASSIVE>>()), 101.0);
+}
+
+TEST(MatchingPolicyTest, ProRataSharesTheLargerLevel) {
+  ProRataOrderBook book;
+  book.addOrder(OrderSide::SELL, 100.0, 1.0);
+  book.addOrder(OrderSide::SELL, 100.0, 3.0);
+  book.addOrder(OrderSide::SELL, 100.0, 6.0);
+  book.addOrder(OrderSide::BUY, 100.0, 5.0);
+
+  auto sold = soldBy(book.matchOrders());
+  EXPECT_DOUBLE_EQ(sold["ORD1"], 0.5);
+  EXPECT_DOUBLE_EQ(sold["ORD2"], 1.5);
+  EXPECT_DOUBLE_EQ(sold["ORD3"], 3.0);
+  EXPECT_EQ(book.getBids().size(), 0);
+  ASSERT_EQ(book.getAsks().size(), 1);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 5.0);
+
+  // FIFO fills the same level in time order
+  OrderBook fifo;
+  fifo.addOrder(OrderSide::SELL, 100.0, 1.0);
+  fifo.addOrder(OrderSide::SELL, 100.0, 3.0);
+  fifo.addOrder(OrderSide::SELL, 100.0, 6.0);
+  fifo.addOrder(OrderSide::BUY, 100.0, 5.0);
+  sold = soldBy(fifo.matchOrders());
+  EXPECT_DOUBLE_EQ(sold["ORD1"], 1.0);
+  EXPECT_DOUBLE_EQ(sold["ORD2"], 3.0);
+  EXPECT_DOUBLE_EQ(sold["ORD3"], 1.0);
+}
+
+TEST(MatchingPolicyTest, ProRataDustNeverOverfills) {
+  // Sevenths add up to 14 only after rounding: the shares fall a little
+  // short of the buys, and the dust must go to an ask with quantity left
+  ProRataOrderBook book;
+  const double sizes[] = {36.0 / 7, 31.0 / 7, 31.0 / 7};
+  for (double size : sizes) {
+    book.addOrder(OrderSide::SELL, 100.0, size);
+  }
+  for (double size : {6.0, 5.0, 3.0}) {
+    book.addOrder(OrderSide::BUY, 100.0, size);
+  }
+
+  const auto trades = book.matchOrders();
+  auto sold = soldBy(trades);
+  double volume = 0.0;
+  for (const auto& trade : trades) {
+    EXPECT_GT(trade.quantity, 0.0);
+    volume += trade.quantity;
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_LE(sold["ORD" + std::to_string(i + 1)], sizes[i]);
+  }
+  EXPECT_NEAR(volume, 14.0, 1e-12);
+  EXPECT_TRUE(book.getBids().empty());
+  for (const auto& level : book.getAsks()) {
+    EXPECT_GE(level.second, 0.0);
+  }
+}
+
+TEST(MatchingPolicyTest, TopOrderFillsFirst) {
+  TopOrderProRataOrderBook book;
+  book.addOrder(OrderSide::SELL, 100.0, 2.0);
+  book.addOrder(OrderSide::SELL, 100.0, 4.0);
+  book.addOrder(OrderSide::SELL, 100.0, 12.0);
+  book.addOrder(OrderSide::BUY, 100.0, 6.0);
+
+  auto sold = soldBy(book.matchOrders());
+  EXPECT_DOUBLE_EQ(sold["ORD1"], 2.0);
+  EXPECT_DOUBLE_EQ(sold["ORD2"], 1.0);
+  EXPECT_DOUBLE_EQ(sold["ORD3"], 3.0);
+  EXPECT_FALSE(book.cancelOrder("ORD1"));
+  EXPECT_TRUE(book.cancelOrder("ORD2"));
+}
+
+TEST(MatchingPolicyTest, PoliciesTradeTheSameVolume) {
+  std::mt19937 rng(21);
+  std::uniform_int_distribution<int> tick(-10, 10);
+  std::uniform_int_distribution<int> lots(1, 9);
+
+  for (int round = 0; round < 20; round++) {
+    OrderBook fifo;
+    ProRataOrderBook pro_rata;
+    TopOrderProRataOrderBook top_order;
+    double volume[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < 400; i++) {
+      OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+      double price = 1000.0 + 0.5 * tick(rng);
+      double quantity = 0.25 * lots(rng);
+      fifo.addOrder(side, price, quantity);
+      pro_rata.addOrder(side, price, quantity);
+      top_order.addOrder(side, price, quantity);
+      if (i % 7 == 6 || i == 399) {
+        for (const auto& t : fifo.matchOrders()) volume[0] += t.quantity;
+        for (const auto& t : pro_rata.matchOrders()) volume[1] += t.quantity;
+        for (const auto& t : top_order.matchOrders()) volume[2] += t.quantity;
+      }
+    }
+
+    // Allocation differs, but each level pair trades the smaller level
+    EXPECT_NEAR(volume[1], volume[0], 1e-9);
+    EXPECT_NEAR(volume[2], volume[0], 1e-9);
+    for (auto levels : {pro_rata.getBids(), pro_rata.getAsks(), top_order.getBids(), top_order.getAsks()}) {
+      for (const auto& level : levels) EXPECT_GT(level.second, 0.0);
+    }
+    EXPECT_LT(pro_rata.getBestBid(), pro_rata.getBestAsk());
+    EXPECT_LT(top_order.getBestBid(), top_order.getBestAsk());
+  }
+}
+
+// ==================== Stop Order Tests ====================
+
+TEST(StopOrderTest, StopFiresOnTick) {
+  OrderBook book;
+  book.addOrder(OrderSide::SELL, 101.0, 2.0);
+  book.addOrder(OrderSide::SELL, 102.0, 2.0);
+  std::string stop = book.addStopOrder(OrderSide::BUY, 100.5, 3.0);
+  EXPECT_EQ(book.stopOrders(), 1);
+  EXPECT_EQ(book.getBids().size(), 0);
+
+  std::vector<Trade> trades;
+  EXPECT_EQ(book.processTick(100.0, trades), 0);
+  EXPECT_EQ(book.stopOrders(), 1);
+
+  // Sweeps the asks like a market order
+  ASSERT_EQ(book.processTick(100.5, trades), 2);
+  EXPECT_EQ(trades[0].buy_order_id, stop);
+  EXPECT_DOUBLE_EQ(trades[0].price, 101.0);
+  EXPECT_DOUBLE_EQ(trades[0].quantity, 2.0);
+  EXPECT_DOUBLE_EQ(trades[1].price, 102.0);
+  EXPECT_DOUBLE_EQ(trades[1].quantity, 1.0);
+  EXPECT_DOUBLE_EQ(book.lastPrice(), 102.0);
+  EXPECT_EQ(book.stopOrders(), 0);
+  EXPECT_FALSE(book.cancelOrder(stop));
+  ASSERT_EQ(book.getAsks().size(), 1);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 1.0);
+}
+
+TEST(StopOrderTest, StopLimitRestsRemainder) {
+  OrderBook book;
+  book.addOrder(OrderSide::BUY, 99.0, 1.0);
+  book.addOrder(OrderSide::BUY, 98.0, 1.0);
+  std::string stop = book.addStopOrder(OrderSide::SELL, 99.5, 3.0, 98.5);
+
+  std::vector<Trade> trades;
+  ASSERT_EQ(book.processTick(99.5, trades), 1);
+  EXPECT_EQ(trades[0].sell_order_id, stop);
+  EXPECT_DOUBLE_EQ(trades[0].price, 98.5);  // OrderBook trades at the ask
+  EXPECT_DOUBLE_EQ(trades[0].quantity, 1.0);
+
+  // The 98 bid is past the limit; the rest joins the book
+  ASSERT_EQ(book.getAsks().size(), 1);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].first, 98.5);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 2.0);
+  EXPECT_DOUBLE_EQ(book.getBestBid(), 98.0);
+  EXPECT_TRUE(book.cancelOrder(stop));
+  EXPECT_EQ(book.getAsks().size(), 0);
+}
+
+TEST(StopOrderTest, FiredStopTakesTheRestingPrice) {
+  BasicOrderBook<FifoMatching<TradePrice::PASSIVE>> passive;
+  passive.addStopOrder(OrderSide::BUY, 100.0, 1.0, 105.0);  // Older than the ask
+  passive.addOrder(OrderSide::SELL, 101.0, 1.0);
+  std::vector<Trade> trades;
+  ASSERT_EQ(passive.processTick(100.0, trades), 1);
+  EXPECT_DOUBLE_EQ(trades[0].price, 101.0);
+
+  BasicOrderBook<FifoMatching<TradePrice::MIDPOINT>> midpoint;
+  midpoint.addStopOrder(OrderSide::BUY, 100.0, 1.0);
+  midpoint.addOrder(OrderSide::SELL, 101.0, 1.0);
+  ASSERT_EQ(midpoint.processTick(100.0, trades), 1);
+  EXPECT_DOUBLE_EQ(trades[0].price, 101.0);
+}
+
+TEST(StopOrderTest, CascadeFiresIteratively) {
+  OrderBook book;
+  for (double price : {101.0, 102.0, 103.0}) {
+    book.addOrder(OrderSide::SELL, price, 1.0);
+  }
+  book.addOrder(OrderSide::SELL, 104.0, 5.0);
+  book.addStopOrder(OrderSide::BUY, 101.0, 2.0);
+  book.addStopOrder(OrderSide::BUY, 102.0, 1.0);
+  book.addStopOrder(OrderSide::BUY, 103.0, 1.0);
+  book.addStopOrder(OrderSide::BUY, 110.0, 1.0);
+
+  // 101 fires the first stop, whose 102 print fires the second, and so on
+  std::vector<Trade> trades;
+  ASSERT_EQ(book.processTick(101.0, trades), 4);
+  const double expected[] = {101.0, 102.0, 103.0, 104.0};
+  for (size_t i = 0; i < 4; i++) EXPECT_DOUBLE_EQ(trades[i].price, expected[i]);
+  EXPECT_DOUBLE_EQ(book.lastPrice(), 104.0);
+  EXPECT_EQ(book.stopOrders(), 1);
+
+  // Trades from matchOrders move the price too
+  OrderBook falling;
+  falling.addOrder(OrderSide::BUY, 99.0, 1.0);
+  falling.addOrder(OrderSide::BUY, 98.0, 1.0);
+  falling.addStopOrder(OrderSide::SELL, 99.0, 1.0);
+  falling.addOrder(OrderSide::SELL, 99.0, 1.0);
+  auto fills = falling.matchOrders();
+  ASSERT_EQ(fills.size(), 2);
+  EXPECT_DOUBLE_EQ(fills[1].price, 98.0);
+  EXPECT_DOUBLE_EQ(falling.lastPrice(), 98.0);
+  EXPECT_EQ(falling.getBids().size(), 0);
+}
+
+TEST(StopOrderTest, CancelRejectAndModes) {
+  OrderBook book;
+  book.addOrder(OrderSide::SELL, 101.0, 1.0);
+  std::string stop = book.addStopOrder(OrderSide::BUY, 100.0, 1.0);
+  book.addStopOrder(OrderSide::BUY, 100.0, 1.0, 101.0);
+  EXPECT_EQ(book.memoryStats().stop_orders, 2);
+  EXPECT_EQ(book.memoryStats().resting_orders, 1);
+  EXPECT_TRUE(book.cancelOrder(stop));
+  EXPECT_FALSE(book.cancelOrder(stop));
+  EXPECT_EQ(book.stopOrders(), 1);
+
+  EXPECT_THROW(book.addStopOrder(OrderSide::BUY, 0.0, 1.0), std::invalid_argument);
+  EXPECT_THROW(book.addStopOrder(OrderSide::BUY, 100.0, 0.0), std::invalid_argument);
+  EXPECT_THROW(book.addStopOrder(OrderSide::BUY, 100.0, 1.0, -1.0), std::invalid_argument);
+
+  // Stops wait out an auction
+  std::vector<Trade> trades;
+  book.setMode(TradingMode::AUCTION);
+  EXPECT_EQ(book.processTick(100.0, trades), 0);
+  EXPECT_EQ(book.stopOrders(), 1);
+  book.setMode(TradingMode::CONTINUOUS);
+  EXPECT_EQ(book.processTick(100.0, trades), 1);
+
+  book.addStopOrder(OrderSide::SELL, 90.0, 1.0);
+  book.reset();
+  EXPECT_EQ(book.stopOrders(), 0);
+  EXPECT_DOUBLE_EQ(book.lastPrice(), 0.0);
+}
+
+// ==================== Good-Till Order Tests ====================
+
+TEST(GoodTillOrderTest, ExpiresOnTheEngineClock) {
+  OrderBook book;
+  book.advanceTime(1000);
+  std::string gtt = book.addOrderGoodTill(OrderSide::BUY, 100.0, 1.5, 1500);
+  book.addOrder(OrderSide::BUY, 99.0, 1.0);
+  EXPECT_THROW(book.addOrderGoodTill(OrderSide::BUY, 100.0, 1.0, 1000), std::invalid_argument);
+
+  EXPECT_EQ(book.advanceTime(1499), 0);
+  EXPECT_EQ(book.getBids().size(), 2);
+  EXPECT_EQ(book.advanceTime(1500), 1);
+  EXPECT_EQ(book.clockMillis(), 1500);
+  ASSERT_EQ(book.getBids().size(), 1);
+  EXPECT_DOUBLE_EQ(book.getBestBid(), 99.0);
+  EXPECT_FALSE(book.cancelOrder(gtt));
+
+  std::vector<ExpiredOrder> expired;
+  ASSERT_EQ(book.takeExpired(expired), 1);
+  EXPECT_EQ(expired[0].order_id, gtt);
+  EXPECT_EQ(expired[0].side, OrderSide::BUY);
+  EXPECT_DOUBLE_EQ(expired[0].price, 100.0);
+  EXPECT_DOUBLE_EQ(expired[0].quantity, 1.5);
+  EXPECT_EQ(book.takeExpired(expired), 0);
+}
+
+TEST(GoodTillOrderTest, OnlyOpenQuantityExpires) {
+  OrderBook book;
+  book.addOrderGoodTill(OrderSide::SELL, 101.0, 1.0, 2000);
+  std::string partial = book.addOrderGoodTill(OrderSide::SELL, 102.0, 2.0, 2000);
+  std::string cancelled = book.addOrderGoodTill(OrderSide::SELL, 103.0, 1.0, 2000);
+  book.addOrder(OrderSide::BUY, 102.0, 1.5);
+  EXPECT_EQ(book.matchOrders().size(), 2);
+  EXPECT_TRUE(book.cancelOrder(cancelled));
+
+  // The filled and cancelled orders are dropped quietly
+  EXPECT_EQ(book.advanceTime(5000), 1);
+  std::vector<ExpiredOrder> expired;
+  ASSERT_EQ(book.takeExpired(expired), 1);
+  EXPECT_EQ(expired[0].order_id, partial);
+  EXPECT_DOUBLE_EQ(expired[0].quantity, 1.5);
+  EXPECT_EQ(book.getAsks().size(), 0);
+}
+
+TEST(GoodTillOrderTest, GoodForTicks) {
+  OrderBook book;
+  std::string quote = book.addOrderGoodForTicks(OrderSide::BUY, 99.0, 1.0, 2);
+  EXPECT_THROW(book.addOrderGoodForTicks(OrderSide::BUY, 99.0, 1.0, 0), std::invalid_argument);
+
+  std::vector<Trade> trades;
+  book.processTick(100.0, trades);
+  EXPECT_EQ(book.getBids().size(), 1);
+  book.processTick(100.0, trades);
+  EXPECT_EQ(book.ticks(), 2);
+  EXPECT_EQ(book.getBids().size(), 0);
+
+  // Orders waiting for a batch expire too
+  book.setMode(TradingMode::BATCH);
+  book.addOrderGoodForTicks(OrderSide::SELL, 101.0, 1.0, 1);
+  EXPECT_EQ(book.pendingOrders(), 1);
+  book.processTick(100.0, trades);
+  EXPECT_EQ(book.pendingOrders(), 0);
+
+  std::vector<ExpiredOrder> expired;
+  ASSERT_EQ(book.takeExpired(expired), 2);
+  EXPECT_EQ(expired[0].order_id, quote);
+  EXPECT_EQ(expired[1].side, OrderSide::SELL);
+}
+
+TEST(GoodTillOrderTest, ManyShortLivedQuotes) {
+  std::mt19937 rng(4);
+  std::uniform_int_distribution<int> life(1, 500);
+  std::uniform_int_distribution<int> tick(1, 20);
+
+  OrderBook book;
+  long long now = 1717200000000;
+  book.advanceTime(now);
+  std::multiset<long long> alive;
+  std::vector<ExpiredOrder> expired;
+  for (int step = 0; step < 200; step++) {
+    for (int i = 0; i < 50; i++) {
+      long long expiry = now + life(rng);
+      book.addOrderGoodTill(i % 2 ? OrderSide::BUY : OrderSide::SELL,
+                            i % 2 ? 99.0 - tick(rng) : 101.0 + tick(rng), 1.0, expiry);
+      alive.insert(expiry);
+    }
+    now += 37;
+    size_t due = std::distance(alive.begin(), alive.upper_bound(now));
+    alive.erase(alive.begin(), alive.upper_bound(now));
+    ASSERT_EQ(book.advanceTime(now), due);
+    ASSERT_EQ(book.memoryStats().resting_orders, alive.size());
+  }
+  book.takeExpired(expired);
+  EXPECT_EQ(expired.size() + alive.size(), 200 * 50);
+
+  book.reset();
+  EXPECT_EQ(book.clockMillis(), 0);
+  EXPECT_EQ(book.ticks(), 0);
+}
+
+// ==================== Iceberg Order Tests ====================
+
+TEST(IcebergOrderTest, ShowsOneTrancheAndRequeues) {
+  OrderBook book;
+  std::string iceberg = book.addIcebergOrder(OrderSide::SELL, 100.0, 10.0, 35.0);
+  std::string plain = book.addOrder(OrderSide::SELL, 100.0, 5.0);
+  ASSERT_EQ(book.getAsks().size(), 1);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 15.0);
+  EXPECT_EQ(book.icebergOrders(), 1);
+
+  // The first tranche fills and the refill queues behind the plain order
+  book.addOrder(OrderSide::BUY, 100.0, 12.0);
+  std::vector<Trade> trades;
+  ASSERT_EQ(book.matchOrders(trades), 2);
+  EXPECT_EQ(trades[0].sell_order_id, iceberg);
+  EXPECT_DOUBLE_EQ(trades[0].quantity, 10.0);
+  EXPECT_EQ(trades[1].sell_order_id, plain);
+  EXPECT_DOUBLE_EQ(trades[1].quantity, 2.0);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 13.0);
+
+  // One sweep works through the rest of the reserve, the last tranche partial
+  book.addOrder(OrderSide::BUY, 100.0, 30.0);
+  ASSERT_EQ(book.matchOrders(trades), 4);
+  double from_iceberg = 0.0;
+  for (const auto& trade : trades) {
+    if (trade.sell_order_id == iceberg) from_iceberg += trade.quantity;
+  }
+  EXPECT_DOUBLE_EQ(from_iceberg, 25.0);
+  EXPECT_TRUE(book.getAsks().empty());
+  EXPECT_DOUBLE_EQ(book.getBids()[0].second, 2.0);
+  EXPECT_EQ(book.icebergOrders(), 0);
+  EXPECT_EQ(book.memoryStats().resting_orders, 1);
+}
+
+TEST(IcebergOrderTest, RefillsRotateThroughADeepLevel) {
+  OrderBook book;
+  std::vector<std::string> icebergs;
+  for (int i = 0; i < 8; ++i) {
+    icebergs.push_back(book.addIcebergOrder(OrderSide::SELL, 100.0, 1.0, 1000.0));
+  }
+
+  // Three tranches per buy: the level turns over many times, always in the
+  // order the refills were queued, and a cancel in the middle keeps it
+  std::vector<Trade> trades;
+  size_t next = 0;
+  for (int round = 0; round < 50; ++round) {
+    if (round == 20) {
+      const size_t gone = (next + 4) % icebergs.size();
+      ASSERT_TRUE(book.cancelOrder(icebergs[gone]));
+      icebergs.erase(icebergs.begin() + static_cast<long>(gone));
+      if (gone < next) --next;
+    }
+    book.addOrder(OrderSide::BUY, 100.0, 3.0);
+    ASSERT_EQ(book.matchOrders(trades), 3);
+    const auto& refills = book.lastRefills();
+    ASSERT_EQ(refills.size(), 3);
+    for (size_t i = 0; i < trades.size(); ++i) {
+      EXPECT_EQ(trades[i].sell_order_id, icebergs[next]);
+      EXPECT_EQ("ORD" + std::to_string(refills[i].seq), icebergs[next]);
+      EXPECT_DOUBLE_EQ(refills[i].quantity, 1.0);
+      next = (next + 1) % icebergs.size();
+    }
+  }
+  const auto* queue = book.ordersAt(OrderSide::SELL, 100.0);
+  ASSERT_NE(queue, nullptr);
+  EXPECT_EQ(queue->size(), 7);
+  EXPECT_EQ(queue->front().id, icebergs[next]);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 7.0);
+}
+
+TEST(IcebergOrderTest, CancelTakesTheReserve) {
+  OrderBook book;
+  EXPECT_THROW(book.addIcebergOrder(OrderSide::BUY, 100.0, 0.0, 10.0), std::invalid_argument);
+  EXPECT_THROW(book.addIcebergOrder(OrderSide::BUY, 100.0, 10.0, 5.0), std::invalid_argument);
+
+  // Display equal to the total is just a limit order
+  book.addIcebergOrder(OrderSide::BUY, 99.0, 5.0, 5.0);
+  EXPECT_EQ(book.icebergOrders(), 0);
+
+  std::string id = book.addIcebergOrder(OrderSide::BUY, 100.0, 2.0, 9.0);
+  EXPECT_EQ(book.icebergOrders(), 1);
+  EXPECT_TRUE(book.cancelOrder(id));
+  EXPECT_EQ(book.icebergOrders(), 0);
+  EXPECT_FALSE(book.cancelOrder(id));
+  EXPECT_EQ(book.getBids().size(), 1);
+}
+
+TEST(IcebergOrderTest, AuctionsSeeOnlyTheDisplayedTranche) {
+  OrderBook book;
+  book.setMode(TradingMode::AUCTION);
+  std::string iceberg = book.addIcebergOrder(OrderSide::SELL, 100.0, 5.0, 20.0);
+  book.addOrder(OrderSide::BUY, 101.0, 12.0);
+  std::vector<Trade> trades;
+  AuctionResult result = book.uncross(trades);
+  EXPECT_DOUBLE_EQ(result.volume, 5.0);
+  ASSERT_EQ(book.getAsks().size(), 1);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 5.0);
+  EXPECT_EQ(book.icebergOrders(), 1);
+  // The refill is left crossing the rest of the bid, for continuous matching
+  EXPECT_DOUBLE_EQ(book.indicativeAuction().volume, 5.0);
+  EXPECT_DOUBLE_EQ(book.getBids()[0].second, 7.0);
+
+  // Batch clears refill the same way
+  book.reset();
+  book.setMode(TradingMode::BATCH);
+  iceberg = book.addIcebergOrder(OrderSide::SELL, 100.0, 5.0, 12.0);
+  book.addOrder(OrderSide::BUY, 100.0, 8.0);
+  result = book.clearBatch(trades, BatchAllocation::TIME);
+  EXPECT_DOUBLE_EQ(result.volume, 5.0);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 5.0);
+  EXPECT_DOUBLE_EQ(book.getBids()[0].second, 3.0);
+
+  book.setMode(TradingMode::CONTINUOUS);
+  ASSERT_EQ(book.matchOrders(trades), 1);
+  EXPECT_DOUBLE_EQ(trades[0].quantity, 3.0);
+  EXPECT_DOUBLE_EQ(book.getAsks()[0].second, 2.0);
+  EXPECT_EQ(book.icebergOrders(), 1);
+
+  book.addOrder(OrderSide::BUY, 100.0, 4.0);
+  ASSERT_EQ(book.matchOrders(trades), 2);
+  EXPECT_TRUE(book.getAsks().empty());
+  EXPECT_EQ(book.icebergOrders(), 0);
+}
@@ -0,0 +1,109 @@
+#include "engine.hpp"
+#include "latency_histogram.hpp"
+#include <gtest/gtest.h>
+
+using namespace trading;
+
+// ==================== LatencyHistogram Tests ====================
+
+TEST(LatencyHistogramTest, EmptyHistogram) {
+  LatencyHistogram hist;
+  EXPECT_EQ(hist.count(), 0);
+  EXPECT_EQ(hist.min(), 0);
+  EXPECT_EQ(hist.max(), 0);
+  EXPECT_EQ(hist.percentile(50.0), 0);
+  EXPECT_DOUBLE_EQ(hist.mean(), 0.0);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram hist;
+  for (uint64_t v = 1; v <= 10; v++) {
+    hist.record(v);
+  }
+
+  EXPECT_EQ(hist.count(), 10);
+  EXPECT_EQ(hist.min(), 1);
+  EXPECT_EQ(hist.max(), 10);
+  EXPECT_EQ(hist.percentile(50.0), 5);
+  EXPECT_DOUBLE_EQ(hist.mean(), 5.5);
+}
+
+TEST(LatencyHistogramTest, BucketBoundsAreMonotonic) {
+  for (size_t i = 1; i < LatencyHistogram::kBucketCount; i++) {
+    EXPECT_LT(LatencyHistogram::bucketLowerBound(i - 1),
+              LatencyHistogram::bucketLowerBound(i));
+  }
+  // Every value maps to the bucket whose lower bound does not exceed it
+  for (uint64_t v : {31ull, 32ull, 33ull, 1000ull, 123456ull, 999999999ull}) {
+    size_t index = LatencyHistogram::bucketIndex(v);
+    EXPECT_LE(LatencyHistogram::bucketLowerBound(index), v);
+    EXPECT_GT(LatencyHistogram::bucketLowerBound(index + 1), v);
+  }
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinRelativeError) {
+  LatencyHistogram hist;
+  for (uint64_t v = 1; v <= 100000; v++) {
+    hist.record(v * 10);
+  }
+
+  EXPECT_NEAR(hist.percentile(50.0), 500000.0, 500000.0 * 0.04);
+  EXPECT_NEAR(hist.percentile(99.0), 990000.0, 990000.0 * 0.04);
+  EXPECT_NEAR(hist.percentile(99.9), 999000.0, 999000.0 * 0.04);
+  EXPECT_EQ(hist.percentile(100.0), 1000000);
+}
+
+TEST(LatencyHistogramTest, ClampsHugeValues) {
+  LatencyHistogram hist;
+  hist.record(~0ull);
+  EXPECT_EQ(hist.max(), LatencyHistogram::kMaxTrackable);
+  EXPECT_EQ(hist.percentile(99.0), LatencyHistogram::kMaxTrackable);
+}
+
+TEST(LatencyHistogramTest, MergeAndReset) {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  a.record(10);
+  b.record(1000);
+  b.record(2000);
+
+  a.merge(b);
+  EXPECT_EQ(a.count(), 3);
+  EXPECT_EQ(a.min(), 10);
+  EXPECT_EQ(a.max(), 2000);
+
+  a.reset();
+  EXPECT_EQ(a.count(), 0);
+  EXPECT_EQ(a.max(), 0);
+}
+
+// ==================== OrderBook Instrumentation Tests ====================
+
+#ifdef TRADING_LATENCY_STATS
+TEST(OrderBookLatencyTest, RecordsEachOperation) {
+  OrderBook book;
+  std::string id = book.addOrder(OrderSide::BUY, 45000.0, 1.0);
+  book.addOrder(OrderSide::SELL, 45100.0, 1.0);
+  book.matchOrders();
+  book.cancelOrder(id);
+  book.getBids();
+  book.getAsks();
+
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::ADD).count(), 2);
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::MATCH).count(), 1);
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::CANCEL).count(), 1);
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::SNAPSHOT).count(), 2);
+
+  // Stats survive a book reset but can be cleared explicitly
+  book.reset();
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::ADD).count(), 2);
+  book.resetLatencyStats();
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::ADD).count(), 0);
+}
+#else
+TEST(OrderBookLatencyTest, DisabledRecordsNothing) {
+  OrderBook book;
+  book.addOrder(OrderSide::BUY, 45000.0, 1.0);
+  EXPECT_EQ(book.latencyHistogram(LatencyOp::ADD).count(), 0);
+}
+#endif
@@ -0,0 +1,93 @@
+#include "engine.hpp"
+#include "metrics.hpp"
+#include "pipeline_stats.hpp"
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace trading;
+
+// Metrics are process-wide, so tests compare snapshots before and after.
+
+// ==================== EngineMetrics Tests ====================
+
+TEST(EngineMetricsTest, CountsOrderBookActivity) {
+  auto before = EngineMetrics::snapshot();
+  {
+    OrderBook book;
+    book.addOrder(OrderSide::BUY, 100.0, 1.0);
+    std::string ask = book.addOrder(OrderSide::SELL, 100.0, 2.0);
+    book.addOrder(OrderSide::SELL, 101.0, 1.0);
+    EXPECT_THROW(book.addOrder(OrderSide::BUY, -1.0, 1.0), std::invalid_argument);
+    book.matchOrders();
+    book.cancelOrder(ask);
+
+    auto during = EngineMetrics::snapshot();
+    EXPECT_EQ(during[Counter::ORDERS_IN] - before[Counter::ORDERS_IN], 4);
+    EXPECT_EQ(during[Counter::ORDERS_REJECTED] - before[Counter::ORDERS_REJECTED], 1);
+    EXPECT_EQ(during[Counter::FILLS] - before[Counter::FILLS], 1);
+    EXPECT_EQ(during[Counter::CANCELS] - before[Counter::CANCELS], 1);
+    EXPECT_EQ(during[Gauge::RESTING_ORDERS] - before[Gauge::RESTING_ORDERS], 1);
+    EXPECT_EQ(during[Gauge::PRICE_LEVELS] - before[Gauge::PRICE_LEVELS], 1);
+  }
+
+  // A destroyed book no longer contributes to the gauges
+  auto after = EngineMetrics::snapshot();
+  EXPECT_EQ(after[Gauge::RESTING_ORDERS], before[Gauge::RESTING_ORDERS]);
+  EXPECT_EQ(after[Gauge::PRICE_LEVELS], before[Gauge::PRICE_LEVELS]);
+}
+
+TEST(EngineMetricsTest, CopiedBooksKeepGaugesExact) {
+  auto before = EngineMetrics::snapshot();
+  {
+    OrderBook book;
+    book.addOrder(OrderSide::BUY, 100.0, 1.0);
+    OrderBook copy = book;
+    auto during = EngineMetrics::snapshot();
+    EXPECT_EQ(during[Gauge::RESTING_ORDERS] - before[Gauge::RESTING_ORDERS], 2);
+    book.reset();
+  }
+  EXPECT_EQ(EngineMetrics::snapshot()[Gauge::RESTING_ORDERS],
+            before[Gauge::RESTING_ORDERS]);
+}
+
+TEST(EngineMetricsTest, CountsIndicatorUpdatesAndTicks) {
+  auto before = EngineMetrics::snapshot();
+  SMACalculator sma(3);
+  sma.addPrice(1.0);
+  sma.addPrice(2.0);
+  PipelineStats pipeline;
+  pipeline.recordTick({1, 2, 3, 4, 5});
+
+  auto after = EngineMetrics::snapshot();
+  EXPECT_EQ(after[Counter::SMA_UPDATES] - before[Counter::SMA_UPDATES], 2);
+  EXPECT_EQ(after[Counter::TICKS] - before[Counter::TICKS], 1);
+}
+
+TEST(EngineMetricsTest, AggregatesAcrossThreads) {
+  auto before = EngineMetrics::snapshot();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 10000; i++) {
+        EngineMetrics::increment(Counter::TICKS);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto after = EngineMetrics::snapshot();
+  EXPECT_EQ(after[Counter::TICKS] - before[Counter::TICKS], 80000);
+}
+
+TEST(EngineMetricsTest, RendersPrometheusText) {
+  EngineMetrics::increment(Counter::FILLS);
+  std::string text = EngineMetrics::renderPrometheus();
+
+  EXPECT_NE(text.find("# TYPE trade_engine_fills_total counter\n"), std::string::npos);
+  EXPECT_NE(text.find("# TYPE trade_engine_resting_orders gauge\n"), std::string::npos);
+  EXPECT_NE(text.find("\ntrade_engine_orders_total "), std::string::npos);
+  EXPECT_EQ(text.back(), '\n');
+}
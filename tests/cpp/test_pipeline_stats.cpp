@@ -0,0 +1,38 @@
+#include "pipeline_stats.hpp"
+#include <gtest/gtest.h>
+
+using namespace trading;
+
+// ==================== PipelineStats Tests ====================
+
+TEST(PipelineStatsTest, StagesFromStamps) {
+  PipelineStats stats;
+  stats.recordTick({1000, 1010, 1030, 1060, 1100});
+
+  EXPECT_EQ(stats.ticks(), 1);
+  EXPECT_EQ(stats.stage(PipelineStage::GENERATE).max(), 10);
+  EXPECT_EQ(stats.stage(PipelineStage::PROCESS).max(), 20);
+  EXPECT_EQ(stats.stage(PipelineStage::SERIALIZE).max(), 30);
+  EXPECT_EQ(stats.stage(PipelineStage::FANOUT).max(), 40);
+  EXPECT_EQ(stats.stage(PipelineStage::TOTAL).max(), 100);
+  EXPECT_DOUBLE_EQ(stats.share(PipelineStage::FANOUT), 0.4);
+}
+
+TEST(PipelineStatsTest, OutOfOrderStampsClampToZero) {
+  PipelineStats stats;
+  stats.recordTick({1000, 1010, 1005, 1020, 1030});
+
+  EXPECT_EQ(stats.stage(PipelineStage::PROCESS).max(), 0);
+  EXPECT_EQ(stats.stage(PipelineStage::SERIALIZE).max(), 10);
+  EXPECT_EQ(stats.stage(PipelineStage::TOTAL).max(), 30);
+}
+
+TEST(PipelineStatsTest, ResetAndEmptyShare) {
+  PipelineStats stats;
+  EXPECT_DOUBLE_EQ(stats.share(PipelineStage::PROCESS), 0.0);
+
+  uint64_t t = monotonicNanos();
+  stats.recordTick({t, t + 1, t + 2, t + 3, t + 4});
+  stats.reset();
+  EXPECT_EQ(stats.ticks(), 0);
+}
@@ -0,0 +1,328 @@
+#include "simulation.hpp"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace trading;
+
+namespace {
+
+// No price model and no synthetic flow: only what a test schedules
+SimulationConfig quietConfig() {
+  SimulationConfig config;
+  config.price_interval_us = 0;
+  config.order_rate = 0.0;
+  config.sma_window = 2;
+  return config;
+}
+
+}  // namespace
+
+// ==================== Simulation Tests ====================
+
+TEST(SimulationTest, AppliesEventsInTimeOrder) {
+  Simulation sim(quietConfig());
+  std::vector<std::pair<long long, uint64_t>> woken;
+  sim.setWakeupHandler([&woken](Simulation& s, uint64_t token) {
+    woken.emplace_back(s.now(), token);
+    if (token == 1) {
+      s.scheduleWakeup(s.now(), 4);  // Same time: runs after those already queued
+    }
+  });
+  sim.scheduleWakeup(300, 3);
+  sim.scheduleWakeup(100, 1);
+  sim.scheduleWakeup(100, 2);
+  sim.schedulePrice(200, 101.0);
+  sim.schedulePrice(250, 103.0);
+
+  EXPECT_EQ(sim.runUntil(250), 5);
+  EXPECT_EQ(woken, (std::vector<std::pair<long long, uint64_t>>{{100, 1}, {100, 2}, {100, 4}}));
+  EXPECT_DOUBLE_EQ(sim.price(), 103.0);
+  EXPECT_DOUBLE_EQ(sim.sma().getSMA(), 102.0);
+  EXPECT_EQ(sim.now(), 250);
+  EXPECT_EQ(sim.pendingEvents(), 1);
+  EXPECT_THROW(sim.scheduleWakeup(249, 9), std::invalid_argument);
+
+  EXPECT_TRUE(sim.step());
+  EXPECT_EQ(sim.now(), 300);
+  EXPECT_FALSE(sim.step());
+  EXPECT_EQ(sim.stats().wakeups, 4);
+  EXPECT_EQ(sim.stats().price_steps, 2);
+}
+
+TEST(SimulationTest, OrdersCancelsAndExpiriesOnSimulatedTime) {
+  Simulation sim(quietConfig());
+  sim.scheduleOrder(1000, OrderSide::SELL, 100.0, 2.0);
+  sim.scheduleOrder(2000, OrderSide::BUY, 100.0, 0.5);
+  sim.scheduleOrder(2000, OrderSide::BUY, 99.0, 1.0, 1500);  // Due at 3.5 ms: expires at 4
+  sim.scheduleOrder(2500, OrderSide::BUY, -1.0, 1.0);
+  sim.scheduleCancel(5000, "ORD1");
+  EXPECT_THROW(sim.scheduleCancel(5000, "order-1"), std::invalid_argument);
+  EXPECT_THROW(sim.scheduleCancel(5000, "ORD +1"), std::invalid_argument);
+  EXPECT_THROW(sim.scheduleCancel(5000, "ORD01"), std::invalid_argument);
+
+  sim.runUntil(3000);
+  ASSERT_EQ(sim.stats().trades, 1);
+  EXPECT_DOUBLE_EQ(sim.stats().volume, 0.5);
+  EXPECT_EQ(sim.stats().rejected, 1);
+  EXPECT_EQ(sim.book().getBids().size(), 1);
+
+  sim.runUntil(3999);
+  EXPECT_EQ(sim.stats().expired, 0);
+  EXPECT_EQ(sim.book().clockMillis(), 3);
+  sim.runUntil(4000);
+  EXPECT_EQ(sim.stats().expired, 1);
+  EXPECT_TRUE(sim.book().getBids().empty());
+
+  sim.runUntil(10000);
+  EXPECT_EQ(sim.stats().cancels, 1);
+  EXPECT_TRUE(sim.book().getAsks().empty());
+  EXPECT_EQ(sim.stats().orders, 3);
+}
+
+TEST(SimulationTest, SimulatedDayIsFastAndDeterministic) {
+  SimulationConfig config;
+  config.seed = 11;
+  config.order_rate = 5.0;
+
+  const long long day_us = 86400LL * 1000000;
+  Simulation a(config), b(config);
+  a.runUntil(day_us);
+  b.runUntil(day_us / 2);
+  b.runUntil(day_us);
+
+  EXPECT_EQ(a.stats().price_steps, 172800);
+  EXPECT_NEAR(static_cast<double>(a.stats().orders), 5.0 * 86400, 3000.0);
+  EXPECT_GT(a.stats().trades, 0);
+  EXPECT_GT(a.stats().expired, 0);
+  EXPECT_EQ(a.stats().events, b.stats().events);
+  EXPECT_EQ(a.stats().trades, b.stats().trades);
+  EXPECT_DOUBLE_EQ(a.price(), b.price());
+  EXPECT_DOUBLE_EQ(a.stats().volume, b.stats().volume);
+
+  // Orders live five seconds, so only a few are resting at any time
+  EXPECT_LT(a.book().memoryStats().resting_orders, 100);
+
+  config.initial_price = 0.0;
+  EXPECT_THROW(Simulation{config}, std::invalid_argument);
+}
+
+// ==================== Participant Tests ====================
+
+TEST(ParticipantTest, LatencyDelaysOrdersAndNotices) {
+  Simulation sim(quietConfig());
+  const size_t trader = sim.addParticipant({LatencyDistribution::FIXED, 300, 0.0},
+                                           {LatencyDistribution::FIXED, 200, 0.0});
+  std::vector<std::pair<long long, ParticipantFill>> fills;
+  std::vector<std::pair<long long, long long>> prices;
+  sim.setFillHandler(trader, [&fills](Simulation& s, const ParticipantFill& fill) {
+    fills.emplace_back(s.now(), fill);
+  });
+  sim.setPriceHandler(trader, [&prices](Simulation& s, double, long long sent) {
+    prices.emplace_back(s.now(), sent);
+  });
+  sim.scheduleOrder(100, OrderSide::SELL, 100.0, 1.0);
+  const uint64_t client = sim.submitOrder(trader, OrderSide::BUY, 100.0, 0.4);
+  sim.schedulePrice(600, 101.0);
+
+  sim.runUntil(299);
+  EXPECT_EQ(sim.participantStats(trader).orders, 0);
+  sim.runUntil(300);
+  EXPECT_EQ(sim.stats().trades, 1);
+  EXPECT_EQ(sim.participantStats(trader).fills, 1);
+  EXPECT_TRUE(fills.empty());
+
+  sim.runUntil(1000);
+  ASSERT_EQ(fills.size(), 1);
+  EXPECT_EQ(fills[0].first, 500);
+  EXPECT_EQ(fills[0].second.client_id, client);
+  EXPECT_EQ(fills[0].second.order_id, "ORD2");
+  EXPECT_DOUBLE_EQ(fills[0].second.quantity, 0.4);
+  EXPECT_DOUBLE_EQ(fills[0].second.remaining, 0.0);
+  EXPECT_EQ(fills[0].second.exchange_time_us, 300);
+  EXPECT_EQ(prices, (std::vector<std::pair<long long, long long>>{{800, 600}}));
+  EXPECT_EQ(sim.queueAhead(client), -1.0);
+
+  EXPECT_THROW(sim.submitOrder(7, OrderSide::BUY, 100.0, 1.0), std::invalid_argument);
+  EXPECT_THROW(sim.addParticipant({LatencyDistribution::UNIFORM, -1, 0.0}), std::invalid_argument);
+}
+
+TEST(ParticipantTest, RandomLatencyKeepsMessagesInOrder) {
+  Simulation sim(quietConfig());
+  const size_t trader = sim.addParticipant({LatencyDistribution::EXPONENTIAL, 1000, 5000.0});
+  std::vector<uint64_t> clients;
+  for (int i = 0; i < 50; i++) {
+    clients.push_back(sim.submitOrder(trader, OrderSide::BUY, 90.0, 1.0));
+  }
+
+  sim.runUntil(999);
+  EXPECT_EQ(sim.participantStats(trader).orders, 0);
+  sim.runUntil(1000000);
+  ASSERT_EQ(sim.participantStats(trader).orders, 50);
+  for (size_t i = 0; i < clients.size(); i++) {
+    EXPECT_DOUBLE_EQ(sim.queueAhead(clients[i]), static_cast<double>(i));
+  }
+}
+
+TEST(ParticipantTest, QueuePositionFollowsFillsAndCancels) {
+  Simulation sim(quietConfig());
+  const size_t trader = sim.addParticipant();
+  sim.book().addOrder(OrderSide::BUY, 100.0, 1.0);               // ORD1
+  sim.book().addIcebergOrder(OrderSide::BUY, 100.0, 0.5, 1.5);   // ORD2
+  sim.book().addOrder(OrderSide::BUY, 100.0, 2.0);               // ORD3
+
+  const uint64_t first = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);  // ORD4
+  EXPECT_EQ(sim.queueAhead(first), -1.0);
+  sim.runUntil(0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(first), 3.5);
+
+  sim.scheduleOrder(10, OrderSide::BUY, 100.0, 5.0);   // ORD5, behind: no change
+  sim.scheduleOrder(10, OrderSide::BUY, 101.0, 5.0);   // ORD6, another level
+  sim.scheduleCancel(20, "ORD3");
+  sim.runUntil(20);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(first), 1.5);
+
+  // ORD6 takes 5.0 of this first; then ORD1 fills and 0.25 of the iceberg's tranche
+  sim.scheduleOrder(30, OrderSide::SELL, 100.0, 6.25);
+  sim.runUntil(30);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(first), 0.25);
+
+  // The tranche fills and its refill queues behind ORD5
+  sim.scheduleOrder(40, OrderSide::SELL, 100.0, 0.25);
+  sim.runUntil(40);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(first), 0.0);
+  const uint64_t second = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);
+  sim.runUntil(40);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(second), 6.5);
+
+  // Fills the first participant order, then half of ORD5
+  sim.scheduleOrder(50, OrderSide::SELL, 100.0, 1.5);
+  sim.runUntil(50);
+  EXPECT_EQ(sim.queueAhead(first), -1.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(second), 5.0);
+
+  sim.submitCancel(trader, second);
+  sim.submitCancel(trader, first);  // Already filled: nothing to do
+  sim.runUntil(60);
+  EXPECT_EQ(sim.queueAhead(second), -1.0);
+  const ParticipantStats& stats = sim.participantStats(trader);
+  EXPECT_EQ(stats.orders, 2);
+  EXPECT_EQ(stats.fills, 1);
+  EXPECT_DOUBLE_EQ(stats.filled_quantity, 1.0);
+  EXPECT_EQ(stats.cancels, 1);
+}
+
+TEST(ParticipantTest, FollowsEachIcebergRefillOfOneMatch) {
+  Simulation sim(quietConfig());
+  const size_t trader = sim.addParticipant();
+  sim.book().addIcebergOrder(OrderSide::BUY, 100.0, 1.0, 10.0);  // ORD1
+
+  // One match fills three tranches and a quarter of the fourth
+  sim.scheduleOrder(10, OrderSide::SELL, 100.0, 3.25);
+  sim.runUntil(10);
+  EXPECT_EQ(sim.book().lastRefills().size(), 3u);
+  const OrderBook::OrderQueue* queue = sim.book().ordersAt(OrderSide::BUY, 100.0);
+  ASSERT_NE(queue, nullptr);
+  ASSERT_DOUBLE_EQ(queue->front().quantity, 0.75);
+
+  const uint64_t client = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);
+  sim.runUntil(20);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(client), 0.75);
+
+  // The rest of that tranche, then the next one rejoins behind the client
+  sim.scheduleOrder(30, OrderSide::SELL, 100.0, 0.75);
+  sim.runUntil(30);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(client), 0.0);
+  sim.scheduleOrder(40, OrderSide::SELL, 100.0, 1.5);
+  sim.runUntil(40);
+  EXPECT_EQ(sim.queueAhead(client), -1.0);
+  const uint64_t behind = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);
+  sim.runUntil(50);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(behind), 0.5);
+}
+
+TEST(ParticipantTest, CancelsBetweenParticipantOrdersCountOnlyForLaterOnes) {
+  Simulation sim(quietConfig());
+  const size_t trader = sim.addParticipant();
+  sim.scheduleOrder(0, OrderSide::BUY, 100.0, 1.0);                           // ORD1
+  const uint64_t a = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);     // ORD2
+  sim.scheduleOrder(10, OrderSide::BUY, 100.0, 2.0);                          // ORD3
+  sim.runUntil(10);
+  const uint64_t b = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);     // ORD4
+  sim.scheduleOrder(20, OrderSide::BUY, 100.0, 4.0);                          // ORD5
+  sim.runUntil(20);
+  const uint64_t c = sim.submitOrder(trader, OrderSide::BUY, 100.0, 1.0);     // ORD6
+  sim.runUntil(20);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(a), 1.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(b), 4.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(c), 9.0);
+
+  // Behind a and b, ahead of c
+  sim.scheduleCancel(30, "ORD5");
+  sim.runUntil(30);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(a), 1.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(b), 4.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(c), 5.0);
+
+  // The oldest leaves; ORD3 is then ahead of everyone still resting
+  sim.submitCancel(trader, a);
+  sim.scheduleCancel(40, "ORD3");
+  sim.runUntil(40);
+  EXPECT_EQ(sim.queueAhead(a), -1.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(b), 1.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(c), 2.0);
+
+  // ORD1 fills, then b
+  sim.scheduleOrder(50, OrderSide::SELL, 100.0, 2.0);
+  sim.runUntil(50);
+  EXPECT_EQ(sim.queueAhead(b), -1.0);
+  EXPECT_DOUBLE_EQ(sim.queueAhead(c), 0.0);
+}
+
+TEST(ParticipantTest, QueueAheadMatchesTheBook) {
+  SimulationConfig config;
+  config.seed = 5;
+  config.price_interval_us = 100000;
+  config.order_rate = 50.0;
+  config.tick_size = 1.0;
+  Simulation sim(config);
+  const size_t trader = sim.addParticipant({LatencyDistribution::FIXED, 50, 0.0},
+                                           {LatencyDistribution::FIXED, 100, 0.0});
+
+  // A bid just under every price it sees, each of its own size so it can
+  // be found in the book; synthetic orders trade, expire and queue around it
+  struct Quote {
+    uint64_t client;
+    double price;
+    double quantity;
+  };
+  std::vector<Quote> quotes;
+  sim.setPriceHandler(trader, [&quotes, trader](Simulation& s, double price, long long) {
+    const double bid = std::round(price * 0.9995);
+    const double quantity = 0.5 + 1e-6 * static_cast<double>(quotes.size());
+    quotes.push_back({s.submitOrder(trader, OrderSide::BUY, bid, quantity), bid, quantity});
+  });
+
+  size_t checked = 0;
+  for (long long t = 1000000; t <= 60000000; t += 1000000) {
+    sim.runUntil(t);
+    for (const auto& quote : quotes) {
+      // Still whole once something is ahead of it
+      const double ahead = sim.queueAhead(quote.client);
+      if (ahead <= 0) continue;
+      const OrderBook::OrderQueue* queue = sim.book().ordersAt(OrderSide::BUY, quote.price);
+      ASSERT_NE(queue, nullptr);
+      double expected = 0.0;
+      auto order = queue->begin();
+      for (; order != queue->end() && order->quantity != quote.quantity; ++order) {
+        expected += order->quantity;
+      }
+      ASSERT_NE(order, queue->end());
+      EXPECT_NEAR(ahead, expected, 1e-9);
+      checked++;
+    }
+  }
+  EXPECT_GT(checked, 100);
+}
@@ -0,0 +1,279 @@
+#include "strategy.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace trading;
+
+namespace {
+
+// Records when each callback ran; buys once on the first tick
+class RecordingStrategy : public Strategy {
+public:
+  void onTick(StrategyContext& context, double price) override {
+    ticks.emplace_back(context.now(), price);
+    if (ticks.size() == 1) {
+      client = context.submitOrder(OrderSide::BUY, price * 1.01, 0.5);
+    }
+  }
+  void onTrade(StrategyContext& /*context*/, const Trade& trade) override { trades.push_back(trade); }
+  void onBookUpdate(StrategyContext& /*context*/, double /*best_bid*/, double /*best_ask*/) override {
+    book_updates++;
+  }
+  void onFill(StrategyContext& context, const ParticipantFill& fill) override {
+    fills.push_back(fill);
+    position_after_fill = context.position();
+  }
+  void onFinish(StrategyContext& /*context*/) override { finished++; }
+
+  std::vector<std::pair<long long, double>> ticks;
+  std::vector<Trade> trades;
+  std::vector<ParticipantFill> fills;
+  int book_updates = 0;
+  int finished = 0;
+  uint64_t client = 0;
+  double position_after_fill = 0.0;
+};
+
+// One tick every 100 simulated ms: up for `rise` ticks, then down
+void vShape(size_t rise, size_t fall, std::vector<long long>& times, std::vector<double>& prices) {
+  double price = 100.0;
+  for (size_t i = 0; i < rise + fall; i++) {
+    price *= i < rise ? 1.001 : 0.999;
+    times.push_back(static_cast<long long>(i + 1) * 100000);
+    prices.push_back(price);
+  }
+}
+
+// A noisy trend with plateaus of repeated times, one tick every 50 ms on average
+void randomWalk(size_t count, std::vector<long long>& times, std::vector<double>& prices) {
+  uint64_t state = 12345;
+  double price = 100.0;
+  long long time = 0;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    const double step = static_cast<double>(state >> 11) / 9007199254740992.0 - 0.48;
+    price *= 1.0 + step * 0.002;
+    time += (state >> 60) < 2 ? 0 : 50000;
+    times.push_back(time);
+    prices.push_back(price);
+  }
+}
+
+}  // namespace
+
+// ==================== Backtest Tests ====================
+
+TEST(BacktestTest, CallbacksSeeMarketDataLatency) {
+  BacktestConfig config;
+  config.market.order_rate = 200.0;
+  config.market_data = {LatencyDistribution::FIXED, 1000, 0.0};
+  config.order_entry = {LatencyDistribution::FIXED, 500, 0.0};
+  RecordingStrategy strategy;
+  Backtest backtest(strategy, config);
+
+  std::vector<long long> times;
+  std::vector<double> prices;
+  vShape(50, 0, times, prices);
+  const BacktestResult result = backtest.replay(times.data(), prices.data(), times.size());
+
+  // The last tick's notice is still in flight when the replay ends
+  ASSERT_EQ(strategy.ticks.size(), 49);
+  EXPECT_EQ(strategy.ticks[0].first, times[0] + 1000);
+  EXPECT_DOUBLE_EQ(strategy.ticks[0].second, prices[0]);
+  EXPECT_EQ(result.ticks, 49);
+  EXPECT_EQ(strategy.finished, 1);
+  EXPECT_GT(strategy.book_updates, 0);
+  ASSERT_FALSE(strategy.trades.empty());
+
+  // The order reached the book 500 us after the first tick was seen
+  ASSERT_FALSE(strategy.fills.empty());
+  EXPECT_EQ(strategy.fills[0].client_id, strategy.client);
+  EXPECT_EQ(strategy.fills[0].exchange_time_us, times[0] + 1500);
+  EXPECT_DOUBLE_EQ(strategy.position_after_fill, result.position);
+  EXPECT_DOUBLE_EQ(result.position, 0.5);
+  EXPECT_DOUBLE_EQ(result.traded_quantity, 0.5);
+  EXPECT_LT(result.cash, 0.0);
+  EXPECT_EQ(result.end_us, times.back());
+}
+
+TEST(BacktestTest, SMACrossoverFollowsTheTrend) {
+  BacktestConfig config;
+  config.market.order_rate = 200.0;
+  config.market.seed = 3;
+  std::vector<long long> times;
+  std::vector<double> prices;
+  vShape(300, 300, times, prices);
+
+  SMACrossoverStrategy strategy(5, 20, 1.0, 0.002);
+  Backtest backtest(strategy, config);
+  const BacktestResult result = backtest.replay(times.data(), prices.data(), times.size());
+
+  EXPECT_EQ(strategy.crossovers(), 1);
+  EXPECT_EQ(result.orders, 2);
+  EXPECT_GT(result.fills, 0);
+  EXPECT_LT(result.position, 0.0);  // Short on the way down
+  EXPECT_GE(result.max_drawdown, 0.0);
+
+  // Same market, fresh strategy: the same run
+  SMACrossoverStrategy again(5, 20, 1.0, 0.002);
+  Backtest rerun(again, config);
+  const BacktestResult repeat = rerun.replay(times.data(), prices.data(), times.size());
+  EXPECT_EQ(repeat.fills, result.fills);
+  EXPECT_DOUBLE_EQ(repeat.pnl, result.pnl);
+
+  EXPECT_THROW(SMACrossoverStrategy(20, 5, 1.0), std::invalid_argument);
+  EXPECT_THROW(SMACrossoverStrategy(5, 20, 0.0), std::invalid_argument);
+}
+
+TEST(BacktestTest, RunsOnThePriceModel) {
+  BacktestConfig config;
+  config.market.seed = 9;
+  SMACrossoverStrategy strategy(10, 40, 0.1);
+  Backtest backtest(strategy, config);
+  const BacktestResult result = backtest.run(3600LL * 1000000);
+
+  EXPECT_EQ(result.ticks, 7200);
+  EXPECT_GT(strategy.crossovers(), 0);
+  EXPECT_GT(result.fills, 0);
+  EXPECT_NEAR(result.pnl, result.cash + result.position * backtest.simulation()->price(), 1e-9);
+  EXPECT_EQ(result.market.price_steps, 7200);
+
+  config.market.price_interval_us = 0;
+  Backtest no_model(strategy, config);
+  EXPECT_THROW(no_model.run(1000), std::invalid_argument);
+
+  const long long unordered[] = {200, 100};
+  const double prices[] = {1.0, 1.0};
+  EXPECT_THROW(backtest.replay(unordered, prices, 2), std::invalid_argument);
+}
+
+TEST(BacktestTest, BatchStrategyDeliversInBatches) {
+  std::vector<size_t> sizes;
+  double fills = 0.0;
+  BatchStrategy strategy(
+      [&](StrategyContext& context, const StrategyBatch& batch) {
+        sizes.push_back(batch.tick_prices.size());
+        EXPECT_EQ(batch.tick_times.size(), batch.tick_prices.size());
+        for (const auto& fill : batch.fills) {
+          fills += fill.quantity;
+        }
+        if (sizes.size() == 1) {
+          context.submitOrder(OrderSide::SELL, batch.tick_prices.back() * 0.99, 0.25);
+        }
+      },
+      10);
+
+  BacktestConfig config;
+  config.market.order_rate = 200.0;
+  Backtest backtest(strategy, config);
+  std::vector<long long> times;
+  std::vector<double> prices;
+  vShape(26, 0, times, prices);
+  const BacktestResult result = backtest.replay(times.data(), prices.data(), times.size());
+
+  EXPECT_EQ(sizes, (std::vector<size_t>{10, 10, 6}));
+  EXPECT_EQ(strategy.batches(), 3);
+  EXPECT_DOUBLE_EQ(fills, 0.25);
+  EXPECT_DOUBLE_EQ(result.position, -0.25);
+
+  EXPECT_THROW(BatchStrategy(nullptr, 0), std::invalid_argument);
+}
+
+// ==================== ParallelBacktest Tests ====================
+
+TEST(ParallelBacktestTest, MatchesSequentialReplays) {
+  std::vector<long long> times;
+  std::vector<double> prices;
+  randomWalk(20000, times, prices);
+
+  const std::vector<std::pair<size_t, size_t>> windows = {{5, 20}, {10, 40}, {3, 30}, {20, 60}, {8, 16}};
+  BacktestConfig config;
+  config.market.seed = 5;
+  config.order_entry = {LatencyDistribution::UNIFORM, 200, 400.0};
+  config.market_data = {LatencyDistribution::EXPONENTIAL, 100, 300.0};
+
+  ParallelBacktest parallel(3);
+  std::vector<std::unique_ptr<SMACrossoverStrategy>> strategies;
+  for (const auto& window : windows) {
+    strategies.push_back(std::make_unique<SMACrossoverStrategy>(window.first, window.second, 0.5));
+    EXPECT_EQ(parallel.add(*strategies.back(), config), strategies.size() - 1);
+  }
+  EXPECT_EQ(parallel.size(), windows.size());
+  EXPECT_EQ(parallel.threads(), 3);
+  const std::vector<BacktestResult> results = parallel.replay(times.data(), prices.data(), times.size(), 1000);
+
+  ASSERT_EQ(results.size(), windows.size());
+  for (size_t i = 0; i < windows.size(); i++) {
+    SMACrossoverStrategy alone(windows[i].first, windows[i].second, 0.5);
+    Backtest backtest(alone, config);
+    const BacktestResult expected = backtest.replay(times.data(), prices.data(), times.size());
+    EXPECT_EQ(results[i].ticks, expected.ticks);
+    EXPECT_EQ(results[i].orders, expected.orders);
+    EXPECT_EQ(results[i].fills, expected.fills);
+    EXPECT_EQ(results[i].market.trades, expected.market.trades);
+    EXPECT_DOUBLE_EQ(results[i].pnl, expected.pnl);
+    EXPECT_DOUBLE_EQ(results[i].max_drawdown, expected.max_drawdown);
+    EXPECT_EQ(results[i].end_us, times.back());
+    EXPECT_EQ(strategies[i]->crossovers(), alone.crossovers());
+    EXPECT_GT(alone.crossovers(), 0);
+  }
+}
+
+TEST(ParallelBacktestTest, ReplaysATickStore) {
+  std::vector<long long> times;
+  std::vector<double> prices;
+  randomWalk(5000, times, prices);
+  TickStore store;
+  for (size_t i = 0; i < times.size(); i++) {
+    store.append(1700000000000 + times[i] / 1000, prices[i]);
+  }
+  ASSERT_GT(store.blockCount(), 2);
+
+  // The store's ticks from the 1001st on, as microseconds from the first
+  const int64_t from = 1700000000000 + times[1000] / 1000;
+  const size_t first = static_cast<size_t>(std::lower_bound(times.begin(), times.end(), times[1000]) - times.begin());
+  std::vector<long long> expected_times;
+  for (size_t i = first; i < times.size(); i++) {
+    expected_times.push_back(times[i] - times[first]);
+  }
+
+  SMACrossoverStrategy strategy(5, 20, 1.0);
+  ParallelBacktest parallel(2);
+  parallel.add(strategy);
+  const BacktestResult result = parallel.replay(store, from, INT64_MAX, 1000, 700)[0];
+
+  SMACrossoverStrategy alone(5, 20, 1.0);
+  Backtest backtest(alone);
+  const BacktestResult expected =
+      backtest.replay(expected_times.data(), prices.data() + first, expected_times.size());
+  EXPECT_EQ(result.ticks, expected.ticks);
+  EXPECT_EQ(result.fills, expected.fills);
+  EXPECT_DOUBLE_EQ(result.pnl, expected.pnl);
+  EXPECT_EQ(result.end_us, expected_times.back());
+
+  // Nothing in range: every strategy still gets a (quiet) run
+  EXPECT_EQ(parallel.replay(store, 0, 1, 1000)[0].ticks, 0);
+}
+
+TEST(ParallelBacktestTest, RejectsBadInput) {
+  SMACrossoverStrategy strategy(5, 20, 1.0);
+  ParallelBacktest parallel(2);
+  parallel.add(strategy);
+  EXPECT_GE(ParallelBacktest().threads(), 1);
+
+  const long long unordered[] = {200, 100};
+  const double prices[] = {1.0, 1.0};
+  EXPECT_THROW(parallel.replay(unordered, prices, 2), std::invalid_argument);
+  EXPECT_THROW(parallel.replay(unordered, prices, 1, 0), std::invalid_argument);
+
+  TickStore store;
+  store.append(0, 1.0);
+  store.append(1, -1.0);
+  EXPECT_THROW(parallel.replay(store, 0, 10), std::invalid_argument);
+  EXPECT_THROW(parallel.replay(store, 0, 10, 0), std::invalid_argument);
+}
@@ -0,0 +1,277 @@
+#include "tick_store.hpp"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace trading;
+
+namespace {
+
+// Random walk on a 0.5 tick grid, ~1 s apart with a little jitter
+std::vector<Tick> marketTicks(size_t n, unsigned seed = 3) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> step(-3, 3);
+  std::uniform_int_distribution<int> jitter(-5, 5);
+  std::uniform_int_distribution<int> lots(0, 8);
+  std::vector<Tick> ticks(n);
+  int64_t t = 1717200000000;
+  double price = 45000.0;
+  for (auto& tick : ticks) {
+    t += 1000 + jitter(rng);
+    price += 0.5 * step(rng);
+    tick = {t, price, 0.25 * lots(rng)};
+  }
+  return ticks;
+}
+
+void appendAll(TickStore& store, const std::vector<Tick>& ticks) {
+  for (const auto& t : ticks) {
+    store.append(t.timestamp, t.price, t.quantity);
+  }
+}
+
+void expectSame(const std::vector<Tick>& got, const std::vector<Tick>& expected) {
+  ASSERT_EQ(got.size(), expected.size());
+  for (size_t i = 0; i < got.size(); i++) {
+    ASSERT_EQ(got[i].timestamp, expected[i].timestamp) << i;
+    ASSERT_EQ(got[i].price, expected[i].price) << i;
+    ASSERT_EQ(got[i].quantity, expected[i].quantity) << i;
+  }
+}
+
+} // namespace
+
+// ==================== TickStore Tests ====================
+
+TEST(TickStoreTest, RoundTripsAcrossBlocks) {
+  TickStore store;
+  auto ticks = marketTicks(50000);
+  appendAll(store, ticks);
+
+  EXPECT_EQ(store.size(), ticks.size());
+  EXPECT_GT(store.blockCount(), 10);
+
+  std::vector<Tick> out;
+  EXPECT_EQ(store.read(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), out),
+            ticks.size());
+  expectSame(out, ticks);
+}
+
+TEST(TickStoreTest, CompressesMarketTicks) {
+  TickStore store;
+  appendAll(store, marketTicks(100000));
+
+  // 24 raw bytes per tick; jittered timestamps + walk + sizes fit in ~5
+  double bytes_per_tick = static_cast<double>(store.storedBytes()) / store.size();
+  EXPECT_LT(bytes_per_tick, 6.0);
+}
+
+TEST(TickStoreTest, RoundTripsIrregularValues) {
+  TickStore store;
+  std::vector<Tick> ticks = {
+      {-5, 0.0, 0.0},
+      {-5, -0.0, 1e-300},
+      {0, 1e300, -1.0},
+      {1LL << 40, std::numeric_limits<double>::infinity(), 0.1},
+      {(1LL << 40) + 1, 123.456, 0.1},
+      {(1LL << 40) + 1, 123.456, 0.1},
+      {std::numeric_limits<int64_t>::max() / 4, 3.0, 7.0},
+  };
+  appendAll(store, ticks);
+
+  std::vector<Tick> out;
+  store.read(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), out);
+  ASSERT_EQ(out.size(), ticks.size());
+  for (size_t i = 0; i < out.size(); i++) {
+    EXPECT_EQ(out[i].timestamp, ticks[i].timestamp);
+    EXPECT_EQ(std::signbit(out[i].price), std::signbit(ticks[i].price));
+    EXPECT_EQ(out[i].price, ticks[i].price);
+    EXPECT_EQ(out[i].quantity, ticks[i].quantity);
+  }
+}
+
+TEST(TickStoreTest, RangeReadMatchesFilter) {
+  TickStore store;
+  auto ticks = marketTicks(20000);
+  appendAll(store, ticks);
+
+  const int64_t from = ticks[4321].timestamp;
+  const int64_t to = ticks[15000].timestamp;
+  std::vector<Tick> expected;
+  for (const auto& t : ticks) {
+    if (t.timestamp >= from && t.timestamp < to) expected.push_back(t);
+  }
+
+  std::vector<Tick> out;
+  EXPECT_EQ(store.read(from, to, out), expected.size());
+  expectSame(out, expected);
+
+  out.clear();
+  EXPECT_EQ(store.read(to, from, out), 0);
+  EXPECT_EQ(store.read(ticks.back().timestamp + 1, ticks.back().timestamp + 100, out), 0);
+}
+
+TEST(TickStoreTest, BlockIndexSummarisesTicks) {
+  TickStore store;
+  auto ticks = marketTicks(10000);
+  appendAll(store, ticks);
+
+  size_t start = 0;
+  for (size_t b = 0; b < store.blockCount(); b++) {
+    const TickBlock& block = store.block(b);
+    double lo = ticks[start].price, hi = ticks[start].price, volume = 0.0;
+    int64_t lo_time = ticks[start].timestamp, hi_time = ticks[start].timestamp;
+    for (size_t i = start; i < start + block.count; i++) {
+      if (ticks[i].price < lo) lo = ticks[i].price, lo_time = ticks[i].timestamp;
+      if (ticks[i].price > hi) hi = ticks[i].price, hi_time = ticks[i].timestamp;
+      volume += ticks[i].quantity;
+    }
+    EXPECT_EQ(block.first_time, ticks[start].timestamp);
+    EXPECT_EQ(block.last_time, ticks[start + block.count - 1].timestamp);
+    EXPECT_EQ(block.min_price, lo);
+    EXPECT_EQ(block.max_price, hi);
+    EXPECT_EQ(block.min_time, lo_time);
+    EXPECT_EQ(block.max_time, hi_time);
+    EXPECT_EQ(block.first_price, ticks[start].price);
+    EXPECT_EQ(block.last_price, ticks[start + block.count - 1].price);
+    EXPECT_DOUBLE_EQ(block.volume, volume);
+    EXPECT_EQ(block.sealed, b + 1 < store.blockCount() ? 1u : 0u);
+    start += block.count;
+  }
+  EXPECT_EQ(start, ticks.size());
+  EXPECT_THROW(store.block(store.blockCount()), std::out_of_range);
+}
+
+// ==================== Downsampling Tests ====================
+
+TEST(TickStoreTest, DownsampleReturnsRawTicksWhenTheyFit) {
+  TickStore store;
+  auto ticks = marketTicks(300);
+  appendAll(store, ticks);
+
+  std::vector<TickPoint> out;
+  EXPECT_EQ(store.downsample(ticks[100].timestamp, ticks[200].timestamp, 500, Downsample::MIN_MAX, out), 100);
+  EXPECT_EQ(out.front().timestamp, ticks[100].timestamp);
+  EXPECT_EQ(out.back().price, ticks[199].price);
+  EXPECT_THROW(store.downsample(0, 1, 1, Downsample::LTTB, out), std::invalid_argument);
+
+  TickStore empty;
+  EXPECT_EQ(empty.downsample(0, 1000, 10, Downsample::LTTB, out), 0);
+}
+
+TEST(TickStoreTest, MinMaxMatchesBruteForce) {
+  TickStore store;
+  auto ticks = marketTicks(60000);
+  appendAll(store, ticks);
+
+  // Few buckets (whole blocks answered from the index) and many (decoded)
+  for (size_t points : {16, 200, 5000}) {
+    const int64_t from = ticks[777].timestamp;
+    const int64_t to = ticks.back().timestamp + 1;
+    const size_t buckets = points / 2;
+    const uint64_t span = static_cast<uint64_t>(to - from);
+    const uint64_t width = span / buckets + (span % buckets != 0);
+
+    std::vector<std::vector<Tick>> grouped(buckets);
+    for (const auto& t : ticks) {
+      if (t.timestamp >= from) grouped[(t.timestamp - from) / width].push_back(t);
+    }
+    std::vector<TickPoint> expected;
+    for (const auto& g : grouped) {
+      if (g.empty()) continue;
+      Tick lo = g[0], hi = g[0];
+      for (const auto& t : g) {
+        if (t.price < lo.price) lo = t;
+        if (t.price > hi.price) hi = t;
+      }
+      if (lo.timestamp > hi.timestamp) std::swap(lo, hi);
+      expected.push_back({lo.timestamp, lo.price});
+      if (lo.timestamp != hi.timestamp) expected.push_back({hi.timestamp, hi.price});
+    }
+
+    std::vector<TickPoint> out;
+    store.downsample(from, std::numeric_limits<int64_t>::max(), points, Downsample::MIN_MAX, out);
+    ASSERT_EQ(out.size(), expected.size()) << points;
+    EXPECT_LE(out.size(), points);
+    for (size_t i = 0; i < out.size(); i++) {
+      ASSERT_EQ(out[i].timestamp, expected[i].timestamp) << points << " " << i;
+      ASSERT_EQ(out[i].price, expected[i].price) << points << " " << i;
+    }
+  }
+}
+
+TEST(TickStoreTest, LTTBKeepsEndsAndSpikes) {
+  TickStore store;
+  auto ticks = marketTicks(40000);
+  ticks[23456].price += 5000.0;
+  appendAll(store, ticks);
+
+  std::vector<TickPoint> out;
+  EXPECT_EQ(store.downsample(ticks.front().timestamp, ticks.back().timestamp + 1, 300, Downsample::LTTB, out), 300);
+  EXPECT_EQ(out.front().timestamp, ticks.front().timestamp);
+  EXPECT_EQ(out.back().timestamp, ticks.back().timestamp);
+
+  bool spike = false;
+  for (size_t i = 0; i < out.size(); i++) {
+    if (i > 0) {
+      EXPECT_LT(out[i - 1].timestamp, out[i].timestamp);
+    }
+    spike |= out[i].timestamp == ticks[23456].timestamp && out[i].price == ticks[23456].price;
+  }
+  EXPECT_TRUE(spike);
+}
+
+TEST(TickStoreTest, RejectsOutOfOrderTimestamps) {
+  TickStore store;
+  store.append(100, 1.0);
+  store.append(100, 1.0);
+  EXPECT_THROW(store.append(99, 1.0), std::invalid_argument);
+  EXPECT_EQ(store.size(), 2);
+}
+
+TEST(TickStoreTest, FileReopensAndResumes) {
+  const std::string path = "test_tick_store.ticks";
+  std::remove(path.c_str());
+  auto ticks = marketTicks(30000);
+
+  {
+    TickStore store(path);
+    appendAll(store, std::vector<Tick>(ticks.begin(), ticks.begin() + 12345));
+    store.flush();
+  }
+  {
+    // Partial last block is picked up and appended to
+    TickStore store(path);
+    EXPECT_EQ(store.size(), 12345);
+    appendAll(store, std::vector<Tick>(ticks.begin() + 12345, ticks.end()));
+  }
+
+  TickStore store(path);
+  EXPECT_EQ(store.size(), ticks.size());
+  std::vector<Tick> out;
+  store.read(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), out);
+  expectSame(out, ticks);
+
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  ASSERT_NE(f, nullptr);
+  std::fseek(f, 0, SEEK_END);
+  EXPECT_EQ(static_cast<size_t>(std::ftell(f)), store.blockCount() * TickStore::kBlockBytes);
+  std::fclose(f);
+  std::remove(path.c_str());
+}
+
+TEST(TickStoreTest, RejectsCorruptFile) {
+  const std::string path = "test_tick_store_corrupt.ticks";
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(f, nullptr);
+  std::vector<char> junk(TickStore::kBlockBytes, 'x');
+  std::fwrite(junk.data(), 1, junk.size(), f);
+  std::fclose(f);
+
+  EXPECT_THROW(TickStore store(path), std::runtime_error);
+  std::remove(path.c_str());
+}
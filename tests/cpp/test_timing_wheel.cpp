@@ -0,0 +1,85 @@
+#include "timing_wheel.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace trading;
+
+// ==================== TimingWheel Tests ====================
+
+TEST(TimingWheelTest, FiresAtDeadline) {
+  TimingWheel wheel(100);
+  wheel.schedule(105, 1);
+  wheel.schedule(100, 2);  // Already due
+  wheel.schedule(5000, 3);
+  EXPECT_EQ(wheel.size(), 3);
+
+  std::vector<uint64_t> expired;
+  EXPECT_EQ(wheel.advance(104, expired), 1);
+  EXPECT_EQ(expired, std::vector<uint64_t>{2});
+  EXPECT_EQ(wheel.advance(105, expired), 1);
+  EXPECT_EQ(expired.back(), 1);
+  EXPECT_EQ(wheel.advance(4999, expired), 0);
+  EXPECT_EQ(wheel.advance(6000, expired), 1);
+  EXPECT_EQ(expired.back(), 3);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.now(), 6000);
+}
+
+TEST(TimingWheelTest, JumpsAcrossLevels) {
+  // Epoch milliseconds from a wheel started at 0: the first advance is a huge jump
+  TimingWheel wheel;
+  const uint64_t now = 1717200000000;
+  std::vector<uint64_t> expired;
+  wheel.advance(now, expired);
+  EXPECT_EQ(wheel.now(), now);
+
+  wheel.schedule(now + 1, 1);
+  wheel.schedule(now + 70, 2);
+  wheel.schedule(now + 86400000, 3);
+  wheel.schedule(UINT64_MAX, 4);
+  EXPECT_EQ(wheel.advance(now + 69, expired), 1);
+  EXPECT_EQ(wheel.advance(now + 86399999, expired), 1);
+  EXPECT_EQ(wheel.advance(now + 86400000, expired), 1);
+  EXPECT_EQ(expired, (std::vector<uint64_t>{1, 2, 3}));
+  EXPECT_EQ(wheel.advance(UINT64_MAX, expired), 1);
+  EXPECT_EQ(expired.back(), 4);
+}
+
+TEST(TimingWheelTest, MatchesSortedDeadlines) {
+  std::mt19937_64 rng(5);
+  std::uniform_int_distribution<uint64_t> horizon(0, 1 << 20);
+  std::uniform_int_distribution<uint64_t> step(0, 5000);
+
+  TimingWheel wheel(1000);
+  std::multimap<uint64_t, uint64_t> pending;
+  uint64_t now = 1000, id = 0;
+  std::vector<uint64_t> expired;
+  for (int round = 0; round < 2000; round++) {
+    for (int i = 0; i < 20; i++) {
+      uint64_t deadline = now + horizon(rng) % (i % 2 ? 100 : 1 << 20);
+      wheel.schedule(deadline, id);
+      pending.emplace(deadline, id++);
+    }
+    now += step(rng);
+    expired.clear();
+    wheel.advance(now, expired);
+
+    std::vector<uint64_t> expected;
+    for (auto it = pending.begin(); it != pending.end() && it->first <= now;) {
+      expected.push_back(it->second);
+      it = pending.erase(it);
+    }
+    std::sort(expired.begin(), expired.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(expired, expected) << round;
+  }
+  EXPECT_EQ(wheel.size(), pending.size());
+
+  wheel.reset(now);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.advance(UINT64_MAX, expired), 0);
+}
@@ -0,0 +1,114 @@
+#include "engine.hpp"
+#include "trace.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+using namespace trading;
+using namespace trading::trace;
+
+// ==================== Trace Ring Tests ====================
+
+TEST(TraceTest, RecordsEventsInOrder) {
+  clear();
+  emit(EventType::ORDER_ADD, 1, 0, 100.0, 2.0);
+  emit(EventType::TRADE, 1, 2, 100.0, 1.0);
+
+  auto records = collect();
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].type, static_cast<uint32_t>(EventType::ORDER_ADD));
+  EXPECT_EQ(records[0].a, 1);
+  EXPECT_DOUBLE_EQ(records[0].price, 100.0);
+  EXPECT_EQ(records[1].type, static_cast<uint32_t>(EventType::TRADE));
+  EXPECT_EQ(records[1].b, 2);
+  EXPECT_LE(records[0].tsc, records[1].tsc);
+}
+
+TEST(TraceTest, RingKeepsNewestRecordsWhenFull) {
+  clear();
+  const uint64_t total = TraceRing::kCapacity + 100;
+  for (uint64_t i = 0; i < total; i++) {
+    emit(EventType::ORDER_ADD, i);
+  }
+
+  auto records = collect();
+  ASSERT_EQ(records.size(), TraceRing::kCapacity);
+  EXPECT_EQ(records.front().a, 100);
+  EXPECT_EQ(records.back().a, total - 1);
+}
+
+TEST(TraceTest, CollectsEveryThread) {
+  clear();
+  emit(EventType::SMA_UPDATE);
+  std::thread worker([] {
+    emit(EventType::SMA_UPDATE);
+    emit(EventType::SMA_UPDATE);
+  });
+  worker.join();
+
+  // The worker's ring outlives the thread
+  auto records = collect();
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_NE(records[0].thread_id == records[1].thread_id &&
+                records[1].thread_id == records[2].thread_id,
+            true);
+}
+
+TEST(TraceTest, DumpWritesHeaderAndRecords) {
+  clear();
+  emit(EventType::MATCH_BEGIN);
+  emit(EventType::MATCH_END, 0, 3);
+
+  const std::string path = "test_trace_dump.trace";
+  EXPECT_EQ(dump(path), 2);
+
+  std::ifstream in(path, std::ios::binary);
+  FileHeader header;
+  ASSERT_TRUE(in.read(reinterpret_cast<char *>(&header), sizeof(header)));
+  EXPECT_EQ(std::string(header.magic, 8), "TRDTRACE");
+  EXPECT_EQ(header.version, kFileVersion);
+  EXPECT_EQ(header.record_size, sizeof(Record));
+  EXPECT_EQ(header.count, 2);
+  EXPECT_GT(header.ticks_per_us, 0.0);
+
+  Record last;
+  in.seekg(sizeof(FileHeader) + sizeof(Record));
+  ASSERT_TRUE(in.read(reinterpret_cast<char *>(&last), sizeof(last)));
+  EXPECT_EQ(last.type, static_cast<uint32_t>(EventType::MATCH_END));
+  EXPECT_EQ(last.b, 3);
+
+  in.close();
+  std::remove(path.c_str());
+}
+
+// ==================== Engine Trace Point Tests ====================
+
+#ifdef TRADING_ENABLE_TRACE
+TEST(TraceTest, EngineEmitsTracePoints) {
+  clear();
+  OrderBook book;
+  book.addOrder(OrderSide::BUY, 100.0, 1.0);
+  std::string ask = book.addOrder(OrderSide::SELL, 100.0, 2.0);
+  book.matchOrders();
+  book.cancelOrder(ask);
+
+  SMACalculator sma(3);
+  sma.addPrice(100.0);
+
+  auto records = collect();
+  std::vector<EventType> types;
+  for (const auto &r : records) {
+    types.push_back(static_cast<EventType>(r.type));
+  }
+  std::vector<EventType> expected = {
+      EventType::ORDER_ADD,    EventType::ORDER_ADD, EventType::MATCH_BEGIN,
+      EventType::TRADE,        EventType::MATCH_END, EventType::ORDER_CANCEL,
+      EventType::SMA_UPDATE};
+  EXPECT_EQ(types, expected);
+  EXPECT_EQ(records[3].a, 1); // buy seq
+  EXPECT_EQ(records[3].b, 2); // sell seq
+  EXPECT_EQ(records[5].b, 1); // partially filled ask was removed
+}
+#endif
@@ -8,12 +8,13 @@ from fastapi.testclient import TestClient
 from httpx import AsyncClient
 import sys
 import os
+import time
 
 # Add backend to path
 sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', '..', 'backend'))
 
 from main import app
-from trading_service import TradingService
+from trading_service import TradingService, trade_engine
 
 
 @pytest.fixture
@@ -155,6 +156,315 @@ class TestCppEngineIntegration:
             trading_service.process_price(45000.0 + i * 10)
         
         assert len(trading_service.price_history) == 10
+        timestamps, prices = trading_service.price_history.arrays()
+        assert list(prices) == [45000.0 + i * 10 for i in range(10)]
+        assert all(timestamps[1:] >= timestamps[:-1])
+    
+    def test_price_history_ring(self):
+        """Test the history keeps the newest prices once its capacity is reached"""
+        service = TradingService(sma_window=5, history_capacity=8)
+        for i in range(20):
+            service.process_price(100.0 + i)
+        
+        assert service.price_history.last() == 119.0
+        prices = service.price_history.prices()
+        assert len(prices) == 8
+        assert list(prices) == [112.0 + i for i in range(8)]
+        assert not prices.flags.writeable
+        assert service.get_memory_stats()["price_history_bytes"] >= 2 * 8 * 8
+    
+    def test_latency_stats(self, trading_service):
+        """Test engine latency stats are reported per operation"""
+        trading_service.add_order("buy", 45000.0, 1.0)
+        trading_service.process_price(45000.0)
+        
+        stats = trading_service.get_latency_stats()
+        assert "enabled" in stats
+        if stats["enabled"]:
+            ops = stats["operations"]
+            assert set(ops) == {"add", "match", "cancel", "snapshot"}
+            assert ops["add"]["count"] == 1
+            assert ops["match"]["count"] == 1
+            assert ops["add"]["p99_ns"] >= ops["add"]["p50_ns"]
+    
+    def test_pipeline_report(self, trading_service):
+        """Test tick pipeline stamps are attributed to stages"""
+        trading_service.record_tick_pipeline([1000, 1100, 1300, 1600, 2000])
+        
+        report = trading_service.get_pipeline_report(budget_s=0.5)
+        assert report["ticks"] == 1
+        assert report["dominant_stage"] == "fanout"
+        assert abs(report["stages"]["fanout"]["share"] - 0.4) < 1e-9
+    
+    def test_memory_stats(self, trading_service):
+        """Test engine memory stats report the resting orders"""
+        trading_service.add_order("buy", 45000.0, 1.0)
+        trading_service.add_order("sell", 46000.0, 1.0)
+        
+        stats = trading_service.get_memory_stats()
+        assert stats["sma_calculator_bytes"] > 0
+        book = stats["order_book"]
+        if book:
+            assert book["resting_orders"] == 2
+            assert book["price_levels"] == 2
+            assert book["total_bytes"] >= book["order_bytes"] > 0
+    
+    def test_indicators(self, trading_service):
+        """Test batch SMAs over the price history match the streaming SMA"""
+        for i in range(30):
+            trading_service.process_price(45000.0 + (i % 7) * 10)
+        
+        result = trading_service.get_indicators([5, 20])
+        assert result["simd_path"]
+        assert len(result["sma"]["20"]) == 30
+        assert abs(result["sma"]["5"][-1] - trading_service.sma_calculator.get_sma()) < 1e-6
+    
+    def test_call_auction(self, trading_service):
+        """Test orders accumulate in an auction and uncross at one price"""
+        trading_service.start_auction()
+        trading_service.add_order("buy", 45010.0, 2.0)
+        trading_service.add_order("buy", 45000.0, 1.0)
+        trading_service.add_order("sell", 44990.0, 1.0)
+        trading_service.add_order("sell", 45000.0, 1.0)
+        
+        assert trading_service.process_price(45000.0)["trades"] == []
+        state = trading_service.get_auction_state()
+        assert state["mode"] == "auction"
+        assert state["volume"] == 2.0
+        
+        result = trading_service.uncross_auction()
+        assert result["volume"] == 2.0
+        assert {t["price"] for t in result["trades"]} == {result["price"]}
+        assert sum(t["quantity"] for t in result["trades"]) == 2.0
+        assert trading_service.get_auction_state()["mode"] == "continuous"
+        assert trading_service.trade_store.stats()["ticks"] == len(result["trades"])
+        assert trading_service.order_book.last_price() == result["price"]
+        
+        # A stop the auction price reaches fires as trading resumes
+        trading_service.start_auction()
+        trading_service.add_order("sell", 45200.0, 1.0)
+        stop = trading_service.add_order("buy", 0.0, 0.5, stop_price=45100.0)["order_id"]
+        trading_service.add_order("buy", 45100.0, 1.0)
+        trading_service.add_order("sell", 45100.0, 1.0)
+        result = trading_service.uncross_auction()
+        assert result["price"] == 45100.0
+        assert (result["trades"][-1]["buy_order_id"], result["trades"][-1]["price"]) == (stop, 45200.0)
+        assert trading_service.order_book.stop_orders() == 0
+        assert trading_service.order_book.last_price() == 45200.0
+    
+    def test_batch_auction(self, trading_service):
+        """Test orders wait for the batch interval and clear at one price"""
+        trading_service.start_batch(interval_ms=60_000, allocation="pro_rata")
+        buy_id = trading_service.add_order("buy", 45010.0, 3.0)["order_id"]
+        trading_service.add_order("sell", 45000.0, 1.0)
+        trading_service.add_order("sell", 45000.0, 1.0)
+        
+        update = trading_service.process_price(45000.0)
+        assert update["trades"] == []
+        assert update["orderbook"]["bids"] == []
+        state = trading_service.get_auction_state()
+        assert state["mode"] == "batch"
+        assert state["pending_orders"] == 3
+        
+        result = trading_service.stop_batch()
+        assert result["volume"] == 2.0
+        assert {t["price"] for t in result["trades"]} == {result["price"]}
+        assert {t["buy_order_id"] for t in result["trades"]} == {buy_id}
+        assert trading_service.order_book.last_price() == result["price"]
+        assert trading_service.get_auction_state()["mode"] == "continuous"
+        assert trading_service.order_book.get_bids() == [(45010.0, 1.0)]
+        
+        # A due batch clears on the next price tick
+        trading_service.start_batch(interval_ms=1)
+        trading_service.add_order("sell", 45010.0, 1.0)
+        time.sleep(0.01)
+        assert len(trading_service.process_price(45005.0)["trades"]) == 1
+    
+    def test_stop_orders(self, trading_service):
+        """Test stop-limit orders wait off the book until the price reaches them"""
+        trading_service.add_order("sell", 45010.0, 1.0)
+        result = trading_service.add_order("buy", 45020.0, 2.0, stop_price=45005.0)
+        assert result["status"] == "pending"
+        assert trading_service.order_book.get_bids() == []
+        
+        assert trading_service.process_price(45000.0)["trades"] == []
+        trades = trading_service.process_price(45006.0)["trades"]
+        assert [(t["price"], t["quantity"]) for t in trades] == [(45010.0, 1.0)]
+        assert trades[0]["buy_order_id"] == result["order_id"]
+        assert trading_service.order_book.get_bids() == [(45020.0, 1.0)]
+        
+        stop = trading_service.add_order("sell", 44000.0, 1.0, stop_price=44500.0)
+        assert trading_service.order_book.stop_orders() == 1
+        assert trading_service.order_book.cancel_order(stop["order_id"])
+        assert trading_service.order_book.stop_orders() == 0
+    
+    def test_good_till_orders(self, trading_service):
+        """Test good-till orders expire on the engine clock and tick count"""
+        timed = trading_service.add_order("buy", 44000.0, 1.0, expire_after_ms=30)
+        ticked = trading_service.add_order("sell", 46000.0, 2.0, expire_after_ticks=2)
+        assert timed["status"] == ticked["status"] == "pending"
+        rejected = trading_service.add_order("buy", 44000.0, 1.0, stop_price=45000.0, expire_after_ms=30)
+        assert rejected["status"] == "rejected"
+        
+        assert trading_service.process_price(45000.0)["expired"] == []
+        expired = trading_service.process_price(45000.0)["expired"]
+        assert [(e["order_id"], e["side"], e["quantity"]) for e in expired] == [(ticked["order_id"], "sell", 2.0)]
+        
+        time.sleep(0.05)
+        expired = trading_service.process_price(45000.0)["expired"]
+        assert [e["order_id"] for e in expired] == [timed["order_id"]]
+        assert trading_service.order_book.get_bids() == []
+    
+    def test_iceberg_orders(self, trading_service):
+        """Test iceberg orders show one tranche and reject stop/expiry combinations"""
+        result = trading_service.add_order("sell", 46000.0, 10.0, display_quantity=2.0)
+        assert result["status"] == "pending"
+        assert trading_service.get_order_book_snapshot()["asks"] == [[46000.0, 2.0]]
+        assert trading_service.order_book.iceberg_orders() == 1
+        
+        assert trading_service.add_order("sell", 46000.0, 1.0, display_quantity=2.0)["status"] == "rejected"
+        assert trading_service.add_order("buy", 44000.0, 5.0, display_quantity=1.0,
+                                         expire_after_ticks=3)["status"] == "rejected"
+        
+        assert trading_service.order_book.cancel_order(result["order_id"])
+        assert trading_service.order_book.iceberg_orders() == 0
+    
+    def test_simulation(self, trading_service):
+        """Test a simulated session runs on simulated time, deterministically"""
+        first = trading_service.run_simulation(600.0, order_rate=2.0, seed=3)
+        again = trading_service.run_simulation(600.0, order_rate=2.0, seed=3)
+        assert first["price_steps"] == 1200
+        assert first["now_us"] == 600 * 10**6
+        assert first["orders"] > 0 and first["expired"] > 0
+        assert (first["events"], first["final_price"]) == (again["events"], again["final_price"])
+        assert first["wall_time_s"] < 600.0
+        
+        sim = trade_engine.Simulation(trade_engine.SimulationConfig())
+        woken = []
+        sim.set_wakeup_handler(lambda s, token: woken.append((s.now(), token)))
+        sim.schedule_wakeup(2_000_000, 2)
+        sim.schedule_wakeup(1_000_000, 1)
+        assert sim.run_until(2_000_000) == 6  # Two wakeups and four price steps
+        assert woken == [(1_000_000, 1), (2_000_000, 2)]
+        
+        # The handler gets the simulation itself, so what it schedules runs
+        chained = []
+        
+        def on_wakeup(s, token):
+            chained.append((s.now(), token))
+            if token < 3:
+                s.schedule_wakeup(s.now() + 500_000, token + 1)
+        
+        sim.set_wakeup_handler(on_wakeup)
+        sim.schedule_wakeup(2_500_000, 1)
+        sim.run_until(4_000_000)
+        assert chained == [(2_500_000, 1), (3_000_000, 2), (3_500_000, 3)]
+        with pytest.raises(ValueError):
+            sim.schedule_price(1_000_000, 45000.0)
+    
+    def test_simulation_handlers(self, trading_service):
+        """Test participant handlers get the simulation itself, after market-data latency"""
+        sim = trade_engine.Simulation(trade_engine.SimulationConfig())
+        me = sim.add_participant(market_data=trade_engine.LatencyModel(base_us=100))
+        seen, books, woken = [], [], []
+        
+        def on_trade(s, trade):
+            seen.append((s.now(), trade.price, trade.quantity))
+            s.schedule_wakeup(s.now() + 1, 7)
+        
+        sim.set_trade_handler(me, on_trade)
+        sim.set_book_handler(me, lambda s, bid, ask: books.append((s.now(), bid, ask)))
+        sim.set_wakeup_handler(lambda s, token: woken.append((s.now(), token)))
+        # The first price step fires the stop into the resting ask
+        sim.schedule_order(10, trade_engine.OrderSide.SELL, 46000.0, 0.4)
+        sim.book().add_stop_order(trade_engine.OrderSide.BUY, 1.0, 0.4)
+        sim.run_until(1_000_000)
+        assert len(seen) == 1 and seen[0][1:] == (46000.0, 0.4)
+        assert woken == [(seen[0][0] + 1, 7)]
+        assert books[0] == (110, 0.0, 46000.0)
+    
+    def test_backtest(self, trading_service):
+        """Test the SMA-crossover backtest and a batched strategy"""
+        result = trading_service.run_backtest(5, 20, quantity=0.5, duration_s=600.0, seed=1)
+        assert result["ticks"] == 1200
+        assert result["orders"] >= 1
+        assert result["end_us"] == 600 * 10**6
+        assert result == {**trading_service.run_backtest(5, 20, quantity=0.5, duration_s=600.0, seed=1),
+                          "wall_time_s": result["wall_time_s"], "speedup": result["speedup"]}
+        with pytest.raises(ValueError):
+            trade_engine.SMACrossoverStrategy(20, 5, 1.0)
+        
+        sizes = []
+        strategy = trade_engine.BatchStrategy(lambda ctx, batch: sizes.append(len(batch["tick_prices"])), 10)
+        replayed = trade_engine.Backtest(strategy).replay([i * 100000 for i in range(1, 26)], [45000.0] * 25)
+        assert sizes == [10, 10, 5]
+        assert replayed["ticks"] == 25
+    
+    def test_backtest_sweep(self, trading_service):
+        """Test a window sweep replays the recorded prices once per pair"""
+        for i in range(300):
+            trading_service.process_price(45000.0 + 50.0 * ((i // 40) % 2) + i % 7)
+        timestamps, prices = trading_service.read_price_ticks()
+        assert len(prices) == 300
+        
+        sweep = trading_service.sweep_backtest(timestamps, prices, [3, 5, 40], [10, 30], quantity=0.5)
+        assert sweep["ticks"] == 300
+        assert sorted((r["fast_window"], r["slow_window"]) for r in sweep["runs"]) == \
+            [(3, 10), (3, 30), (5, 10), (5, 30)]
+        assert [r["pnl"] for r in sweep["runs"]] == sorted((r["pnl"] for r in sweep["runs"]), reverse=True)
+        
+        # Each run is the same as a Backtest of that pair on its own
+        first = sweep["runs"][0]
+        config = trade_engine.BacktestConfig()
+        config.market.sma_window = trading_service.sma_window
+        alone = trade_engine.Backtest(
+            trade_engine.SMACrossoverStrategy(first["fast_window"], first["slow_window"], 0.5), config)
+        times_us = [(int(t) - int(timestamps[0])) * 1000 for t in timestamps]
+        assert alone.replay(times_us, prices)["pnl"] == pytest.approx(first["pnl"])
+    
+    def test_matching_policy(self):
+        """Test the book is built for the configured matching rules"""
+        service = TradingService(sma_window=5, matching="pro_rata", trade_price="passive")
+        assert (service.matching, service.trade_price) == ("pro_rata", "passive")
+        assert service.add_order("buy", 45000.0, 1.0)["status"] == "pending"
+        
+        with pytest.raises(ValueError):
+            TradingService(sma_window=5, matching="lifo")
+    
+    def test_tick_store(self, trading_service):
+        """Test processed prices are recorded in the tick store"""
+        for i in range(50):
+            trading_service.process_price(45000.0 + i)
+        
+        stats = trading_service.get_tick_store_stats()
+        assert stats["prices"]["ticks"] == 50
+        timestamps, prices, _ = trading_service.price_store.read(0, 2**62)
+        assert len(prices) == 50
+        assert prices[-1] == 45049.0
+        assert all(timestamps[1:] >= timestamps[:-1])
+    
+    def test_price_history_downsampling(self, trading_service):
+        """Test stored history is downsampled to the requested point budget"""
+        for i in range(200):
+            trading_service.process_price(45000.0 + (i % 17) * 10)
+        
+        full = trading_service.get_price_history(points=1000)
+        assert len(full["prices"]) == 200
+        
+        for method in ("minmax", "lttb"):
+            result = trading_service.get_price_history(points=20, method=method)
+            assert 0 < len(result["prices"]) <= 20
+            assert result["timestamps"] == sorted(result["timestamps"])
+            assert max(result["prices"]) == 45160.0
+    
+    def test_prometheus_metrics(self, trading_service):
+        """Test engine metrics render in Prometheus text format"""
+        trading_service.add_order("buy", 45000.0, 1.0)
+        
+        text = trading_service.get_prometheus_metrics()
+        if text:
+            assert "# TYPE trade_engine_orders_total counter" in text
+            assert "trade_engine_resting_orders " in text
 
 
 @pytest.mark.asyncio